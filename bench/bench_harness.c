@@ -0,0 +1,172 @@
+#include "bench_harness.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_DEFAULT_SAMPLES 50U
+#define BENCH_DEFAULT_WARMUP 5U
+#define BENCH_DEFAULT_SAMPLE_MS 2.0
+#define BENCH_DEFAULT_BUDGET_MS 2000.0
+#define BENCH_MIN_SAMPLES 3U
+#define BENCH_MAX_SAMPLES 1000U
+#define BENCH_MAX_ITERATIONS (1U << 24)
+
+static double bench_now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1e9) + (double)now.tv_nsec;
+}
+
+static double bench_time_batch(BenchFunction function, void *context, uint32_t iterations) {
+    double started;
+    uint32_t iteration;
+
+    started = bench_now_ns();
+    for (iteration = 0U; iteration < iterations; iteration++) {
+        function(context);
+    }
+    return bench_now_ns() - started;
+}
+
+static int bench_compare_doubles(const void *left, const void *right) {
+    double a;
+    double b;
+
+    a = *(const double *)left;
+    b = *(const double *)right;
+    return (a > b) - (a < b);
+}
+
+// Nearest-rank percentile over sorted samples.
+static double bench_percentile(const double *sorted, uint32_t count, uint32_t percent) {
+    uint32_t rank;
+
+    rank = ((count * percent) + 99U) / 100U;
+    return sorted[rank == 0U ? 0U : rank - 1U];
+}
+
+void bench_suite_init(BenchSuite *suite) {
+    memset(suite, 0, sizeof(*suite));
+    suite->min_sample_ms = BENCH_DEFAULT_SAMPLE_MS;
+    suite->warmup_samples = BENCH_DEFAULT_WARMUP;
+    suite->samples = BENCH_DEFAULT_SAMPLES;
+    suite->budget_ms = BENCH_DEFAULT_BUDGET_MS;
+}
+
+bool bench_suite_wants(const BenchSuite *suite, const char *name, const char *circuit) {
+    char label[128];
+
+    if (!suite->filter) {
+        return true;
+    }
+    snprintf(label, sizeof(label), "%s/%s", name, circuit);
+    return strstr(label, suite->filter) != NULL;
+}
+
+void bench_print_header(FILE *stream) {
+    fprintf(stream, "%-34s %-20s %6s %12s %12s %14s\n", "benchmark", "circuit", "nodes", "median us", "p99 us", "ops/s");
+}
+
+void bench_run(BenchSuite *suite, const char *name, const char *circuit, uint32_t nodes, BenchFunction function, void *context) {
+    double samples[BENCH_MAX_SAMPLES];
+    BenchResult *result;
+    double target_ns;
+    double budget_ns;
+    double spent_ns;
+    double total;
+    uint32_t sample_limit;
+    uint32_t sample_count;
+    uint32_t iterations;
+    uint32_t index;
+
+    if (!bench_suite_wants(suite, name, circuit) || suite->result_count == BENCH_MAX_RESULTS) {
+        return;
+    }
+
+    // Calibrate: double the batch until one batch reaches the sample length.
+    target_ns = suite->min_sample_ms * 1e6;
+    iterations = 1U;
+    while (iterations < BENCH_MAX_ITERATIONS && bench_time_batch(function, context, iterations) < target_ns) {
+        iterations *= 2U;
+    }
+
+    // Slow paths get fewer samples rather than an unbounded run: warm-up
+    // stops at a quarter of the budget and sampling at the whole budget,
+    // once BENCH_MIN_SAMPLES are in.
+    budget_ns = suite->budget_ms * 1e6;
+    spent_ns = 0.0;
+    for (index = 0U; index < suite->warmup_samples && spent_ns < budget_ns / 4.0; index++) {
+        spent_ns += bench_time_batch(function, context, iterations);
+    }
+
+    sample_limit = suite->samples < BENCH_MIN_SAMPLES ? BENCH_MIN_SAMPLES : suite->samples;
+    sample_limit = sample_limit > BENCH_MAX_SAMPLES ? BENCH_MAX_SAMPLES : sample_limit;
+    spent_ns = 0.0;
+    total = 0.0;
+    sample_count = 0U;
+    while (sample_count < sample_limit && (sample_count < BENCH_MIN_SAMPLES || spent_ns < budget_ns)) {
+        double elapsed;
+
+        elapsed = bench_time_batch(function, context, iterations);
+        spent_ns += elapsed;
+        samples[sample_count] = elapsed / (double)iterations;
+        total += samples[sample_count];
+        sample_count++;
+    }
+    qsort(samples, sample_count, sizeof(samples[0]), bench_compare_doubles);
+
+    result = &suite->results[suite->result_count++];
+    memset(result, 0, sizeof(*result));
+    result->name = name;
+    result->circuit = circuit;
+    result->nodes = nodes;
+    result->iterations = iterations;
+    result->samples = sample_count;
+    result->median_ns = bench_percentile(samples, sample_count, 50U);
+    result->p99_ns = bench_percentile(samples, sample_count, 99U);
+    result->min_ns = samples[0];
+    result->mean_ns = total / (double)sample_count;
+    result->ops_per_sec = result->median_ns > 0.0 ? 1e9 / result->median_ns : 0.0;
+
+    printf(
+        "%-34s %-20s %6u %12.3f %12.3f %14.0f\n",
+        name,
+        circuit,
+        nodes,
+        result->median_ns / 1000.0,
+        result->p99_ns / 1000.0,
+        result->ops_per_sec
+    );
+    fflush(stdout);
+}
+
+bool bench_write_json(const BenchSuite *suite, FILE *stream) {
+    uint32_t index;
+
+    fprintf(stream, "{\n  \"warmup_samples\": %u,\n  \"samples\": %u,\n", suite->warmup_samples, suite->samples);
+    fprintf(stream, "  \"min_sample_ms\": %.3f,\n  \"budget_ms\": %.1f,\n  \"benchmarks\": [\n", suite->min_sample_ms, suite->budget_ms);
+    for (index = 0U; index < suite->result_count; index++) {
+        const BenchResult *result;
+
+        result = &suite->results[index];
+        fprintf(
+            stream,
+            "    {\"name\": \"%s\", \"circuit\": \"%s\", \"nodes\": %u, \"iterations\": %u, \"samples\": %u, "
+            "\"median_ns\": %.1f, \"p99_ns\": %.1f, \"min_ns\": %.1f, \"mean_ns\": %.1f, \"ops_per_sec\": %.1f}%s\n",
+            result->name,
+            result->circuit,
+            result->nodes,
+            result->iterations,
+            result->samples,
+            result->median_ns,
+            result->p99_ns,
+            result->min_ns,
+            result->mean_ns,
+            result->ops_per_sec,
+            index + 1U < suite->result_count ? "," : ""
+        );
+    }
+    fprintf(stream, "  ]\n}\n");
+    return !ferror(stream);
+}
@@ -0,0 +1,47 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BENCH_MAX_RESULTS 64U
+
+typedef void (*BenchFunction)(void *context);
+
+typedef struct {
+    const char *name;
+    const char *circuit;
+    double median_ns; // per call
+    double p99_ns;
+    double min_ns;
+    double mean_ns;
+    double ops_per_sec; // calls per second at the median
+    uint32_t nodes;
+    uint32_t iterations; // calls per sample
+    uint32_t samples;
+    uint8_t _padding[4];
+} BenchResult;
+
+// Each benchmark is calibrated so one sample (a batch of back-to-back
+// calls) lasts at least min_sample_ms, then runs warmup_samples untimed
+// samples and up to `samples` timed ones within budget_ms. Per-call times
+// are reported as the median and p99 over the samples.
+typedef struct {
+    BenchResult results[BENCH_MAX_RESULTS];
+    const char *filter; // substring of "name/circuit", NULL runs everything
+    double min_sample_ms;
+    double budget_ms; // per benchmark, after calibration
+    uint32_t warmup_samples;
+    uint32_t samples;
+    uint32_t result_count;
+    uint8_t _padding[4];
+} BenchSuite;
+
+void bench_suite_init(BenchSuite *suite);
+bool bench_suite_wants(const BenchSuite *suite, const char *name, const char *circuit);
+void bench_run(BenchSuite *suite, const char *name, const char *circuit, uint32_t nodes, BenchFunction function, void *context);
+void bench_print_header(FILE *stream);
+bool bench_write_json(const BenchSuite *suite, FILE *stream);
+
+#endif // BENCH_HARNESS_H
@@ -0,0 +1,303 @@
+#include "arena.h"
+#include "bench_harness.h"
+#include "circuit_file_app.h"
+#include "circuit_gen.h"
+#include "circuit_layout.h"
+#include "logic.h"
+#include "mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Hot-path benchmarks over generated circuits. Run with --json FILE to keep
+// a machine-readable copy for comparing releases.
+
+#define ENGINE_BENCH_LAYOUT_ARENA (64U * 1024U)
+
+// What to run on a circuit besides evaluate, topological sort and headless load.
+#define ENGINE_BENCH_TICK 1U
+#define ENGINE_BENCH_ANALYSIS 2U // truth table and expression; at most 8 inputs
+#define ENGINE_BENCH_LAYOUT 4U // auto-layout and the editor load, which lays out
+
+typedef struct {
+    LogicGraph *graph;
+    LogicNode *output; // expression root
+    LogicNode *sorted[MAX_NODES];
+    AppContext *app;
+    CircuitSpec spec;
+    CircuitPosition *positions;
+    const char *path;
+} EngineBenchContext;
+
+typedef struct {
+    const char *label;
+    LogicGraph *graph;
+    CircuitGenParams params;
+    uint32_t flags;
+    char path[60];
+} EngineBenchCircuit;
+
+static void bench_evaluate(void *context) {
+    logic_evaluate(((EngineBenchContext *)context)->graph);
+}
+
+static void bench_tick(void *context) {
+    logic_tick(((EngineBenchContext *)context)->graph);
+}
+
+static void bench_topological_sort(void *context) {
+    EngineBenchContext *bench;
+
+    bench = (EngineBenchContext *)context;
+    logic_topological_sort(bench->graph, bench->sorted);
+}
+
+static void bench_truth_table(void *context) {
+    logic_free_truth_table(logic_generate_truth_table(((EngineBenchContext *)context)->graph));
+}
+
+static void bench_expression(void *context) {
+    EngineBenchContext *bench;
+
+    bench = (EngineBenchContext *)context;
+    mem_free(logic_generate_expression(bench->graph, bench->output));
+}
+
+static void bench_layout(void *context) {
+    EngineBenchContext *bench;
+    Arena scratch;
+
+    bench = (EngineBenchContext *)context;
+    arena_init(&scratch, ENGINE_BENCH_LAYOUT_ARENA, MEM_TAG_LAYOUT);
+    circuit_layout_resolve_positions(
+        bench->spec.nodes,
+        bench->spec.node_count,
+        bench->spec.edges,
+        bench->spec.edge_count,
+        bench->positions,
+        &scratch
+    );
+    arena_release(&scratch);
+}
+
+static void bench_load_graph(void *context) {
+    EngineBenchContext *bench;
+    char error[256];
+
+    bench = (EngineBenchContext *)context;
+    circuit_file_load_graph(bench->graph, bench->path, error, sizeof(error));
+}
+
+static void bench_load_app(void *context) {
+    EngineBenchContext *bench;
+    char error[256];
+
+    bench = (EngineBenchContext *)context;
+    circuit_file_load(bench->app, bench->path, error, sizeof(error));
+}
+
+static LogicNode *engine_bench_last_output(LogicGraph *graph) {
+    uint32_t index;
+
+    for (index = graph->node_count; index > 0U; index--) {
+        if (graph->nodes[index - 1U].type == NODE_OUTPUT) {
+            return &graph->nodes[index - 1U];
+        }
+    }
+    return NULL;
+}
+
+// Builds the circuit and saves it (without positions) to a temporary .circ
+// for the layout and load benchmarks.
+static bool engine_bench_prepare(EngineBenchCircuit *circuit) {
+    char error[256];
+    int fd;
+
+    if (!circuit_gen_build(circuit->graph, &circuit->params, error, sizeof(error))) {
+        fprintf(stderr, "%s: %s\n", circuit->label, error);
+        return false;
+    }
+    snprintf(circuit->path, sizeof(circuit->path), "/tmp/logicsim_engine_bench_XXXXXX");
+    fd = mkstemp(circuit->path);
+    if (fd < 0) {
+        fprintf(stderr, "could not create a temporary file\n");
+        return false;
+    }
+    close(fd);
+    if (!circuit_file_save(circuit->graph, NULL, circuit->path, error, sizeof(error))) {
+        fprintf(stderr, "%s: %s\n", circuit->label, error);
+        return false;
+    }
+    logic_evaluate(circuit->graph);
+    return true;
+}
+
+static void engine_bench_circuit(BenchSuite *suite, EngineBenchCircuit *circuit, EngineBenchContext *context) {
+    LogicGraph *graph;
+    CircuitFileText text;
+    Arena arena;
+    char error[256];
+    uint32_t nodes;
+
+    graph = circuit->graph;
+    nodes = graph->node_count;
+    context->graph = graph;
+    context->output = engine_bench_last_output(graph);
+    context->path = circuit->path;
+
+    bench_run(suite, "logic_evaluate", circuit->label, nodes, bench_evaluate, context);
+    if ((circuit->flags & ENGINE_BENCH_TICK) != 0U) {
+        bench_run(suite, "logic_tick", circuit->label, nodes, bench_tick, context);
+    }
+    bench_run(suite, "logic_topological_sort", circuit->label, nodes, bench_topological_sort, context);
+    if ((circuit->flags & ENGINE_BENCH_ANALYSIS) != 0U) {
+        bench_run(suite, "logic_generate_truth_table", circuit->label, nodes, bench_truth_table, context);
+        bench_run(suite, "logic_generate_expression", circuit->label, nodes, bench_expression, context);
+    }
+
+    if ((circuit->flags & ENGINE_BENCH_LAYOUT) != 0U &&
+        bench_suite_wants(suite, "circuit_layout_resolve_positions", circuit->label) &&
+        circuit_file_open_spec(circuit->path, &text, &arena, &context->spec, error, sizeof(error))) {
+        context->positions = (CircuitPosition *)calloc(context->spec.node_count + 1U, sizeof(*context->positions));
+        if (context->positions) {
+            bench_run(suite, "circuit_layout_resolve_positions", circuit->label, nodes, bench_layout, context);
+        }
+        free(context->positions);
+        context->positions = NULL;
+        circuit_file_close_spec(&text, &arena);
+    }
+
+    // The load benchmarks load into a scratch graph and app so the circuit
+    // under test stays intact.
+    context->graph = (LogicGraph *)calloc(1U, sizeof(*context->graph));
+    if (context->graph) {
+        logic_init_graph(context->graph);
+        bench_run(suite, "circuit_file_load_graph", circuit->label, nodes, bench_load_graph, context);
+        logic_clear_graph(context->graph);
+        free(context->graph);
+    }
+    if ((circuit->flags & ENGINE_BENCH_LAYOUT) != 0U) {
+        bench_run(suite, "circuit_file_load", circuit->label, nodes, bench_load_app, context);
+    }
+    context->graph = graph;
+}
+
+static void engine_bench_define(
+    EngineBenchCircuit *circuit,
+    const char *label,
+    uint32_t flags,
+    CircuitGenKind kind,
+    uint32_t bits
+) {
+    circuit->label = label;
+    circuit->flags = flags;
+    circuit_gen_params_init(&circuit->params, kind);
+    circuit->params.bits = bits;
+}
+
+static void engine_bench_define_random(EngineBenchCircuit *circuit, const char *label, uint32_t flags, uint32_t gates, uint32_t seed) {
+    engine_bench_define(circuit, label, flags, CIRCUIT_GEN_RANDOM_DAG, 0U);
+    circuit->params.gates = gates;
+    circuit->params.seed = seed;
+}
+
+static uint32_t engine_bench_count(const char *text) {
+    unsigned long value;
+
+    value = strtoul(text, NULL, 10);
+    return value > UINT32_MAX ? UINT32_MAX : (uint32_t)value;
+}
+
+static void engine_bench_usage(void) {
+    fprintf(stderr, "usage: engine_bench [--samples N] [--warmup N] [--sample-ms MS] [--budget-ms MS] [--filter TEXT] [--json FILE]\n");
+}
+
+int main(int argc, char **argv) {
+    static BenchSuite suite;
+    static EngineBenchContext context;
+    static AppContext app;
+    EngineBenchCircuit circuits[7];
+    const char *json_path;
+    uint32_t circuit_count;
+    uint32_t index;
+    int status;
+    int arg;
+
+    bench_suite_init(&suite);
+    json_path = NULL;
+    for (arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--samples") == 0 && arg + 1 < argc) {
+            suite.samples = engine_bench_count(argv[++arg]);
+        } else if (strcmp(argv[arg], "--warmup") == 0 && arg + 1 < argc) {
+            suite.warmup_samples = engine_bench_count(argv[++arg]);
+        } else if (strcmp(argv[arg], "--budget-ms") == 0 && arg + 1 < argc) {
+            suite.budget_ms = strtod(argv[++arg], NULL);
+        } else if (strcmp(argv[arg], "--sample-ms") == 0 && arg + 1 < argc) {
+            suite.min_sample_ms = strtod(argv[++arg], NULL);
+        } else if (strcmp(argv[arg], "--filter") == 0 && arg + 1 < argc) {
+            suite.filter = argv[++arg];
+        } else if (strcmp(argv[arg], "--json") == 0 && arg + 1 < argc) {
+            json_path = argv[++arg];
+        } else {
+            engine_bench_usage();
+            return 2;
+        }
+    }
+
+    // Layout is superlinear in node count, so the large random DAG skips it
+    // and a smaller one covers layout of unstructured netlists.
+    memset(circuits, 0, sizeof(circuits));
+    engine_bench_define(&circuits[0], "ripple_adder_32", ENGINE_BENCH_LAYOUT, CIRCUIT_GEN_RIPPLE_ADDER, 32U);
+    engine_bench_define(&circuits[1], "multiplier_8x8", ENGINE_BENCH_LAYOUT, CIRCUIT_GEN_MULTIPLIER, 8U);
+    engine_bench_define(&circuits[2], "shift_register_256", ENGINE_BENCH_TICK | ENGINE_BENCH_LAYOUT, CIRCUIT_GEN_SHIFT_REGISTER, 256U);
+    engine_bench_define_random(&circuits[3], "random_dag_1000", ENGINE_BENCH_TICK, 984U, 12345U);
+    engine_bench_define_random(&circuits[4], "random_dag_250", ENGINE_BENCH_LAYOUT, 234U, 4242U);
+    engine_bench_define(&circuits[5], "multiplier_4x4", ENGINE_BENCH_ANALYSIS, CIRCUIT_GEN_MULTIPLIER, 4U);
+    engine_bench_define_random(&circuits[6], "random_dag_8x120", ENGINE_BENCH_ANALYSIS, 120U, 777U);
+    circuit_count = sizeof(circuits) / sizeof(circuits[0]);
+    status = 0;
+    for (index = 0U; index < circuit_count && status == 0; index++) {
+        circuits[index].graph = (LogicGraph *)calloc(1U, sizeof(LogicGraph));
+        if (!circuits[index].graph) {
+            fprintf(stderr, "out of memory\n");
+            status = 1;
+        } else if (!engine_bench_prepare(&circuits[index])) {
+            status = 1;
+        }
+    }
+
+    if (status == 0) {
+        app_init(&app);
+        context.app = &app;
+        bench_print_header(stdout);
+        for (index = 0U; index < circuit_count; index++) {
+            engine_bench_circuit(&suite, &circuits[index], &context);
+        }
+        app_clear_graph(&app);
+    }
+
+    if (status == 0 && json_path) {
+        FILE *stream;
+
+        stream = fopen(json_path, "w");
+        if (!stream || !bench_write_json(&suite, stream)) {
+            fprintf(stderr, "could not write %s\n", json_path);
+            status = 1;
+        }
+        if (stream) {
+            fclose(stream);
+        }
+    }
+
+    for (index = 0U; index < circuit_count; index++) {
+        if (circuits[index].path[0] != '\0') {
+            unlink(circuits[index].path);
+        }
+        if (circuits[index].graph) {
+            logic_clear_graph(circuits[index].graph);
+            free(circuits[index].graph);
+        }
+    }
+    return status;
+}
@@ -0,0 +1,221 @@
+#include "circuit_file_app.h"
+#include "logic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Load-time benchmark over generated netlists of doubling size: parse, resolve
+// wires and build the graph (no layout or analysis), from .circ and from the
+// same circuit converted to .circb. If loading is linear, the per-node columns
+// stay flat as the circuits grow. The last columns time saving the loaded
+// graph back out as .circ.
+
+#define LOAD_BENCH_INPUTS 8U
+#define LOAD_BENCH_OUTPUTS 8U
+#define LOAD_BENCH_MAX_FANOUT 8U
+#define LOAD_BENCH_RUNS 20U
+
+static uint32_t load_bench_seed = 12345U;
+
+static uint32_t load_bench_random(void) {
+    load_bench_seed = (load_bench_seed * 1103515245U) + 12345U;
+    return (load_bench_seed >> 8) & 0xFFFFFFU;
+}
+
+static double load_bench_now_ms(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1000.0) + ((double)now.tv_nsec / 1000000.0);
+}
+
+// Picks a recent signal that still has room on its net, so the generated
+// circuit stays within the engine's per-net sink limit.
+static uint32_t load_bench_pick_source(const uint8_t *fanout, uint32_t signal_count) {
+    uint32_t window;
+    uint32_t attempt;
+    uint32_t candidate;
+
+    window = signal_count < 32U ? signal_count : 32U;
+    for (attempt = 0U; attempt < 8U; attempt++) {
+        candidate = signal_count - 1U - (load_bench_random() % window);
+        if (fanout[candidate] < LOAD_BENCH_MAX_FANOUT) {
+            return candidate;
+        }
+    }
+    for (candidate = signal_count; candidate > 0U; candidate--) {
+        if (fanout[candidate - 1U] < LOAD_BENCH_MAX_FANOUT) {
+            return candidate - 1U;
+        }
+    }
+    return 0U;
+}
+
+static const char *load_bench_signal_name(uint32_t signal, char *buffer, size_t buffer_size) {
+    if (signal < LOAD_BENCH_INPUTS) {
+        snprintf(buffer, buffer_size, "IN%u", signal);
+    } else {
+        snprintf(buffer, buffer_size, "G%u", signal - LOAD_BENCH_INPUTS);
+    }
+    return buffer;
+}
+
+// Writes `node_count` nodes with roughly two wires per node to `path`.
+static bool load_bench_write_circuit(const char *path, uint32_t node_count, uint32_t *wire_count) {
+    static const char *gate_kinds[] = { "and", "or", "xor" };
+    uint8_t fanout[MAX_NODES];
+    char source_name[32];
+    uint32_t gate_count;
+    uint32_t signal;
+    uint32_t index;
+    FILE *file;
+
+    file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+
+    memset(fanout, 0, sizeof(fanout));
+    gate_count = node_count - LOAD_BENCH_INPUTS - LOAD_BENCH_OUTPUTS;
+    *wire_count = 0U;
+    for (index = 0U; index < LOAD_BENCH_INPUTS; index++) {
+        fprintf(file, "input IN%u\n", index);
+    }
+    for (index = 0U; index < gate_count; index++) {
+        fprintf(file, "%s G%u\n", gate_kinds[load_bench_random() % 3U], index);
+    }
+    for (index = 0U; index < LOAD_BENCH_OUTPUTS; index++) {
+        fprintf(file, "output OUT%u\n", index);
+    }
+
+    for (index = 0U; index < gate_count; index++) {
+        uint32_t pin;
+
+        for (pin = 0U; pin < 2U; pin++) {
+            signal = load_bench_pick_source(fanout, LOAD_BENCH_INPUTS + index);
+            fanout[signal]++;
+            fprintf(file, "wire %s -> G%u.in%u\n", load_bench_signal_name(signal, source_name, sizeof(source_name)), index, pin);
+            (*wire_count)++;
+        }
+    }
+    for (index = 0U; index < LOAD_BENCH_OUTPUTS; index++) {
+        signal = LOAD_BENCH_INPUTS + gate_count - 1U - index;
+        fprintf(file, "wire %s -> OUT%u.in0\n", load_bench_signal_name(signal, source_name, sizeof(source_name)), index);
+        (*wire_count)++;
+    }
+
+    return fclose(file) == 0;
+}
+
+// Best of LOAD_BENCH_RUNS headless loads, or a negative time on failure.
+static double load_bench_time(LogicGraph *graph, const char *path, uint32_t node_count) {
+    char error[256];
+    double best;
+    uint32_t run;
+
+    best = 0.0;
+    for (run = 0U; run < LOAD_BENCH_RUNS; run++) {
+        double started;
+        double elapsed;
+
+        started = load_bench_now_ms();
+        if (!circuit_file_load_graph(graph, path, error, sizeof(error))) {
+            fprintf(stderr, "%u nodes: %s\n", node_count, error);
+            return -1.0;
+        }
+        elapsed = load_bench_now_ms() - started;
+        best = (run == 0U || elapsed < best) ? elapsed : best;
+    }
+    return best;
+}
+
+// Best of LOAD_BENCH_RUNS saves of `graph` to `path`, or a negative time on failure.
+static double load_bench_save_time(const LogicGraph *graph, const char *path) {
+    char error[256];
+    double best;
+    uint32_t run;
+
+    best = 0.0;
+    for (run = 0U; run < LOAD_BENCH_RUNS; run++) {
+        double started;
+        double elapsed;
+
+        started = load_bench_now_ms();
+        if (!circuit_file_save(graph, NULL, path, error, sizeof(error))) {
+            fprintf(stderr, "save: %s\n", error);
+            return -1.0;
+        }
+        elapsed = load_bench_now_ms() - started;
+        best = (run == 0U || elapsed < best) ? elapsed : best;
+    }
+    return best;
+}
+
+int main(void) {
+    static const uint32_t sizes[] = { 125U, 250U, 500U, 1000U };
+    LogicGraph *graph;
+    char error[256];
+    uint32_t size_index;
+
+    graph = (LogicGraph *)calloc(1U, sizeof(*graph));
+    if (!graph) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+    logic_init_graph(graph);
+
+    printf("%8s %8s %10s %10s %10s %10s %10s %10s\n", "nodes", "wires", "circ ms", "us/node", "circb ms", "us/node", "save ms", "Mlines/s");
+    for (size_index = 0U; size_index < sizeof(sizes) / sizeof(sizes[0]); size_index++) {
+        char path[] = "/tmp/logicsim_load_bench_XXXXXX";
+        char binary_path[64];
+        double text_ms;
+        double binary_ms;
+        double save_ms;
+        uint32_t wire_count;
+        int fd;
+
+        fd = mkstemp(path);
+        if (fd < 0) {
+            fprintf(stderr, "could not create a temporary file\n");
+            free(graph);
+            return 1;
+        }
+        close(fd);
+        snprintf(binary_path, sizeof(binary_path), "%s.circb", path);
+        if (!load_bench_write_circuit(path, sizes[size_index], &wire_count) ||
+            !circuit_file_convert(path, binary_path, error, sizeof(error))) {
+            fprintf(stderr, "could not write %s\n", path);
+            unlink(path);
+            free(graph);
+            return 1;
+        }
+
+        text_ms = load_bench_time(graph, path, sizes[size_index]);
+        binary_ms = load_bench_time(graph, binary_path, sizes[size_index]);
+        save_ms = load_bench_save_time(graph, path);
+        unlink(path);
+        unlink(binary_path);
+        if (text_ms < 0.0 || binary_ms < 0.0 || save_ms < 0.0) {
+            free(graph);
+            return 1;
+        }
+
+        printf(
+            "%8u %8u %10.3f %10.3f %10.3f %10.3f %10.3f %10.2f\n",
+            sizes[size_index],
+            wire_count,
+            text_ms,
+            (text_ms * 1000.0) / (double)sizes[size_index],
+            binary_ms,
+            (binary_ms * 1000.0) / (double)sizes[size_index],
+            save_ms,
+            (double)(sizes[size_index] + wire_count) / (save_ms * 1000.0)
+        );
+    }
+
+    logic_clear_graph(graph);
+    free(graph);
+    return 0;
+}
@@ -3,6 +3,9 @@
 #include "app_canvas.h"
 #include "app_commands.h"
 #include "app_internal.h"
+#include "logic_activity.h"
+#include "mem.h"
+#include "trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -143,6 +146,10 @@ void app_init(AppContext *app) {
     app->comparison.status = APP_COMPARE_NO_TARGET;
     app_reset_canvas_view(app);
     app_set_source_status(app, "Canvas editing");
+    arena_init(&app->analysis.arenas[0], APP_ANALYSIS_ARENA_BLOCK, MEM_TAG_ANALYSIS);
+    arena_init(&app->analysis.arenas[1], APP_ANALYSIS_ARENA_BLOCK, MEM_TAG_ANALYSIS);
+    mem_set_fixed(MEM_TAG_GRAPH, sizeof(app->graph));
+    mem_set_fixed(MEM_TAG_WAVEFORMS, sizeof(app->simulation.waveforms));
 }
 
 void app_update_logic(AppContext *app) {
@@ -151,7 +158,11 @@ void app_update_logic(AppContext *app) {
     LogicNode *saved_input_nodes[MAX_PINS];
     uint8_t saved_count;
     uint32_t index;
+    double started;
+    double table_started;
 
+    TRACE_BEGIN("app_update_logic");
+    started = GetTime();
     app->simulation.waveform_index = 0U;
     memset(app->simulation.waveforms, 0, sizeof(app->simulation.waveforms));
     output_node = app_primary_output_node(app);
@@ -168,26 +179,34 @@ void app_update_logic(AppContext *app) {
         }
     }
 
-    if (app->analysis.truth_table) {
-        logic_free_truth_table(app->analysis.truth_table);
-    }
-    app->analysis.truth_table = logic_generate_truth_table(&app->graph);
+    app_analysis_begin_pass(app);
+    TRACE_BEGIN("logic_generate_truth_table");
+    table_started = GetTime();
+    app->analysis.truth_table = logic_generate_truth_table_in(&app->graph, app_analysis_arena(app));
+    app->perf.truth_table_seconds = GetTime() - table_started;
+    TRACE_END();
 
     for (index = 0U; index < saved_count; index++) {
         saved_input_nodes[index]->outputs[0].value = saved_inputs[index];
     }
     logic_evaluate(&app->graph);
 
-    free(app->analysis.expression);
-    app->analysis.expression = NULL;
     if (output_node) {
-        app->analysis.expression = logic_generate_expression(&app->graph, output_node);
+        TRACE_BEGIN("logic_generate_expression");
+        app->analysis.expression = logic_generate_expression_in(&app->graph, output_node, app_analysis_arena(app));
+        TRACE_END();
     }
 
+    TRACE_BEGIN("app_update_kmap_grouping");
     app_update_kmap_grouping(app);
+    TRACE_END();
     app_compute_view_context(app);
+    TRACE_BEGIN("app_compare_if_needed");
     app_compare_if_needed(app);
+    TRACE_END();
     app_record_waveforms(app);
+    app->perf.update_logic_seconds = GetTime() - started;
+    TRACE_END();
 }
 
 LogicNode *app_add_node(AppContext *app, NodeType type, Vector2 pos) {
@@ -197,11 +216,7 @@ LogicNode *app_add_node(AppContext *app, NodeType type, Vector2 pos) {
 LogicNode *app_add_named_node(AppContext *app, NodeType type, const char *custom_name, Vector2 pos) {
     const char *resolved_name;
     char generated_name[APP_NAME_BUFFER_SIZE];
-    int width;
-    int height;
-    LogicNode *node;
 
-    app_node_dimensions(type, &width, &height);
     if (custom_name) {
         resolved_name = custom_name;
     } else {
@@ -209,13 +224,20 @@ LogicNode *app_add_named_node(AppContext *app, NodeType type, const char *custom
         resolved_name = generated_name;
     }
 
-    node = logic_add_node(&app->graph, type, resolved_name);
+    return app_graph_add_node(&app->graph, &app->geometry, type, resolved_name, pos);
+}
+
+// The placement half of app_add_named_node; needs no AppContext, so graphs
+// can be built off the UI thread.
+LogicNode *app_graph_add_node(LogicGraph *graph, GraphGeometry *geometry, NodeType type, const char *name, Vector2 pos) {
+    LogicNode *node;
+
+    node = logic_add_node(graph, type, name);
     if (!node) {
         return NULL;
     }
 
-    node->pos = pos;
-    node->rect = (Rectangle){ pos.x, pos.y, (float)width, (float)height };
+    geometry->positions[graph->node_count - 1U] = (CircuitPosition){ pos.x, pos.y };
     if (type == NODE_INPUT && node->output_count > 0U) {
         node->outputs[0].value = LOGIC_HIGH;
     }
@@ -223,6 +245,27 @@ LogicNode *app_add_named_node(AppContext *app, NodeType type, const char *custom
     return node;
 }
 
+Vector2 app_node_position(const AppContext *app, const LogicNode *node) {
+    const CircuitPosition *position;
+
+    position = &app->geometry.positions[node - app->graph.nodes];
+    return (Vector2){ position->x, position->y };
+}
+
+Rectangle app_node_rect(const AppContext *app, const LogicNode *node) {
+    Vector2 position;
+    int width;
+    int height;
+
+    position = app_node_position(app, node);
+    app_node_dimensions(node->type, &width, &height);
+    return (Rectangle){ position.x, position.y, (float)width, (float)height };
+}
+
+void app_set_node_position(AppContext *app, const LogicNode *node, Vector2 pos) {
+    app->geometry.positions[node - app->graph.nodes] = (CircuitPosition){ pos.x, pos.y };
+}
+
 void app_set_mode(AppContext *app, AppMode mode) {
     app->mode = mode;
     app_compute_view_context(app);
@@ -250,26 +293,21 @@ void app_select_row(AppContext *app, uint32_t row_index) {
 }
 
 void app_clear_graph(AppContext *app) {
-    uint32_t index;
-
     if (!app) {
         return;
     }
 
-    for (index = 0U; index < app->graph.node_count; index++) {
-        free(app->graph.nodes[index].name);
-        app->graph.nodes[index].name = NULL;
+    app_clear_stimulus(app);
+    logic_clear_graph(&app->graph);
+    if (app->simulation.activity) {
+        logic_activity_reset(app->simulation.activity, LOGIC_ACTIVITY_SAMPLE_INTERVAL);
     }
-
-    logic_init_graph(&app->graph);
-    if (app->analysis.truth_table) {
-        logic_free_truth_table(app->analysis.truth_table);
-        app->analysis.truth_table = NULL;
-    }
-    free(app->analysis.expression);
+    app->analysis.truth_table = NULL;
     app->analysis.expression = NULL;
-    free(app->analysis.simplified_expression);
     app->analysis.simplified_expression = NULL;
+    app->analysis.kmap_group_count = 0U;
+    arena_release(&app->analysis.arenas[0]);
+    arena_release(&app->analysis.arenas[1]);
     app->canvas.drag_node = NULL;
     app->selection.selected_node = NULL;
     app->selection.selected_wire_sink = NULL;
@@ -287,6 +325,45 @@ void app_clear_graph(AppContext *app) {
     app->analysis.kmap_group_count = 0U;
     app->comparison.status = APP_COMPARE_NO_TARGET;
     app->comparison.equivalent = false;
+    logic_compare_target_invalidate_alignment(&app->comparison.target);
+}
+
+// Stimulus node indices refer to the graph the file was parsed against, so
+// loading a different circuit drops it (see app_clear_graph).
+bool app_load_stimulus(AppContext *app, const char *path, char *error_message, size_t error_message_size) {
+    LogicStimulusRun *playback;
+
+    if (!app || !path) {
+        return false;
+    }
+
+    playback = (LogicStimulusRun *)mem_calloc(MEM_TAG_SIMULATION, 1U, sizeof(*playback));
+    if (!playback) {
+        snprintf(error_message, error_message_size, "out of memory");
+        return false;
+    }
+    app_clear_stimulus(app);
+    if (!logic_stimulus_load(&app->simulation.stimulus, &app->graph, path, error_message, error_message_size)) {
+        mem_free(playback);
+        return false;
+    }
+
+    logic_stimulus_run_init(playback, &app->graph, &app->simulation.stimulus);
+    app->simulation.playback = playback;
+    app->simulation.active = false;
+    app->simulation.waveform_index = 0U;
+    memset(app->simulation.waveforms, 0, sizeof(app->simulation.waveforms));
+    return true;
+}
+
+void app_clear_stimulus(AppContext *app) {
+    if (!app) {
+        return;
+    }
+
+    mem_free(app->simulation.playback);
+    app->simulation.playback = NULL;
+    logic_stimulus_release(&app->simulation.stimulus);
 }
 
 void app_set_source_path(AppContext *app, const char *path) {
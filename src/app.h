@@ -1,7 +1,12 @@
 #ifndef APP_H
 #define APP_H
 
+#include "arena.h"
+#include "circuit_spec.h"
 #include "logic.h"
+#include "logic_compare.h"
+#include "logic_stimulus.h"
+#include "raylib.h"
 
 typedef enum {
     MODE_BUILD,
@@ -54,20 +59,22 @@ typedef enum {
     EDITOR_COMMAND_MOVE_SELECTION_UP,
     EDITOR_COMMAND_MOVE_SELECTION_DOWN,
     EDITOR_COMMAND_SELECT_PREVIOUS_ROW,
-    EDITOR_COMMAND_SELECT_NEXT_ROW
+    EDITOR_COMMAND_SELECT_NEXT_ROW,
+    EDITOR_COMMAND_TOGGLE_HEATMAP
 } EditorCommand;
 
 #define MAX_KMAP_GROUPS 8
 #define APP_SOURCE_PATH_MAX 512
 #define APP_STATUS_MESSAGE_MAX 128
+#define APP_ANALYSIS_ARENA_BLOCK (16U * 1024U) // a full 8-input table plus expressions
 #define APP_CANVAS_MIN_ZOOM 0.4f
 #define APP_CANVAS_MAX_ZOOM 3.0f
 
 typedef struct {
     char term[16];
     Color color;
-    uint8_t cell_mask;
-    uint8_t _padding[3];
+    uint16_t cell_mask; // bit r set when truth-table row r is in the group
+    uint8_t _padding[2];
 } KMapGroup;
 
 #define WAVEFORM_SAMPLES 100
@@ -78,6 +85,13 @@ typedef struct {
 #pragma clang diagnostic ignored "-Wpadded"
 #endif
 
+// Canvas positions, kept beside the graph rather than in LogicNode so the
+// engine carries no geometry. Indexed like LogicGraph.nodes; a node's size
+// follows from its type (app_node_dimensions).
+typedef struct {
+    CircuitPosition positions[MAX_NODES];
+} GraphGeometry;
+
 typedef struct {
     Vector2 origin;
     float zoom;
@@ -105,28 +119,42 @@ typedef struct {
 typedef struct {
     LogicValue waveforms[MAX_NODES][WAVEFORM_SAMPLES];
     double last_tick_time;
+    LogicStimulus stimulus;
+    LogicStimulusRun *playback; // NULL unless a stimulus is loaded; replaces plain ticks, rewound by a reset
+    LogicActivity *activity; // NULL unless the heatmap is on; counts simulation steps only
+    uint32_t activity_revision; // graph revision the counts belong to
     float speed;
     uint32_t waveform_index;
     bool active;
     uint8_t _padding[3];
 } AppSimulationState;
 
+// Everything one analysis pass produces lives in arenas[arena_index]. The
+// next pass builds into the other arena, so the previous results stay valid
+// until the pass after that starts and rewinds their arena in one step.
 typedef struct {
+    Arena arenas[2];
     TruthTable *truth_table;
     char *expression;
     char *simplified_expression;
     KMapGroup kmap_groups[MAX_KMAP_GROUPS];
     uint8_t kmap_group_count;
-    uint8_t _padding[7];
+    uint8_t arena_index;
+    uint8_t _padding[6];
 } AppAnalysisState;
 
 typedef struct {
     LogicGraph *target_graph;
     LogicNode *divergence_node;
+    LogicCompareTarget target; // Cached analysis of target_graph, refreshed when its revision changes
     AppCompareStatus status;
     bool equivalent;
-    uint8_t _padding[3];
+    uint8_t divergence_stuck_value; // divergence_node stuck at this value reproduces the target
+    uint8_t _padding[2];
     uint32_t first_failing_row;
+    uint32_t divergence_revision; // graph revision divergence_node was searched for; 0 when none
+    uint32_t divergence_target_revision; // target revision of that search
+    uint8_t _padding1[4];
 } AppComparisonState;
 
 typedef struct {
@@ -152,8 +180,18 @@ typedef struct {
     uint8_t count;
 } AppCommandQueue;
 
+// Running totals for the performance overlay, which samples them a few times
+// a second; nothing in the app reads them back.
+typedef struct {
+    uint64_t ticks; // simulation steps taken, clock ticks or stimulus samples
+    uint64_t tick_evaluations; // node evaluations spent inside those steps
+    double update_logic_seconds; // the last app_update_logic, truth table included
+    double truth_table_seconds;
+} AppPerfCounters;
+
 typedef struct {
     LogicGraph graph;
+    GraphGeometry geometry;
     AppMode mode;
     AppTool active_tool;
     AppCanvasState canvas;
@@ -164,6 +202,7 @@ typedef struct {
     AppSourceState source;
     AppInteractionState interaction;
     AppCommandQueue commands;
+    AppPerfCounters perf;
 } AppContext;
 
 #if defined(__clang__)
@@ -174,11 +213,17 @@ void app_init(AppContext *app);
 void app_update_logic(AppContext *app);
 LogicNode* app_add_node(AppContext *app, NodeType type, Vector2 pos);
 LogicNode* app_add_named_node(AppContext *app, NodeType type, const char *name, Vector2 pos);
+LogicNode* app_graph_add_node(LogicGraph *graph, GraphGeometry *geometry, NodeType type, const char *name, Vector2 pos);
+Vector2 app_node_position(const AppContext *app, const LogicNode *node);
+Rectangle app_node_rect(const AppContext *app, const LogicNode *node);
+void app_set_node_position(AppContext *app, const LogicNode *node, Vector2 pos);
 void app_set_mode(AppContext *app, AppMode mode);
 void app_set_tool(AppContext *app, AppTool tool);
 void app_set_panel_focus(AppContext *app, AppPanelFocus panel);
 void app_select_row(AppContext *app, uint32_t row_index);
 void app_clear_graph(AppContext *app);
+bool app_load_stimulus(AppContext *app, const char *path, char *error_message, size_t error_message_size);
+void app_clear_stimulus(AppContext *app);
 void app_set_source_path(AppContext *app, const char *path);
 void app_set_source_status(AppContext *app, const char *status);
 
@@ -1,5 +1,7 @@
 #include "app_analysis.h"
 #include "app_internal.h"
+#include "logic_fault.h"
+#include "logic_minimize.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -98,220 +100,262 @@ void app_compute_view_context(AppContext *app) {
     }
 }
 
+void app_release_compare_target(AppContext *app) {
+    if (!app) {
+        return;
+    }
+
+    logic_compare_target_release(&app->comparison.target);
+}
+
+// Faults times gates times 64-row blocks, roughly; past this the search would
+// stall the frame, so no node is blamed.
+#define APP_DIVERGENCE_MAX_WORK (1ULL << 26)
+
+// Blames the node whose stuck-at fault best reproduces the target's outputs.
+// Only possible for a fully connected combinational circuit. The netlist is
+// scratch in the current analysis arena, gone with the pass. The search runs
+// on the UI thread, so it runs once per pair of graph and target revisions
+// and is skipped for circuits too large to search within a frame.
+static void app_find_divergence_node(AppContext *app) {
+    LogicNetlist *netlist;
+    LogicFault fault;
+    uint64_t work;
+
+    if (app->comparison.divergence_revision == app->graph.revision &&
+        app->comparison.divergence_target_revision == app->comparison.target.graph_revision) {
+        return;
+    }
+    app->comparison.divergence_node = NULL;
+    app->comparison.divergence_revision = app->graph.revision;
+    app->comparison.divergence_target_revision = app->comparison.target.graph_revision;
+
+    netlist = (LogicNetlist *)arena_alloc(app_analysis_arena(app), sizeof(*netlist));
+    if (!netlist || !logic_netlist_compile(&app->graph, netlist)) {
+        return;
+    }
+    work = (uint64_t)netlist->signal_count * netlist->signal_count * ((app->analysis.truth_table->row_count + 63U) / 64U);
+    if (work <= APP_DIVERGENCE_MAX_WORK &&
+        netlist->input_count == app->analysis.truth_table->input_count &&
+        netlist->output_count == app->analysis.truth_table->output_count &&
+        logic_fault_explain(netlist, app->comparison.target.aligned_columns, app->analysis.truth_table->row_count, &fault, NULL)) {
+        app->comparison.divergence_node = netlist->signal_nodes[fault.signal];
+        app->comparison.divergence_stuck_value = fault.stuck_value;
+    }
+}
+
+static void app_clear_divergence(AppContext *app) {
+    app->comparison.divergence_node = NULL;
+    app->comparison.divergence_revision = 0U;
+    app->comparison.divergence_target_revision = 0U;
+}
+
 void app_compare_with_target(AppContext *app, LogicGraph *target) {
-    TruthTable *target_table;
-    uint32_t column_count;
-    uint32_t target_column_count;
-    uint32_t row_index;
-    uint8_t output_index;
+    LogicCompareResult result;
 
     app->comparison.target_graph = target;
     app->comparison.equivalent = true;
     app->comparison.status = APP_COMPARE_EQUIVALENT;
-    app->comparison.divergence_node = NULL;
     app->comparison.first_failing_row = 0U;
 
-    target_table = logic_generate_truth_table(target);
-    if (!target_table || !app->analysis.truth_table) {
-        if (target_table) {
-            logic_free_truth_table(target_table);
-        }
+    if (!logic_compare_target_refresh(&app->comparison.target, target)) {
         app->comparison.status = APP_COMPARE_NO_TARGET;
         app->comparison.equivalent = false;
+        app_clear_divergence(app);
         return;
     }
 
-    column_count = (uint32_t)app->analysis.truth_table->input_count + (uint32_t)app->analysis.truth_table->output_count;
-    target_column_count = (uint32_t)target_table->input_count + (uint32_t)target_table->output_count;
-
-    if (app->analysis.truth_table->input_count != target_table->input_count ||
-        app->analysis.truth_table->output_count != target_table->output_count) {
+    result = logic_compare_with_table(&app->comparison.target, app->analysis.truth_table, app->graph.revision);
+    if (!result.comparable) {
+        app->comparison.status = APP_COMPARE_NO_TARGET;
+        app->comparison.equivalent = false;
+        app_clear_divergence(app);
+        return;
+    }
+    if (!result.equivalent) {
         app->comparison.equivalent = false;
         app->comparison.status = APP_COMPARE_MISMATCH;
+        app->comparison.first_failing_row = result.first_failing_row;
+    }
+    if (!result.equivalent && result.shapes_match) {
+        app_find_divergence_node(app);
     } else {
-        for (row_index = 0U; row_index < app->analysis.truth_table->row_count; row_index++) {
-            bool row_matches;
-
-            row_matches = true;
-            for (output_index = 0U; output_index < app->analysis.truth_table->output_count; output_index++) {
-                if (app->analysis.truth_table->data[(row_index * column_count) + (uint32_t)app->analysis.truth_table->input_count + (uint32_t)output_index] !=
-                    target_table->data[(row_index * target_column_count) + (uint32_t)target_table->input_count + (uint32_t)output_index]) {
-                    row_matches = false;
-                    break;
-                }
-            }
-            if (!row_matches) {
-                app->comparison.equivalent = false;
-                app->comparison.status = APP_COMPARE_MISMATCH;
-                app->comparison.first_failing_row = row_index;
-                break;
-            }
-        }
+        app_clear_divergence(app);
     }
-
-    logic_free_truth_table(target_table);
 }
 
 void app_compare_if_needed(AppContext *app) {
     if (!app->comparison.target_graph) {
         app->comparison.equivalent = false;
         app->comparison.status = APP_COMPARE_NO_TARGET;
-        app->comparison.divergence_node = NULL;
         app->comparison.first_failing_row = 0U;
+        app_clear_divergence(app);
         return;
     }
 
     app_compare_with_target(app, app->comparison.target_graph);
 }
 
-char *app_get_node_explanation(AppContext *app, LogicNode *node) {
-    char *buffer;
+void app_analysis_begin_pass(AppContext *app) {
+    app->analysis.arena_index ^= 1U;
+    arena_reset(&app->analysis.arenas[app->analysis.arena_index]);
+    app->analysis.truth_table = NULL;
+    app->analysis.expression = NULL;
+    app->analysis.simplified_expression = NULL;
+}
+
+Arena *app_analysis_arena(AppContext *app) {
+    return &app->analysis.arenas[app->analysis.arena_index];
+}
+
+bool app_get_node_explanation(const LogicNode *node, char *buffer, size_t buffer_size) {
     LogicValue output_value;
     const char *output_text;
 
-    (void)app;
-    if (!node || node->type == (NodeType)-1) {
-        return NULL;
+    if (!buffer || buffer_size == 0U) {
+        return false;
     }
-
-    buffer = (char *)calloc(256U, sizeof(char));
-    if (!buffer) {
-        return NULL;
+    buffer[0] = '\0';
+    if (!node || node->type == (NodeType)-1) {
+        return false;
     }
 
     output_value = (node->output_count > 0U) ? node->outputs[0].value : node->inputs[0].value;
     output_text = (output_value == LOGIC_HIGH) ? "1" : "0";
 
     if (node->type == NODE_GATE_AND) {
-        snprintf(buffer, 256U, (output_value == LOGIC_HIGH)
+        snprintf(buffer, buffer_size, (output_value == LOGIC_HIGH)
             ? "Output is 1 because all inputs are 1."
             : "Output is 0 because at least one input is 0.");
     } else if (node->type == NODE_GATE_OR) {
-        snprintf(buffer, 256U, (output_value == LOGIC_HIGH)
+        snprintf(buffer, buffer_size, (output_value == LOGIC_HIGH)
             ? "Output is 1 because at least one input is 1."
             : "Output is 0 because all inputs are 0.");
     } else if (node->type == NODE_GATE_NOT) {
-        snprintf(buffer, 256U, "NOT gate inverts input to %s.", output_text);
+        snprintf(buffer, buffer_size, "NOT gate inverts input to %s.", output_text);
     } else if (node->type == NODE_GATE_DFF) {
         if (output_value == LOGIC_ERROR) {
-            snprintf(buffer, 256U, "POSSIBLE RACE CONDITION: Input D changed at the exact same tick as the rising edge of CLK.");
+            snprintf(buffer, buffer_size, "POSSIBLE RACE CONDITION: Input D changed at the exact same tick as the rising edge of CLK.");
         } else {
-            snprintf(buffer, 256U, "DFF stores state %s (latched on rising edge of CLK).", output_text);
+            snprintf(buffer, buffer_size, "DFF stores state %s (latched on rising edge of CLK).", output_text);
         }
     } else if (node->type == NODE_GATE_CLOCK) {
-        snprintf(buffer, 256U, "Clock toggles on every tick.");
+        snprintf(buffer, buffer_size, "Clock toggles on every tick.");
     } else if (node->type == NODE_INPUT) {
-        snprintf(buffer, 256U, "Input node fixed at %s.", output_text);
+        snprintf(buffer, buffer_size, "Input node fixed at %s.", output_text);
     } else if (node->type == NODE_OUTPUT) {
-        snprintf(buffer, 256U, "Output reflects its incoming pin %s.", output_text);
+        snprintf(buffer, buffer_size, "Output reflects its incoming pin %s.", output_text);
     } else if (node->type == NODE_GATE_XOR) {
-        snprintf(buffer, 256U, "XOR gate outputs 1 if inputs differ.");
+        snprintf(buffer, buffer_size, "XOR gate outputs 1 if inputs differ.");
     } else if (node->type == NODE_GATE_NAND) {
-        snprintf(buffer, 256U, "NAND gate outputs 0 only if all inputs are 1.");
+        snprintf(buffer, buffer_size, "NAND gate outputs 0 only if all inputs are 1.");
     } else if (node->type == NODE_GATE_NOR) {
-        snprintf(buffer, 256U, "NOR gate outputs 1 only if all inputs are 0.");
+        snprintf(buffer, buffer_size, "NOR gate outputs 1 only if all inputs are 0.");
     } else if (node->type == NODE_GATE_LATCH) {
-        snprintf(buffer, 256U, "LATCH stores state while enabled.");
+        snprintf(buffer, buffer_size, "LATCH stores state while enabled.");
+    }
+
+    return buffer[0] != '\0';
+}
+
+static char *app_format_output_covers(const TruthTable *table, const LogicCover *covers, Arena *arena) {
+    char *buffer;
+    size_t length;
+    size_t written;
+    uint8_t output_index;
+
+    length = 1U;
+    for (output_index = 0U; output_index < table->output_count; output_index++) {
+        if (table->output_count > 1U) {
+            length += strlen(table->outputs[output_index]->name ? table->outputs[output_index]->name : "?") + 4U;
+        }
+        length += logic_cover_format(&covers[output_index], table->inputs, table->input_count, NULL, 0U) + 1U;
+    }
+
+    buffer = (char *)arena_alloc(arena, length);
+    if (!buffer) {
+        return NULL;
+    }
+
+    written = 0U;
+    for (output_index = 0U; output_index < table->output_count; output_index++) {
+        if (output_index > 0U) {
+            buffer[written++] = '\n';
+        }
+        if (table->output_count > 1U) {
+            written += (size_t)snprintf(
+                buffer + written,
+                length - written,
+                "%s = ",
+                table->outputs[output_index]->name ? table->outputs[output_index]->name : "?"
+            );
+        }
+        written += logic_cover_format(&covers[output_index], table->inputs, table->input_count, buffer + written, length - written);
     }
 
     return buffer;
 }
 
+// Minimizes every output; K-map groups are only kept for the first output of a
+// 2-4 input circuit, which is what the side panel draws.
 void app_update_kmap_grouping(AppContext *app) {
     static const Color colors[] = {
         { 255, 0, 0, 100 },
         { 0, 255, 0, 100 },
         { 0, 0, 255, 100 },
-        { 255, 165, 0, 100 }
+        { 255, 165, 0, 100 },
+        { 255, 0, 255, 100 },
+        { 0, 255, 255, 100 },
+        { 255, 255, 0, 100 },
+        { 160, 120, 255, 100 }
     };
-    static const uint8_t groups2_masks[] = { 0x5U, 0xAU, 0x3U, 0xCU };
-    static const char *groups2_terms[] = { "B'", "B", "A'", "A" };
-    static const char *groups1_terms[] = { "A'B'", "A'B", "AB'", "AB" };
-    char buffer[256];
-    uint32_t column_count;
-    uint32_t table_bits;
-    uint32_t index;
-    uint8_t covered;
+    LogicCover *covers;
+    const TruthTable *table;
+    uint32_t cube_index;
+    uint8_t output_index;
 
     app->analysis.kmap_group_count = 0U;
-    free(app->analysis.simplified_expression);
     app->analysis.simplified_expression = NULL;
-    memset(buffer, 0, sizeof(buffer));
 
-    if (!app->analysis.truth_table || app->analysis.truth_table->input_count != 2U) {
+    table = app->analysis.truth_table;
+    if (!table || table->output_count == 0U) {
         return;
     }
 
-    column_count = (uint32_t)app->analysis.truth_table->input_count + (uint32_t)app->analysis.truth_table->output_count;
-    table_bits = 0U;
-    covered = 0U;
-    for (index = 0U; index < 4U; index++) {
-        uint32_t cell_index;
-
-        cell_index = (index * column_count) + 2U;
-        if (app->analysis.truth_table->data[cell_index] == LOGIC_HIGH) {
-            table_bits |= (1U << index);
-        }
-    }
-
-    if (table_bits == 0U) {
-        app->analysis.simplified_expression = strdup("0");
+    covers = (LogicCover *)arena_alloc(app_analysis_arena(app), table->output_count * sizeof(*covers));
+    if (!covers) {
         return;
     }
-    if (table_bits == 0xFU) {
-        KMapGroup *group;
-
-        group = &app->analysis.kmap_groups[app->analysis.kmap_group_count++];
-        group->cell_mask = 0xFU;
-        strcpy(group->term, "1");
-        group->color = colors[0];
-        app->analysis.simplified_expression = strdup("1");
-        return;
-    }
-
-    for (index = 0U; index < 4U; index++) {
-        uint32_t uncovered_mask;
+    for (output_index = 0U; output_index < table->output_count; output_index++) {
+        TruthColumn column;
 
-        if ((table_bits & groups2_masks[index]) != groups2_masks[index]) {
-            continue;
-        }
-
-        uncovered_mask = table_bits & (uint32_t)groups2_masks[index] & (uint32_t)(uint8_t)(~covered);
-        if (uncovered_mask != 0U) {
-            KMapGroup *group;
-
-            group = &app->analysis.kmap_groups[app->analysis.kmap_group_count++];
-            group->cell_mask = groups2_masks[index];
-            strcpy(group->term, groups2_terms[index]);
-            group->color = colors[app->analysis.kmap_group_count % 4U];
-            covered = (uint8_t)(covered | groups2_masks[index]);
+        logic_truth_table_pack_column(table, (uint32_t)table->input_count + (uint32_t)output_index, &column);
+        if (!logic_minimize_column(&column, table->input_count, &covers[output_index])) {
+            return;
         }
     }
+    app->analysis.simplified_expression = app_format_output_covers(table, covers, app_analysis_arena(app));
 
-    for (index = 0U; index < 4U; index++) {
-        uint8_t cell_mask;
-
-        cell_mask = (uint8_t)(1U << index);
-        if ((table_bits & (uint32_t)cell_mask) == 0U || (covered & cell_mask) != 0U) {
-            continue;
-        }
-
-        {
+    if (table->input_count >= 2U && table->input_count <= 4U && covers[0].cube_count <= MAX_KMAP_GROUPS) {
+        for (cube_index = 0U; cube_index < covers[0].cube_count; cube_index++) {
             KMapGroup *group;
+            LogicCover single;
+            uint32_t row;
+
+            group = &app->analysis.kmap_groups[app->analysis.kmap_group_count];
+            memset(group, 0, sizeof(*group));
+            for (row = 0U; row < table->row_count; row++) {
+                if ((row & covers[0].cubes[cube_index].care) == covers[0].cubes[cube_index].value) {
+                    group->cell_mask = (uint16_t)(group->cell_mask | (1U << row));
+                }
+            }
 
-            group = &app->analysis.kmap_groups[app->analysis.kmap_group_count++];
-            group->cell_mask = cell_mask;
-            strcpy(group->term, groups1_terms[index]);
-            group->color = colors[app->analysis.kmap_group_count % 4U];
-            covered = (uint8_t)(covered | cell_mask);
-        }
-    }
-
-    for (index = 0U; index < app->analysis.kmap_group_count; index++) {
-        if (index > 0U) {
-            strcat(buffer, " OR ");
+            memset(&single, 0, sizeof(single));
+            single.cubes[0] = covers[0].cubes[cube_index];
+            single.cube_count = 1U;
+            logic_cover_format(&single, table->inputs, table->input_count, group->term, sizeof(group->term));
+            group->color = colors[app->analysis.kmap_group_count % (sizeof(colors) / sizeof(colors[0]))];
+            app->analysis.kmap_group_count++;
         }
-        strcat(buffer, app->analysis.kmap_groups[index].term);
     }
-    app->analysis.simplified_expression = strdup(buffer);
 }
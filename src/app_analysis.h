@@ -5,9 +5,13 @@
 
 void app_update_kmap_grouping(AppContext *app);
 void app_compare_with_target(AppContext *app, LogicGraph *target);
+void app_release_compare_target(AppContext *app);
 void app_compute_view_context(AppContext *app);
 void app_apply_selected_row_to_inputs(AppContext *app);
 bool app_toggle_input_value(AppContext *app, LogicNode *node);
-char* app_get_node_explanation(AppContext *app, LogicNode *node);
+// Writes why `node` shows its current value into `buffer`, which the caller
+// owns, so it can be asked every frame. False, with an empty buffer, for a
+// deleted node or a type with nothing to say.
+bool app_get_node_explanation(const LogicNode *node, char *buffer, size_t buffer_size);
 
 #endif // APP_ANALYSIS_H
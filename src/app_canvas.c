@@ -68,17 +68,20 @@ void app_node_dimensions(NodeType type, int *width, int *height) {
 float app_node_pin_offset_y(const LogicNode *node, bool is_output_pin, uint8_t pin_index) {
     uint8_t pin_count;
     float pitch;
+    int width;
+    int height;
 
     if (!node) {
         return 0.0f;
     }
 
+    app_node_dimensions(node->type, &width, &height);
     pin_count = is_output_pin ? node->output_count : node->input_count;
     if (pin_count <= 1U) {
-        return node->rect.height * 0.5f;
+        return (float)height * 0.5f;
     }
 
-    pitch = (node->rect.height - (APP_GRID_SIZE * 2.0f)) / (float)(pin_count - 1U);
+    pitch = ((float)height - (APP_GRID_SIZE * 2.0f)) / (float)(pin_count - 1U);
     return APP_GRID_SIZE + ((float)pin_index * pitch);
 }
 
@@ -159,9 +162,9 @@ Vector2 app_snap_live_node_position(const AppContext *app, const LogicNode *node
                     continue;
                 }
 
-                candidate_y = sink_pin->node->pos.y + app_node_pin_offset_y(sink_pin->node, false, sink_pin->index) - source_offset;
+                candidate_y = app_node_position(app, sink_pin->node).y + app_node_pin_offset_y(sink_pin->node, false, sink_pin->index) - source_offset;
                 app_consider_vertical_alignment(candidate_y, position.y, &best_y, &best_distance);
-                output_pin_sum_y += sink_pin->node->pos.y + app_node_pin_offset_y(sink_pin->node, false, sink_pin->index);
+                output_pin_sum_y += app_node_position(app, sink_pin->node).y + app_node_pin_offset_y(sink_pin->node, false, sink_pin->index);
                 output_offset_sum += source_offset;
                 output_alignment_count++;
             }
@@ -181,11 +184,11 @@ Vector2 app_snap_live_node_position(const AppContext *app, const LogicNode *node
             }
 
             candidate_y =
-                net->source->node->pos.y +
+                app_node_position(app, net->source->node).y +
                 app_node_pin_offset_y(net->source->node, true, net->source->index) -
                 app_node_pin_offset_y(node, false, sink_pin->index);
             app_consider_vertical_alignment(candidate_y, position.y, &best_y, &best_distance);
-            input_pin_sum_y += net->source->node->pos.y + app_node_pin_offset_y(net->source->node, true, net->source->index);
+            input_pin_sum_y += app_node_position(app, net->source->node).y + app_node_pin_offset_y(net->source->node, true, net->source->index);
             input_offset_sum += app_node_pin_offset_y(node, false, sink_pin->index);
             input_alignment_count++;
         }
@@ -303,31 +306,33 @@ bool app_frame_graph_in_canvas(AppContext *app, Rectangle canvas_rect) {
     max_y = 0.0f;
     for (node_index = 0U; node_index < app->graph.node_count; node_index++) {
         LogicNode *node;
+        Rectangle rect;
 
         node = &app->graph.nodes[node_index];
         if (node->type == (NodeType)-1) {
             continue;
         }
+        rect = app_node_rect(app, node);
         if (!found_node) {
-            min_x = node->rect.x;
-            min_y = node->rect.y;
-            max_x = node->rect.x + node->rect.width;
-            max_y = node->rect.y + node->rect.height;
+            min_x = rect.x;
+            min_y = rect.y;
+            max_x = rect.x + rect.width;
+            max_y = rect.y + rect.height;
             found_node = true;
             continue;
         }
 
-        if (node->rect.x < min_x) {
-            min_x = node->rect.x;
+        if (rect.x < min_x) {
+            min_x = rect.x;
         }
-        if (node->rect.y < min_y) {
-            min_y = node->rect.y;
+        if (rect.y < min_y) {
+            min_y = rect.y;
         }
-        if (node->rect.x + node->rect.width > max_x) {
-            max_x = node->rect.x + node->rect.width;
+        if (rect.x + rect.width > max_x) {
+            max_x = rect.x + rect.width;
         }
-        if (node->rect.y + node->rect.height > max_y) {
-            max_y = node->rect.y + node->rect.height;
+        if (rect.y + rect.height > max_y) {
+            max_y = rect.y + rect.height;
         }
     }
 
@@ -2,7 +2,11 @@
 #include "app_analysis.h"
 #include "app_canvas.h"
 #include "app_internal.h"
+#include "logic_activity.h"
+#include "mem.h"
 #include "raylib.h"
+#include "trace.h"
+#include <stdlib.h>
 #include <string.h>
 
 bool app_pin_is_input(const LogicPin *pin) {
@@ -101,9 +105,46 @@ bool app_delete_selected_wire(AppContext *app) {
     return true;
 }
 
+// One simulation step: the next stimulus sample while one is loaded,
+// otherwise a clock tick. Playback stops the run when the stimulus ends and
+// keeps it loaded, so a reset plays it again.
+static void app_advance_simulation(AppContext *app) {
+    uint64_t evaluations;
+    uint32_t produced;
+
+    // Counts from before an edit describe a different circuit.
+    if (app->simulation.activity && app->simulation.activity_revision != app->graph.revision) {
+        logic_activity_reset(app->simulation.activity, LOGIC_ACTIVITY_SAMPLE_INTERVAL);
+        app->simulation.activity_revision = app->graph.revision;
+    }
+    evaluations = app->graph.node_evaluations;
+    logic_activity_attach(&app->graph, app->simulation.activity);
+    if (!app->simulation.playback) {
+        TRACE_BEGIN("logic_tick");
+        logic_tick(&app->graph);
+        TRACE_END();
+        logic_activity_attach(&app->graph, NULL);
+        app->perf.ticks++;
+        app->perf.tick_evaluations += app->graph.node_evaluations - evaluations;
+        app_record_waveforms(app);
+        return;
+    }
+
+    produced = logic_apply_stimulus_batch(app->simulation.playback, NULL, 1U);
+    logic_activity_attach(&app->graph, NULL);
+    app->perf.ticks += produced;
+    app->perf.tick_evaluations += app->graph.node_evaluations - evaluations;
+    if (produced > 0U) {
+        app_record_waveforms(app);
+    }
+    if (logic_stimulus_run_done(app->simulation.playback)) {
+        app->simulation.active = false;
+        app_set_source_status(app, "Stimulus finished");
+    }
+}
+
 void app_step_simulation(AppContext *app) {
-    logic_tick(&app->graph);
-    app_record_waveforms(app);
+    app_advance_simulation(app);
     app->simulation.last_tick_time = GetTime();
 }
 
@@ -116,10 +157,36 @@ void app_reset_simulation(AppContext *app) {
     app->simulation.last_tick_time = 0.0;
     app->simulation.waveform_index = 0U;
     memset(app->simulation.waveforms, 0, sizeof(app->simulation.waveforms));
+    if (app->simulation.playback) {
+        logic_stimulus_run_init(app->simulation.playback, &app->graph, &app->simulation.stimulus);
+    }
+    if (app->simulation.activity) {
+        logic_activity_reset(app->simulation.activity, LOGIC_ACTIVITY_SAMPLE_INTERVAL);
+    }
     logic_evaluate(&app->graph);
     app_compute_view_context(app);
 }
 
+// Recording only while the heatmap is shown keeps plain simulation free of
+// the per-node bookkeeping.
+void app_toggle_heatmap(AppContext *app) {
+    if (app->simulation.activity) {
+        mem_free(app->simulation.activity);
+        app->simulation.activity = NULL;
+        app_set_source_status(app, "Heatmap off");
+        return;
+    }
+
+    app->simulation.activity = (LogicActivity *)mem_alloc(MEM_TAG_SIMULATION, sizeof(*app->simulation.activity));
+    if (!app->simulation.activity) {
+        app_set_source_status(app, "Heatmap failed: out of memory");
+        return;
+    }
+    logic_activity_reset(app->simulation.activity, LOGIC_ACTIVITY_SAMPLE_INTERVAL);
+    app->simulation.activity_revision = app->graph.revision;
+    app_set_source_status(app, "Heatmap on: gates warm up as they toggle while the simulation runs");
+}
+
 void app_update_simulation(AppContext *app) {
     double now;
     double interval;
@@ -134,9 +201,8 @@ void app_update_simulation(AppContext *app) {
         app->simulation.last_tick_time = now;
     }
 
-    while ((now - app->simulation.last_tick_time) >= interval) {
-        logic_tick(&app->graph);
-        app_record_waveforms(app);
+    while (app->simulation.active && (now - app->simulation.last_tick_time) >= interval) {
+        app_advance_simulation(app);
         app->simulation.last_tick_time += interval;
     }
 }
@@ -216,19 +282,16 @@ bool app_select_next_node(AppContext *app, int direction) {
 }
 
 bool app_move_selected_node(AppContext *app, int grid_dx, int grid_dy) {
-    Vector2 moved_position;
+    Vector2 position;
 
     if (!app || !app->selection.selected_node) {
         return false;
     }
 
-    moved_position = (Vector2){
-        app->selection.selected_node->pos.x + ((float)grid_dx * APP_GRID_SIZE),
-        app->selection.selected_node->pos.y + ((float)grid_dy * APP_GRID_SIZE)
-    };
-    app->selection.selected_node->pos = app_snap_live_node_position(app, app->selection.selected_node, moved_position);
-    app->selection.selected_node->rect.x = app->selection.selected_node->pos.x;
-    app->selection.selected_node->rect.y = app->selection.selected_node->pos.y;
+    position = app_node_position(app, app->selection.selected_node);
+    position.x += (float)grid_dx * APP_GRID_SIZE;
+    position.y += (float)grid_dy * APP_GRID_SIZE;
+    app_set_node_position(app, app->selection.selected_node, app_snap_live_node_position(app, app->selection.selected_node, position));
     app->selection.focused_panel = APP_PANEL_CANVAS;
     return true;
 }
@@ -496,6 +559,9 @@ void app_handle_command(AppContext *app, EditorCommand command) {
                 app_select_row(app, app->selection.selected_row + 1U);
             }
             break;
+        case EDITOR_COMMAND_TOGGLE_HEATMAP:
+            app_toggle_heatmap(app);
+            break;
         case EDITOR_COMMAND_NONE:
         default:
             break;
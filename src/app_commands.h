@@ -10,6 +10,7 @@ void app_cancel_interaction(AppContext *app);
 void app_step_simulation(AppContext *app);
 void app_update_simulation(AppContext *app);
 void app_reset_simulation(AppContext *app);
+void app_toggle_heatmap(AppContext *app);
 bool app_delete_selected_node(AppContext *app);
 bool app_delete_selected_wire(AppContext *app);
 void app_select_wire_by_sink(AppContext *app, LogicPin *sink);
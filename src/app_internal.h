@@ -9,5 +9,8 @@ bool app_sink_has_connection(const AppContext *app, const LogicPin *pin);
 LogicNode *app_primary_output_node(AppContext *app);
 void app_record_waveforms(AppContext *app);
 void app_compare_if_needed(AppContext *app);
+// Switches to the other analysis arena and rewinds it for a new pass.
+void app_analysis_begin_pass(AppContext *app);
+Arena *app_analysis_arena(AppContext *app);
 
 #endif // APP_INTERNAL_H
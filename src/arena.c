@@ -0,0 +1,90 @@
+#include "arena.h"
+#include <string.h>
+
+#define ARENA_ALIGNMENT 16U
+
+struct ArenaBlock {
+    ArenaBlock *next;
+    size_t size;
+    size_t used;
+    size_t dirty; // most bytes ever handed out; reused bytes below this need zeroing
+};
+
+static size_t arena_align(size_t size) {
+    return (size + (ARENA_ALIGNMENT - 1U)) & ~(size_t)(ARENA_ALIGNMENT - 1U);
+}
+
+void arena_init(Arena *arena, size_t block_size, MemTag tag) {
+    memset(arena, 0, sizeof(*arena));
+    arena->block_size = block_size;
+    arena->tag = tag;
+}
+
+// Returns NULL only when the system is out of memory.
+void *arena_alloc(Arena *arena, size_t size) {
+    ArenaBlock *block;
+    uint8_t *memory;
+
+    size = arena_align(size > 0U ? size : 1U);
+    block = arena->head;
+    if (!block || block->size - block->used < size) {
+        size_t block_size;
+
+        block_size = size > arena->block_size ? size : arena->block_size;
+        // calloc keeps large blocks lazily zeroed by the OS.
+        block = (ArenaBlock *)mem_calloc(arena->tag, 1U, sizeof(ArenaBlock) + block_size);
+        if (!block) {
+            return NULL;
+        }
+        block->size = block_size;
+        block->next = arena->head;
+        arena->head = block;
+    }
+
+    // Bytes below `dirty` were handed out before a reset; zero them here so
+    // the reset itself does not have to.
+    memory = (uint8_t *)(block + 1) + block->used;
+    if (block->used < block->dirty) {
+        memset(memory, 0, block->dirty - block->used < size ? block->dirty - block->used : size);
+    }
+    block->used += size;
+    if (block->used > block->dirty) {
+        block->dirty = block->used;
+    }
+    arena->used += size;
+    return memory;
+}
+
+void arena_reset(Arena *arena) {
+    ArenaBlock *block;
+
+    block = arena->head;
+    if (!block) {
+        return;
+    }
+    if (block->next) {
+        if (arena->used > arena->block_size) {
+            arena->block_size = arena->used;
+        }
+        arena_release(arena);
+        return;
+    }
+
+    block->used = 0U;
+    arena->used = 0U;
+}
+
+void arena_release(Arena *arena) {
+    ArenaBlock *block;
+
+    block = arena->head;
+    while (block) {
+        ArenaBlock *next;
+
+        next = block->next;
+        mem_free(block);
+        block = next;
+    }
+    arena->head = NULL;
+    arena->used = 0U;
+}
@@ -0,0 +1,29 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "mem.h"
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+// Bump allocator for scratch that shares one lifetime. Allocations are zeroed
+// and 16-byte aligned; nothing is freed until arena_release.
+typedef struct {
+    ArenaBlock *head; // newest block; older blocks hang off it
+    size_t block_size; // minimum size of each new block
+    size_t used; // bytes handed out so far, including alignment
+    MemTag tag; // blocks are accounted to this subsystem
+    uint8_t _padding[4];
+} Arena;
+
+void arena_init(Arena *arena, size_t block_size, MemTag tag);
+void *arena_alloc(Arena *arena, size_t size);
+// Drops everything allocated so far but keeps memory for reuse. One block is
+// rewound in O(1) and its bytes are zeroed again as arena_alloc hands them
+// out; several are freed and the next block grows to hold them, so after the
+// first large pass every reset is a rewind.
+void arena_reset(Arena *arena);
+void arena_release(Arena *arena);
+
+#endif // ARENA_H
@@ -0,0 +1,585 @@
+#include "batch_grade.h"
+#include "circuit_file.h"
+#include "logic_compare.h"
+#include "mem.h"
+#include "text_util.h"
+#include "trace.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// Workers recurse through the topological sort, so do not rely on the
+// platform's (sometimes 512 KiB) default secondary-thread stack.
+#define BATCH_GRADE_STACK_SIZE (4U * 1024U * 1024U)
+#define BATCH_GRADE_MAX_JOBS 64U
+
+typedef struct {
+    const BatchGradeOptions *options;
+    const LogicCompareTarget *reference;
+    BatchGradeResult *results;
+    pthread_mutex_t lock;
+    uint32_t next_index;
+    uint8_t _padding[4];
+} BatchGradeQueue;
+
+typedef struct {
+    char **items;
+    uint32_t count;
+    uint32_t capacity;
+} BatchGradePathList;
+
+static double batch_grade_now_ms(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((double)now.tv_sec * 1000.0) + ((double)now.tv_nsec / 1000000.0);
+}
+
+static void batch_grade_append(char *buffer, size_t buffer_size, size_t *length, const char *text) {
+    int written;
+
+    if (*length >= buffer_size) {
+        return;
+    }
+    written = snprintf(buffer + *length, buffer_size - *length, "%s", text);
+    if (written > 0) {
+        *length += (size_t)written;
+    }
+}
+
+static char batch_grade_value_char(LogicValue value) {
+    switch (value) {
+        case LOGIC_LOW:
+            return '0';
+        case LOGIC_HIGH:
+            return '1';
+        case LOGIC_UNKNOWN:
+            return 'X';
+        case LOGIC_ERROR:
+            return 'E';
+        default:
+            return '?';
+    }
+}
+
+// Formats the failing row as "A=0 B=1 -> Z=1 (expected 0)", listing only the
+// outputs that disagree with the reference.
+static void batch_grade_describe_row(const LogicCompareTarget *reference, const TruthTable *table, uint32_t row, char *buffer, size_t buffer_size) {
+    const LogicValue *values;
+    uint32_t column_count;
+    size_t length;
+    uint8_t index;
+
+    length = 0U;
+    buffer[0] = '\0';
+    column_count = (uint32_t)table->input_count + (uint32_t)table->output_count;
+    values = &table->data[row * column_count];
+    for (index = 0U; index < table->input_count; index++) {
+        char cell[48];
+
+        snprintf(
+            cell,
+            sizeof(cell),
+            "%s%s=%c",
+            index == 0U ? "" : " ",
+            table->inputs[index]->name ? table->inputs[index]->name : "?",
+            batch_grade_value_char(values[index])
+        );
+        batch_grade_append(buffer, buffer_size, &length, cell);
+    }
+
+    batch_grade_append(buffer, buffer_size, &length, " ->");
+    for (index = 0U; index < table->output_count; index++) {
+        LogicValue actual;
+        LogicValue expected;
+        char cell[64];
+
+        actual = values[table->input_count + index];
+        expected = logic_compare_expected_value(reference, index, row);
+        if (actual == expected) {
+            continue;
+        }
+        snprintf(
+            cell,
+            sizeof(cell),
+            " %s=%c (expected %c)",
+            table->outputs[index]->name ? table->outputs[index]->name : "?",
+            batch_grade_value_char(actual),
+            batch_grade_value_char(expected)
+        );
+        batch_grade_append(buffer, buffer_size, &length, cell);
+    }
+}
+
+static void batch_grade_candidate(LogicGraph *graph, LogicCompareTarget *reference, const char *path, BatchGradeResult *result) {
+    LogicCompareResult compare;
+    TruthTable *table;
+    double started;
+    double loaded;
+
+    memset(result, 0, sizeof(*result));
+    result->path = path;
+    result->status = BATCH_GRADE_ERROR;
+
+    started = batch_grade_now_ms();
+    if (!circuit_file_load_graph(graph, path, result->detail, sizeof(result->detail))) {
+        result->load_ms = batch_grade_now_ms() - started;
+        return;
+    }
+    loaded = batch_grade_now_ms();
+    result->load_ms = loaded - started;
+
+    table = logic_generate_truth_table(graph);
+    if (!table) {
+        snprintf(result->detail, sizeof(result->detail), "out of memory");
+        return;
+    }
+    logic_compare_target_invalidate_alignment(reference);
+    compare = logic_compare_with_table(reference, table, graph->revision);
+    if (!compare.comparable) {
+        snprintf(result->detail, sizeof(result->detail), "circuit has no inputs or outputs to compare");
+    } else if (!compare.shapes_match) {
+        result->status = BATCH_GRADE_SHAPE_MISMATCH;
+        snprintf(
+            result->detail,
+            sizeof(result->detail),
+            "expected %u inputs / %u outputs, found %u / %u",
+            (unsigned int)reference->table->input_count,
+            (unsigned int)reference->table->output_count,
+            (unsigned int)table->input_count,
+            (unsigned int)table->output_count
+        );
+    } else if (!compare.equivalent) {
+        result->status = BATCH_GRADE_MISMATCH;
+        result->first_failing_row = compare.first_failing_row;
+        batch_grade_describe_row(reference, table, compare.first_failing_row, result->detail, sizeof(result->detail));
+    } else {
+        result->status = BATCH_GRADE_EQUIVALENT;
+    }
+
+    logic_free_truth_table(table);
+    result->check_ms = batch_grade_now_ms() - loaded;
+}
+
+static bool batch_grade_next_index(BatchGradeQueue *queue, uint32_t *index) {
+    bool has_work;
+
+    pthread_mutex_lock(&queue->lock);
+    *index = queue->next_index;
+    has_work = *index < queue->options->candidate_count;
+    if (has_work) {
+        queue->next_index++;
+    }
+    pthread_mutex_unlock(&queue->lock);
+    return has_work;
+}
+
+static void *batch_grade_worker(void *context) {
+    BatchGradeQueue *queue;
+    LogicCompareTarget reference;
+    LogicGraph *graph;
+    uint32_t index;
+
+    queue = (BatchGradeQueue *)context;
+    graph = (LogicGraph *)mem_calloc(MEM_TAG_GRAPH, 1U, sizeof(*graph));
+    if (!graph) {
+        return NULL;
+    }
+    logic_init_graph(graph);
+
+    // Each worker owns its alignment state; the reference table and packed
+    // columns are shared read-only.
+    reference = *queue->reference;
+    while (batch_grade_next_index(queue, &index)) {
+        TRACE_BEGIN("batch_grade_candidate");
+        batch_grade_candidate(graph, &reference, queue->options->candidate_paths[index], &queue->results[index]);
+        TRACE_END();
+    }
+
+    logic_clear_graph(graph);
+    mem_free(graph);
+    return NULL;
+}
+
+static uint32_t batch_grade_job_count(const BatchGradeOptions *options) {
+    uint32_t jobs;
+    long online;
+
+    jobs = options->jobs;
+    if (jobs == 0U) {
+        online = sysconf(_SC_NPROCESSORS_ONLN);
+        jobs = online > 0 ? (uint32_t)online : 1U;
+    }
+    if (jobs > BATCH_GRADE_MAX_JOBS) {
+        jobs = BATCH_GRADE_MAX_JOBS;
+    }
+    if (jobs > options->candidate_count) {
+        jobs = options->candidate_count;
+    }
+    return jobs == 0U ? 1U : jobs;
+}
+
+bool batch_grade_run(const BatchGradeOptions *options, BatchGradeResult *results, char *error_message, size_t error_message_size) {
+    pthread_t threads[BATCH_GRADE_MAX_JOBS];
+    pthread_attr_t attributes;
+    BatchGradeQueue queue;
+    LogicCompareTarget reference;
+    LogicGraph *reference_graph;
+    char load_error[BATCH_GRADE_DETAIL_MAX];
+    uint32_t jobs;
+    uint32_t started;
+    uint32_t index;
+
+    if (!options || !options->reference_path || (!results && options->candidate_count > 0U)) {
+        snprintf(error_message, error_message_size, "missing reference or result buffer");
+        return false;
+    }
+
+    reference_graph = (LogicGraph *)mem_calloc(MEM_TAG_GRAPH, 1U, sizeof(*reference_graph));
+    if (!reference_graph) {
+        snprintf(error_message, error_message_size, "out of memory");
+        return false;
+    }
+    logic_init_graph(reference_graph);
+    memset(&reference, 0, sizeof(reference));
+    if (!circuit_file_load_graph(reference_graph, options->reference_path, load_error, sizeof(load_error))) {
+        snprintf(error_message, error_message_size, "%s: %s", options->reference_path, load_error);
+        mem_free(reference_graph);
+        return false;
+    }
+    if (!logic_compare_target_refresh(&reference, reference_graph)) {
+        snprintf(error_message, error_message_size, "%s: reference has no inputs or outputs to compare", options->reference_path);
+        logic_compare_target_release(&reference);
+        logic_clear_graph(reference_graph);
+        mem_free(reference_graph);
+        return false;
+    }
+
+    // A slot a worker never reaches (it could not allocate its graph) must
+    // not read as a pass.
+    for (index = 0U; index < options->candidate_count; index++) {
+        memset(&results[index], 0, sizeof(results[index]));
+        results[index].path = options->candidate_paths[index];
+        results[index].status = BATCH_GRADE_ERROR;
+        snprintf(results[index].detail, sizeof(results[index].detail), "not graded: out of memory");
+    }
+
+    memset(&queue, 0, sizeof(queue));
+    queue.options = options;
+    queue.reference = &reference;
+    queue.results = results;
+    pthread_mutex_init(&queue.lock, NULL);
+
+    jobs = batch_grade_job_count(options);
+    started = 0U;
+    pthread_attr_init(&attributes);
+    pthread_attr_setstacksize(&attributes, BATCH_GRADE_STACK_SIZE);
+    for (index = 0U; index + 1U < jobs; index++) {
+        if (pthread_create(&threads[index], &attributes, batch_grade_worker, &queue) != 0) {
+            break;
+        }
+        started++;
+    }
+    pthread_attr_destroy(&attributes);
+
+    // The calling thread is the last worker, and also picks up everything
+    // if no thread could be started.
+    batch_grade_worker(&queue);
+    for (index = 0U; index < started; index++) {
+        pthread_join(threads[index], NULL);
+    }
+    pthread_mutex_destroy(&queue.lock);
+
+    logic_compare_target_release(&reference);
+    logic_clear_graph(reference_graph);
+    mem_free(reference_graph);
+    return true;
+}
+
+const char *batch_grade_status_name(BatchGradeStatus status) {
+    switch (status) {
+        case BATCH_GRADE_EQUIVALENT:
+            return "equivalent";
+        case BATCH_GRADE_MISMATCH:
+            return "mismatch";
+        case BATCH_GRADE_SHAPE_MISMATCH:
+            return "shape_mismatch";
+        case BATCH_GRADE_ERROR:
+            return "error";
+        default:
+            return "unknown";
+    }
+}
+
+static void batch_grade_write_csv_field(FILE *stream, const char *text) {
+    const char *cursor;
+
+    fputc('"', stream);
+    for (cursor = text; *cursor; cursor++) {
+        if (*cursor == '"') {
+            fputc('"', stream);
+        }
+        fputc(*cursor, stream);
+    }
+    fputc('"', stream);
+}
+
+static void batch_grade_write_json_string(FILE *stream, const char *text) {
+    const unsigned char *cursor;
+
+    fputc('"', stream);
+    for (cursor = (const unsigned char *)text; *cursor; cursor++) {
+        if (*cursor == '"' || *cursor == '\\') {
+            fputc('\\', stream);
+            fputc(*cursor, stream);
+        } else if (*cursor < 0x20U) {
+            fprintf(stream, "\\u%04x", (unsigned int)*cursor);
+        } else {
+            fputc(*cursor, stream);
+        }
+    }
+    fputc('"', stream);
+}
+
+void batch_grade_write_csv(FILE *stream, const BatchGradeResult *results, uint32_t count) {
+    uint32_t index;
+
+    fprintf(stream, "file,status,first_failing_row,detail,load_ms,check_ms\n");
+    for (index = 0U; index < count; index++) {
+        const BatchGradeResult *result;
+
+        result = &results[index];
+        batch_grade_write_csv_field(stream, result->path ? result->path : "");
+        fprintf(stream, ",%s,", batch_grade_status_name(result->status));
+        if (result->status == BATCH_GRADE_MISMATCH) {
+            fprintf(stream, "%u", result->first_failing_row);
+        }
+        fputc(',', stream);
+        batch_grade_write_csv_field(stream, result->detail);
+        fprintf(stream, ",%.3f,%.3f\n", result->load_ms, result->check_ms);
+    }
+}
+
+void batch_grade_write_json(FILE *stream, const BatchGradeResult *results, uint32_t count) {
+    uint32_t index;
+
+    fprintf(stream, "[\n");
+    for (index = 0U; index < count; index++) {
+        const BatchGradeResult *result;
+
+        result = &results[index];
+        fprintf(stream, "  {\"file\": ");
+        batch_grade_write_json_string(stream, result->path ? result->path : "");
+        fprintf(stream, ", \"status\": \"%s\", \"first_failing_row\": ", batch_grade_status_name(result->status));
+        if (result->status == BATCH_GRADE_MISMATCH) {
+            fprintf(stream, "%u", result->first_failing_row);
+        } else {
+            fprintf(stream, "null");
+        }
+        fprintf(stream, ", \"detail\": ");
+        batch_grade_write_json_string(stream, result->detail);
+        fprintf(stream, ", \"load_ms\": %.3f, \"check_ms\": %.3f}%s\n", result->load_ms, result->check_ms, index + 1U < count ? "," : "");
+    }
+    fprintf(stream, "]\n");
+}
+
+static bool batch_grade_path_list_push(BatchGradePathList *list, const char *path) {
+    char *copy;
+
+    if (list->count == list->capacity) {
+        uint32_t capacity;
+        char **items;
+
+        capacity = list->capacity == 0U ? 64U : list->capacity * 2U;
+        items = (char **)mem_realloc(MEM_TAG_ANALYSIS, list->items, capacity * sizeof(*items));
+        if (!items) {
+            return false;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+
+    copy = mem_strdup(MEM_TAG_ANALYSIS, path);
+    if (!copy) {
+        return false;
+    }
+    list->items[list->count] = copy;
+    list->count++;
+    return true;
+}
+
+static void batch_grade_path_list_free(BatchGradePathList *list) {
+    uint32_t index;
+
+    for (index = 0U; index < list->count; index++) {
+        mem_free(list->items[index]);
+    }
+    mem_free(list->items);
+    memset(list, 0, sizeof(*list));
+}
+
+static int batch_grade_compare_paths(const void *left, const void *right) {
+    return strcmp(*(char *const *)left, *(char *const *)right);
+}
+
+// Adds every *.circ file in `directory`, sorted so reports are stable between runs.
+static bool batch_grade_collect_directory(BatchGradePathList *list, const char *directory) {
+    DIR *handle;
+    struct dirent *entry;
+    uint32_t first;
+    bool ok;
+
+    handle = opendir(directory);
+    if (!handle) {
+        return false;
+    }
+
+    ok = true;
+    first = list->count;
+    while (ok && (entry = readdir(handle)) != NULL) {
+        char path[1024];
+
+        if (entry->d_name[0] == '.' || (!path_has_suffix(entry->d_name, ".circ") && !path_has_suffix(entry->d_name, ".circb"))) {
+            continue;
+        }
+        snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name);
+        ok = batch_grade_path_list_push(list, path);
+    }
+    closedir(handle);
+
+    qsort(list->items + first, list->count - first, sizeof(*list->items), batch_grade_compare_paths);
+    return ok;
+}
+
+static bool batch_grade_collect(BatchGradePathList *list, const char *path) {
+    struct stat info;
+
+    if (stat(path, &info) == 0 && S_ISDIR(info.st_mode)) {
+        return batch_grade_collect_directory(list, path);
+    }
+    return batch_grade_path_list_push(list, path);
+}
+
+static void batch_grade_usage(void) {
+    fprintf(stderr, "usage: logicsim --grade REFERENCE.circ CANDIDATE... [--jobs N] [--report out.csv|out.json]\n");
+    fprintf(stderr, "  each CANDIDATE is a .circ file or a directory of them\n");
+}
+
+bool batch_grade_requested(int argc, char **argv) {
+    int index;
+
+    for (index = 1; index < argc; index++) {
+        if (strcmp(argv[index], "--grade") == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int batch_grade_main(int argc, char **argv) {
+    BatchGradePathList candidates;
+    BatchGradeOptions options;
+    BatchGradeResult *results;
+    const char *report_path;
+    FILE *report;
+    char error_message[256];
+    uint32_t counts[BATCH_GRADE_ERROR + 1];
+    uint32_t index;
+    double started;
+    double elapsed_ms;
+    int arg;
+
+    memset(&candidates, 0, sizeof(candidates));
+    memset(&options, 0, sizeof(options));
+    memset(counts, 0, sizeof(counts));
+    report_path = NULL;
+
+    for (arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--grade") == 0) {
+            continue;
+        }
+        if (strcmp(argv[arg], "--jobs") == 0 && arg + 1 < argc) {
+            arg++;
+            options.jobs = (uint32_t)strtoul(argv[arg], NULL, 10);
+        } else if (strcmp(argv[arg], "--report") == 0 && arg + 1 < argc) {
+            arg++;
+            report_path = argv[arg];
+        } else if (argv[arg][0] == '-') {
+            batch_grade_usage();
+            batch_grade_path_list_free(&candidates);
+            return 2;
+        } else if (!options.reference_path) {
+            options.reference_path = argv[arg];
+        } else if (!batch_grade_collect(&candidates, argv[arg])) {
+            fprintf(stderr, "grade: could not read %s\n", argv[arg]);
+            batch_grade_path_list_free(&candidates);
+            return 1;
+        }
+    }
+
+    if (!options.reference_path || candidates.count == 0U) {
+        batch_grade_usage();
+        batch_grade_path_list_free(&candidates);
+        return 2;
+    }
+
+    results = (BatchGradeResult *)mem_calloc(MEM_TAG_ANALYSIS, candidates.count, sizeof(*results));
+    if (!results) {
+        fprintf(stderr, "grade: out of memory\n");
+        batch_grade_path_list_free(&candidates);
+        return 1;
+    }
+
+    options.candidate_paths = (const char *const *)candidates.items;
+    options.candidate_count = candidates.count;
+    started = batch_grade_now_ms();
+    if (!batch_grade_run(&options, results, error_message, sizeof(error_message))) {
+        fprintf(stderr, "grade: %s\n", error_message);
+        mem_free(results);
+        batch_grade_path_list_free(&candidates);
+        return 1;
+    }
+    elapsed_ms = batch_grade_now_ms() - started;
+
+    report = stdout;
+    if (report_path) {
+        report = fopen(report_path, "w");
+        if (!report) {
+            fprintf(stderr, "grade: could not open %s for writing\n", report_path);
+            mem_free(results);
+            batch_grade_path_list_free(&candidates);
+            return 1;
+        }
+    }
+    if (report_path && path_has_suffix(report_path, ".json")) {
+        batch_grade_write_json(report, results, candidates.count);
+    } else {
+        batch_grade_write_csv(report, results, candidates.count);
+    }
+    if (report != stdout) {
+        fclose(report);
+    }
+
+    for (index = 0U; index < candidates.count; index++) {
+        counts[results[index].status]++;
+    }
+    fprintf(
+        stderr,
+        "graded %u files in %.1f ms (%.0f files/s): %u equivalent, %u mismatch, %u shape mismatch, %u error\n",
+        candidates.count,
+        elapsed_ms,
+        elapsed_ms > 0.0 ? ((double)candidates.count * 1000.0) / elapsed_ms : 0.0,
+        counts[BATCH_GRADE_EQUIVALENT],
+        counts[BATCH_GRADE_MISMATCH],
+        counts[BATCH_GRADE_SHAPE_MISMATCH],
+        counts[BATCH_GRADE_ERROR]
+    );
+
+    mem_free(results);
+    batch_grade_path_list_free(&candidates);
+    return 0;
+}
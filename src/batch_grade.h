@@ -0,0 +1,41 @@
+#ifndef BATCH_GRADE_H
+#define BATCH_GRADE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define BATCH_GRADE_DETAIL_MAX 160U
+
+typedef enum {
+    BATCH_GRADE_EQUIVALENT,
+    BATCH_GRADE_MISMATCH,
+    BATCH_GRADE_SHAPE_MISMATCH,
+    BATCH_GRADE_ERROR
+} BatchGradeStatus;
+
+typedef struct {
+    const char *path;
+    BatchGradeStatus status;
+    uint32_t first_failing_row;
+    double load_ms;
+    double check_ms;
+    char detail[BATCH_GRADE_DETAIL_MAX]; // counterexample, shape summary or load error
+} BatchGradeResult;
+
+typedef struct {
+    const char *reference_path;
+    const char *const *candidate_paths;
+    uint32_t candidate_count;
+    uint32_t jobs; // 0 picks one worker per online CPU
+} BatchGradeOptions;
+
+bool batch_grade_run(const BatchGradeOptions *options, BatchGradeResult *results, char *error_message, size_t error_message_size);
+const char *batch_grade_status_name(BatchGradeStatus status);
+void batch_grade_write_csv(FILE *stream, const BatchGradeResult *results, uint32_t count);
+void batch_grade_write_json(FILE *stream, const BatchGradeResult *results, uint32_t count);
+bool batch_grade_requested(int argc, char **argv);
+int batch_grade_main(int argc, char **argv);
+
+#endif // BATCH_GRADE_H
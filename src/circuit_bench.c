@@ -0,0 +1,240 @@
+#include "circuit_bench.h"
+#include "circuit_import.h"
+#include "mem.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    CircuitImport import;
+    const char *cursor; // within the current line
+    const char *line_end;
+    uint32_t *terminals; // gate inputs being collected
+    uint32_t terminal_count;
+    uint32_t terminal_capacity;
+    unsigned int line;
+    uint8_t _padding[4];
+} BenchParser;
+
+static bool bench_fail(BenchParser *parser, const char *message, const char *name, size_t name_length) {
+    return circuit_import_fail(&parser->import, parser->line, message, name, name_length);
+}
+
+static void bench_skip_space(BenchParser *parser) {
+    while (parser->cursor < parser->line_end && (*parser->cursor == ' ' || *parser->cursor == '\t' || *parser->cursor == '\r')) {
+        parser->cursor++;
+    }
+}
+
+static bool bench_at_line_end(BenchParser *parser) {
+    bench_skip_space(parser);
+    return parser->cursor >= parser->line_end || *parser->cursor == '#';
+}
+
+static bool bench_symbol(BenchParser *parser, char symbol) {
+    bench_skip_space(parser);
+    if (parser->cursor < parser->line_end && *parser->cursor == symbol) {
+        parser->cursor++;
+        return true;
+    }
+    return false;
+}
+
+// Signal names run up to whitespace or punctuation, so ISCAS names like
+// `10GAT` or `G10.3` come through as written.
+static bool bench_name(BenchParser *parser, const char **name, size_t *length) {
+    const char *start;
+
+    bench_skip_space(parser);
+    start = parser->cursor;
+    while (parser->cursor < parser->line_end &&
+           !isspace((unsigned char)*parser->cursor) &&
+           strchr("(),=#", *parser->cursor) == NULL) {
+        parser->cursor++;
+    }
+    *name = start;
+    *length = (size_t)(parser->cursor - start);
+    return *length > 0U;
+}
+
+static bool bench_keyword(const char *name, size_t length, const char *keyword) {
+    size_t index;
+
+    if (strlen(keyword) != length) {
+        return false;
+    }
+    for (index = 0U; index < length; index++) {
+        if (toupper((unsigned char)name[index]) != keyword[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Returns false for DFF and anything unknown; `dff` tells them apart.
+static bool bench_gate_kind(const char *name, size_t length, CircuitImportGate *gate, bool *dff) {
+    static const char *keywords[] = { "AND", "OR", "XOR", "NAND", "NOR", "XNOR", "NOT", "BUF", "BUFF" };
+    static const CircuitImportGate gates[] = {
+        CIRCUIT_IMPORT_AND,
+        CIRCUIT_IMPORT_OR,
+        CIRCUIT_IMPORT_XOR,
+        CIRCUIT_IMPORT_NAND,
+        CIRCUIT_IMPORT_NOR,
+        CIRCUIT_IMPORT_XNOR,
+        CIRCUIT_IMPORT_NOT,
+        CIRCUIT_IMPORT_BUF,
+        CIRCUIT_IMPORT_BUF
+    };
+    size_t index;
+
+    *dff = bench_keyword(name, length, "DFF");
+    for (index = 0U; index < sizeof(keywords) / sizeof(keywords[0]); index++) {
+        if (bench_keyword(name, length, keywords[index])) {
+            *gate = gates[index];
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool bench_push_terminal(BenchParser *parser, uint32_t net) {
+    if (parser->terminal_count >= parser->terminal_capacity) {
+        uint32_t capacity;
+        uint32_t *terminals;
+
+        capacity = parser->terminal_capacity < 16U ? 16U : parser->terminal_capacity * 2U;
+        terminals = (uint32_t *)mem_realloc(MEM_TAG_LOADER, parser->terminals, capacity * sizeof(*terminals));
+        if (!terminals) {
+            return bench_fail(parser, "out of memory", NULL, 0U);
+        }
+        parser->terminals = terminals;
+        parser->terminal_capacity = capacity;
+    }
+    parser->terminals[parser->terminal_count++] = net;
+    return true;
+}
+
+// `INPUT(x)` or `OUTPUT(x)`, after the keyword.
+static bool bench_port(BenchParser *parser, bool input) {
+    const char *name;
+    size_t length;
+
+    if (!bench_name(parser, &name, &length)) {
+        return bench_fail(parser, "expected a signal name", NULL, 0U);
+    }
+    if (!bench_symbol(parser, ')')) {
+        return bench_fail(parser, "expected ')'", NULL, 0U);
+    }
+    return input
+        ? circuit_import_input(&parser->import, name, length, parser->line)
+        : circuit_import_output(&parser->import, name, length, parser->line);
+}
+
+// `x = GATE(a, b, ...)`, after the `=`.
+static bool bench_assignment(BenchParser *parser, const char *target, size_t target_length) {
+    CircuitImportGate gate;
+    const char *name;
+    size_t length;
+    uint32_t output;
+    bool dff;
+
+    gate = CIRCUIT_IMPORT_BUF;
+    if (!bench_name(parser, &name, &length)) {
+        return bench_fail(parser, "expected a gate type", NULL, 0U);
+    }
+    if (!bench_gate_kind(name, length, &gate, &dff) && !dff) {
+        return bench_fail(parser, "unknown gate type", name, length);
+    }
+    if (!bench_symbol(parser, '(')) {
+        return bench_fail(parser, "expected '('", NULL, 0U);
+    }
+
+    parser->terminal_count = 0U;
+    do {
+        uint32_t net;
+
+        if (!bench_name(parser, &name, &length)) {
+            return bench_fail(parser, "expected a signal name", NULL, 0U);
+        }
+        if (!circuit_import_net(&parser->import, name, length, parser->line, &net) || !bench_push_terminal(parser, net)) {
+            return false;
+        }
+    } while (bench_symbol(parser, ','));
+    if (!bench_symbol(parser, ')')) {
+        return bench_fail(parser, "expected ')'", NULL, 0U);
+    }
+
+    if (!circuit_import_net(&parser->import, target, target_length, parser->line, &output)) {
+        return false;
+    }
+    if (dff) {
+        if (parser->terminal_count != 1U) {
+            return bench_fail(parser, "DFF takes exactly one input", target, target_length);
+        }
+        return circuit_import_dff(&parser->import, NULL, 0U, output, parser->terminals[0], CIRCUIT_IMPORT_NONE, parser->line);
+    }
+    return circuit_import_gate(&parser->import, gate, NULL, 0U, output, parser->terminals, parser->terminal_count, parser->line);
+}
+
+static bool bench_statement(BenchParser *parser) {
+    const char *name;
+    size_t length;
+
+    if (bench_at_line_end(parser)) {
+        return true;
+    }
+    if (!bench_name(parser, &name, &length)) {
+        return bench_fail(parser, "expected a signal name", NULL, 0U);
+    }
+
+    if (bench_symbol(parser, '(')) {
+        if (bench_keyword(name, length, "INPUT")) {
+            if (!bench_port(parser, true)) {
+                return false;
+            }
+        } else if (bench_keyword(name, length, "OUTPUT")) {
+            if (!bench_port(parser, false)) {
+                return false;
+            }
+        } else {
+            return bench_fail(parser, "expected INPUT or OUTPUT", name, length);
+        }
+    } else if (bench_symbol(parser, '=')) {
+        if (!bench_assignment(parser, name, length)) {
+            return false;
+        }
+    } else {
+        return bench_fail(parser, "expected '=' after", name, length);
+    }
+
+    if (!bench_at_line_end(parser)) {
+        return bench_fail(parser, "unexpected text after statement", NULL, 0U);
+    }
+    return true;
+}
+
+bool circuit_bench_parse(const char *data, size_t size, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size) {
+    BenchParser parser;
+    const char *end;
+    bool parsed;
+
+    memset(&parser, 0, sizeof(parser));
+    circuit_import_init(&parser.import, arena, error_message, error_message_size);
+    end = data + size;
+    parser.cursor = data;
+    parsed = true;
+    while (parsed && parser.cursor < end) {
+        const char *newline;
+
+        parser.line++;
+        newline = (const char *)memchr(parser.cursor, '\n', (size_t)(end - parser.cursor));
+        parser.line_end = newline ? newline : end;
+        parsed = bench_statement(&parser);
+        parser.cursor = parser.line_end + (newline ? 1 : 0);
+    }
+
+    parsed = parsed && circuit_import_finish(&parser.import, spec);
+    mem_free(parser.terminals);
+    circuit_import_release(&parser.import);
+    return parsed;
+}
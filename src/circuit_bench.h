@@ -0,0 +1,14 @@
+#ifndef CIRCUIT_BENCH_H
+#define CIRCUIT_BENCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "circuit_spec.h"
+
+// ISCAS-85/89 .bench netlists: INPUT(x), OUTPUT(x), `x = GATE(a, b, ...)`
+// with AND/OR/NAND/NOR/XOR/XNOR/NOT/BUF(F) of any fan-in, and `x = DFF(d)`
+// clocked by one shared clock node. Keywords are case-insensitive.
+bool circuit_bench_parse(const char *data, size_t size, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size);
+
+#endif // CIRCUIT_BENCH_H
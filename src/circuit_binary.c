@@ -0,0 +1,287 @@
+#include "circuit_binary.h"
+#include "name_index.h"
+#include <string.h>
+
+#define CIRCUIT_BINARY_HEADER_SIZE 32U
+#define CIRCUIT_BINARY_EDGE_SIZE 8U
+
+typedef struct {
+    uint64_t types;
+    uint64_t name_offsets;
+    uint64_t names;
+    uint64_t first_edge;
+    uint64_t edges;
+    uint64_t positions;
+    uint64_t end;
+} CircuitBinaryLayout;
+
+static void circuit_binary_error(char *error_message, size_t error_message_size, const char *message) {
+    if (error_message && error_message_size > 0U) {
+        snprintf(error_message, error_message_size, "%s", message);
+    }
+}
+
+static uint64_t circuit_binary_align(uint64_t offset) {
+    return (offset + 3U) & ~(uint64_t)3U;
+}
+
+static uint32_t circuit_binary_read_u32(const uint8_t *bytes) {
+    return (uint32_t)bytes[0] |
+        ((uint32_t)bytes[1] << 8) |
+        ((uint32_t)bytes[2] << 16) |
+        ((uint32_t)bytes[3] << 24);
+}
+
+static uint16_t circuit_binary_read_u16(const uint8_t *bytes) {
+    return (uint16_t)((uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8));
+}
+
+static float circuit_binary_read_f32(const uint8_t *bytes) {
+    uint32_t bits;
+    float value;
+
+    bits = circuit_binary_read_u32(bytes);
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+static void circuit_binary_put_u32(uint8_t *bytes, uint32_t value) {
+    bytes[0] = (uint8_t)(value & 0xFFU);
+    bytes[1] = (uint8_t)((value >> 8) & 0xFFU);
+    bytes[2] = (uint8_t)((value >> 16) & 0xFFU);
+    bytes[3] = (uint8_t)((value >> 24) & 0xFFU);
+}
+
+static void circuit_binary_put_u16(uint8_t *bytes, uint16_t value) {
+    bytes[0] = (uint8_t)(value & 0xFFU);
+    bytes[1] = (uint8_t)((value >> 8) & 0xFFU);
+}
+
+static void circuit_binary_put_f32(uint8_t *bytes, float value) {
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    circuit_binary_put_u32(bytes, bits);
+}
+
+static void circuit_binary_compute_layout(
+    uint32_t node_count,
+    uint32_t edge_count,
+    uint32_t names_size,
+    bool has_positions,
+    CircuitBinaryLayout *layout
+) {
+    layout->types = CIRCUIT_BINARY_HEADER_SIZE;
+    layout->name_offsets = circuit_binary_align(layout->types + node_count);
+    layout->names = layout->name_offsets + ((uint64_t)node_count * 4U);
+    layout->first_edge = circuit_binary_align(layout->names + names_size);
+    layout->edges = layout->first_edge + (((uint64_t)node_count + 1U) * 4U);
+    layout->positions = layout->edges + ((uint64_t)edge_count * CIRCUIT_BINARY_EDGE_SIZE);
+    layout->end = layout->positions + (has_positions ? (uint64_t)node_count * 8U : 0U);
+}
+
+bool circuit_binary_detect(const char *data, size_t size) {
+    return data && size >= 4U && memcmp(data, CIRCUIT_BINARY_MAGIC, 4U) == 0;
+}
+
+// Names stay pointers into `data`, so the caller keeps it mapped for as long
+// as the spec is in use. Everything is bounds-checked before it is read.
+bool circuit_binary_decode(const char *data, size_t size, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size) {
+    const uint8_t *bytes;
+    const char *names;
+    CircuitBinaryLayout layout;
+    NameIndex name_index;
+    NameIndexSlot *name_slots;
+    uint32_t names_size;
+    uint32_t name_capacity;
+    uint32_t node_index;
+    uint32_t edge_index;
+    uint16_t flags;
+
+    memset(spec, 0, sizeof(*spec));
+    bytes = (const uint8_t *)data;
+    if (!circuit_binary_detect(data, size) || size < CIRCUIT_BINARY_HEADER_SIZE) {
+        circuit_binary_error(error_message, error_message_size, "not a .circb file");
+        return false;
+    }
+    if (circuit_binary_read_u16(bytes + 4) != CIRCUIT_BINARY_VERSION) {
+        circuit_binary_error(error_message, error_message_size, "unsupported .circb version");
+        return false;
+    }
+
+    flags = circuit_binary_read_u16(bytes + 6);
+    spec->node_count = circuit_binary_read_u32(bytes + 8);
+    spec->edge_count = circuit_binary_read_u32(bytes + 12);
+    names_size = circuit_binary_read_u32(bytes + 16);
+    circuit_binary_compute_layout(spec->node_count, spec->edge_count, names_size, (flags & CIRCUIT_BINARY_HAS_POSITIONS) != 0U, &layout);
+    if (layout.end > (uint64_t)size || (spec->node_count > 0U && (names_size == 0U || data[layout.names + names_size - 1U] != '\0'))) {
+        circuit_binary_error(error_message, error_message_size, "truncated .circb file");
+        return false;
+    }
+
+    spec->nodes = (CircuitLayoutNode *)arena_alloc(arena, spec->node_count * sizeof(*spec->nodes));
+    spec->edges = (CircuitLayoutEdge *)arena_alloc(arena, spec->edge_count * sizeof(*spec->edges));
+    name_capacity = name_index_capacity_for(spec->node_count);
+    name_slots = (NameIndexSlot *)arena_alloc(arena, name_capacity * sizeof(*name_slots));
+    if (!spec->nodes || !spec->edges || !name_slots) {
+        circuit_binary_error(error_message, error_message_size, "out of memory");
+        return false;
+    }
+    name_index_init(&name_index, name_slots, name_capacity);
+
+    names = data + layout.names;
+    for (node_index = 0U; node_index < spec->node_count; node_index++) {
+        uint32_t type;
+        uint32_t name_offset;
+        const char *name;
+
+        type = bytes[layout.types + node_index];
+        name_offset = circuit_binary_read_u32(bytes + layout.name_offsets + ((uint64_t)node_index * 4U));
+        if (type > (uint32_t)NODE_GATE_CLOCK) {
+            circuit_binary_error(error_message, error_message_size, "unknown node type in .circb file");
+            return false;
+        }
+        if (name_offset >= names_size || names[name_offset] == '\0') {
+            circuit_binary_error(error_message, error_message_size, "bad node name in .circb file");
+            return false;
+        }
+
+        name = names + name_offset;
+        if (!name_index_insert(&name_index, name, strlen(name), (uint16_t)node_index)) {
+            circuit_binary_error(error_message, error_message_size, "duplicate node name in .circb file");
+            return false;
+        }
+        spec->nodes[node_index].type = (NodeType)type;
+        spec->nodes[node_index].name = name;
+    }
+
+    edge_index = 0U;
+    for (node_index = 0U; node_index < spec->node_count; node_index++) {
+        uint32_t first;
+        uint32_t last;
+
+        first = circuit_binary_read_u32(bytes + layout.first_edge + ((uint64_t)node_index * 4U));
+        last = circuit_binary_read_u32(bytes + layout.first_edge + (((uint64_t)node_index + 1U) * 4U));
+        if (first != edge_index || last < first || last > spec->edge_count) {
+            circuit_binary_error(error_message, error_message_size, "bad connectivity in .circb file");
+            return false;
+        }
+        for (; edge_index < last; edge_index++) {
+            const uint8_t *edge;
+            CircuitLayoutEdge *out;
+
+            edge = bytes + layout.edges + ((uint64_t)edge_index * CIRCUIT_BINARY_EDGE_SIZE);
+            out = &spec->edges[edge_index];
+            out->source_node_index = node_index;
+            out->sink_node_index = circuit_binary_read_u32(edge);
+            out->source_pin_index = edge[4];
+            out->sink_pin_index = edge[5];
+            if (out->sink_node_index >= spec->node_count) {
+                circuit_binary_error(error_message, error_message_size, "bad connectivity in .circb file");
+                return false;
+            }
+        }
+    }
+    if (edge_index != spec->edge_count) {
+        circuit_binary_error(error_message, error_message_size, "bad connectivity in .circb file");
+        return false;
+    }
+
+    if ((flags & CIRCUIT_BINARY_HAS_POSITIONS) != 0U) {
+        spec->positions = (CircuitPosition *)arena_alloc(arena, spec->node_count * sizeof(*spec->positions));
+        if (!spec->positions) {
+            circuit_binary_error(error_message, error_message_size, "out of memory");
+            return false;
+        }
+        for (node_index = 0U; node_index < spec->node_count; node_index++) {
+            spec->positions[node_index].x = circuit_binary_read_f32(bytes + layout.positions + ((uint64_t)node_index * 8U));
+            spec->positions[node_index].y = circuit_binary_read_f32(bytes + layout.positions + ((uint64_t)node_index * 8U) + 4U);
+        }
+    }
+
+    return true;
+}
+
+// Builds the whole image in `arena` and writes it with one fwrite.
+bool circuit_binary_write(FILE *stream, const CircuitSpec *spec, Arena *arena, char *error_message, size_t error_message_size) {
+    CircuitBinaryLayout layout;
+    uint32_t *fanout_start;
+    uint32_t *fanout_fill;
+    uint8_t *image;
+    uint64_t names_size;
+    uint32_t name_cursor;
+    uint32_t node_index;
+    uint32_t edge_index;
+
+    names_size = 0U;
+    for (node_index = 0U; node_index < spec->node_count; node_index++) {
+        names_size += strlen(spec->nodes[node_index].name) + 1U;
+    }
+    if (names_size > UINT32_MAX) {
+        circuit_binary_error(error_message, error_message_size, "names do not fit in a .circb file");
+        return false;
+    }
+
+    circuit_binary_compute_layout(spec->node_count, spec->edge_count, (uint32_t)names_size, spec->positions != NULL, &layout);
+    image = (uint8_t *)arena_alloc(arena, (size_t)layout.end);
+    fanout_start = (uint32_t *)arena_alloc(arena, ((size_t)spec->node_count + 1U) * sizeof(*fanout_start));
+    fanout_fill = (uint32_t *)arena_alloc(arena, ((size_t)spec->node_count + 1U) * sizeof(*fanout_fill));
+    if (!image || !fanout_start || !fanout_fill) {
+        circuit_binary_error(error_message, error_message_size, "out of memory");
+        return false;
+    }
+
+    memcpy(image, CIRCUIT_BINARY_MAGIC, 4U);
+    circuit_binary_put_u16(image + 4, (uint16_t)CIRCUIT_BINARY_VERSION);
+    circuit_binary_put_u16(image + 6, spec->positions ? (uint16_t)CIRCUIT_BINARY_HAS_POSITIONS : (uint16_t)0U);
+    circuit_binary_put_u32(image + 8, spec->node_count);
+    circuit_binary_put_u32(image + 12, spec->edge_count);
+    circuit_binary_put_u32(image + 16, (uint32_t)names_size);
+
+    name_cursor = 0U;
+    for (node_index = 0U; node_index < spec->node_count; node_index++) {
+        size_t name_length;
+
+        name_length = strlen(spec->nodes[node_index].name);
+        image[layout.types + node_index] = (uint8_t)spec->nodes[node_index].type;
+        circuit_binary_put_u32(image + layout.name_offsets + ((uint64_t)node_index * 4U), name_cursor);
+        memcpy(image + layout.names + name_cursor, spec->nodes[node_index].name, name_length + 1U);
+        name_cursor += (uint32_t)name_length + 1U;
+    }
+
+    // Counting sort by source node gives the CSR row starts.
+    for (edge_index = 0U; edge_index < spec->edge_count; edge_index++) {
+        fanout_start[spec->edges[edge_index].source_node_index + 1U]++;
+    }
+    for (node_index = 0U; node_index < spec->node_count; node_index++) {
+        fanout_start[node_index + 1U] += fanout_start[node_index];
+    }
+    memcpy(fanout_fill, fanout_start, ((size_t)spec->node_count + 1U) * sizeof(*fanout_fill));
+    for (node_index = 0U; node_index <= spec->node_count; node_index++) {
+        circuit_binary_put_u32(image + layout.first_edge + ((uint64_t)node_index * 4U), fanout_start[node_index]);
+    }
+    for (edge_index = 0U; edge_index < spec->edge_count; edge_index++) {
+        const CircuitLayoutEdge *edge;
+        uint8_t *out;
+
+        edge = &spec->edges[edge_index];
+        out = image + layout.edges + ((uint64_t)fanout_fill[edge->source_node_index] * CIRCUIT_BINARY_EDGE_SIZE);
+        fanout_fill[edge->source_node_index]++;
+        circuit_binary_put_u32(out, edge->sink_node_index);
+        out[4] = edge->source_pin_index;
+        out[5] = edge->sink_pin_index;
+    }
+
+    if (spec->positions) {
+        for (node_index = 0U; node_index < spec->node_count; node_index++) {
+            circuit_binary_put_f32(image + layout.positions + ((uint64_t)node_index * 8U), spec->positions[node_index].x);
+            circuit_binary_put_f32(image + layout.positions + ((uint64_t)node_index * 8U) + 4U, spec->positions[node_index].y);
+        }
+    }
+
+    if (fwrite(image, (size_t)layout.end, 1U, stream) != 1U) {
+        circuit_binary_error(error_message, error_message_size, "could not write .circb file");
+        return false;
+    }
+    return true;
+}
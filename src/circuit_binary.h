@@ -0,0 +1,29 @@
+#ifndef CIRCUIT_BINARY_H
+#define CIRCUIT_BINARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "arena.h"
+#include "circuit_spec.h"
+
+// .circb: little-endian, every section 4-byte aligned.
+//
+//   header   "CIRB", u16 version, u16 flags, u32 node_count, u32 edge_count,
+//            u32 names_size, u32 reserved[3]
+//   types    u8[node_count] (NodeType)
+//   names    u32 offset[node_count] into a blob of NUL-terminated names
+//   blob     char[names_size]
+//   fanout   u32 first_edge[node_count + 1], edges grouped by source node (CSR)
+//   edges    { u32 sink_node; u8 source_pin; u8 sink_pin; u8 reserved[2] }[edge_count]
+//   layout   f32 { x, y }[node_count], only with CIRCUIT_BINARY_HAS_POSITIONS
+#define CIRCUIT_BINARY_MAGIC "CIRB"
+#define CIRCUIT_BINARY_VERSION 1U
+#define CIRCUIT_BINARY_HAS_POSITIONS 0x0001U
+
+bool circuit_binary_detect(const char *data, size_t size);
+bool circuit_binary_decode(const char *data, size_t size, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size);
+bool circuit_binary_write(FILE *stream, const CircuitSpec *spec, Arena *arena, char *error_message, size_t error_message_size);
+
+#endif // CIRCUIT_BINARY_H
@@ -0,0 +1,439 @@
+#include "circuit_blif.h"
+#include "circuit_import.h"
+#include "mem.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum {
+    BLIF_TOKEN_END,
+    BLIF_TOKEN_NEWLINE,
+    BLIF_TOKEN_WORD
+} BlifTokenKind;
+
+typedef struct {
+    uint32_t *items;
+    uint32_t count;
+    uint32_t capacity;
+} BlifList;
+
+typedef struct {
+    CircuitImport import;
+    const char *cursor;
+    const char *end;
+    const char *token;
+    size_t token_length;
+    const char *cover_name; // output of the open .names
+    size_t cover_name_length;
+    BlifList cover_inputs; // input nets of the open .names
+    BlifList inverted; // complement of each cover input, made on first use
+    BlifList literals; // nets of the cube being read
+    BlifList terms; // one net per cube of the open .names
+    BlifTokenKind kind;
+    unsigned int line;
+    unsigned int token_line;
+    unsigned int cover_line;
+    uint32_t cover_output;
+    bool in_model;
+    bool model_done;
+    bool cover_open;
+    bool cover_on_set;
+    bool cover_has_rows;
+    uint8_t _padding[7];
+} BlifParser;
+
+static bool blif_fail(BlifParser *parser, const char *message, const char *name, size_t name_length) {
+    return circuit_import_fail(&parser->import, parser->token_line, message, name, name_length);
+}
+
+static bool blif_push(BlifParser *parser, BlifList *list, uint32_t value) {
+    if (list->count >= list->capacity) {
+        uint32_t capacity;
+        uint32_t *items;
+
+        capacity = list->capacity < 16U ? 16U : list->capacity * 2U;
+        items = (uint32_t *)mem_realloc(MEM_TAG_LOADER, list->items, capacity * sizeof(*items));
+        if (!items) {
+            return blif_fail(parser, "out of memory", NULL, 0U);
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = value;
+    return true;
+}
+
+static bool blif_is_continuation(const BlifParser *parser) {
+    const char *next;
+
+    next = parser->cursor + 1;
+    if (next < parser->end && *next == '\r') {
+        next++;
+    }
+    return *parser->cursor == '\\' && (next >= parser->end || *next == '\n');
+}
+
+// Words and line ends; comments and backslash-newline continuations vanish.
+static void blif_next(BlifParser *parser) {
+    const char *start;
+
+    for (;;) {
+        while (parser->cursor < parser->end && (*parser->cursor == ' ' || *parser->cursor == '\t' || *parser->cursor == '\r')) {
+            parser->cursor++;
+        }
+        if (parser->cursor < parser->end && *parser->cursor == '#') {
+            while (parser->cursor < parser->end && *parser->cursor != '\n') {
+                parser->cursor++;
+            }
+        } else if (parser->cursor < parser->end && blif_is_continuation(parser)) {
+            while (parser->cursor < parser->end && *parser->cursor != '\n') {
+                parser->cursor++;
+            }
+            if (parser->cursor < parser->end) {
+                parser->cursor++;
+                parser->line++;
+            }
+        } else {
+            break;
+        }
+    }
+
+    parser->token_line = parser->line;
+    parser->token = parser->cursor;
+    parser->token_length = 0U;
+    if (parser->cursor >= parser->end) {
+        parser->kind = BLIF_TOKEN_END;
+        return;
+    }
+    if (*parser->cursor == '\n') {
+        parser->cursor++;
+        parser->line++;
+        parser->kind = BLIF_TOKEN_NEWLINE;
+        return;
+    }
+
+    start = parser->cursor;
+    while (parser->cursor < parser->end &&
+           !isspace((unsigned char)*parser->cursor) &&
+           *parser->cursor != '#' &&
+           !blif_is_continuation(parser)) {
+        parser->cursor++;
+    }
+    parser->token = start;
+    parser->token_length = (size_t)(parser->cursor - start);
+    parser->kind = BLIF_TOKEN_WORD;
+}
+
+static bool blif_is(const BlifParser *parser, const char *word) {
+    size_t length;
+
+    length = strlen(word);
+    return parser->kind == BLIF_TOKEN_WORD && parser->token_length == length && memcmp(parser->token, word, length) == 0;
+}
+
+static bool blif_net(BlifParser *parser, uint32_t *net) {
+    return circuit_import_net(&parser->import, parser->token, parser->token_length, parser->token_line, net);
+}
+
+// `.inputs`/`.clock` or `.outputs`: every word to the end of the line.
+static bool blif_ports(BlifParser *parser, bool input) {
+    blif_next(parser);
+    while (parser->kind == BLIF_TOKEN_WORD) {
+        if (input
+                ? !circuit_import_input(&parser->import, parser->token, parser->token_length, parser->token_line)
+                : !circuit_import_output(&parser->import, parser->token, parser->token_length, parser->token_line)) {
+            return false;
+        }
+        blif_next(parser);
+    }
+    return true;
+}
+
+// Complement of cover input `column`, shared by every cube that needs it.
+static bool blif_inverted_input(BlifParser *parser, uint32_t column, uint32_t *net) {
+    if (parser->inverted.items[column] == CIRCUIT_IMPORT_NONE) {
+        if (!circuit_import_new_net(&parser->import, parser->token_line, &parser->inverted.items[column]) ||
+            !circuit_import_gate(
+                &parser->import,
+                CIRCUIT_IMPORT_NOT,
+                parser->cover_name,
+                parser->cover_name_length,
+                parser->inverted.items[column],
+                &parser->cover_inputs.items[column],
+                1U,
+                parser->token_line
+            )) {
+            return false;
+        }
+    }
+    *net = parser->inverted.items[column];
+    return true;
+}
+
+// `.names a b ... y`: opens a cover whose rows follow on their own lines.
+static bool blif_names(BlifParser *parser) {
+    uint32_t net;
+    uint32_t index;
+
+    parser->cover_inputs.count = 0U;
+    parser->inverted.count = 0U;
+    parser->terms.count = 0U;
+    parser->cover_line = parser->token_line;
+    blif_next(parser);
+    while (parser->kind == BLIF_TOKEN_WORD) {
+        parser->cover_name = parser->token;
+        parser->cover_name_length = parser->token_length;
+        if (!blif_net(parser, &net) || !blif_push(parser, &parser->cover_inputs, net)) {
+            return false;
+        }
+        blif_next(parser);
+    }
+    if (parser->cover_inputs.count == 0U) {
+        return blif_fail(parser, ".names needs an output", NULL, 0U);
+    }
+
+    parser->cover_output = parser->cover_inputs.items[--parser->cover_inputs.count];
+    for (index = 0U; index < parser->cover_inputs.count; index++) {
+        if (!blif_push(parser, &parser->inverted, CIRCUIT_IMPORT_NONE)) {
+            return false;
+        }
+    }
+    parser->cover_open = true;
+    parser->cover_has_rows = false;
+    return true;
+}
+
+// One cube: an input plane of 0/1/- and the output value. Each cube becomes
+// an AND of its literals, or just the literal when there is one.
+static bool blif_cover_row(BlifParser *parser) {
+    const char *plane;
+    uint32_t column;
+    uint32_t term;
+    bool on_set;
+
+    if (!parser->cover_open) {
+        return blif_fail(parser, "cover row outside .names", parser->token, parser->token_length);
+    }
+    if (parser->cover_inputs.count == 0U) {
+        return blif_fail(parser, "constant nets are not supported", parser->cover_name, parser->cover_name_length);
+    }
+
+    plane = parser->token;
+    if (parser->token_length != parser->cover_inputs.count) {
+        return blif_fail(parser, "cover row does not match the .names inputs", plane, parser->token_length);
+    }
+    blif_next(parser);
+    if (parser->kind != BLIF_TOKEN_WORD || parser->token_length != 1U || (parser->token[0] != '0' && parser->token[0] != '1')) {
+        return blif_fail(parser, "expected a 0 or 1 output after the cover row", NULL, 0U);
+    }
+    on_set = parser->token[0] == '1';
+    if (parser->cover_has_rows && on_set != parser->cover_on_set) {
+        return blif_fail(parser, "cover mixes on-set and off-set rows", parser->cover_name, parser->cover_name_length);
+    }
+    parser->cover_on_set = on_set;
+    parser->cover_has_rows = true;
+
+    parser->literals.count = 0U;
+    for (column = 0U; column < parser->cover_inputs.count; column++) {
+        uint32_t literal;
+
+        if (plane[column] == '-') {
+            continue;
+        }
+        if (plane[column] == '1') {
+            literal = parser->cover_inputs.items[column];
+        } else if (plane[column] == '0') {
+            if (!blif_inverted_input(parser, column, &literal)) {
+                return false;
+            }
+        } else {
+            return blif_fail(parser, "cover rows use only 0, 1 and -", plane, parser->cover_inputs.count);
+        }
+        if (!blif_push(parser, &parser->literals, literal)) {
+            return false;
+        }
+    }
+    if (parser->literals.count == 0U) {
+        return blif_fail(parser, "constant nets are not supported", parser->cover_name, parser->cover_name_length);
+    }
+
+    term = parser->literals.items[0];
+    if (parser->literals.count > 1U &&
+        (!circuit_import_new_net(&parser->import, parser->token_line, &term) ||
+         !circuit_import_gate(
+             &parser->import,
+             CIRCUIT_IMPORT_AND,
+             parser->cover_name,
+             parser->cover_name_length,
+             term,
+             parser->literals.items,
+             parser->literals.count,
+             parser->token_line
+         ))) {
+        return false;
+    }
+    blif_next(parser);
+    if (parser->kind == BLIF_TOKEN_WORD) {
+        return blif_fail(parser, "unexpected text after cover row", parser->token, parser->token_length);
+    }
+    return blif_push(parser, &parser->terms, term);
+}
+
+// The output is the OR of the cubes (on-set) or its complement (off-set).
+static bool blif_close_cover(BlifParser *parser) {
+    if (!parser->cover_open) {
+        return true;
+    }
+    parser->cover_open = false;
+    if (!parser->cover_has_rows) {
+        return circuit_import_fail(&parser->import, parser->cover_line, "constant nets are not supported", parser->cover_name, parser->cover_name_length);
+    }
+    return circuit_import_gate(
+        &parser->import,
+        parser->cover_on_set ? CIRCUIT_IMPORT_OR : CIRCUIT_IMPORT_NOR,
+        parser->cover_name,
+        parser->cover_name_length,
+        parser->cover_output,
+        parser->terms.items,
+        parser->terms.count,
+        parser->cover_line
+    );
+}
+
+// `.latch d q [type control] [init]`. Edge types become flip-flops and level
+// types latches; falling/low-active controls go through a NOT. The initial
+// value is ignored: the engine starts all state unknown.
+static bool blif_latch(BlifParser *parser) {
+    const char *words[5];
+    size_t lengths[5];
+    const char *type;
+    uint32_t count;
+    uint32_t d;
+    uint32_t q;
+    uint32_t control;
+    unsigned int line;
+
+    line = parser->token_line;
+    count = 0U;
+    blif_next(parser);
+    while (parser->kind == BLIF_TOKEN_WORD) {
+        if (count >= 5U) {
+            return blif_fail(parser, "expected .latch input output [type control] [init]", NULL, 0U);
+        }
+        words[count] = parser->token;
+        lengths[count] = parser->token_length;
+        count++;
+        blif_next(parser);
+    }
+    if (count < 2U) {
+        return circuit_import_fail(&parser->import, line, "expected .latch input output [type control] [init]", NULL, 0U);
+    }
+
+    type = count >= 4U ? words[2] : "re";
+    if (count >= 4U && lengths[2] != 2U) {
+        return circuit_import_fail(&parser->import, line, "unknown latch type", words[2], lengths[2]);
+    }
+    if (memcmp(type, "as", 2U) == 0) {
+        return circuit_import_fail(&parser->import, line, "asynchronous latches are not supported", words[1], lengths[1]);
+    }
+    if (memcmp(type, "re", 2U) != 0 && memcmp(type, "fe", 2U) != 0 && memcmp(type, "ah", 2U) != 0 && memcmp(type, "al", 2U) != 0) {
+        return circuit_import_fail(&parser->import, line, "unknown latch type", type, 2U);
+    }
+
+    control = CIRCUIT_IMPORT_NONE;
+    if (!circuit_import_net(&parser->import, words[0], lengths[0], line, &d) ||
+        !circuit_import_net(&parser->import, words[1], lengths[1], line, &q) ||
+        (count >= 4U && !(lengths[3] == 3U && memcmp(words[3], "NIL", 3U) == 0) &&
+         !circuit_import_net(&parser->import, words[3], lengths[3], line, &control))) {
+        return false;
+    }
+
+    if (control != CIRCUIT_IMPORT_NONE && (type[0] == 'f' || type[1] == 'l')) {
+        uint32_t inverted;
+
+        if (!circuit_import_new_net(&parser->import, line, &inverted) ||
+            !circuit_import_gate(&parser->import, CIRCUIT_IMPORT_NOT, words[1], lengths[1], inverted, &control, 1U, line)) {
+            return false;
+        }
+        control = inverted;
+    }
+
+    if (type[0] == 'a') {
+        if (control == CIRCUIT_IMPORT_NONE) {
+            return circuit_import_fail(&parser->import, line, "level-sensitive latch needs a control signal", words[1], lengths[1]);
+        }
+        return circuit_import_latch(&parser->import, words[1], lengths[1], q, d, control, line);
+    }
+    return circuit_import_dff(&parser->import, words[1], lengths[1], q, d, control, line);
+}
+
+static bool blif_directive(BlifParser *parser) {
+    if (!blif_close_cover(parser)) {
+        return false;
+    }
+    if (parser->model_done || (parser->in_model && blif_is(parser, ".model"))) {
+        return blif_fail(parser, "only one .model per file is supported", NULL, 0U);
+    }
+
+    if (blif_is(parser, ".model")) {
+        parser->in_model = true;
+        do {
+            blif_next(parser);
+        } while (parser->kind == BLIF_TOKEN_WORD);
+    } else if (blif_is(parser, ".inputs") || blif_is(parser, ".clock")) {
+        return blif_ports(parser, true);
+    } else if (blif_is(parser, ".outputs")) {
+        return blif_ports(parser, false);
+    } else if (blif_is(parser, ".names")) {
+        return blif_names(parser);
+    } else if (blif_is(parser, ".latch")) {
+        return blif_latch(parser);
+    } else if (blif_is(parser, ".end")) {
+        parser->model_done = true;
+        blif_next(parser);
+    } else if (blif_is(parser, ".subckt") || blif_is(parser, ".gate") || blif_is(parser, ".mlatch") || blif_is(parser, ".exdc")) {
+        return blif_fail(parser, "directive is not supported", parser->token, parser->token_length);
+    } else {
+        return blif_fail(parser, "unknown directive", parser->token, parser->token_length);
+    }
+
+    if (parser->kind == BLIF_TOKEN_WORD) {
+        return blif_fail(parser, "unexpected text after directive", parser->token, parser->token_length);
+    }
+    return true;
+}
+
+static bool blif_model(BlifParser *parser) {
+    blif_next(parser);
+    while (parser->kind != BLIF_TOKEN_END) {
+        if (parser->kind == BLIF_TOKEN_NEWLINE) {
+            blif_next(parser);
+        } else if (parser->token[0] == '.') {
+            if (!blif_directive(parser)) {
+                return false;
+            }
+        } else if (!blif_cover_row(parser)) {
+            return false;
+        }
+    }
+    return blif_close_cover(parser);
+}
+
+bool circuit_blif_parse(const char *data, size_t size, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size) {
+    BlifParser parser;
+    bool parsed;
+
+    memset(&parser, 0, sizeof(parser));
+    circuit_import_init(&parser.import, arena, error_message, error_message_size);
+    parser.cursor = data;
+    parser.end = data + size;
+    parser.line = 1U;
+
+    parsed = blif_model(&parser) && circuit_import_finish(&parser.import, spec);
+    mem_free(parser.cover_inputs.items);
+    mem_free(parser.inverted.items);
+    mem_free(parser.literals.items);
+    mem_free(parser.terms.items);
+    circuit_import_release(&parser.import);
+    return parsed;
+}
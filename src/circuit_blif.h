@@ -0,0 +1,16 @@
+#ifndef CIRCUIT_BLIF_H
+#define CIRCUIT_BLIF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "circuit_spec.h"
+
+// The combinational/latch subset of BLIF, one .model per file: .inputs,
+// .outputs, .names covers (single-output, on-set or off-set) turned into
+// AND/OR trees with NOTs on complemented literals, and .latch with re/fe
+// clocks (flip-flops) or ah/al enables (latches). A latch with no control
+// uses one shared clock node. Constants, .subckt and .gate are rejected.
+bool circuit_blif_parse(const char *data, size_t size, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size);
+
+#endif // CIRCUIT_BLIF_H
@@ -1,28 +1,48 @@
 #include "circuit_file.h"
-#include "app_analysis.h"
-#include "app_canvas.h"
-#include "circuit_layout.h"
+#include "circuit_bench.h"
+#include "circuit_binary.h"
+#include "circuit_blif.h"
+#include "circuit_verilog.h"
+#include "mem.h"
+#include "name_index.h"
+#include "text_util.h"
+#include "trace.h"
 #include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #define PARSED_NAME_MAX 64
+#define CIRCUIT_FILE_PATH_MAX 512
+#define CIRCUIT_FILE_MAP_MIN_SIZE (1024U * 1024U) // smaller files are read, not mapped
 
 #if defined(__clang__)
 #pragma clang diagnostic push
 #pragma clang diagnostic ignored "-Wpadded"
 #endif
 
+// Slice of the source text; not NUL-terminated.
+typedef struct {
+    const char *data;
+    size_t length;
+} CircuitTextView;
+
 typedef struct {
     NodeType type;
     char name[PARSED_NAME_MAX];
-    Vector2 position;
+    CircuitPosition position;
     bool has_position;
 } CircuitDocumentNode;
 
 typedef struct {
-    char node_name[PARSED_NAME_MAX];
+    CircuitTextView node_name;
     bool explicit_pin;
     bool is_output_pin;
     uint8_t pin_index;
@@ -33,95 +53,195 @@ typedef struct {
     CircuitEndpoint sink;
 } CircuitDocumentWire;
 
+// Arrays live in the per-load arena and are sized from the file's line count,
+// which bounds both the node and the wire declarations.
 typedef struct {
-    CircuitDocumentNode nodes[MAX_NODES];
-    CircuitDocumentWire wires[MAX_NETS];
+    CircuitDocumentNode *nodes;
+    CircuitDocumentWire *wires;
+    NameIndex names; // node name -> index into nodes, filled while parsing
     uint32_t node_count;
     uint32_t wire_count;
+    uint32_t node_capacity;
+    uint32_t wire_capacity;
 } CircuitDocument;
 
-typedef struct {
-    AppMode mode;
-    AppTool active_tool;
-    AppPanelFocus focused_panel;
-    LogicGraph *target_graph;
-    float simulation_speed;
-    bool live_reload;
-    char source_path[APP_SOURCE_PATH_MAX];
-} AppLoadSettings;
-
 #if defined(__clang__)
 #pragma clang diagnostic pop
 #endif
 
-static void set_error(char *error_message, size_t error_message_size, const char *message, unsigned int line_number) {
-    if (!error_message || error_message_size == 0U) {
-        return;
-    }
+static bool text_is_space(char c) {
+    return isspace((unsigned char)c) != 0;
+}
 
-    if (line_number == 0U) {
-        snprintf(error_message, error_message_size, "%s", message);
-        return;
+static CircuitTextView text_view_trim(CircuitTextView view) {
+    while (view.length > 0U && text_is_space(view.data[0])) {
+        view.data++;
+        view.length--;
     }
+    while (view.length > 0U && text_is_space(view.data[view.length - 1U])) {
+        view.length--;
+    }
+    return view;
+}
+
+static bool text_view_equals(CircuitTextView view, const char *text) {
+    size_t length;
 
-    snprintf(error_message, error_message_size, "Line %u: %s", line_number, message);
+    length = strlen(text);
+    return view.length == length && memcmp(view.data, text, length) == 0;
 }
 
-static char *trim_whitespace(char *text) {
+// Splits the next space- or tab-separated token off the front of `rest`.
+static bool text_view_next_token(CircuitTextView *rest, CircuitTextView *token) {
     size_t length;
 
-    while (*text != '\0' && isspace((unsigned char)*text)) {
-        text++;
+    while (rest->length > 0U && (rest->data[0] == ' ' || rest->data[0] == '\t')) {
+        rest->data++;
+        rest->length--;
+    }
+    if (rest->length == 0U) {
+        return false;
     }
 
-    length = strlen(text);
-    while (length > 0U && isspace((unsigned char)text[length - 1U])) {
-        text[length - 1U] = '\0';
-        length--;
+    length = 0U;
+    while (length < rest->length && rest->data[length] != ' ' && rest->data[length] != '\t') {
+        length++;
     }
+    token->data = rest->data;
+    token->length = length;
+    rest->data += length;
+    rest->length -= length;
+    return true;
+}
 
-    return text;
+static const char *skip_spaces(const char *cursor, const char *end) {
+    while (cursor < end && text_is_space(*cursor)) {
+        cursor++;
+    }
+    return cursor;
 }
 
-static void strip_comment(char *text) {
-    char *comment;
+// Decimal float with optional sign, fraction and exponent. The source text is
+// not NUL-terminated, so strtof/sscanf cannot be pointed at it directly.
+static bool parse_float(const char **cursor, const char *end, float *value) {
+    const char *p;
+    double result;
+    double scale;
+    int exponent;
+    int exponent_sign;
+    bool negative;
+    bool has_digits;
+
+    p = skip_spaces(*cursor, end);
+    result = 0.0;
+    exponent = 0;
+    negative = false;
+    has_digits = false;
+
+    if (p < end && (*p == '+' || *p == '-')) {
+        negative = *p == '-';
+        p++;
+    }
+    while (p < end && isdigit((unsigned char)*p)) {
+        result = (result * 10.0) + (double)(*p - '0');
+        has_digits = true;
+        p++;
+    }
+    if (p < end && *p == '.') {
+        p++;
+        while (p < end && isdigit((unsigned char)*p)) {
+            result = (result * 10.0) + (double)(*p - '0');
+            exponent--;
+            has_digits = true;
+            p++;
+        }
+    }
+    if (!has_digits) {
+        return false;
+    }
 
-    comment = strchr(text, '#');
-    if (comment) {
-        *comment = '\0';
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        const char *exponent_cursor;
+        int exponent_value;
+
+        exponent_cursor = p + 1;
+        exponent_sign = 1;
+        exponent_value = 0;
+        if (exponent_cursor < end && (*exponent_cursor == '+' || *exponent_cursor == '-')) {
+            exponent_sign = *exponent_cursor == '-' ? -1 : 1;
+            exponent_cursor++;
+        }
+        // Like strtod, a bare 'e' is not part of the number.
+        if (exponent_cursor < end && isdigit((unsigned char)*exponent_cursor)) {
+            while (exponent_cursor < end && isdigit((unsigned char)*exponent_cursor)) {
+                if (exponent_value < 1000) {
+                    exponent_value = (exponent_value * 10) + (*exponent_cursor - '0');
+                }
+                exponent_cursor++;
+            }
+            exponent += exponent_sign * exponent_value;
+            p = exponent_cursor;
+        }
+    }
+
+    scale = 1.0;
+    while (exponent > 0) {
+        scale *= 10.0;
+        exponent--;
+    }
+    while (exponent < 0) {
+        scale /= 10.0;
+        exponent++;
     }
+    result *= scale;
+
+    *value = (float)(negative ? -result : result);
+    *cursor = p;
+    return true;
 }
 
-static bool parse_node_type(const char *token, NodeType *type) {
-    if (strcmp(token, "input") == 0) {
+static bool parse_node_type(CircuitTextView token, NodeType *type) {
+    if (text_view_equals(token, "input")) {
         *type = NODE_INPUT;
         return true;
     }
-    if (strcmp(token, "output") == 0) {
+    if (text_view_equals(token, "output")) {
         *type = NODE_OUTPUT;
         return true;
     }
-    if (strcmp(token, "and") == 0) {
+    if (text_view_equals(token, "and")) {
         *type = NODE_GATE_AND;
         return true;
     }
-    if (strcmp(token, "or") == 0) {
+    if (text_view_equals(token, "or")) {
         *type = NODE_GATE_OR;
         return true;
     }
-    if (strcmp(token, "not") == 0) {
+    if (text_view_equals(token, "not")) {
         *type = NODE_GATE_NOT;
         return true;
     }
-    if (strcmp(token, "xor") == 0) {
+    if (text_view_equals(token, "xor")) {
         *type = NODE_GATE_XOR;
         return true;
     }
-    if (strcmp(token, "dff") == 0) {
+    if (text_view_equals(token, "nand")) {
+        *type = NODE_GATE_NAND;
+        return true;
+    }
+    if (text_view_equals(token, "nor")) {
+        *type = NODE_GATE_NOR;
+        return true;
+    }
+    if (text_view_equals(token, "dff")) {
         *type = NODE_GATE_DFF;
         return true;
     }
-    if (strcmp(token, "clock") == 0) {
+    if (text_view_equals(token, "latch")) {
+        *type = NODE_GATE_LATCH;
+        return true;
+    }
+    if (text_view_equals(token, "clock")) {
         *type = NODE_GATE_CLOCK;
         return true;
     }
@@ -129,70 +249,59 @@ static bool parse_node_type(const char *token, NodeType *type) {
     return false;
 }
 
-static CircuitDocumentNode *find_document_node(CircuitDocument *document, const char *name) {
-    uint32_t index;
+static int32_t find_document_node_index(const CircuitDocument *document, CircuitTextView name) {
+    uint16_t index;
 
-    for (index = 0U; index < document->node_count; index++) {
-        if (strcmp(document->nodes[index].name, name) == 0) {
-            return &document->nodes[index];
-        }
+    if (!name_index_find(&document->names, name.data, name.length, &index)) {
+        return -1;
     }
-
-    return NULL;
+    return (int32_t)index;
 }
 
-static int32_t find_document_node_index(const CircuitDocument *document, const char *name) {
+static bool parse_endpoint(CircuitTextView text, CircuitEndpoint *endpoint) {
+    const char *dot;
+    const char *cursor;
+    const char *end;
     uint32_t index;
 
-    for (index = 0U; index < document->node_count; index++) {
-        if (strcmp(document->nodes[index].name, name) == 0) {
-            return (int32_t)index;
-        }
-    }
-
-    return -1;
-}
-
-static bool parse_endpoint(const char *text, CircuitEndpoint *endpoint) {
-    char buffer[PARSED_NAME_MAX];
-    char *dot;
-    char *endptr;
-    long index;
-
     memset(endpoint, 0, sizeof(*endpoint));
-    if (strlen(text) >= sizeof(buffer)) {
+    if (text.length >= PARSED_NAME_MAX) {
         return false;
     }
 
-    snprintf(buffer, sizeof(buffer), "%s", text);
-    dot = strchr(buffer, '.');
+    endpoint->node_name = text;
+    dot = (const char *)memchr(text.data, '.', text.length);
     if (!dot) {
-        snprintf(endpoint->node_name, sizeof(endpoint->node_name), "%s", buffer);
         endpoint->pin_index = 0U;
         return true;
     }
 
-    *dot = '\0';
-    dot++;
-    snprintf(endpoint->node_name, sizeof(endpoint->node_name), "%s", buffer);
-
-    if (strncmp(dot, "out", 3) == 0) {
+    endpoint->node_name.length = (size_t)(dot - text.data);
+    cursor = dot + 1;
+    end = text.data + text.length;
+    if (end - cursor >= 3 && memcmp(cursor, "out", 3U) == 0) {
         endpoint->is_output_pin = true;
-        dot += 3;
-    } else if (strncmp(dot, "in", 2) == 0) {
+        cursor += 3;
+    } else if (end - cursor >= 2 && memcmp(cursor, "in", 2U) == 0) {
         endpoint->is_output_pin = false;
-        dot += 2;
+        cursor += 2;
     } else {
         return false;
     }
 
-    if (*dot == '\0') {
+    if (cursor == end) {
         return false;
     }
 
-    index = strtol(dot, &endptr, 10);
-    if (*endptr != '\0' || index < 0L || index > 255L) {
-        return false;
+    index = 0U;
+    for (; cursor < end; cursor++) {
+        if (!isdigit((unsigned char)*cursor)) {
+            return false;
+        }
+        index = (index * 10U) + (uint32_t)(*cursor - '0');
+        if (index > 255U) {
+            return false;
+        }
     }
 
     endpoint->explicit_pin = true;
@@ -200,42 +309,51 @@ static bool parse_endpoint(const char *text, CircuitEndpoint *endpoint) {
     return true;
 }
 
-static bool parse_position_clause(const char *text, Vector2 *position) {
+// Accepts "at X,Y" with optional spaces around the comma.
+static bool parse_position_clause(CircuitTextView text, CircuitPosition *position) {
+    const char *cursor;
+    const char *end;
     float x;
     float y;
 
-    if (sscanf(text, "at %f , %f", &x, &y) == 2) {
-        position->x = x;
-        position->y = y;
-        return true;
+    cursor = text.data;
+    end = text.data + text.length;
+    if (end - cursor < 2 || cursor[0] != 'a' || cursor[1] != 't') {
+        return false;
     }
-    if (sscanf(text, "at %f,%f", &x, &y) == 2) {
-        position->x = x;
-        position->y = y;
-        return true;
+    cursor += 2;
+    if (!parse_float(&cursor, end, &x)) {
+        return false;
+    }
+    cursor = skip_spaces(cursor, end);
+    if (cursor == end || *cursor != ',') {
+        return false;
+    }
+    cursor++;
+    if (!parse_float(&cursor, end, &y)) {
+        return false;
     }
 
-    return false;
+    position->x = x;
+    position->y = y;
+    return true;
 }
 
 static bool parse_node_line(
     CircuitDocument *document,
-    char *line,
+    CircuitTextView line,
     unsigned int line_number,
     char *error_message,
     size_t error_message_size
 ) {
-    char *kind_token;
-    char *name_token;
-    char *rest;
+    CircuitTextView kind_token;
+    CircuitTextView name_token;
+    CircuitTextView rest;
     NodeType type;
     CircuitDocumentNode *node;
 
-    kind_token = strtok(line, " \t");
-    name_token = strtok(NULL, " \t");
-    rest = strtok(NULL, "");
-
-    if (!kind_token || !name_token) {
+    rest = line;
+    if (!text_view_next_token(&rest, &kind_token) || !text_view_next_token(&rest, &name_token)) {
         set_error(error_message, error_message_size, "node declaration needs a type and name", line_number);
         return false;
     }
@@ -243,26 +361,28 @@ static bool parse_node_line(
         set_error(error_message, error_message_size, "unknown node type", line_number);
         return false;
     }
-    if (find_document_node(document, name_token)) {
-        set_error(error_message, error_message_size, "duplicate node name", line_number);
+    if (name_token.length >= PARSED_NAME_MAX) {
+        set_error(error_message, error_message_size, "node name is too long", line_number);
         return false;
     }
-    if (document->node_count >= MAX_NODES) {
+    if (document->node_count >= document->node_capacity) {
         set_error(error_message, error_message_size, "too many nodes", line_number);
         return false;
     }
 
-    node = &document->nodes[document->node_count++];
+    node = &document->nodes[document->node_count];
     memset(node, 0, sizeof(*node));
     node->type = type;
-    snprintf(node->name, sizeof(node->name), "%s", name_token);
-
-    if (!rest) {
-        return true;
+    memcpy(node->name, name_token.data, name_token.length);
+    node->name[name_token.length] = '\0';
+    if (!name_index_insert(&document->names, node->name, name_token.length, (uint16_t)document->node_count)) {
+        set_error(error_message, error_message_size, "duplicate node name", line_number);
+        return false;
     }
+    document->node_count++;
 
-    rest = trim_whitespace(rest);
-    if (*rest == '\0') {
+    rest = text_view_trim(rest);
+    if (rest.length == 0U) {
         return true;
     }
     if (!parse_position_clause(rest, &node->position)) {
@@ -275,25 +395,24 @@ static bool parse_node_line(
 
 static bool parse_wire_line(
     CircuitDocument *document,
-    char *line,
+    CircuitTextView rest,
     unsigned int line_number,
     char *error_message,
     size_t error_message_size
 ) {
-    char *source_token;
-    char *arrow_token;
-    char *sink_token;
+    CircuitTextView source_token;
+    CircuitTextView arrow_token;
+    CircuitTextView sink_token;
     CircuitDocumentWire *wire;
 
-    source_token = strtok(line, " \t");
-    arrow_token = strtok(NULL, " \t");
-    sink_token = strtok(NULL, " \t");
-
-    if (!source_token || !arrow_token || !sink_token || strcmp(arrow_token, "->") != 0) {
+    if (!text_view_next_token(&rest, &source_token) ||
+        !text_view_next_token(&rest, &arrow_token) ||
+        !text_view_next_token(&rest, &sink_token) ||
+        !text_view_equals(arrow_token, "->")) {
         set_error(error_message, error_message_size, "wire declaration must look like 'wire A -> G1.in0'", line_number);
         return false;
     }
-    if (document->wire_count >= MAX_NETS) {
+    if (document->wire_count >= document->wire_capacity) {
         set_error(error_message, error_message_size, "too many wires", line_number);
         return false;
     }
@@ -312,69 +431,113 @@ static bool parse_wire_line(
     return true;
 }
 
-static bool parse_circuit_text(const char *text, CircuitDocument *document, char *error_message, size_t error_message_size) {
-    char *buffer;
-    char *cursor;
+static uint32_t count_text_lines(const char *text, size_t size) {
+    const char *cursor;
+    const char *end;
+    uint32_t line_count;
+
+    cursor = text;
+    end = text + size;
+    line_count = 1U;
+    while (cursor < end) {
+        cursor = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+        if (!cursor) {
+            break;
+        }
+        cursor++;
+        line_count++;
+    }
+    return line_count;
+}
+
+// Single pass over the source text. Wire endpoints stay views into `text` and
+// the document's arrays come from `arena`, so both must outlive the document.
+static bool parse_circuit_text(
+    const char *text,
+    size_t size,
+    Arena *arena,
+    CircuitDocument *document,
+    char *error_message,
+    size_t error_message_size
+) {
+    NameIndexSlot *name_slots;
+    const char *cursor;
+    const char *end;
+    uint32_t line_count;
+    uint32_t name_capacity;
     unsigned int line_number;
 
     memset(document, 0, sizeof(*document));
-    buffer = strdup(text);
-    if (!buffer) {
+    line_count = count_text_lines(text, size);
+    document->node_capacity = line_count < MAX_NODES ? line_count : MAX_NODES;
+    document->wire_capacity = line_count < MAX_NETS ? line_count : MAX_NETS;
+    name_capacity = name_index_capacity_for(document->node_capacity);
+    document->nodes = (CircuitDocumentNode *)arena_alloc(arena, document->node_capacity * sizeof(*document->nodes));
+    document->wires = (CircuitDocumentWire *)arena_alloc(arena, document->wire_capacity * sizeof(*document->wires));
+    name_slots = (NameIndexSlot *)arena_alloc(arena, name_capacity * sizeof(*name_slots));
+    if (!document->nodes || !document->wires || !name_slots) {
         set_error(error_message, error_message_size, "out of memory", 0U);
         return false;
     }
+    name_index_init(&document->names, name_slots, name_capacity);
 
-    cursor = buffer;
+    cursor = text;
+    end = text + size;
     line_number = 0U;
-    while (cursor && *cursor != '\0') {
-        char *line_end;
-        char *line;
-
-        line_end = strchr(cursor, '\n');
-        if (line_end) {
-            *line_end = '\0';
+    while (cursor < end) {
+        const char *line_end;
+        const char *comment;
+        CircuitTextView line;
+        CircuitTextView rest;
+        CircuitTextView kind_token;
+
+        line_end = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+        if (!line_end) {
+            line_end = end;
         }
 
         line_number++;
-        line = trim_whitespace(cursor);
-        strip_comment(line);
-        line = trim_whitespace(line);
-        if (*line != '\0') {
-            if (strncmp(line, "wire ", 5) == 0) {
-                if (!parse_wire_line(document, line + 5, line_number, error_message, error_message_size)) {
-                    free(buffer);
+        line.data = cursor;
+        line.length = (size_t)(line_end - cursor);
+        comment = (const char *)memchr(line.data, '#', line.length);
+        if (comment) {
+            line.length = (size_t)(comment - line.data);
+        }
+        line = text_view_trim(line);
+        rest = line;
+        if (text_view_next_token(&rest, &kind_token)) {
+            if (text_view_equals(kind_token, "wire")) {
+                if (!parse_wire_line(document, rest, line_number, error_message, error_message_size)) {
                     return false;
                 }
             } else if (!parse_node_line(document, line, line_number, error_message, error_message_size)) {
-                free(buffer);
                 return false;
             }
         }
 
-        cursor = line_end ? line_end + 1 : NULL;
+        cursor = line_end < end ? line_end + 1 : end;
     }
 
-    free(buffer);
     return true;
 }
 
-static void document_node_pin_counts(const CircuitDocumentNode *node, uint8_t *input_count, uint8_t *output_count) {
-    if (node->type == NODE_INPUT || node->type == NODE_GATE_CLOCK) {
+static void node_type_pin_counts(NodeType type, uint8_t *input_count, uint8_t *output_count) {
+    if (type == NODE_INPUT || type == NODE_GATE_CLOCK) {
         *input_count = 0U;
         *output_count = 1U;
         return;
     }
-    if (node->type == NODE_OUTPUT) {
+    if (type == NODE_OUTPUT) {
         *input_count = 1U;
         *output_count = 0U;
         return;
     }
-    if (node->type == NODE_GATE_NOT) {
+    if (type == NODE_GATE_NOT) {
         *input_count = 1U;
         *output_count = 1U;
         return;
     }
-    if (node->type == NODE_GATE_DFF) {
+    if (type == NODE_GATE_DFF) {
         *input_count = 2U;
         *output_count = 1U;
         return;
@@ -388,7 +551,7 @@ static bool resolve_source_pin(const CircuitDocumentNode *node, const CircuitEnd
     uint8_t input_count;
     uint8_t output_count;
 
-    document_node_pin_counts(node, &input_count, &output_count);
+    node_type_pin_counts(node->type, &input_count, &output_count);
     if (endpoint->explicit_pin) {
         if (!endpoint->is_output_pin || endpoint->pin_index >= output_count) {
             return false;
@@ -408,7 +571,7 @@ static bool resolve_sink_pin(const CircuitDocumentNode *node, const CircuitEndpo
     uint8_t input_count;
     uint8_t output_count;
 
-    document_node_pin_counts(node, &input_count, &output_count);
+    node_type_pin_counts(node->type, &input_count, &output_count);
     if (endpoint->explicit_pin) {
         if (endpoint->is_output_pin || endpoint->pin_index >= input_count) {
             return false;
@@ -426,20 +589,32 @@ static bool resolve_sink_pin(const CircuitDocumentNode *node, const CircuitEndpo
 
 static bool build_layout_spec(
     const CircuitDocument *document,
-    CircuitLayoutNode *layout_nodes,
-    CircuitLayoutEdge *layout_edges,
+    Arena *arena,
+    CircuitLayoutNode **layout_nodes_out,
+    CircuitLayoutEdge **layout_edges_out,
     uint32_t *layout_edge_count,
     char *error_message,
     size_t error_message_size
 ) {
+    CircuitLayoutNode *layout_nodes;
+    CircuitLayoutEdge *layout_edges;
     uint32_t node_index;
     uint32_t wire_index;
 
+    layout_nodes = (CircuitLayoutNode *)arena_alloc(arena, document->node_count * sizeof(*layout_nodes));
+    layout_edges = (CircuitLayoutEdge *)arena_alloc(arena, document->wire_count * sizeof(*layout_edges));
+    if (!layout_nodes || !layout_edges) {
+        set_error(error_message, error_message_size, "out of memory", 0U);
+        return false;
+    }
+    *layout_nodes_out = layout_nodes;
+    *layout_edges_out = layout_edges;
+
     for (node_index = 0U; node_index < document->node_count; node_index++) {
         uint8_t input_count;
         uint8_t output_count;
 
-        document_node_pin_counts(&document->nodes[node_index], &input_count, &output_count);
+        node_type_pin_counts(document->nodes[node_index].type, &input_count, &output_count);
         layout_nodes[node_index].type = document->nodes[node_index].type;
         layout_nodes[node_index].name = document->nodes[node_index].name;
         layout_nodes[node_index].input_count = input_count;
@@ -480,151 +655,618 @@ static bool build_layout_spec(
     return true;
 }
 
-static void capture_load_settings(const AppContext *app, AppLoadSettings *settings) {
-    settings->mode = app->mode;
-    settings->active_tool = app->active_tool;
-    settings->focused_panel = app->selection.focused_panel;
-    settings->target_graph = app->comparison.target_graph;
-    settings->simulation_speed = app->simulation.speed;
-    settings->live_reload = app->source.live_reload;
-    snprintf(settings->source_path, sizeof(settings->source_path), "%s", app->source.path);
+
+// Small files, which is every circuit someone edits by hand, are read into a
+// buffer: an editor truncating the file in place while the watcher reloads it
+// must not kill the app. Large generated files are mapped, and dropped back to
+// read() if the file changed between opening and mapping. The mapping still
+// must not outlive a concurrent writer: truncation during the parse faults
+// the read (SIGBUS), as with any mmap reader.
+static bool circuit_file_text_open(const char *path, CircuitFileText *text, char *error_message, size_t error_message_size) {
+    struct stat info;
+    struct stat mapped_info;
+    size_t offset;
+    int fd;
+
+    memset(text, 0, sizeof(*text));
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        set_error(error_message, error_message_size, "could not open circuit file", 0U);
+        return false;
+    }
+    if (fstat(fd, &info) != 0 || info.st_size < 0) {
+        close(fd);
+        set_error(error_message, error_message_size, "could not read circuit file size", 0U);
+        return false;
+    }
+
+    text->size = (size_t)info.st_size;
+    if (text->size == 0U) {
+        close(fd);
+        text->data = "";
+        return true;
+    }
+
+    if (text->size >= CIRCUIT_FILE_MAP_MIN_SIZE) {
+        text->mapping = mmap(NULL, text->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text->mapping != MAP_FAILED) {
+            mapped_info = info;
+            if (fstat(fd, &mapped_info) == 0 && mapped_info.st_size == info.st_size && mapped_info.st_mtime == info.st_mtime) {
+                close(fd);
+                text->data = (const char *)text->mapping;
+                return true;
+            }
+            // Being rewritten under us; read whatever is there now instead.
+            munmap(text->mapping, text->size);
+            if (mapped_info.st_size >= 0) {
+                text->size = (size_t)mapped_info.st_size;
+            }
+        }
+        // Not mappable (e.g. some network filesystems): read it.
+        text->mapping = NULL;
+    }
+
+    text->buffer = (char *)mem_alloc(MEM_TAG_LOADER, text->size);
+    if (!text->buffer) {
+        close(fd);
+        set_error(error_message, error_message_size, "out of memory", 0U);
+        return false;
+    }
+    offset = 0U;
+    while (offset < text->size) {
+        ssize_t count;
+
+        count = read(fd, text->buffer + offset, text->size - offset);
+        if (count == 0) {
+            // Truncated since the stat: parse what was there.
+            text->size = offset;
+            break;
+        }
+        if (count < 0) {
+            mem_free(text->buffer);
+            text->buffer = NULL;
+            close(fd);
+            set_error(error_message, error_message_size, "could not read circuit file", 0U);
+            return false;
+        }
+        offset += (size_t)count;
+    }
+    close(fd);
+    text->data = text->buffer;
+    return true;
 }
 
-static void restore_load_settings(AppContext *app, const AppLoadSettings *settings) {
-    app->mode = settings->mode;
-    app->active_tool = settings->active_tool;
-    app->selection.focused_panel = settings->focused_panel;
-    app->comparison.target_graph = settings->target_graph;
-    app->simulation.speed = settings->simulation_speed;
-    app->source.live_reload = settings->live_reload;
-    app_set_source_path(app, settings->source_path);
+static void circuit_file_text_close(CircuitFileText *text) {
+    if (text->mapping) {
+        munmap(text->mapping, text->size);
+    }
+    mem_free(text->buffer);
+    memset(text, 0, sizeof(*text));
 }
 
-static void reset_graph_after_failed_load(AppContext *app, const AppLoadSettings *settings) {
-    app_clear_graph(app);
-    restore_load_settings(app, settings);
+// Document, layout input and layout scratch share one arena per load; the
+// first block is sized from the file so small circuits stay small.
+static void circuit_load_arena_init(Arena *arena, const CircuitFileText *text) {
+    size_t per_line;
+
+    if (circuit_binary_detect(text->data, text->size)) {
+        arena_init(arena, 4096U + (text->size * 2U), MEM_TAG_LOADER);
+        return;
+    }
+
+    per_line =
+        sizeof(CircuitDocumentNode) +
+        sizeof(CircuitDocumentWire) +
+        (2U * sizeof(NameIndexSlot)) +
+        sizeof(CircuitLayoutNode) +
+        sizeof(CircuitLayoutEdge) +
+        sizeof(CircuitPosition);
+    arena_init(arena, 4096U + ((size_t)count_text_lines(text->data, text->size) * per_line), MEM_TAG_LOADER);
 }
 
-static bool apply_document(
-    AppContext *app,
-    const CircuitDocument *document,
+// Binary files and imported netlists carry resolved indices, so only the pin
+// numbers (and the graph limits) are left to check.
+static bool check_spec(CircuitSpec *spec, char *error_message, size_t error_message_size) {
+    uint32_t index;
+
+    if (spec->node_count > MAX_NODES) {
+        set_error(error_message, error_message_size, "too many nodes", 0U);
+        return false;
+    }
+    if (spec->edge_count > MAX_NETS) {
+        set_error(error_message, error_message_size, "too many wires", 0U);
+        return false;
+    }
+    for (index = 0U; index < spec->node_count; index++) {
+        node_type_pin_counts(spec->nodes[index].type, &spec->nodes[index].input_count, &spec->nodes[index].output_count);
+    }
+    for (index = 0U; index < spec->edge_count; index++) {
+        const CircuitLayoutEdge *edge;
+
+        edge = &spec->edges[index];
+        if (edge->source_pin_index >= spec->nodes[edge->source_node_index].output_count) {
+            set_error(error_message, error_message_size, "wire source pin is invalid", 0U);
+            return false;
+        }
+        if (edge->sink_pin_index >= spec->nodes[edge->sink_node_index].input_count) {
+            set_error(error_message, error_message_size, "wire sink pin is invalid", 0U);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Reads any supported format: .circb by its magic (whatever the suffix),
+// then structural Verilog by a .v suffix, ISCAS .bench by .bench, BLIF by
+// .blif, and the .circ text format otherwise. Names in the spec point into
+// `text` or `arena`, so both must outlive it.
+static bool load_circuit_spec(
+    const CircuitFileText *text,
+    const char *path,
+    Arena *arena,
+    CircuitSpec *spec,
     char *error_message,
     size_t error_message_size
 ) {
-    CircuitLayoutNode layout_nodes[MAX_NODES];
-    CircuitLayoutEdge layout_edges[MAX_NETS];
-    Vector2 layout_positions[MAX_NODES];
-    AppLoadSettings settings;
-    uint32_t layout_edge_count;
-    uint32_t node_index;
-    uint32_t wire_index;
+    CircuitDocument document;
 
-    if (!build_layout_spec(document, layout_nodes, layout_edges, &layout_edge_count, error_message, error_message_size)) {
-        return false;
+    memset(spec, 0, sizeof(*spec));
+    if (circuit_binary_detect(text->data, text->size)) {
+        return circuit_binary_decode(text->data, text->size, arena, spec, error_message, error_message_size) &&
+            check_spec(spec, error_message, error_message_size);
+    }
+    if (path_has_suffix(path, ".v")) {
+        return circuit_verilog_parse(text->data, text->size, arena, spec, error_message, error_message_size) &&
+            check_spec(spec, error_message, error_message_size);
+    }
+    if (path_has_suffix(path, ".bench")) {
+        return circuit_bench_parse(text->data, text->size, arena, spec, error_message, error_message_size) &&
+            check_spec(spec, error_message, error_message_size);
     }
-    if (!circuit_layout_resolve_positions(
-            layout_nodes,
-            document->node_count,
-            layout_edges,
-            layout_edge_count,
-            layout_positions
-        )) {
-        set_error(error_message, error_message_size, "could not lay out circuit", 0U);
+    if (path_has_suffix(path, ".blif")) {
+        return circuit_blif_parse(text->data, text->size, arena, spec, error_message, error_message_size) &&
+            check_spec(spec, error_message, error_message_size);
+    }
+
+    if (!parse_circuit_text(text->data, text->size, arena, &document, error_message, error_message_size) ||
+        !build_layout_spec(&document, arena, &spec->nodes, &spec->edges, &spec->edge_count, error_message, error_message_size)) {
         return false;
     }
+    spec->node_count = document.node_count;
+    return true;
+}
 
-    capture_load_settings(app, &settings);
-    app_clear_graph(app);
-    restore_load_settings(app, &settings);
+static const char *node_type_keyword(NodeType type) {
+    switch (type) {
+        case NODE_INPUT:
+            return "input";
+        case NODE_OUTPUT:
+            return "output";
+        case NODE_GATE_AND:
+            return "and";
+        case NODE_GATE_OR:
+            return "or";
+        case NODE_GATE_NOT:
+            return "not";
+        case NODE_GATE_XOR:
+            return "xor";
+        case NODE_GATE_NAND:
+            return "nand";
+        case NODE_GATE_NOR:
+            return "nor";
+        case NODE_GATE_DFF:
+            return "dff";
+        case NODE_GATE_LATCH:
+            return "latch";
+        case NODE_GATE_CLOCK:
+            return "clock";
+        default:
+            return NULL;
+    }
+}
 
-    for (node_index = 0U; node_index < document->node_count; node_index++) {
-        Vector2 position;
+bool circuit_file_write_text(FILE *stream, const CircuitSpec *spec, char *error_message, size_t error_message_size) {
+    uint32_t index;
 
-        position = app_snap_node_position(layout_positions[node_index], document->nodes[node_index].type);
-        if (!app_add_named_node(app, document->nodes[node_index].type, document->nodes[node_index].name, position)) {
-            set_error(error_message, error_message_size, "could not add node to graph", 0U);
-            reset_graph_after_failed_load(app, &settings);
+    for (index = 0U; index < spec->node_count; index++) {
+        const char *keyword;
+
+        keyword = node_type_keyword(spec->nodes[index].type);
+        if (!keyword) {
+            set_error(error_message, error_message_size, "node type has no .circ keyword", 0U);
             return false;
         }
+        fprintf(stream, "%s %s", keyword, spec->nodes[index].name);
+        if (spec->positions) {
+            fprintf(stream, " at %g,%g", (double)spec->positions[index].x, (double)spec->positions[index].y);
+        }
+        fputc('\n', stream);
+    }
+    if (spec->edge_count > 0U) {
+        fputc('\n', stream);
+    }
+    for (index = 0U; index < spec->edge_count; index++) {
+        const CircuitLayoutEdge *edge;
+
+        edge = &spec->edges[index];
+        fprintf(
+            stream,
+            "wire %s.out%u -> %s.in%u\n",
+            spec->nodes[edge->source_node_index].name,
+            (unsigned int)edge->source_pin_index,
+            spec->nodes[edge->sink_node_index].name,
+            (unsigned int)edge->sink_pin_index
+        );
     }
+    return true;
+}
 
-    for (wire_index = 0U; wire_index < document->wire_count; wire_index++) {
-        LogicNode *source_node;
-        LogicNode *sink_node;
-        LogicPin *source_pin;
-        LogicPin *sink_pin;
+bool circuit_file_open_spec(
+    const char *path,
+    CircuitFileText *text,
+    Arena *arena,
+    CircuitSpec *spec,
+    char *error_message,
+    size_t error_message_size
+) {
+    bool opened;
+
+    if (!path || !text || !arena || !spec) {
+        set_error(error_message, error_message_size, "missing path or spec", 0U);
+        return false;
+    }
 
-        source_node = &app->graph.nodes[layout_edges[wire_index].source_node_index];
-        sink_node = &app->graph.nodes[layout_edges[wire_index].sink_node_index];
-        source_pin = &source_node->outputs[layout_edges[wire_index].source_pin_index];
-        sink_pin = &sink_node->inputs[layout_edges[wire_index].sink_pin_index];
+    TRACE_BEGIN("circuit_file_open_spec");
+    opened = circuit_file_text_open(path, text, error_message, error_message_size);
+    if (opened) {
+        circuit_load_arena_init(arena, text);
+        opened = load_circuit_spec(text, path, arena, spec, error_message, error_message_size);
+        if (!opened) {
+            circuit_file_close_spec(text, arena);
+        }
+    }
+    TRACE_END();
+    return opened;
+}
 
-        if (!logic_connect(&app->graph, source_pin, sink_pin)) {
+void circuit_file_close_spec(CircuitFileText *text, Arena *arena) {
+    arena_release(arena);
+    circuit_file_text_close(text);
+}
+
+bool circuit_file_load_graph(LogicGraph *graph, const char *path, char *error_message, size_t error_message_size) {
+    CircuitFileText text;
+    CircuitSpec spec;
+    Arena arena;
+    uint32_t index;
+    bool loaded;
+
+    if (!graph || !path) {
+        set_error(error_message, error_message_size, "missing graph or path", 0U);
+        return false;
+    }
+
+    logic_clear_graph(graph);
+    if (!circuit_file_open_spec(path, &text, &arena, &spec, error_message, error_message_size)) {
+        return false;
+    }
+
+    loaded = true;
+    for (index = 0U; loaded && index < spec.node_count; index++) {
+        if (!logic_add_node(graph, spec.nodes[index].type, spec.nodes[index].name)) {
+            set_error(error_message, error_message_size, "could not add node to graph", 0U);
+            loaded = false;
+        }
+    }
+    for (index = 0U; loaded && index < spec.edge_count; index++) {
+        const CircuitLayoutEdge *edge;
+
+        edge = &spec.edges[index];
+        if (!logic_connect(
+                graph,
+                &graph->nodes[edge->source_node_index].outputs[edge->source_pin_index],
+                &graph->nodes[edge->sink_node_index].inputs[edge->sink_pin_index]
+            )) {
             set_error(error_message, error_message_size, "could not connect wire", 0U);
-            reset_graph_after_failed_load(app, &settings);
+            loaded = false;
+        }
+    }
+
+    circuit_file_close_spec(&text, &arena);
+    if (!loaded) {
+        logic_clear_graph(graph);
+    }
+    return loaded;
+}
+
+#define CIRCUIT_WRITER_BUFFER_SIZE (256U * 1024U)
+
+static pthread_once_t circuit_file_umask_once = PTHREAD_ONCE_INIT;
+static mode_t circuit_file_umask;
+
+// umask can only be read by setting it, so do that once rather than racing
+// other threads on every save.
+static void circuit_file_read_umask(void) {
+    circuit_file_umask = umask(022);
+    umask(circuit_file_umask);
+}
+
+// What open(O_CREAT, 0666) would have given a new file.
+static mode_t circuit_file_new_file_mode(void) {
+    pthread_once(&circuit_file_umask_once, circuit_file_read_umask);
+    return (mode_t)(0666U & ~(unsigned int)circuit_file_umask);
+}
+
+// Buffered output straight to a file descriptor; the first failed write
+// sticks, so callers only check once at the end.
+typedef struct {
+    char *buffer;
+    size_t used;
+    int fd;
+    bool failed;
+    uint8_t _padding[3];
+} CircuitWriter;
+
+static void circuit_writer_flush(CircuitWriter *writer) {
+    size_t offset;
+
+    offset = 0U;
+    while (!writer->failed && offset < writer->used) {
+        ssize_t written;
+
+        written = write(writer->fd, writer->buffer + offset, writer->used - offset);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            writer->failed = true;
+            break;
+        }
+        offset += (size_t)written;
+    }
+    writer->used = 0U;
+}
+
+static void circuit_writer_put(CircuitWriter *writer, const char *data, size_t length) {
+    if (writer->used + length > CIRCUIT_WRITER_BUFFER_SIZE) {
+        circuit_writer_flush(writer);
+    }
+    if (length > CIRCUIT_WRITER_BUFFER_SIZE) {
+        writer->failed = true;
+        return;
+    }
+    memcpy(writer->buffer + writer->used, data, length);
+    writer->used += length;
+}
+
+static void circuit_writer_put_text(CircuitWriter *writer, const char *text) {
+    circuit_writer_put(writer, text, strlen(text));
+}
+
+static void circuit_writer_put_unsigned(CircuitWriter *writer, uint32_t value) {
+    char digits[10];
+    size_t count;
+
+    count = 0U;
+    do {
+        digits[sizeof(digits) - 1U - count] = (char)('0' + (value % 10U));
+        value /= 10U;
+        count++;
+    } while (value > 0U);
+    circuit_writer_put(writer, digits + sizeof(digits) - count, count);
+}
+
+// Saved positions are grid-snapped, so the integer path is the common one.
+static void circuit_writer_put_float(CircuitWriter *writer, float value) {
+    char text[32];
+    int32_t integral;
+
+    integral = (int32_t)value;
+    if (value > -1.0e9f && value < 1.0e9f && fabsf(value - (float)integral) < 1.0e-6f) {
+        if (integral < 0) {
+            circuit_writer_put(writer, "-", 1U);
+        }
+        circuit_writer_put_unsigned(writer, integral < 0 ? (uint32_t)(-(int64_t)integral) : (uint32_t)integral);
+        return;
+    }
+    snprintf(text, sizeof(text), "%g", (double)value);
+    circuit_writer_put_text(writer, text);
+}
+
+// One pass over the nodes, then one over the nets. Deleted nodes are skipped,
+// so the indices a reader assigns need not match the graph's.
+static bool write_graph_text(
+    CircuitWriter *writer,
+    const LogicGraph *graph,
+    const CircuitPosition *positions,
+    char *error_message,
+    size_t error_message_size
+) {
+    uint32_t index;
+    uint8_t sink;
+
+    for (index = 0U; index < graph->node_count; index++) {
+        const LogicNode *node;
+        const char *keyword;
+
+        node = &graph->nodes[index];
+        if (node->type == (NodeType)-1) {
+            continue;
+        }
+        keyword = node_type_keyword(node->type);
+        if (!keyword) {
+            set_error(error_message, error_message_size, "node type has no .circ keyword", 0U);
             return false;
         }
+        if (!node->name || node->name[0] == '\0' || node->name[0] == '#' ||
+            strlen(node->name) >= PARSED_NAME_MAX || strpbrk(node->name, " \t\r\n.") != NULL) {
+            set_error(error_message, error_message_size, "node name cannot be saved", 0U);
+            return false;
+        }
+        circuit_writer_put_text(writer, keyword);
+        circuit_writer_put(writer, " ", 1U);
+        circuit_writer_put_text(writer, node->name);
+        if (positions) {
+            circuit_writer_put(writer, " at ", 4U);
+            circuit_writer_put_float(writer, positions[index].x);
+            circuit_writer_put(writer, ",", 1U);
+            circuit_writer_put_float(writer, positions[index].y);
+        }
+        circuit_writer_put(writer, "\n", 1U);
+    }
+
+    if (graph->net_count > 0U) {
+        circuit_writer_put(writer, "\n", 1U);
+    }
+    for (index = 0U; index < graph->net_count; index++) {
+        const LogicNet *net;
+
+        net = &graph->nets[index];
+        if (!net->source || !net->source->node) {
+            continue;
+        }
+        for (sink = 0U; sink < net->sink_count; sink++) {
+            circuit_writer_put(writer, "wire ", 5U);
+            circuit_writer_put_text(writer, net->source->node->name);
+            circuit_writer_put(writer, ".out", 4U);
+            circuit_writer_put_unsigned(writer, net->source->index);
+            circuit_writer_put(writer, " -> ", 4U);
+            circuit_writer_put_text(writer, net->sinks[sink]->node->name);
+            circuit_writer_put(writer, ".in", 3U);
+            circuit_writer_put_unsigned(writer, net->sinks[sink]->index);
+            circuit_writer_put(writer, "\n", 1U);
+        }
     }
 
-    app_update_logic(app);
     return true;
 }
 
-bool circuit_file_load(AppContext *app, const char *path, char *error_message, size_t error_message_size) {
-    FILE *file;
-    long size;
-    char *buffer;
-    CircuitDocument document;
-    bool parsed;
+// Creates the temporary file a save writes before renaming it over `path`.
+// mkstemp creates it private; it gets the mode of the file it replaces, or
+// the mode the user's umask asks for a new one.
+static int circuit_file_open_temp(
+    const char *path,
+    char *temp_path,
+    size_t temp_path_size,
+    char *error_message,
+    size_t error_message_size
+) {
+    struct stat info;
+    int fd;
 
-    if (!app || !path) {
-        set_error(error_message, error_message_size, "missing app or path", 0U);
-        return false;
+    if (snprintf(temp_path, temp_path_size, "%s.XXXXXX", path) >= (int)temp_path_size) {
+        set_error(error_message, error_message_size, "path is too long", 0U);
+        return -1;
     }
+    fd = mkstemp(temp_path);
+    if (fd < 0) {
+        set_error(error_message, error_message_size, "could not create temporary file", 0U);
+        return -1;
+    }
+    fchmod(fd, stat(path, &info) == 0 ? (mode_t)(info.st_mode & 07777) : circuit_file_new_file_mode());
+    return fd;
+}
 
-    file = fopen(path, "rb");
-    if (!file) {
-        set_error(error_message, error_message_size, "could not open circuit file", 0U);
-        return false;
+// Renames a fully written temporary file into place, or removes it when the
+// save failed, so a reader (the live-reload watcher included) only ever sees
+// the old file or the complete new one.
+static bool circuit_file_commit_temp(
+    const char *temp_path,
+    const char *path,
+    bool saved,
+    char *error_message,
+    size_t error_message_size
+) {
+    if (saved && rename(temp_path, path) != 0) {
+        set_error(error_message, error_message_size, "could not replace file", 0U);
+        saved = false;
+    }
+    if (!saved) {
+        unlink(temp_path);
     }
-    if (fseek(file, 0L, SEEK_END) != 0) {
-        fclose(file);
-        set_error(error_message, error_message_size, "could not seek circuit file", 0U);
+    return saved;
+}
+
+bool circuit_file_save(
+    const LogicGraph *graph,
+    const CircuitPosition *positions,
+    const char *path,
+    char *error_message,
+    size_t error_message_size
+) {
+    CircuitWriter writer;
+    char temp_path[CIRCUIT_FILE_PATH_MAX + 16];
+    bool saved;
+
+    if (!graph || !path) {
+        set_error(error_message, error_message_size, "missing graph or path", 0U);
         return false;
     }
 
-    size = ftell(file);
-    if (size < 0L) {
-        fclose(file);
-        set_error(error_message, error_message_size, "could not read circuit file size", 0U);
+    memset(&writer, 0, sizeof(writer));
+    writer.buffer = (char *)mem_alloc(MEM_TAG_LOADER, CIRCUIT_WRITER_BUFFER_SIZE);
+    if (!writer.buffer) {
+        set_error(error_message, error_message_size, "out of memory", 0U);
         return false;
     }
-    if (fseek(file, 0L, SEEK_SET) != 0) {
-        fclose(file);
-        set_error(error_message, error_message_size, "could not rewind circuit file", 0U);
+    writer.fd = circuit_file_open_temp(path, temp_path, sizeof(temp_path), error_message, error_message_size);
+    if (writer.fd < 0) {
+        mem_free(writer.buffer);
         return false;
     }
 
-    buffer = (char *)calloc((size_t)size + 1U, sizeof(char));
-    if (!buffer) {
-        fclose(file);
-        set_error(error_message, error_message_size, "out of memory", 0U);
-        return false;
+    saved = write_graph_text(&writer, graph, positions, error_message, error_message_size);
+    circuit_writer_flush(&writer);
+    if (saved && (writer.failed || fsync(writer.fd) != 0)) {
+        set_error(error_message, error_message_size, "could not write file", 0U);
+        saved = false;
     }
+    if (close(writer.fd) != 0 && saved) {
+        set_error(error_message, error_message_size, "could not write file", 0U);
+        saved = false;
+    }
+    saved = circuit_file_commit_temp(temp_path, path, saved, error_message, error_message_size);
+
+    mem_free(writer.buffer);
+    return saved;
+}
+
+bool circuit_file_save_binary(
+    const CircuitSpec *spec,
+    Arena *arena,
+    const char *path,
+    char *error_message,
+    size_t error_message_size
+) {
+    char temp_path[CIRCUIT_FILE_PATH_MAX + 16];
+    FILE *stream;
+    int fd;
+    bool saved;
 
-    if (size > 0L && fread(buffer, (size_t)size, 1U, file) != 1U) {
-        free(buffer);
-        fclose(file);
-        set_error(error_message, error_message_size, "could not read circuit file", 0U);
+    if (!spec || !path) {
+        set_error(error_message, error_message_size, "missing circuit or path", 0U);
         return false;
     }
-    fclose(file);
-
-    parsed = parse_circuit_text(buffer, &document, error_message, error_message_size);
-    free(buffer);
-    if (!parsed) {
+    fd = circuit_file_open_temp(path, temp_path, sizeof(temp_path), error_message, error_message_size);
+    if (fd < 0) {
+        return false;
+    }
+    stream = fdopen(fd, "wb");
+    if (!stream) {
+        close(fd);
+        unlink(temp_path);
+        set_error(error_message, error_message_size, "could not create temporary file", 0U);
         return false;
     }
 
-    return apply_document(app, &document, error_message, error_message_size);
+    saved = circuit_binary_write(stream, spec, arena, error_message, error_message_size);
+    if (saved && (fflush(stream) != 0 || fsync(fd) != 0)) {
+        set_error(error_message, error_message_size, "could not write file", 0U);
+        saved = false;
+    }
+    if (fclose(stream) != 0 && saved) {
+        set_error(error_message, error_message_size, "could not write file", 0U);
+        saved = false;
+    }
+    return circuit_file_commit_temp(temp_path, path, saved, error_message, error_message_size);
 }
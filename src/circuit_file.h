@@ -3,8 +3,55 @@
 
 #include <stdbool.h>
 #include <stddef.h>
-#include "app.h"
+#include <stdio.h>
+#include "arena.h"
+#include "circuit_spec.h"
+#include "logic.h"
 
-bool circuit_file_load(AppContext *app, const char *path, char *error_message, size_t error_message_size);
+// Contents of a circuit file: large files are mapped read-only, small ones
+// (and anything that cannot be mapped) are read into `buffer`. Either way
+// `data` is not NUL-terminated, and a mapping must not outlive a concurrent
+// writer that may truncate the file.
+typedef struct {
+    const char *data;
+    size_t size;
+    void *mapping;
+    char *buffer;
+} CircuitFileText;
+
+// Reads any supported format into `spec`: .circb by its magic; Verilog,
+// .bench and BLIF by suffix; .circ otherwise. Names in the spec point into
+// `text` and `arena`, so keep both open until circuit_file_close_spec. On
+// failure nothing is left to close.
+bool circuit_file_open_spec(
+    const char *path,
+    CircuitFileText *text,
+    Arena *arena,
+    CircuitSpec *spec,
+    char *error_message,
+    size_t error_message_size
+);
+void circuit_file_close_spec(CircuitFileText *text, Arena *arena);
+bool circuit_file_write_text(FILE *stream, const CircuitSpec *spec, char *error_message, size_t error_message_size);
+
+bool circuit_file_load_graph(LogicGraph *graph, const char *path, char *error_message, size_t error_message_size);
+// Both savers write a temporary file next to `path` and rename it into place,
+// so a reader only ever sees the old file or the complete new one.
+// `positions` is indexed like graph->nodes; pass NULL to save without them.
+bool circuit_file_save(
+    const LogicGraph *graph,
+    const CircuitPosition *positions,
+    const char *path,
+    char *error_message,
+    size_t error_message_size
+);
+// Writes `spec` as .circb; `arena` is scratch for circuit_binary_write.
+bool circuit_file_save_binary(
+    const CircuitSpec *spec,
+    Arena *arena,
+    const char *path,
+    char *error_message,
+    size_t error_message_size
+);
 
 #endif // CIRCUIT_FILE_H
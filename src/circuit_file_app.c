@@ -0,0 +1,510 @@
+#include "circuit_file_app.h"
+#include "app_analysis.h"
+#include "app_canvas.h"
+#include "app_commands.h"
+#include "circuit_binary.h"
+#include "circuit_layout.h"
+#include "mem.h"
+#include "name_index.h"
+#include "text_util.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+#endif
+
+typedef struct {
+    AppMode mode;
+    AppTool active_tool;
+    AppPanelFocus focused_panel;
+    LogicGraph *target_graph;
+    float simulation_speed;
+    bool live_reload;
+    char source_path[APP_SOURCE_PATH_MAX];
+} AppLoadSettings;
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+static void capture_load_settings(const AppContext *app, AppLoadSettings *settings) {
+    settings->mode = app->mode;
+    settings->active_tool = app->active_tool;
+    settings->focused_panel = app->selection.focused_panel;
+    settings->target_graph = app->comparison.target_graph;
+    settings->simulation_speed = app->simulation.speed;
+    settings->live_reload = app->source.live_reload;
+    snprintf(settings->source_path, sizeof(settings->source_path), "%s", app->source.path);
+}
+
+static void restore_load_settings(AppContext *app, const AppLoadSettings *settings) {
+    app->mode = settings->mode;
+    app->active_tool = settings->active_tool;
+    app->selection.focused_panel = settings->focused_panel;
+    app->comparison.target_graph = settings->target_graph;
+    app->simulation.speed = settings->simulation_speed;
+    app->source.live_reload = settings->live_reload;
+    app_set_source_path(app, settings->source_path);
+}
+
+static void reset_graph_after_failed_load(AppContext *app, const AppLoadSettings *settings) {
+    app_clear_graph(app);
+    restore_load_settings(app, settings);
+}
+
+// Cached positions when the file has them, otherwise a fresh auto-layout.
+static CircuitPosition *resolve_spec_positions(const CircuitSpec *spec, Arena *arena, char *error_message, size_t error_message_size) {
+    CircuitPosition *layout_positions;
+    bool laid_out;
+
+    if (spec->positions) {
+        return spec->positions;
+    }
+
+    layout_positions = (CircuitPosition *)arena_alloc(arena, spec->node_count * sizeof(*layout_positions));
+    if (!layout_positions) {
+        set_error(error_message, error_message_size, "out of memory", 0U);
+        return NULL;
+    }
+    TRACE_BEGIN("circuit_layout_resolve_positions");
+    laid_out = circuit_layout_resolve_positions(
+        spec->nodes,
+        spec->node_count,
+        spec->edges,
+        spec->edge_count,
+        layout_positions,
+        arena
+    );
+    TRACE_END();
+    if (!laid_out) {
+        set_error(error_message, error_message_size, "could not lay out circuit", 0U);
+        return NULL;
+    }
+    return layout_positions;
+}
+
+// Adds the spec's nodes at their snapped positions and wires them up. Touches
+// nothing but `graph`, so it is safe off the UI thread.
+static bool build_spec_graph(
+    LogicGraph *graph,
+    GraphGeometry *geometry,
+    const CircuitSpec *spec,
+    const CircuitPosition *layout_positions,
+    char *error_message,
+    size_t error_message_size
+) {
+    uint32_t node_index;
+    uint32_t wire_index;
+
+    for (node_index = 0U; node_index < spec->node_count; node_index++) {
+        Vector2 position;
+
+        position.x = layout_positions[node_index].x;
+        position.y = layout_positions[node_index].y;
+        position = app_snap_node_position(position, spec->nodes[node_index].type);
+        if (!app_graph_add_node(graph, geometry, spec->nodes[node_index].type, spec->nodes[node_index].name, position)) {
+            set_error(error_message, error_message_size, "could not add node to graph", 0U);
+            return false;
+        }
+    }
+
+    for (wire_index = 0U; wire_index < spec->edge_count; wire_index++) {
+        const CircuitLayoutEdge *edge;
+        LogicNode *source_node;
+        LogicNode *sink_node;
+        LogicPin *source_pin;
+        LogicPin *sink_pin;
+
+        edge = &spec->edges[wire_index];
+        source_node = &graph->nodes[edge->source_node_index];
+        sink_node = &graph->nodes[edge->sink_node_index];
+        source_pin = &source_node->outputs[edge->source_pin_index];
+        sink_pin = &sink_node->inputs[edge->sink_pin_index];
+
+        if (!logic_connect(graph, source_pin, sink_pin)) {
+            set_error(error_message, error_message_size, "could not connect wire", 0U);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool apply_spec(
+    AppContext *app,
+    const CircuitSpec *spec,
+    Arena *arena,
+    char *error_message,
+    size_t error_message_size
+) {
+    CircuitPosition *layout_positions;
+    AppLoadSettings settings;
+    bool built;
+
+    layout_positions = resolve_spec_positions(spec, arena, error_message, error_message_size);
+    if (!layout_positions) {
+        return false;
+    }
+
+    capture_load_settings(app, &settings);
+    app_clear_graph(app);
+    restore_load_settings(app, &settings);
+
+    TRACE_BEGIN("build_spec_graph");
+    built = build_spec_graph(&app->graph, &app->geometry, spec, layout_positions, error_message, error_message_size);
+    TRACE_END();
+    if (!built) {
+        reset_graph_after_failed_load(app, &settings);
+        return false;
+    }
+
+    app_update_logic(app);
+    return true;
+}
+
+bool circuit_file_load(AppContext *app, const char *path, char *error_message, size_t error_message_size) {
+    CircuitFileText text;
+    CircuitSpec spec;
+    LogicGraph *graph;
+    GraphGeometry *geometry;
+    Arena arena;
+    bool loaded;
+
+    if (!app || !path) {
+        set_error(error_message, error_message_size, "missing app or path", 0U);
+        return false;
+    }
+
+    // Reloading the open file edits the live graph rather than rebuilding it.
+    if (app->graph.node_count > 0U && strcmp(app->source.path, path) == 0) {
+        graph = (LogicGraph *)mem_calloc(MEM_TAG_GRAPH, 1U, sizeof(*graph));
+        geometry = (GraphGeometry *)mem_calloc(MEM_TAG_LAYOUT, 1U, sizeof(*geometry));
+        loaded = graph && geometry;
+        if (!loaded) {
+            set_error(error_message, error_message_size, "out of memory", 0U);
+        }
+        loaded = loaded && circuit_file_build_graph(graph, geometry, path, error_message, error_message_size);
+        if (loaded) {
+            circuit_file_merge_graph(app, graph, geometry);
+        }
+        mem_free(geometry);
+        mem_free(graph);
+        return loaded;
+    }
+
+    if (!circuit_file_open_spec(path, &text, &arena, &spec, error_message, error_message_size)) {
+        return false;
+    }
+
+    loaded = apply_spec(app, &spec, &arena, error_message, error_message_size);
+    circuit_file_close_spec(&text, &arena);
+    return loaded;
+}
+
+// Everything circuit_file_load does short of touching the app: parse, lay
+// out and build a positioned graph. Thread-safe; pair with
+// circuit_file_swap_graph on the UI thread.
+bool circuit_file_build_graph(
+    LogicGraph *graph,
+    GraphGeometry *geometry,
+    const char *path,
+    char *error_message,
+    size_t error_message_size
+) {
+    CircuitFileText text;
+    CircuitSpec spec;
+    CircuitPosition *layout_positions;
+    Arena arena;
+    bool loaded;
+
+    if (!graph || !geometry || !path) {
+        set_error(error_message, error_message_size, "missing graph or path", 0U);
+        return false;
+    }
+
+    logic_clear_graph(graph);
+    if (!circuit_file_open_spec(path, &text, &arena, &spec, error_message, error_message_size)) {
+        return false;
+    }
+
+    layout_positions = resolve_spec_positions(&spec, &arena, error_message, error_message_size);
+    TRACE_BEGIN("build_spec_graph");
+    loaded = layout_positions && build_spec_graph(graph, geometry, &spec, layout_positions, error_message, error_message_size);
+    TRACE_END();
+
+    circuit_file_close_spec(&text, &arena);
+    if (!loaded) {
+        logic_clear_graph(graph);
+    }
+    return loaded;
+}
+
+// Replaces the app's circuit with `graph` (left empty) laid out by
+// `geometry`, keeping the same settings a regular load keeps.
+void circuit_file_swap_graph(AppContext *app, LogicGraph *graph, const GraphGeometry *geometry) {
+    AppLoadSettings settings;
+
+    capture_load_settings(app, &settings);
+    app_clear_graph(app);
+    restore_load_settings(app, &settings);
+    logic_move_graph(&app->graph, graph);
+    memcpy(&app->geometry, geometry, sizeof(app->geometry));
+    app_update_logic(app);
+}
+
+#define MERGE_NO_DRIVER UINT32_MAX
+
+// Input pin drivers as (node index << 8 | output pin), one row per node.
+static void collect_graph_drivers(const LogicGraph *graph, uint32_t drivers[MAX_NODES][MAX_PINS]) {
+    uint32_t net_index;
+
+    memset(drivers, 0xFF, sizeof(uint32_t) * MAX_NODES * MAX_PINS);
+    for (net_index = 0U; net_index < graph->net_count; net_index++) {
+        const LogicNet *net;
+        uint32_t source;
+        uint8_t sink;
+
+        net = &graph->nets[net_index];
+        if (!net->source || !net->source->node) {
+            continue;
+        }
+        source = ((uint32_t)(net->source->node - graph->nodes) << 8) | net->source->index;
+        for (sink = 0U; sink < net->sink_count; sink++) {
+            drivers[net->sinks[sink]->node - graph->nodes][net->sinks[sink]->index] = source;
+        }
+    }
+}
+
+static void forget_removed_node(AppContext *app, const LogicNode *node) {
+    if (app->selection.selected_node == node) {
+        app->selection.selected_node = NULL;
+    }
+    if (app->selection.selected_wire_sink && app->selection.selected_wire_sink->node == node) {
+        app->selection.selected_wire_sink = NULL;
+    }
+    if (app->canvas.drag_node == node) {
+        app->canvas.drag_node = NULL;
+    }
+    if (app->interaction.active_pin && app->interaction.active_pin->node == node) {
+        app->interaction.active_pin = NULL;
+        app->interaction.wiring_active = false;
+    }
+    if (app->interaction.wire_drag_pin && app->interaction.wire_drag_pin->node == node) {
+        app_cancel_wire_drag(app);
+    }
+    if (app->interaction.wire_hover_pin && app->interaction.wire_hover_pin->node == node) {
+        app->interaction.wire_hover_pin = NULL;
+    }
+}
+
+// About 100 KB, so it lives on the heap rather than the UI thread's stack.
+typedef struct {
+    NameIndexSlot slots[2U * MAX_NODES];
+    uint32_t live_drivers[MAX_NODES][MAX_PINS];
+    uint32_t incoming_drivers[MAX_NODES][MAX_PINS];
+    uint16_t live_of[MAX_NODES];
+    bool kept[MAX_NODES];
+} MergeScratch;
+
+// Applies `incoming` to the live graph as edits: nodes match by name and type
+// and keep their position and state, and only input pins whose driver changed
+// are rewired. Returns false if the edit could not be made in place (the live
+// graph is out of node slots, or a connect failed); the caller then swaps the
+// whole graph in, which also repairs anything half-applied.
+static bool merge_graph(AppContext *app, const LogicGraph *incoming, const GraphGeometry *geometry, MergeScratch *scratch, bool *changed) {
+    uint32_t (*live_drivers)[MAX_PINS];
+    uint32_t (*incoming_drivers)[MAX_PINS];
+    NameIndex names;
+    uint16_t *live_of;
+    bool *kept;
+    LogicGraph *graph;
+    uint32_t added;
+    uint32_t index;
+    uint8_t pin;
+
+    graph = &app->graph;
+    live_drivers = scratch->live_drivers;
+    incoming_drivers = scratch->incoming_drivers;
+    live_of = scratch->live_of;
+    kept = scratch->kept;
+    *changed = false;
+    name_index_init(&names, scratch->slots, name_index_capacity_for(MAX_NODES));
+    for (index = 0U; index < graph->node_count; index++) {
+        if (graph->nodes[index].type != (NodeType)-1 && graph->nodes[index].name) {
+            name_index_insert(&names, graph->nodes[index].name, strlen(graph->nodes[index].name), (uint16_t)index);
+        }
+    }
+
+    memset(kept, 0, sizeof(scratch->kept));
+    added = 0U;
+    for (index = 0U; index < incoming->node_count; index++) {
+        const LogicNode *node;
+        uint16_t live;
+
+        node = &incoming->nodes[index];
+        live_of[index] = UINT16_MAX;
+        if (node->name && name_index_find(&names, node->name, strlen(node->name), &live) && graph->nodes[live].type == node->type) {
+            live_of[index] = live;
+            kept[live] = true;
+        } else {
+            added++;
+        }
+    }
+    if (graph->node_count + added > MAX_NODES) {
+        return false;
+    }
+
+    // Removing a node drops every net it touches, so rewiring is worked out
+    // only after removals and additions are done.
+    for (index = 0U; index < graph->node_count; index++) {
+        if (!kept[index] && graph->nodes[index].type != (NodeType)-1) {
+            forget_removed_node(app, &graph->nodes[index]);
+            logic_remove_node(graph, &graph->nodes[index]);
+            *changed = true;
+        }
+    }
+    for (index = 0U; index < incoming->node_count; index++) {
+        const LogicNode *node;
+        Vector2 position;
+
+        node = &incoming->nodes[index];
+        if (live_of[index] != UINT16_MAX) {
+            continue;
+        }
+        position.x = geometry->positions[index].x;
+        position.y = geometry->positions[index].y;
+        if (!app_graph_add_node(graph, &app->geometry, node->type, node->name, position)) {
+            return false;
+        }
+        live_of[index] = (uint16_t)(graph->node_count - 1U);
+        *changed = true;
+    }
+
+    collect_graph_drivers(graph, live_drivers);
+    collect_graph_drivers(incoming, incoming_drivers);
+    for (index = 0U; index < incoming->node_count; index++) {
+        for (pin = 0U; pin < incoming->nodes[index].input_count; pin++) {
+            uint32_t wanted;
+
+            wanted = incoming_drivers[index][pin];
+            if (wanted != MERGE_NO_DRIVER) {
+                wanted = ((uint32_t)live_of[wanted >> 8] << 8) | (wanted & 0xFFU);
+            }
+            incoming_drivers[index][pin] = wanted;
+            if (live_drivers[live_of[index]][pin] != MERGE_NO_DRIVER && live_drivers[live_of[index]][pin] != wanted) {
+                LogicPin *sink;
+
+                sink = &graph->nodes[live_of[index]].inputs[pin];
+                if (app->selection.selected_wire_sink == sink) {
+                    app->selection.selected_wire_sink = NULL;
+                }
+                logic_disconnect_sink(graph, sink);
+                *changed = true;
+            }
+        }
+    }
+    for (index = 0U; index < incoming->node_count; index++) {
+        for (pin = 0U; pin < incoming->nodes[index].input_count; pin++) {
+            uint32_t wanted;
+
+            wanted = incoming_drivers[index][pin];
+            if (wanted == MERGE_NO_DRIVER || live_drivers[live_of[index]][pin] == wanted) {
+                continue;
+            }
+            if (!logic_connect(graph, &graph->nodes[wanted >> 8].outputs[wanted & 0xFFU], &graph->nodes[live_of[index]].inputs[pin])) {
+                return false;
+            }
+            *changed = true;
+        }
+    }
+
+    return true;
+}
+
+// Reload path: brings the app in line with `graph` by editing what changed,
+// or by swapping it in whole when that is not possible. Returns true for an
+// in-place edit, where the view and everything unchanged is left alone.
+bool circuit_file_merge_graph(AppContext *app, LogicGraph *graph, const GraphGeometry *geometry) {
+    MergeScratch *scratch;
+    bool merged;
+    bool changed;
+
+    changed = false;
+    scratch = (MergeScratch *)mem_alloc(MEM_TAG_LOADER, sizeof(*scratch));
+    merged = scratch && merge_graph(app, graph, geometry, scratch, &changed);
+    mem_free(scratch);
+    if (!merged) {
+        circuit_file_swap_graph(app, graph, geometry);
+        return false;
+    }
+
+    logic_clear_graph(graph);
+    if (changed) {
+        app_update_logic(app);
+    }
+    return true;
+}
+
+// Either direction between .circ and .circb, picked by the output suffix.
+// Binary output always carries the auto-layout so opening it skips layout.
+bool circuit_file_convert(const char *input_path, const char *output_path, char *error_message, size_t error_message_size) {
+    CircuitFileText text;
+    CircuitSpec spec;
+    Arena arena;
+    FILE *stream;
+    bool binary;
+    bool converted;
+
+    if (!input_path || !output_path) {
+        set_error(error_message, error_message_size, "missing input or output path", 0U);
+        return false;
+    }
+    if (!circuit_file_open_spec(input_path, &text, &arena, &spec, error_message, error_message_size)) {
+        return false;
+    }
+
+    binary = path_has_suffix(output_path, ".circb");
+    converted = true;
+    if (binary && !spec.positions) {
+        uint32_t index;
+
+        spec.positions = (CircuitPosition *)arena_alloc(&arena, spec.node_count * sizeof(*spec.positions));
+        converted = spec.positions != NULL &&
+            circuit_layout_resolve_positions(spec.nodes, spec.node_count, spec.edges, spec.edge_count, spec.positions, &arena);
+        for (index = 0U; converted && index < spec.node_count; index++) {
+            Vector2 position;
+
+            position.x = spec.positions[index].x;
+            position.y = spec.positions[index].y;
+            position = app_snap_node_position(position, spec.nodes[index].type);
+            spec.positions[index].x = position.x;
+            spec.positions[index].y = position.y;
+        }
+        if (!converted) {
+            set_error(error_message, error_message_size, "could not lay out circuit", 0U);
+        }
+    }
+
+    if (converted) {
+        stream = fopen(output_path, binary ? "wb" : "w");
+        if (!stream) {
+            set_error(error_message, error_message_size, "could not open output file", 0U);
+            converted = false;
+        } else {
+            converted = binary
+                ? circuit_binary_write(stream, &spec, &arena, error_message, error_message_size)
+                : circuit_file_write_text(stream, &spec, error_message, error_message_size);
+            if (fclose(stream) != 0 && converted) {
+                set_error(error_message, error_message_size, "could not write output file", 0U);
+                converted = false;
+            }
+        }
+    }
+
+    circuit_file_close_spec(&text, &arena);
+    return converted;
+}
@@ -0,0 +1,23 @@
+#ifndef CIRCUIT_FILE_APP_H
+#define CIRCUIT_FILE_APP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "app.h"
+#include "circuit_file.h"
+
+// Editor side of circuit files: loads that lay out, snap and position nodes
+// for the canvas. The headless parts live in circuit_file.h.
+bool circuit_file_load(AppContext *app, const char *path, char *error_message, size_t error_message_size);
+bool circuit_file_build_graph(
+    LogicGraph *graph,
+    GraphGeometry *geometry,
+    const char *path,
+    char *error_message,
+    size_t error_message_size
+);
+void circuit_file_swap_graph(AppContext *app, LogicGraph *graph, const GraphGeometry *geometry);
+bool circuit_file_merge_graph(AppContext *app, LogicGraph *graph, const GraphGeometry *geometry);
+bool circuit_file_convert(const char *input_path, const char *output_path, char *error_message, size_t error_message_size);
+
+#endif // CIRCUIT_FILE_APP_H
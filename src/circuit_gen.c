@@ -0,0 +1,891 @@
+#include "circuit_gen.h"
+#include "arena.h"
+#include "circuit_file.h"
+#include "text_util.h"
+#include <stdio.h>
+#include <string.h>
+
+#define CIRCUIT_GEN_CLOCK_FANOUT 8U
+#define CIRCUIT_GEN_MAX_MULTIPLIER_BITS 16U
+#define CIRCUIT_GEN_MAX_SHIFTER_BITS 256U
+#define CIRCUIT_GEN_MIN_LFSR_BITS 2U
+#define CIRCUIT_GEN_MAX_LFSR_BITS 32U
+#define CIRCUIT_GEN_MAX_SELECTS 8U
+#define CIRCUIT_GEN_RANDOM_WINDOW 32U
+#define CIRCUIT_GEN_SPREAD_DRIVERS 32U // up to 256 sinks per fanned-out signal
+#define CIRCUIT_GEN_SPEC_ARENA (64U * 1024U)
+
+// Every helper is a no-op once `ok` drops, so builders check it once at the end.
+typedef struct {
+    LogicGraph *graph;
+    bool ok;
+    uint8_t _padding[7];
+} GenBuilder;
+
+// One signal's buffer tree: sink n is wired to drivers[n / MAX_PINS].
+typedef struct {
+    LogicNode *drivers[CIRCUIT_GEN_SPREAD_DRIVERS];
+    uint32_t count;
+    uint32_t next;
+} GenFanout;
+
+typedef struct {
+    uint8_t fanout[MAX_NODES];
+    uint32_t seed;
+    uint32_t max_fanout;
+    uint32_t skew;
+    uint8_t _padding[4];
+} GenRandom;
+
+static const char *const gen_kind_names[CIRCUIT_GEN_KIND_COUNT] = {
+    "ripple-adder",
+    "lookahead-adder",
+    "multiplier",
+    "barrel-shifter",
+    "lfsr",
+    "counter",
+    "decoder",
+    "shift-register",
+    "random-dag"
+};
+
+// Feedback taps (bit t-1 for stage t) of maximal-length XNOR LFSRs, indexed by width.
+static const uint32_t gen_lfsr_taps[CIRCUIT_GEN_MAX_LFSR_BITS + 1U] = {
+    0x0U, 0x0U, 0x3U, 0x6U, 0xCU, 0x14U, 0x30U, 0x60U, 0xB8U, 0x110U, 0x240U, 0x500U,
+    0x829U, 0x100DU, 0x2015U, 0x6000U, 0xD008U, 0x12000U, 0x20400U, 0x40023U, 0x90000U,
+    0x140000U, 0x300000U, 0x420000U, 0xE10000U, 0x1200000U, 0x2000023U, 0x4000013U,
+    0x9000000U, 0x14000000U, 0x20000029U, 0x48000000U, 0x80200003U
+};
+
+static void gen_begin(GenBuilder *builder, LogicGraph *graph) {
+    logic_clear_graph(graph);
+    builder->graph = graph;
+    builder->ok = true;
+}
+
+static LogicNode *gen_node(GenBuilder *builder, NodeType type, const char *prefix, uint32_t index) {
+    LogicNode *node;
+    char name[32];
+
+    if (!builder->ok) {
+        return NULL;
+    }
+    snprintf(name, sizeof(name), "%s%u", prefix, index);
+    node = logic_add_node(builder->graph, type, name);
+    builder->ok = node != NULL;
+    return node;
+}
+
+static void gen_wire(GenBuilder *builder, LogicNode *source, LogicNode *sink, uint8_t pin) {
+    if (!builder->ok || !source || !sink) {
+        builder->ok = false;
+        return;
+    }
+    builder->ok = logic_connect(builder->graph, &source->outputs[0], &sink->inputs[pin]);
+}
+
+// Internal gates are named G<node index>, which keeps names unique.
+static LogicNode *gen_gate(GenBuilder *builder, NodeType type, LogicNode *a, LogicNode *b) {
+    LogicNode *gate;
+
+    gate = gen_node(builder, type, "G", builder->graph->node_count);
+    gen_wire(builder, a, gate, 0U);
+    if (b) {
+        gen_wire(builder, b, gate, 1U);
+    }
+    return gate;
+}
+
+static LogicNode *gen_half_adder(GenBuilder *builder, LogicNode *a, LogicNode *b, LogicNode **carry) {
+    *carry = gen_gate(builder, NODE_GATE_AND, a, b);
+    return gen_gate(builder, NODE_GATE_XOR, a, b);
+}
+
+static LogicNode *gen_full_adder(GenBuilder *builder, LogicNode *a, LogicNode *b, LogicNode *carry_in, LogicNode **carry_out) {
+    LogicNode *partial;
+    LogicNode *generate;
+    LogicNode *propagate;
+
+    partial = gen_gate(builder, NODE_GATE_XOR, a, b);
+    generate = gen_gate(builder, NODE_GATE_AND, a, b);
+    propagate = gen_gate(builder, NODE_GATE_AND, partial, carry_in);
+    *carry_out = gen_gate(builder, NODE_GATE_OR, generate, propagate);
+    return gen_gate(builder, NODE_GATE_XOR, partial, carry_in);
+}
+
+static void gen_output(GenBuilder *builder, LogicNode *source, const char *prefix, uint32_t index) {
+    gen_wire(builder, source, gen_node(builder, NODE_OUTPUT, prefix, index), 0U);
+}
+
+static uint32_t gen_sinks_used(const LogicGraph *graph, const LogicNode *node) {
+    uint32_t index;
+
+    for (index = 0U; index < graph->net_count; index++) {
+        if (graph->nets[index].source == &node->outputs[0]) {
+            return graph->nets[index].sink_count;
+        }
+    }
+    return 0U;
+}
+
+// Makes room for `sinks` more loads on `source`. When its net cannot take
+// them, they go to fresh AND(x, x) buffers, eight per buffer, which are
+// themselves fanned out the same way; every load ends up at the same depth.
+static void gen_fanout(GenBuilder *builder, LogicNode *source, uint32_t sinks, GenFanout *fanout) {
+    GenFanout parents;
+    uint32_t used;
+    uint32_t index;
+
+    memset(fanout, 0, sizeof(*fanout));
+    if (!builder->ok || !source) {
+        builder->ok = false;
+        return;
+    }
+    used = gen_sinks_used(builder->graph, source);
+    if (used + sinks <= MAX_PINS) {
+        fanout->drivers[0] = source;
+        fanout->count = 1U;
+        return;
+    }
+    fanout->count = (sinks + MAX_PINS - 1U) / MAX_PINS;
+    if (fanout->count > CIRCUIT_GEN_SPREAD_DRIVERS || used + 2U > MAX_PINS) {
+        builder->ok = false;
+        return;
+    }
+    gen_fanout(builder, source, fanout->count * 2U, &parents);
+    for (index = 0U; index < fanout->count && builder->ok; index++) {
+        LogicNode *parent;
+
+        parent = parents.drivers[(index * 2U) / MAX_PINS];
+        fanout->drivers[index] = gen_gate(builder, NODE_GATE_AND, parent, parent);
+    }
+}
+
+static LogicNode *gen_fanout_next(GenFanout *fanout) {
+    uint32_t index;
+
+    index = fanout->next++ / MAX_PINS;
+    return index < fanout->count ? fanout->drivers[index] : NULL;
+}
+
+static bool gen_is_power_of_two(uint32_t value) {
+    return value != 0U && (value & (value - 1U)) == 0U;
+}
+
+// A0..An-1, B0..Bn-1 and CIN in; S0..Sn-1 and COUT out; 5 gates per bit.
+static bool gen_ripple_adder(GenBuilder *builder, uint32_t bits, char *error_message, size_t error_message_size) {
+    LogicNode *a[MAX_NODES];
+    LogicNode *b[MAX_NODES];
+    LogicNode *carry;
+    uint32_t bit;
+
+    if (bits == 0U || (bits * 8U) + 2U > MAX_NODES) {
+        set_error(error_message, error_message_size, "ripple adder width must be 1..127 bits", 0U);
+        return false;
+    }
+    for (bit = 0U; bit < bits; bit++) {
+        a[bit] = gen_node(builder, NODE_INPUT, "A", bit);
+        b[bit] = gen_node(builder, NODE_INPUT, "B", bit);
+    }
+    carry = gen_node(builder, NODE_INPUT, "CIN", 0U);
+    for (bit = 0U; bit < bits && builder->ok; bit++) {
+        LogicNode *next;
+
+        gen_output(builder, gen_full_adder(builder, a[bit], b[bit], carry, &next), "S", bit);
+        carry = next;
+    }
+    gen_output(builder, carry, "COUT", 0U);
+    return builder->ok;
+}
+
+// Pins, per-bit generate/propagate, the CIN fold and sums, plus a generate
+// (AND and OR) per bit at each prefix level and the group propagates.
+static uint32_t gen_lookahead_nodes(uint32_t bits) {
+    uint32_t nodes;
+    uint32_t span;
+
+    nodes = (6U * bits) + 4U;
+    for (span = 1U; span < bits; span *= 2U) {
+        nodes += 2U * (bits - span);
+        nodes += bits > span * 2U ? bits - (span * 2U) : 0U;
+    }
+    return nodes;
+}
+
+// Same pins as the ripple adder. Carries come from a Kogge-Stone prefix tree
+// over (generate, propagate) pairs, so the carry path is log2(n) levels deep;
+// group propagates are only built where a later level still reads them.
+static bool gen_lookahead_adder(GenBuilder *builder, uint32_t bits, char *error_message, size_t error_message_size) {
+    LogicNode *a[MAX_NODES];
+    LogicNode *b[MAX_NODES];
+    LogicNode *propagate[MAX_NODES];
+    LogicNode *group_generate[MAX_NODES];
+    LogicNode *group_propagate[MAX_NODES];
+    LogicNode *carry_in;
+    uint32_t span;
+    uint32_t bit;
+
+    if (bits == 0U || gen_lookahead_nodes(bits) > MAX_NODES) {
+        set_error(error_message, error_message_size, "lookahead adder width must be 1..52 bits", 0U);
+        return false;
+    }
+    for (bit = 0U; bit < bits; bit++) {
+        a[bit] = gen_node(builder, NODE_INPUT, "A", bit);
+        b[bit] = gen_node(builder, NODE_INPUT, "B", bit);
+    }
+    carry_in = gen_node(builder, NODE_INPUT, "CIN", 0U);
+    for (bit = 0U; bit < bits; bit++) {
+        propagate[bit] = gen_gate(builder, NODE_GATE_XOR, a[bit], b[bit]);
+        group_generate[bit] = gen_gate(builder, NODE_GATE_AND, a[bit], b[bit]);
+        group_propagate[bit] = propagate[bit];
+    }
+    // CIN folds into bit 0, so group_generate[i] ends up as the carry out of bit i.
+    group_generate[0] = gen_gate(
+        builder,
+        NODE_GATE_OR,
+        group_generate[0],
+        gen_gate(builder, NODE_GATE_AND, propagate[0], carry_in)
+    );
+
+    // Downwards, so [bit - span] still holds the previous level.
+    for (span = 1U; span < bits; span *= 2U) {
+        for (bit = bits - 1U; bit >= span && builder->ok; bit--) {
+            LogicNode *generate;
+
+            generate = gen_gate(
+                builder,
+                NODE_GATE_OR,
+                group_generate[bit],
+                gen_gate(builder, NODE_GATE_AND, group_propagate[bit], group_generate[bit - span])
+            );
+            if (bit >= span * 2U) {
+                group_propagate[bit] = gen_gate(builder, NODE_GATE_AND, group_propagate[bit], group_propagate[bit - span]);
+            }
+            group_generate[bit] = generate;
+        }
+    }
+
+    for (bit = 0U; bit < bits; bit++) {
+        gen_output(
+            builder,
+            gen_gate(builder, NODE_GATE_XOR, propagate[bit], bit == 0U ? carry_in : group_generate[bit - 1U]),
+            "S",
+            bit
+        );
+    }
+    gen_output(builder, group_generate[bits - 1U], "COUT", 0U);
+    return builder->ok;
+}
+
+// Array multiplier: n^2 partial-product ANDs summed row by row with ripple
+// adders. A0..An-1 and B0..Bn-1 in, P0..P2n-1 out. Past eight bits each
+// operand bit feeds its row or column through a buffer tree.
+static bool gen_multiplier(GenBuilder *builder, uint32_t bits, char *error_message, size_t error_message_size) {
+    GenFanout a[CIRCUIT_GEN_MAX_MULTIPLIER_BITS];
+    GenFanout b[CIRCUIT_GEN_MAX_MULTIPLIER_BITS];
+    LogicNode *sum[2U * CIRCUIT_GEN_MAX_MULTIPLIER_BITS];
+    LogicNode *pins[CIRCUIT_GEN_MAX_MULTIPLIER_BITS];
+    uint32_t row;
+    uint32_t bit;
+
+    if (bits == 0U || bits > CIRCUIT_GEN_MAX_MULTIPLIER_BITS) {
+        set_error(error_message, error_message_size, "multiplier width must be 1..16 bits", 0U);
+        return false;
+    }
+    memset(sum, 0, sizeof(sum));
+    for (bit = 0U; bit < bits; bit++) {
+        pins[bit] = gen_node(builder, NODE_INPUT, "A", bit);
+    }
+    for (bit = 0U; bit < bits; bit++) {
+        gen_fanout(builder, pins[bit], bits, &a[bit]);
+    }
+    for (bit = 0U; bit < bits; bit++) {
+        pins[bit] = gen_node(builder, NODE_INPUT, "B", bit);
+    }
+    for (bit = 0U; bit < bits; bit++) {
+        gen_fanout(builder, pins[bit], bits, &b[bit]);
+    }
+
+    for (row = 0U; row < bits && builder->ok; row++) {
+        LogicNode *carry;
+
+        carry = NULL;
+        for (bit = 0U; bit < bits; bit++) {
+            LogicNode *term;
+            LogicNode **slot;
+            LogicNode *next;
+
+            term = gen_gate(builder, NODE_GATE_AND, gen_fanout_next(&a[bit]), gen_fanout_next(&b[row]));
+            slot = &sum[row + bit];
+            if (!*slot && !carry) {
+                *slot = term;
+            } else if (!*slot || !carry) {
+                // An empty top slot still has to absorb the row's carry.
+                *slot = gen_half_adder(builder, *slot ? *slot : carry, term, &next);
+                carry = next;
+            } else {
+                *slot = gen_full_adder(builder, *slot, term, carry, &next);
+                carry = next;
+            }
+        }
+        if (carry) {
+            sum[row + bits] = carry;
+        }
+    }
+
+    for (bit = 0U; bit < 2U * bits; bit++) {
+        if (sum[bit]) {
+            gen_output(builder, sum[bit], "P", bit);
+        }
+    }
+    return builder->ok;
+}
+
+// Logical left shift: D0..Dn-1 and S0..S(log2 n - 1) in, Y0..Yn-1 out. Stage k
+// is a row of two-AND-one-OR muxes that shifts by 2^k when Sk is high, with
+// Sk and its complement fanned out across the row.
+static bool gen_barrel_shifter(GenBuilder *builder, uint32_t bits, char *error_message, size_t error_message_size) {
+    LogicNode *data[CIRCUIT_GEN_MAX_SHIFTER_BITS];
+    LogicNode *next[CIRCUIT_GEN_MAX_SHIFTER_BITS];
+    LogicNode *selects[CIRCUIT_GEN_MAX_SELECTS];
+    uint32_t select_count;
+    uint32_t stage;
+    uint32_t bit;
+
+    if (bits < 2U || bits > CIRCUIT_GEN_MAX_SHIFTER_BITS || !gen_is_power_of_two(bits)) {
+        set_error(error_message, error_message_size, "barrel shifter width must be a power of two from 2 to 256", 0U);
+        return false;
+    }
+    for (bit = 0U; bit < bits; bit++) {
+        data[bit] = gen_node(builder, NODE_INPUT, "D", bit);
+    }
+    select_count = 0U;
+    while ((1U << select_count) < bits) {
+        selects[select_count] = gen_node(builder, NODE_INPUT, "S", select_count);
+        select_count++;
+    }
+
+    for (stage = 0U; stage < select_count && builder->ok; stage++) {
+        GenFanout shift;
+        GenFanout keep;
+        uint32_t span;
+
+        span = 1U << stage;
+        gen_fanout(builder, gen_gate(builder, NODE_GATE_NOT, selects[stage], NULL), bits, &keep);
+        gen_fanout(builder, selects[stage], bits - span, &shift);
+        for (bit = 0U; bit < bits && builder->ok; bit++) {
+            next[bit] = gen_gate(builder, NODE_GATE_AND, data[bit], gen_fanout_next(&keep));
+            if (bit >= span) {
+                next[bit] = gen_gate(
+                    builder,
+                    NODE_GATE_OR,
+                    next[bit],
+                    gen_gate(builder, NODE_GATE_AND, data[bit - span], gen_fanout_next(&shift))
+                );
+            }
+        }
+        memcpy(data, next, bits * sizeof(data[0]));
+    }
+
+    for (bit = 0U; bit < bits; bit++) {
+        gen_output(builder, data[bit], "Y", bit);
+    }
+    return builder->ok;
+}
+
+// One CLOCK node per eight flip-flops; the clocks come first, so every
+// flip-flop sees the same edge within a tick.
+static void gen_clocks(GenBuilder *builder, uint32_t flip_flops, LogicNode **clocks) {
+    uint32_t index;
+
+    for (index = 0U; index * CIRCUIT_GEN_CLOCK_FANOUT < flip_flops; index++) {
+        clocks[index] = gen_node(builder, NODE_GATE_CLOCK, "CLK", index);
+    }
+}
+
+// Fibonacci LFSR: R0..Rn-1 shift up each rising edge and R0 takes the XNOR
+// of the taps, so the all-zero state is part of the 2^n - 1 cycle. Q0..Qn-1
+// out. The feedback gates are added before the flip-flops: logic_evaluate
+// sorts from the lowest node index, so starting at the XNOR puts every
+// flip-flop ahead of the gates that read it. The stages then go in last
+// first, as in the shift register, so each D is read before it shifts.
+static bool gen_lfsr(GenBuilder *builder, uint32_t bits, char *error_message, size_t error_message_size) {
+    LogicNode *clocks[CIRCUIT_GEN_MAX_LFSR_BITS / CIRCUIT_GEN_CLOCK_FANOUT];
+    LogicNode *stage[CIRCUIT_GEN_MAX_LFSR_BITS];
+    LogicNode *xors[CIRCUIT_GEN_MAX_LFSR_BITS];
+    LogicNode *feedback;
+    LogicNode *sum;
+    uint32_t xor_count;
+    uint32_t index;
+
+    if (bits < CIRCUIT_GEN_MIN_LFSR_BITS || bits > CIRCUIT_GEN_MAX_LFSR_BITS) {
+        set_error(error_message, error_message_size, "LFSR width must be 2..32 bits", 0U);
+        return false;
+    }
+    gen_clocks(builder, bits, clocks);
+    feedback = gen_node(builder, NODE_GATE_NOT, "G", builder->graph->node_count);
+    // One XOR per tap after the first.
+    xor_count = 0U;
+    for (index = 0U; index < bits; index++) {
+        if ((gen_lfsr_taps[bits] & (1U << index)) != 0U) {
+            xor_count++;
+        }
+    }
+    for (index = 0U; index + 1U < xor_count; index++) {
+        xors[index] = gen_node(builder, NODE_GATE_XOR, "G", builder->graph->node_count);
+    }
+    for (index = bits; index > 0U; index--) {
+        stage[index - 1U] = gen_node(builder, NODE_GATE_DFF, "R", index - 1U);
+    }
+    if (!builder->ok) {
+        return false;
+    }
+
+    sum = NULL;
+    xor_count = 0U;
+    for (index = 0U; index < bits; index++) {
+        if ((gen_lfsr_taps[bits] & (1U << index)) == 0U) {
+            continue;
+        }
+        if (sum) {
+            gen_wire(builder, sum, xors[xor_count], 0U);
+            gen_wire(builder, stage[index], xors[xor_count], 1U);
+            sum = xors[xor_count++];
+        } else {
+            sum = stage[index];
+        }
+    }
+    gen_wire(builder, sum, feedback, 0U);
+
+    for (index = 0U; index < bits; index++) {
+        gen_wire(builder, index == 0U ? feedback : stage[index - 1U], stage[index], 0U);
+        gen_wire(builder, clocks[index / CIRCUIT_GEN_CLOCK_FANOUT], stage[index], 1U);
+        gen_output(builder, stage[index], "Q", index);
+    }
+    return builder->ok;
+}
+
+// Synchronous up counter from toggle cells: Ri takes Ri XOR Ci, where C0 is
+// EN and Ci+1 = Ci AND Ri. EN in, Q0..Qn-1 out. The toggle XORs are added
+// first, lowest bit first, for the same reason as the LFSR's feedback: each
+// one then sorts after the flip-flops and carries it reads.
+static bool gen_counter(GenBuilder *builder, uint32_t bits, char *error_message, size_t error_message_size) {
+    LogicNode *clocks[MAX_NODES / CIRCUIT_GEN_CLOCK_FANOUT];
+    LogicNode *toggle[MAX_NODES / 4U];
+    LogicNode *stage[MAX_NODES / 4U];
+    LogicNode *carry;
+    uint32_t index;
+
+    if (bits == 0U || (bits * 4U) + ((bits + CIRCUIT_GEN_CLOCK_FANOUT - 1U) / CIRCUIT_GEN_CLOCK_FANOUT) > MAX_NODES) {
+        set_error(error_message, error_message_size, "counter width must be 1..248 bits", 0U);
+        return false;
+    }
+    carry = gen_node(builder, NODE_INPUT, "EN", 0U);
+    gen_clocks(builder, bits, clocks);
+    for (index = 0U; index < bits; index++) {
+        toggle[index] = gen_node(builder, NODE_GATE_XOR, "G", builder->graph->node_count);
+    }
+    for (index = 0U; index < bits; index++) {
+        stage[index] = gen_node(builder, NODE_GATE_DFF, "R", index);
+    }
+    for (index = 0U; index < bits && builder->ok; index++) {
+        gen_wire(builder, stage[index], toggle[index], 0U);
+        gen_wire(builder, carry, toggle[index], 1U);
+        gen_wire(builder, toggle[index], stage[index], 0U);
+        gen_wire(builder, clocks[index / CIRCUIT_GEN_CLOCK_FANOUT], stage[index], 1U);
+        gen_output(builder, stage[index], "Q", index);
+        if (index + 1U < bits) {
+            carry = gen_gate(builder, NODE_GATE_AND, carry, stage[index]);
+        }
+    }
+    return builder->ok;
+}
+
+// Minterms of `count` select lines, S0 the least significant: each half is
+// decoded recursively and every pair of half-minterms ANDed, so no literal
+// feeds more than a buffer tree's worth of gates.
+static void gen_decode(GenBuilder *builder, LogicNode **selects, uint32_t count, LogicNode **minterms) {
+    LogicNode *low[1U << (CIRCUIT_GEN_MAX_SELECTS / 2U)];
+    LogicNode *high[1U << (CIRCUIT_GEN_MAX_SELECTS - (CIRCUIT_GEN_MAX_SELECTS / 2U))];
+    GenFanout low_fanout[1U << (CIRCUIT_GEN_MAX_SELECTS / 2U)];
+    GenFanout high_fanout;
+    uint32_t low_count;
+    uint32_t high_count;
+    uint32_t low_index;
+    uint32_t high_index;
+
+    if (count == 1U) {
+        minterms[0] = gen_gate(builder, NODE_GATE_NOT, selects[0], NULL);
+        minterms[1] = selects[0];
+        return;
+    }
+    low_count = count / 2U;
+    high_count = count - low_count;
+    gen_decode(builder, selects, low_count, low);
+    gen_decode(builder, selects + low_count, high_count, high);
+    for (low_index = 0U; low_index < (1U << low_count); low_index++) {
+        gen_fanout(builder, low[low_index], 1U << high_count, &low_fanout[low_index]);
+    }
+    for (high_index = 0U; high_index < (1U << high_count) && builder->ok; high_index++) {
+        gen_fanout(builder, high[high_index], 1U << low_count, &high_fanout);
+        for (low_index = 0U; low_index < (1U << low_count); low_index++) {
+            minterms[(high_index << low_count) | low_index] = gen_gate(
+                builder,
+                NODE_GATE_AND,
+                gen_fanout_next(&low_fanout[low_index]),
+                gen_fanout_next(&high_fanout)
+            );
+        }
+    }
+}
+
+// S0..Sk-1 in, Y0..Y(2^k - 1) out with Yi high when S reads i.
+static bool gen_decoder(GenBuilder *builder, uint32_t bits, char *error_message, size_t error_message_size) {
+    LogicNode *selects[CIRCUIT_GEN_MAX_SELECTS];
+    LogicNode *minterms[1U << CIRCUIT_GEN_MAX_SELECTS];
+    uint32_t index;
+
+    if (bits == 0U || bits > CIRCUIT_GEN_MAX_SELECTS) {
+        set_error(error_message, error_message_size, "decoder must have 1..8 select lines", 0U);
+        return false;
+    }
+    for (index = 0U; index < bits; index++) {
+        selects[index] = gen_node(builder, NODE_INPUT, "S", index);
+    }
+    gen_decode(builder, selects, bits, minterms);
+    for (index = 0U; index < (1U << bits) && builder->ok; index++) {
+        gen_output(builder, minterms[index], "Y", index);
+    }
+    return builder->ok;
+}
+
+// SIN through `stages` DFFs to SOUT. The flip-flops are added last stage
+// first so logic_tick reads each D before the previous stage updates it, as
+// a real shift register does.
+static bool gen_shift_register(GenBuilder *builder, uint32_t stages, char *error_message, size_t error_message_size) {
+    LogicNode *stage[MAX_NODES];
+    LogicNode *clocks[MAX_NODES / CIRCUIT_GEN_CLOCK_FANOUT];
+    LogicNode *input;
+    uint32_t clock_count;
+    uint32_t index;
+
+    clock_count = (stages + CIRCUIT_GEN_CLOCK_FANOUT - 1U) / CIRCUIT_GEN_CLOCK_FANOUT;
+    if (stages == 0U || stages + clock_count + 2U > MAX_NODES) {
+        set_error(error_message, error_message_size, "shift register must have 1..908 stages", 0U);
+        return false;
+    }
+    input = gen_node(builder, NODE_INPUT, "SIN", 0U);
+    gen_clocks(builder, stages, clocks);
+    for (index = stages; index > 0U; index--) {
+        stage[index - 1U] = gen_node(builder, NODE_GATE_DFF, "R", index - 1U);
+    }
+    for (index = 0U; index < stages; index++) {
+        gen_wire(builder, index == 0U ? input : stage[index - 1U], stage[index], 0U);
+        gen_wire(builder, clocks[index / CIRCUIT_GEN_CLOCK_FANOUT], stage[index], 1U);
+    }
+    gen_output(builder, stage[stages - 1U], "SOUT", 0U);
+    return builder->ok;
+}
+
+static uint32_t gen_random(uint32_t *seed) {
+    *seed = (*seed * 1103515245U) + 12345U;
+    return (*seed >> 8) & 0xFFFFFFU;
+}
+
+// Picks a signal in [first, end) that still has room on its net, scanning
+// down to `fallback` when eight random tries all hit full nets. With a skew,
+// that share of tries draws twice and keeps the signal with more fanout
+// already, which stretches the fanout distribution into a long tail.
+static bool gen_pick_source(GenRandom *random, uint32_t first, uint32_t end, uint32_t fallback, uint32_t *picked) {
+    uint32_t attempt;
+    uint32_t candidate;
+
+    for (attempt = 0U; attempt < 8U; attempt++) {
+        candidate = end - 1U - (gen_random(&random->seed) % (end - first));
+        if (random->skew > 0U && gen_random(&random->seed) % 100U < random->skew) {
+            uint32_t other;
+
+            other = end - 1U - (gen_random(&random->seed) % (end - first));
+            if (random->fanout[other] > random->fanout[candidate] && random->fanout[other] < random->max_fanout) {
+                candidate = other;
+            }
+        }
+        if (random->fanout[candidate] < random->max_fanout) {
+            *picked = candidate;
+            return true;
+        }
+    }
+    for (candidate = end; candidate > fallback; candidate--) {
+        if (random->fanout[candidate - 1U] < random->max_fanout) {
+            *picked = candidate - 1U;
+            return true;
+        }
+    }
+    return false;
+}
+
+// IN0.. in, two-input gates of random kinds, and the last gates out as
+// OUT0... Without a depth each gate reads two of the 32 most recent signals.
+// With one, the gates are split into that many levels and each reads the
+// level just before it and anything earlier, so the longest path is exactly
+// `depth` gates.
+static bool gen_random_dag(GenBuilder *builder, const CircuitGenParams *params, char *error_message, size_t error_message_size) {
+    static const NodeType kinds[] = { NODE_GATE_AND, NODE_GATE_OR, NODE_GATE_XOR, NODE_GATE_NAND, NODE_GATE_NOR };
+    LogicNode *signals[MAX_NODES];
+    GenRandom random;
+    uint32_t level_first; // first signal of the previous level
+    uint32_t level_end; // first signal of the current level
+    uint32_t level_left; // gates still to place in the current level
+    uint32_t level;
+    uint32_t index;
+
+    if (params->inputs == 0U || params->outputs > params->gates ||
+        (uint64_t)params->inputs + params->gates + params->outputs > MAX_NODES) {
+        set_error(error_message, error_message_size, "random DAG needs inputs and at most 1024 nodes, with outputs <= gates", 0U);
+        return false;
+    }
+    if (params->max_fanout == 0U || params->max_fanout > MAX_PINS || params->fanout_skew > 100U) {
+        set_error(error_message, error_message_size, "fan-out must be 1..8 and skew 0..100", 0U);
+        return false;
+    }
+    if (params->depth > params->gates) {
+        set_error(error_message, error_message_size, "depth cannot exceed the gate count", 0U);
+        return false;
+    }
+
+    memset(&random, 0, sizeof(random));
+    random.seed = params->seed;
+    random.max_fanout = params->max_fanout;
+    random.skew = params->fanout_skew;
+    for (index = 0U; index < params->inputs; index++) {
+        signals[index] = gen_node(builder, NODE_INPUT, "IN", index);
+    }
+
+    level = 0U;
+
+    level_first = 0U;
+    level_end = 0U;
+    level_left = 0U;
+    for (index = 0U; index < params->gates && builder->ok; index++) {
+        uint32_t signal_count;
+        uint32_t first;
+        uint32_t second;
+        bool picked;
+
+        signal_count = params->inputs + index;
+        if (params->depth == 0U) {
+            uint32_t window;
+
+            window = signal_count < CIRCUIT_GEN_RANDOM_WINDOW ? signal_count : CIRCUIT_GEN_RANDOM_WINDOW;
+            picked = gen_pick_source(&random, signal_count - window, signal_count, 0U, &first);
+            if (picked) {
+                random.fanout[first]++;
+                picked = gen_pick_source(&random, signal_count - window, signal_count, 0U, &second);
+            }
+        } else {
+            // gates % depth levels get one gate more than the rest.
+            if (level_left == 0U) {
+                level_left = (params->gates / params->depth) + (level < params->gates % params->depth ? 1U : 0U);
+                level_first = level_end;
+                level_end = signal_count;
+                level++;
+            }
+            level_left--;
+            picked = gen_pick_source(&random, level_first, level_end, level_first, &first);
+            if (picked) {
+                random.fanout[first]++;
+                picked = gen_pick_source(&random, 0U, level_end, 0U, &second);
+            }
+        }
+        if (!picked) {
+            set_error(error_message, error_message_size, "ran out of signals with fan-out to spare; raise the fan-out or add inputs", 0U);
+            return false;
+        }
+        random.fanout[second]++;
+        signals[signal_count] = gen_gate(
+            builder,
+            kinds[gen_random(&random.seed) % (sizeof(kinds) / sizeof(kinds[0]))],
+            signals[first],
+            signals[second]
+        );
+    }
+    for (index = 0U; index < params->outputs; index++) {
+        gen_output(builder, signals[params->inputs + params->gates - 1U - index], "OUT", index);
+    }
+    return builder->ok;
+}
+
+void circuit_gen_params_init(CircuitGenParams *params, CircuitGenKind kind) {
+    memset(params, 0, sizeof(*params));
+    params->kind = kind;
+    switch (kind) {
+        case CIRCUIT_GEN_LFSR:
+        case CIRCUIT_GEN_SHIFT_REGISTER:
+            params->bits = 16U;
+            break;
+        case CIRCUIT_GEN_DECODER:
+            params->bits = 3U;
+            break;
+        case CIRCUIT_GEN_RIPPLE_ADDER:
+        case CIRCUIT_GEN_LOOKAHEAD_ADDER:
+        case CIRCUIT_GEN_MULTIPLIER:
+        case CIRCUIT_GEN_BARREL_SHIFTER:
+        case CIRCUIT_GEN_COUNTER:
+        case CIRCUIT_GEN_RANDOM_DAG:
+        default:
+            params->bits = 8U;
+            break;
+    }
+    params->seed = 1U;
+    params->inputs = 8U;
+    params->gates = 200U;
+    params->outputs = 8U;
+    params->max_fanout = MAX_PINS;
+}
+
+const char *circuit_gen_kind_name(CircuitGenKind kind) {
+    return (uint32_t)kind < CIRCUIT_GEN_KIND_COUNT ? gen_kind_names[kind] : "unknown";
+}
+
+bool circuit_gen_kind_from_name(const char *name, CircuitGenKind *kind) {
+    uint32_t index;
+
+    for (index = 0U; index < CIRCUIT_GEN_KIND_COUNT; index++) {
+        if (strcmp(name, gen_kind_names[index]) == 0) {
+            *kind = (CircuitGenKind)index;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool circuit_gen_build(LogicGraph *graph, const CircuitGenParams *params, char *error_message, size_t error_message_size) {
+    GenBuilder builder;
+    bool built;
+
+    if (params->kind != CIRCUIT_GEN_RANDOM_DAG && params->bits > MAX_NODES) {
+        set_error(error_message, error_message_size, "width is over the 1024-node limit", 0U);
+        return false;
+    }
+    gen_begin(&builder, graph);
+    switch (params->kind) {
+        case CIRCUIT_GEN_RIPPLE_ADDER:
+            built = gen_ripple_adder(&builder, params->bits, error_message, error_message_size);
+            break;
+        case CIRCUIT_GEN_LOOKAHEAD_ADDER:
+            built = gen_lookahead_adder(&builder, params->bits, error_message, error_message_size);
+            break;
+        case CIRCUIT_GEN_MULTIPLIER:
+            built = gen_multiplier(&builder, params->bits, error_message, error_message_size);
+            break;
+        case CIRCUIT_GEN_BARREL_SHIFTER:
+            built = gen_barrel_shifter(&builder, params->bits, error_message, error_message_size);
+            break;
+        case CIRCUIT_GEN_LFSR:
+            built = gen_lfsr(&builder, params->bits, error_message, error_message_size);
+            break;
+        case CIRCUIT_GEN_COUNTER:
+            built = gen_counter(&builder, params->bits, error_message, error_message_size);
+            break;
+        case CIRCUIT_GEN_DECODER:
+            built = gen_decoder(&builder, params->bits, error_message, error_message_size);
+            break;
+        case CIRCUIT_GEN_SHIFT_REGISTER:
+            built = gen_shift_register(&builder, params->bits, error_message, error_message_size);
+            break;
+        case CIRCUIT_GEN_RANDOM_DAG:
+            built = gen_random_dag(&builder, params, error_message, error_message_size);
+            break;
+        default:
+            set_error(error_message, error_message_size, "unknown circuit kind", 0U);
+            return false;
+    }
+    if (!built && !builder.ok) {
+        set_error(error_message, error_message_size, "circuit does not fit the engine limits (1024 nodes, 8 sinks per net)", 0U);
+    }
+    if (!built) {
+        logic_clear_graph(graph);
+    }
+    return built;
+}
+
+// Flattens the graph into a spec for circuit_file_save_binary, skipping deleted
+// nodes the way the text writer does.
+static bool gen_graph_spec(const LogicGraph *graph, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size) {
+    uint32_t remap[MAX_NODES];
+    uint32_t index;
+    uint8_t sink;
+
+    memset(spec, 0, sizeof(*spec));
+    spec->nodes = (CircuitLayoutNode *)arena_alloc(arena, (graph->node_count + 1U) * sizeof(*spec->nodes));
+    for (index = 0U; index < graph->net_count; index++) {
+        spec->edge_count += graph->nets[index].source ? graph->nets[index].sink_count : 0U;
+    }
+    spec->edges = (CircuitLayoutEdge *)arena_alloc(arena, (spec->edge_count + 1U) * sizeof(*spec->edges));
+    if (!spec->nodes || !spec->edges) {
+        set_error(error_message, error_message_size, "out of memory", 0U);
+        return false;
+    }
+
+    for (index = 0U; index < graph->node_count; index++) {
+        const LogicNode *node;
+        CircuitLayoutNode *entry;
+
+        node = &graph->nodes[index];
+        if (node->type == (NodeType)-1) {
+            continue;
+        }
+        if (!node->name || node->name[0] == '\0') {
+            set_error(error_message, error_message_size, "node name cannot be saved", 0U);
+            return false;
+        }
+        remap[index] = spec->node_count;
+        entry = &spec->nodes[spec->node_count++];
+        entry->name = node->name;
+        entry->type = node->type;
+        entry->input_count = node->input_count;
+        entry->output_count = node->output_count;
+    }
+
+    spec->edge_count = 0U;
+    for (index = 0U; index < graph->net_count; index++) {
+        const LogicNet *net;
+
+        net = &graph->nets[index];
+        if (!net->source || !net->source->node) {
+            continue;
+        }
+        for (sink = 0U; sink < net->sink_count; sink++) {
+            CircuitLayoutEdge *edge;
+
+            edge = &spec->edges[spec->edge_count++];
+            edge->source_node_index = remap[net->source->node - graph->nodes];
+            edge->sink_node_index = remap[net->sinks[sink]->node - graph->nodes];
+            edge->source_pin_index = net->source->index;
+            edge->sink_pin_index = net->sinks[sink]->index;
+        }
+    }
+    return true;
+}
+
+bool circuit_gen_save(const LogicGraph *graph, const char *path, char *error_message, size_t error_message_size) {
+    CircuitSpec spec;
+    Arena arena;
+    bool saved;
+
+    if (!graph || !path) {
+        set_error(error_message, error_message_size, "missing graph or path", 0U);
+        return false;
+    }
+    if (!path_has_suffix(path, ".circb")) {
+        return circuit_file_save(graph, NULL, path, error_message, error_message_size);
+    }
+
+    arena_init(&arena, CIRCUIT_GEN_SPEC_ARENA, MEM_TAG_LOADER);
+    saved = gen_graph_spec(graph, &arena, &spec, error_message, error_message_size);
+    if (saved) {
+        saved = circuit_file_save_binary(&spec, &arena, path, error_message, error_message_size);
+    }
+    arena_release(&arena);
+    return saved;
+}
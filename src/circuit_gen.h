@@ -0,0 +1,53 @@
+#ifndef CIRCUIT_GEN_H
+#define CIRCUIT_GEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "logic.h"
+
+typedef enum {
+    CIRCUIT_GEN_RIPPLE_ADDER, // A, B, CIN in; S, COUT out
+    CIRCUIT_GEN_LOOKAHEAD_ADDER, // same pins, Kogge-Stone carry lookahead
+    CIRCUIT_GEN_MULTIPLIER, // A, B in; P out
+    CIRCUIT_GEN_BARREL_SHIFTER, // D, S in; Y = D << S out; `bits` a power of two
+    CIRCUIT_GEN_LFSR, // maximal-length XNOR LFSR, Q out
+    CIRCUIT_GEN_COUNTER, // synchronous binary up counter, EN in, Q out
+    CIRCUIT_GEN_DECODER, // S in, Y0..Y(2^bits - 1) out
+    CIRCUIT_GEN_SHIFT_REGISTER, // SIN in, SOUT out
+    CIRCUIT_GEN_RANDOM_DAG // IN in, OUT out
+} CircuitGenKind;
+
+#define CIRCUIT_GEN_KIND_COUNT 9U
+
+typedef struct {
+    CircuitGenKind kind;
+    uint32_t bits; // operand width, register stages, or decoder select lines
+    // The rest shapes CIRCUIT_GEN_RANDOM_DAG; the same values give the same circuit.
+    uint32_t seed;
+    uint32_t inputs;
+    uint32_t gates;
+    uint32_t outputs; // taken from the last gates
+    uint32_t depth; // gate levels; 0 wires each gate to recent signals instead
+    uint32_t max_fanout; // sinks per signal, 1..MAX_PINS
+    uint32_t fanout_skew; // percent of picks that favour signals already fanning out
+    uint8_t _padding[4];
+} CircuitGenParams;
+
+// Defaults for `kind`: an 8-bit datapath, a 16-bit LFSR and shift register,
+// a 3-to-8 decoder, or a 200-gate DAG over 8 inputs.
+void circuit_gen_params_init(CircuitGenParams *params, CircuitGenKind kind);
+const char *circuit_gen_kind_name(CircuitGenKind kind);
+bool circuit_gen_kind_from_name(const char *name, CircuitGenKind *kind);
+
+// Builds the circuit straight into `graph`, which is cleared first. Signals
+// that need more sinks than a net holds are fanned out through buffer trees
+// of two-input ANDs. Flip-flops come up unknown like any other DFF, and one
+// CLOCK node drives every eight of them.
+bool circuit_gen_build(LogicGraph *graph, const CircuitGenParams *params, char *error_message, size_t error_message_size);
+
+// Writes `graph` as .circb when `path` ends in ".circb" and as .circ
+// otherwise, without positions either way: the editor lays it out on load.
+bool circuit_gen_save(const LogicGraph *graph, const char *path, char *error_message, size_t error_message_size);
+
+#endif // CIRCUIT_GEN_H
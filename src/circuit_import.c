@@ -0,0 +1,478 @@
+#include "circuit_import.h"
+#include "mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Writes "Line N: message 'name'" (either part optional) and returns false,
+// so parsers can `return circuit_import_fail(...)`.
+bool circuit_import_fail(CircuitImport *import, unsigned int line, const char *message, const char *name, size_t name_length) {
+    char location[32];
+
+    if (!import->error_message || import->error_message_size == 0U) {
+        return false;
+    }
+
+    location[0] = '\0';
+    if (line > 0U) {
+        snprintf(location, sizeof(location), "Line %u: ", line);
+    }
+    if (name) {
+        snprintf(
+            import->error_message,
+            import->error_message_size,
+            "%s%s '%.*s'",
+            location,
+            message,
+            (int)(name_length > 64U ? 64U : name_length),
+            name
+        );
+    } else {
+        snprintf(import->error_message, import->error_message_size, "%s%s", location, message);
+    }
+    return false;
+}
+
+// Returns `items` with room for `needed` entries (possibly moved), or NULL
+// with `items` untouched.
+static void *import_grow(void *items, uint32_t *capacity, uint32_t needed, size_t item_size) {
+    uint32_t grown;
+    void *resized;
+
+    if (needed <= *capacity) {
+        return items;
+    }
+
+    grown = *capacity < 64U ? 64U : *capacity;
+    while (grown < needed) {
+        grown *= 2U;
+    }
+    resized = mem_realloc(MEM_TAG_LOADER, items, (size_t)grown * item_size);
+    if (resized) {
+        *capacity = grown;
+    }
+    return resized;
+}
+
+// Keeps the table at most half full by rehashing into twice the slots. Keys
+// are arena names, so moving the slots leaves them valid.
+static bool import_index_reserve(NameIndex *index) {
+    NameIndex grown;
+    NameIndexSlot *slots;
+    uint32_t capacity;
+    uint32_t slot;
+
+    if (index->slots && index->count + 1U <= index->capacity / 2U) {
+        return true;
+    }
+
+    capacity = index->slots ? index->capacity * 2U : 64U;
+    slots = (NameIndexSlot *)mem_alloc(MEM_TAG_LOADER, capacity * sizeof(*slots));
+    if (!slots) {
+        return false;
+    }
+    name_index_init(&grown, slots, capacity);
+    for (slot = 0U; index->slots && slot < index->capacity; slot++) {
+        if (index->slots[slot].name) {
+            name_index_insert(&grown, index->slots[slot].name, index->slots[slot].length, index->slots[slot].value);
+        }
+    }
+    mem_free(index->slots);
+    *index = grown;
+    return true;
+}
+
+static char *import_copy_name(CircuitImport *import, const char *name, size_t length) {
+    char *copy;
+
+    copy = (char *)arena_alloc(import->arena, length + 1U);
+    if (copy) {
+        memcpy(copy, name, length);
+        copy[length] = '\0';
+    }
+    return copy;
+}
+
+// Nodes keep the name they are given when it is free; otherwise (and always
+// when `inner`, for the inner nodes of decomposed gates) they get "name$N".
+static bool import_add_node(CircuitImport *import, NodeType type, const char *name, size_t length, bool inner, unsigned int line, uint32_t *node) {
+    CircuitLayoutNode *nodes;
+    char generated[96];
+    const char *chosen;
+    size_t chosen_length;
+    uint16_t existing;
+    char *copy;
+
+    if (import->node_count >= UINT16_MAX) {
+        return circuit_import_fail(import, line, "too many nodes", NULL, 0U);
+    }
+    nodes = (CircuitLayoutNode *)import_grow(import->nodes, &import->node_capacity, import->node_count + 1U, sizeof(*nodes));
+    if (!nodes || !import_index_reserve(&import->node_names)) {
+        return circuit_import_fail(import, line, "out of memory", NULL, 0U);
+    }
+    import->nodes = nodes;
+
+    chosen = name;
+    chosen_length = length;
+    while (inner || name_index_find(&import->node_names, chosen, chosen_length, &existing)) {
+        inner = false;
+        import->generated_names++;
+        snprintf(generated, sizeof(generated), "%.*s$%u", (int)(length > 64U ? 64U : length), name, import->generated_names);
+        chosen = generated;
+        chosen_length = strlen(generated);
+    }
+
+    copy = import_copy_name(import, chosen, chosen_length);
+    if (!copy) {
+        return circuit_import_fail(import, line, "out of memory", NULL, 0U);
+    }
+    name_index_insert(&import->node_names, copy, chosen_length, (uint16_t)import->node_count);
+
+    memset(&import->nodes[import->node_count], 0, sizeof(*import->nodes));
+    import->nodes[import->node_count].name = copy;
+    import->nodes[import->node_count].type = type;
+    *node = import->node_count;
+    import->node_count++;
+    return true;
+}
+
+static bool import_drive(CircuitImport *import, uint32_t net, uint32_t node, uint8_t pin, unsigned int line) {
+    CircuitImportNet *entry;
+
+    entry = &import->nets[net];
+    if (entry->driver_node != CIRCUIT_IMPORT_NONE || entry->alias != CIRCUIT_IMPORT_NONE) {
+        return circuit_import_fail(import, line, "net has more than one driver", entry->name, entry->name ? strlen(entry->name) : 0U);
+    }
+    entry->driver_node = node;
+    entry->driver_pin = pin;
+    return true;
+}
+
+static bool import_add_sink(CircuitImport *import, uint32_t net, uint32_t node, uint8_t pin, unsigned int line) {
+    CircuitImportSink *sinks;
+    CircuitImportSink *sink;
+
+    sinks = (CircuitImportSink *)import_grow(import->sinks, &import->sink_capacity, import->sink_count + 1U, sizeof(*sinks));
+    if (!sinks) {
+        return circuit_import_fail(import, line, "out of memory", NULL, 0U);
+    }
+    import->sinks = sinks;
+    sink = &import->sinks[import->sink_count];
+    memset(sink, 0, sizeof(*sink));
+    sink->net = net;
+    sink->node = node;
+    sink->pin = pin;
+    sink->line = line;
+    import->sink_count++;
+    return true;
+}
+
+void circuit_import_init(CircuitImport *import, Arena *arena, char *error_message, size_t error_message_size) {
+    memset(import, 0, sizeof(*import));
+    import->arena = arena;
+    import->error_message = error_message;
+    import->error_message_size = error_message_size;
+    import->clock_net = CIRCUIT_IMPORT_NONE;
+}
+
+void circuit_import_release(CircuitImport *import) {
+    mem_free(import->nodes);
+    mem_free(import->nets);
+    mem_free(import->sinks);
+    mem_free(import->scratch);
+    mem_free(import->net_names.slots);
+    mem_free(import->node_names.slots);
+    memset(import, 0, sizeof(*import));
+}
+
+bool circuit_import_new_net(CircuitImport *import, unsigned int line, uint32_t *net) {
+    CircuitImportNet *nets;
+    CircuitImportNet *entry;
+
+    nets = (CircuitImportNet *)import_grow(import->nets, &import->net_capacity, import->net_count + 1U, sizeof(*nets));
+    if (!nets) {
+        return circuit_import_fail(import, line, "out of memory", NULL, 0U);
+    }
+    import->nets = nets;
+    entry = &import->nets[import->net_count];
+    memset(entry, 0, sizeof(*entry));
+    entry->driver_node = CIRCUIT_IMPORT_NONE;
+    entry->alias = CIRCUIT_IMPORT_NONE;
+    entry->line = line;
+    *net = import->net_count;
+    import->net_count++;
+    return true;
+}
+
+// Finds the net called `name`, creating it on first mention.
+bool circuit_import_net(CircuitImport *import, const char *name, size_t length, unsigned int line, uint32_t *net) {
+    uint16_t existing;
+    char *copy;
+
+    if (name_index_find(&import->net_names, name, length, &existing)) {
+        *net = existing;
+        return true;
+    }
+    if (import->net_count >= UINT16_MAX) {
+        return circuit_import_fail(import, line, "too many nets", NULL, 0U);
+    }
+    if (!import_index_reserve(&import->net_names)) {
+        return circuit_import_fail(import, line, "out of memory", NULL, 0U);
+    }
+    copy = import_copy_name(import, name, length);
+    if (!copy || !circuit_import_new_net(import, line, net)) {
+        return circuit_import_fail(import, line, "out of memory", NULL, 0U);
+    }
+    import->nets[*net].name = copy;
+    name_index_insert(&import->net_names, copy, length, (uint16_t)*net);
+    return true;
+}
+
+bool circuit_import_input(CircuitImport *import, const char *name, size_t length, unsigned int line) {
+    uint32_t net;
+    uint32_t node;
+
+    return circuit_import_net(import, name, length, line, &net) &&
+        import_add_node(import, NODE_INPUT, name, length, false, line, &node) &&
+        import_drive(import, net, node, 0U, line);
+}
+
+bool circuit_import_output(CircuitImport *import, const char *name, size_t length, unsigned int line) {
+    uint32_t net;
+    uint32_t node;
+
+    return circuit_import_net(import, name, length, line, &net) &&
+        import_add_node(import, NODE_OUTPUT, name, length, false, line, &node) &&
+        import_add_sink(import, net, node, 0U, line);
+}
+
+// One node of `type` reading `a` (and `b` unless it is NONE) and driving `net`.
+static bool import_add_gate_node(
+    CircuitImport *import,
+    NodeType type,
+    const char *name,
+    size_t name_length,
+    bool inner,
+    uint32_t a,
+    uint32_t b,
+    uint32_t net,
+    unsigned int line
+) {
+    uint32_t node;
+
+    return import_add_node(import, type, name, name_length, inner, line, &node) &&
+        import_add_sink(import, a, node, 0U, line) &&
+        (b == CIRCUIT_IMPORT_NONE || import_add_sink(import, b, node, 1U, line)) &&
+        import_drive(import, net, node, 0U, line);
+}
+
+// Gates wider than two inputs become a balanced tree of two-input nodes of
+// the non-inverting kind, with the inversion (if any) at the root. The node
+// that drives the gate's output (the root, or the NOT after an XNOR's XOR)
+// keeps the gate's name; the inner nodes are "name$N".
+bool circuit_import_gate(
+    CircuitImport *import,
+    CircuitImportGate gate,
+    const char *name,
+    size_t name_length,
+    uint32_t output_net,
+    const uint32_t *input_nets,
+    uint32_t input_count,
+    unsigned int line
+) {
+    NodeType tree_type;
+    NodeType root_type;
+    uint32_t *scratch;
+    uint32_t count;
+    uint32_t index;
+
+    if (!name) {
+        name = import->nets[output_net].name ? import->nets[output_net].name : "g";
+        name_length = strlen(name);
+    }
+    if (input_count == 0U) {
+        return circuit_import_fail(import, line, "gate has no inputs", name, name_length);
+    }
+    if ((gate == CIRCUIT_IMPORT_NOT || gate == CIRCUIT_IMPORT_BUF) && input_count != 1U) {
+        return circuit_import_fail(import, line, "gate takes exactly one input", name, name_length);
+    }
+
+    switch (gate) {
+        case CIRCUIT_IMPORT_AND:
+        case CIRCUIT_IMPORT_NAND:
+            tree_type = NODE_GATE_AND;
+            root_type = gate == CIRCUIT_IMPORT_AND ? NODE_GATE_AND : NODE_GATE_NAND;
+            break;
+        case CIRCUIT_IMPORT_OR:
+        case CIRCUIT_IMPORT_NOR:
+            tree_type = NODE_GATE_OR;
+            root_type = gate == CIRCUIT_IMPORT_OR ? NODE_GATE_OR : NODE_GATE_NOR;
+            break;
+        case CIRCUIT_IMPORT_XOR:
+        case CIRCUIT_IMPORT_XNOR:
+            tree_type = NODE_GATE_XOR;
+            root_type = NODE_GATE_XOR;
+            break;
+        case CIRCUIT_IMPORT_NOT:
+        case CIRCUIT_IMPORT_BUF:
+        default:
+            tree_type = NODE_GATE_NOT;
+            root_type = NODE_GATE_NOT;
+            break;
+    }
+
+    if (input_count == 1U) {
+        if (gate == CIRCUIT_IMPORT_AND || gate == CIRCUIT_IMPORT_OR || gate == CIRCUIT_IMPORT_XOR || gate == CIRCUIT_IMPORT_BUF) {
+            return circuit_import_alias(import, output_net, input_nets[0], line);
+        }
+        return import_add_gate_node(import, NODE_GATE_NOT, name, name_length, false, input_nets[0], CIRCUIT_IMPORT_NONE, output_net, line);
+    }
+
+    scratch = (uint32_t *)import_grow(import->scratch, &import->scratch_capacity, input_count, sizeof(*scratch));
+    if (!scratch) {
+        return circuit_import_fail(import, line, "out of memory", NULL, 0U);
+    }
+    import->scratch = scratch;
+    memcpy(import->scratch, input_nets, input_count * sizeof(*input_nets));
+    count = input_count;
+    while (count > 2U) {
+        uint32_t next;
+
+        next = 0U;
+        for (index = 0U; index + 1U < count; index += 2U) {
+            uint32_t net;
+
+            if (!circuit_import_new_net(import, line, &net) ||
+                !import_add_gate_node(import, tree_type, name, name_length, true, import->scratch[index], import->scratch[index + 1U], net, line)) {
+                return false;
+            }
+            import->scratch[next++] = net;
+        }
+        if (index < count) {
+            import->scratch[next++] = import->scratch[index];
+        }
+        count = next;
+    }
+
+    if (gate == CIRCUIT_IMPORT_XNOR) {
+        uint32_t net;
+
+        return circuit_import_new_net(import, line, &net) &&
+            import_add_gate_node(import, NODE_GATE_XOR, name, name_length, true, import->scratch[0], import->scratch[1], net, line) &&
+            import_add_gate_node(import, NODE_GATE_NOT, name, name_length, false, net, CIRCUIT_IMPORT_NONE, output_net, line);
+    }
+    return import_add_gate_node(import, root_type, name, name_length, false, import->scratch[0], import->scratch[1], output_net, line);
+}
+
+// A flip-flop or latch: data on in0, clock or enable on in1, state on out0.
+static bool import_add_storage_node(
+    CircuitImport *import,
+    NodeType type,
+    const char *name,
+    size_t name_length,
+    uint32_t q,
+    uint32_t d,
+    uint32_t control,
+    unsigned int line
+) {
+    uint32_t node;
+
+    if (!name) {
+        name = import->nets[q].name ? import->nets[q].name : (type == NODE_GATE_DFF ? "dff" : "latch");
+        name_length = strlen(name);
+    }
+    return import_add_node(import, type, name, name_length, false, line, &node) &&
+        import_add_sink(import, d, node, 0U, line) &&
+        import_add_sink(import, control, node, 1U, line) &&
+        import_drive(import, q, node, 0U, line);
+}
+
+// `clock` may be NONE for formats with an implicit global clock; those
+// flip-flops share one clock node.
+bool circuit_import_dff(CircuitImport *import, const char *name, size_t name_length, uint32_t q, uint32_t d, uint32_t clock, unsigned int line) {
+    uint32_t node;
+
+    if (clock == CIRCUIT_IMPORT_NONE) {
+        if (import->clock_net == CIRCUIT_IMPORT_NONE) {
+            if (!circuit_import_new_net(import, line, &import->clock_net) ||
+                !import_add_node(import, NODE_GATE_CLOCK, "clock", 5U, false, line, &node) ||
+                !import_drive(import, import->clock_net, node, 0U, line)) {
+                return false;
+            }
+        }
+        clock = import->clock_net;
+    }
+    return import_add_storage_node(import, NODE_GATE_DFF, name, name_length, q, d, clock, line);
+}
+
+// Level-sensitive: `q` follows `d` while `enable` is high.
+bool circuit_import_latch(CircuitImport *import, const char *name, size_t name_length, uint32_t q, uint32_t d, uint32_t enable, unsigned int line) {
+    return import_add_storage_node(import, NODE_GATE_LATCH, name, name_length, q, d, enable, line);
+}
+
+// `net` carries whatever drives `source_net` (Verilog `assign a = b;`).
+bool circuit_import_alias(CircuitImport *import, uint32_t net, uint32_t source_net, unsigned int line) {
+    CircuitImportNet *entry;
+
+    entry = &import->nets[net];
+    if (entry->driver_node != CIRCUIT_IMPORT_NONE || entry->alias != CIRCUIT_IMPORT_NONE) {
+        return circuit_import_fail(import, line, "net has more than one driver", entry->name, entry->name ? strlen(entry->name) : 0U);
+    }
+    entry->alias = source_net;
+    return true;
+}
+
+// Resolves every sink through aliases to its driver and lays the result out
+// as a spec in the arena.
+bool circuit_import_finish(CircuitImport *import, CircuitSpec *spec) {
+    uint8_t *fanout;
+    uint32_t index;
+
+    memset(spec, 0, sizeof(*spec));
+    spec->nodes = (CircuitLayoutNode *)arena_alloc(import->arena, (import->node_count + 1U) * sizeof(*spec->nodes));
+    spec->edges = (CircuitLayoutEdge *)arena_alloc(import->arena, (import->sink_count + 1U) * sizeof(*spec->edges));
+    fanout = (uint8_t *)mem_calloc(MEM_TAG_LOADER, import->node_count + 1U, sizeof(*fanout));
+    if (!spec->nodes || !spec->edges || !fanout) {
+        mem_free(fanout);
+        return circuit_import_fail(import, 0U, "out of memory", NULL, 0U);
+    }
+
+    for (index = 0U; index < import->sink_count; index++) {
+        const CircuitImportSink *sink;
+        const CircuitImportNet *net;
+        CircuitLayoutEdge *edge;
+        uint32_t steps;
+
+        sink = &import->sinks[index];
+        net = &import->nets[sink->net];
+        for (steps = 0U; net->alias != CIRCUIT_IMPORT_NONE && steps < import->net_count; steps++) {
+            net = &import->nets[net->alias];
+        }
+        if (net->alias != CIRCUIT_IMPORT_NONE) {
+            mem_free(fanout);
+            return circuit_import_fail(import, sink->line, "assignments form a loop through", net->name, net->name ? strlen(net->name) : 0U);
+        }
+        if (net->driver_node == CIRCUIT_IMPORT_NONE) {
+            mem_free(fanout);
+            net = &import->nets[sink->net];
+            return circuit_import_fail(import, sink->line, "net is never driven", net->name, net->name ? strlen(net->name) : 0U);
+        }
+        if (fanout[net->driver_node] >= MAX_PINS) {
+            mem_free(fanout);
+            return circuit_import_fail(import, sink->line, "net feeds more than 8 inputs", net->name, net->name ? strlen(net->name) : 0U);
+        }
+        fanout[net->driver_node]++;
+
+        edge = &spec->edges[index];
+        edge->source_node_index = net->driver_node;
+        edge->source_pin_index = net->driver_pin;
+        edge->sink_node_index = sink->node;
+        edge->sink_pin_index = sink->pin;
+    }
+
+    memcpy(spec->nodes, import->nodes, import->node_count * sizeof(*spec->nodes));
+    spec->node_count = import->node_count;
+    spec->edge_count = import->sink_count;
+    mem_free(fanout);
+    return true;
+}
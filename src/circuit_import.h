@@ -0,0 +1,93 @@
+#ifndef CIRCUIT_IMPORT_H
+#define CIRCUIT_IMPORT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "arena.h"
+#include "circuit_spec.h"
+#include "name_index.h"
+
+#define CIRCUIT_IMPORT_NONE UINT32_MAX
+
+// Gate kinds the netlist formats use. Wide gates become trees of two-input
+// nodes; the inverting kinds invert only at the root.
+typedef enum {
+    CIRCUIT_IMPORT_AND,
+    CIRCUIT_IMPORT_OR,
+    CIRCUIT_IMPORT_XOR,
+    CIRCUIT_IMPORT_NAND,
+    CIRCUIT_IMPORT_NOR,
+    CIRCUIT_IMPORT_XNOR,
+    CIRCUIT_IMPORT_NOT,
+    CIRCUIT_IMPORT_BUF
+} CircuitImportGate;
+
+typedef struct {
+    const char *name; // NULL for nets the importer made up
+    uint32_t driver_node; // CIRCUIT_IMPORT_NONE until something drives it
+    uint32_t alias; // net this one is a plain copy of, or CIRCUIT_IMPORT_NONE
+    uint32_t line; // first mention, for "never driven" errors
+    uint8_t driver_pin;
+    uint8_t _padding[3];
+} CircuitImportNet;
+
+typedef struct {
+    uint32_t net;
+    uint32_t node;
+    uint32_t line;
+    uint8_t pin;
+    uint8_t _padding[3];
+} CircuitImportSink;
+
+// Collects a net-based netlist (named nets, each driven by one port, gate or
+// flip-flop) and resolves it into a CircuitSpec. Verilog, .bench and BLIF all
+// have this shape. Names are copied into `arena`, which must outlive the
+// spec; everything else is freed by circuit_import_release. The first error
+// is written to the buffer given at init, prefixed with its line. As with
+// .circb, node pin counts are left for the loader to fill in.
+typedef struct {
+    Arena *arena;
+    char *error_message;
+    size_t error_message_size;
+    CircuitLayoutNode *nodes;
+    CircuitImportNet *nets;
+    CircuitImportSink *sinks;
+    uint32_t *scratch;
+    NameIndex net_names;
+    NameIndex node_names;
+    uint32_t node_count;
+    uint32_t node_capacity;
+    uint32_t net_count;
+    uint32_t net_capacity;
+    uint32_t sink_count;
+    uint32_t sink_capacity;
+    uint32_t scratch_capacity;
+    uint32_t generated_names;
+    uint32_t clock_net; // shared clock for flip-flops that name none, made on first use
+    uint8_t _padding[4];
+} CircuitImport;
+
+void circuit_import_init(CircuitImport *import, Arena *arena, char *error_message, size_t error_message_size);
+void circuit_import_release(CircuitImport *import);
+bool circuit_import_fail(CircuitImport *import, unsigned int line, const char *message, const char *name, size_t name_length);
+bool circuit_import_net(CircuitImport *import, const char *name, size_t length, unsigned int line, uint32_t *net);
+bool circuit_import_new_net(CircuitImport *import, unsigned int line, uint32_t *net);
+bool circuit_import_input(CircuitImport *import, const char *name, size_t length, unsigned int line);
+bool circuit_import_output(CircuitImport *import, const char *name, size_t length, unsigned int line);
+bool circuit_import_gate(
+    CircuitImport *import,
+    CircuitImportGate gate,
+    const char *name,
+    size_t name_length,
+    uint32_t output_net,
+    const uint32_t *input_nets,
+    uint32_t input_count,
+    unsigned int line
+);
+bool circuit_import_dff(CircuitImport *import, const char *name, size_t name_length, uint32_t q, uint32_t d, uint32_t clock, unsigned int line);
+bool circuit_import_latch(CircuitImport *import, const char *name, size_t name_length, uint32_t q, uint32_t d, uint32_t enable, unsigned int line);
+bool circuit_import_alias(CircuitImport *import, uint32_t net, uint32_t source_net, unsigned int line);
+bool circuit_import_finish(CircuitImport *import, CircuitSpec *spec);
+
+#endif // CIRCUIT_IMPORT_H
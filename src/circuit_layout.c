@@ -28,28 +28,32 @@ typedef struct {
 } SccEdge;
 
 typedef struct {
-    uint32_t node_indices[MAX_NODES];
+    const uint32_t *node_indices; // slice of the shared component member list
     uint32_t node_count;
+    uint8_t _padding[4];
 } GraphComponent;
 
+// Per-node arrays hold the whole circuit's node count (edges its edge count)
+// and are reused by each component in turn; all come from the caller's arena.
 typedef struct {
     const CircuitLayoutNode *nodes;
-    uint32_t node_indices[MAX_NODES];
-    LayoutEdge edges[MAX_NETS];
+    uint32_t *node_indices;
+    LayoutEdge *edges;
+    int32_t *local_index_by_global;
+    uint32_t *indegree;
+    uint32_t *outdegree;
+    int *widths;
+    int *heights;
+    uint32_t *scc_of_node;
+    uint32_t *scc_member_count;
+    uint32_t *node_rank;
+    uint32_t *ordered_nodes;
+    uint32_t *layer_offsets; // node capacity + 1 entries
+    float *node_y;
+    float *node_x_offset;
+    uint32_t global_node_count;
     uint32_t node_count;
     uint32_t edge_count;
-    int32_t local_index_by_global[MAX_NODES];
-    uint32_t indegree[MAX_NODES];
-    uint32_t outdegree[MAX_NODES];
-    int widths[MAX_NODES];
-    int heights[MAX_NODES];
-    uint32_t scc_of_node[MAX_NODES];
-    uint32_t scc_member_count[MAX_NODES];
-    uint32_t node_rank[MAX_NODES];
-    uint32_t ordered_nodes[MAX_NODES];
-    uint32_t layer_offsets[MAX_NODES + 1U];
-    float node_y[MAX_NODES];
-    float node_x_offset[MAX_NODES];
     uint32_t max_rank;
 } LayoutComponent;
 
@@ -82,25 +86,35 @@ static int layout_node_role_priority(NodeType type) {
     return 1;
 }
 
-static void collect_graph_components(
+// Breadth-first walk over undirected connectivity. Each component's members
+// are written to `members` in visit order, which doubles as the BFS queue.
+static bool collect_graph_components(
     uint32_t node_count,
     const CircuitLayoutEdge *edges,
     uint32_t edge_count,
+    Arena *scratch,
     GraphComponent *components,
     uint32_t *component_count
 ) {
-    int32_t component_by_node[MAX_NODES];
-    uint32_t queue[MAX_NODES];
+    int32_t *component_by_node;
+    uint32_t *members;
+    uint32_t member_count;
     uint32_t next_component;
     uint32_t node_index;
 
-    memset(component_by_node, 0xff, sizeof(component_by_node));
+    component_by_node = (int32_t *)arena_alloc(scratch, node_count * sizeof(*component_by_node));
+    members = (uint32_t *)arena_alloc(scratch, node_count * sizeof(*members));
+    if (!component_by_node || !members) {
+        return false;
+    }
+
+    memset(component_by_node, 0xff, node_count * sizeof(*component_by_node));
     next_component = 0U;
+    member_count = 0U;
 
     for (node_index = 0U; node_index < node_count; node_index++) {
         GraphComponent *component;
         uint32_t queue_head;
-        uint32_t queue_tail;
 
         if (component_by_node[node_index] >= 0) {
             continue;
@@ -108,18 +122,18 @@ static void collect_graph_components(
 
         component = &components[next_component];
         memset(component, 0, sizeof(*component));
+        component->node_indices = &members[member_count];
 
-        queue_head = 0U;
-        queue_tail = 0U;
-        queue[queue_tail++] = node_index;
+        queue_head = member_count;
+        members[member_count++] = node_index;
         component_by_node[node_index] = (int32_t)next_component;
 
-        while (queue_head < queue_tail) {
+        while (queue_head < member_count) {
             uint32_t current;
             uint32_t edge_index;
 
-            current = queue[queue_head++];
-            component->node_indices[component->node_count++] = current;
+            current = members[queue_head++];
+            component->node_count++;
 
             for (edge_index = 0U; edge_index < edge_count; edge_index++) {
                 uint32_t neighbor;
@@ -136,13 +150,38 @@ static void collect_graph_components(
                 }
 
                 component_by_node[neighbor] = (int32_t)next_component;
-                queue[queue_tail++] = neighbor;
+                members[member_count++] = neighbor;
             }
         }
 
         next_component++;
     }
     *component_count = next_component;
+    return true;
+}
+
+static bool layout_component_alloc(LayoutComponent *component, Arena *scratch, uint32_t node_count, uint32_t edge_count) {
+    memset(component, 0, sizeof(*component));
+    component->global_node_count = node_count;
+    component->node_indices = (uint32_t *)arena_alloc(scratch, node_count * sizeof(uint32_t));
+    component->edges = (LayoutEdge *)arena_alloc(scratch, edge_count * sizeof(LayoutEdge));
+    component->local_index_by_global = (int32_t *)arena_alloc(scratch, node_count * sizeof(int32_t));
+    component->indegree = (uint32_t *)arena_alloc(scratch, node_count * sizeof(uint32_t));
+    component->outdegree = (uint32_t *)arena_alloc(scratch, node_count * sizeof(uint32_t));
+    component->widths = (int *)arena_alloc(scratch, node_count * sizeof(int));
+    component->heights = (int *)arena_alloc(scratch, node_count * sizeof(int));
+    component->scc_of_node = (uint32_t *)arena_alloc(scratch, node_count * sizeof(uint32_t));
+    component->scc_member_count = (uint32_t *)arena_alloc(scratch, node_count * sizeof(uint32_t));
+    component->node_rank = (uint32_t *)arena_alloc(scratch, node_count * sizeof(uint32_t));
+    component->ordered_nodes = (uint32_t *)arena_alloc(scratch, node_count * sizeof(uint32_t));
+    component->layer_offsets = (uint32_t *)arena_alloc(scratch, (node_count + 1U) * sizeof(uint32_t));
+    component->node_y = (float *)arena_alloc(scratch, node_count * sizeof(float));
+    component->node_x_offset = (float *)arena_alloc(scratch, node_count * sizeof(float));
+
+    return component->node_indices && component->edges && component->local_index_by_global &&
+        component->indegree && component->outdegree && component->widths && component->heights &&
+        component->scc_of_node && component->scc_member_count && component->node_rank &&
+        component->ordered_nodes && component->layer_offsets && component->node_y && component->node_x_offset;
 }
 
 static float layout_pin_offset(uint8_t pin_count, float node_height, uint8_t pin_index) {
@@ -205,10 +244,19 @@ static void layout_component_build(
     uint32_t local_index;
     uint32_t edge_index;
 
-    memset(component, 0, sizeof(*component));
     component->nodes = nodes;
     component->node_count = graph_component->node_count;
-    memset(component->local_index_by_global, 0xff, sizeof(component->local_index_by_global));
+    component->edge_count = 0U;
+    component->max_rank = 0U;
+    memset(component->local_index_by_global, 0xff, component->global_node_count * sizeof(int32_t));
+    memset(component->indegree, 0, component->node_count * sizeof(uint32_t));
+    memset(component->outdegree, 0, component->node_count * sizeof(uint32_t));
+    memset(component->scc_of_node, 0, component->node_count * sizeof(uint32_t));
+    memset(component->node_rank, 0, component->node_count * sizeof(uint32_t));
+    memset(component->ordered_nodes, 0, component->node_count * sizeof(uint32_t));
+    memset(component->layer_offsets, 0, (component->node_count + 1U) * sizeof(uint32_t));
+    memset(component->node_y, 0, component->node_count * sizeof(float));
+    memset(component->node_x_offset, 0, component->node_count * sizeof(float));
 
     for (local_index = 0U; local_index < component->node_count; local_index++) {
         uint32_t global_index;
@@ -341,7 +389,7 @@ static uint32_t layout_component_find_sccs(LayoutComponent *component) {
     memset(indices, 0xff, sizeof(indices));
     memset(lowlink, 0, sizeof(lowlink));
     memset(on_stack, 0, sizeof(on_stack));
-    memset(component->scc_member_count, 0, sizeof(component->scc_member_count));
+    memset(component->scc_member_count, 0, component->node_count * sizeof(uint32_t));
 
     stack_size = 0U;
     next_index = 0;
@@ -1040,7 +1088,7 @@ static float layout_component_fanout_offset(
 static float layout_component_finalize_positions(
     LayoutComponent *component,
     float component_top,
-    Vector2 *positions
+    CircuitPosition *positions
 ) {
     uint32_t layer_position[MAX_NODES];
     float base_x[MAX_NODES];
@@ -1113,7 +1161,7 @@ static float layout_component_finalize_positions(
         global_index = component->node_indices[local_index];
         node_x = base_x[component->node_rank[local_index]] + component->node_x_offset[local_index];
         node_y = component->node_y[local_index];
-        positions[global_index] = (Vector2){ node_x, node_y };
+        positions[global_index] = (CircuitPosition){ node_x, node_y };
 
         if (node_x < min_x) {
             min_x = node_x;
@@ -1141,54 +1189,67 @@ static float layout_component_finalize_positions(
 }
 
 static float layout_resolve_component(
+    LayoutComponent *component,
     const CircuitLayoutNode *nodes,
     const CircuitLayoutEdge *edges,
     uint32_t edge_count,
     const GraphComponent *graph_component,
     float component_top,
-    Vector2 *positions
+    CircuitPosition *positions
 ) {
-    LayoutComponent component;
     uint32_t sweep_index;
 
-    layout_component_build(&component, nodes, edges, edge_count, graph_component);
-    layout_component_assign_ranks(&component);
-    layout_component_rebuild_layers(&component);
+    layout_component_build(component, nodes, edges, edge_count, graph_component);
+    layout_component_assign_ranks(component);
+    layout_component_rebuild_layers(component);
 
     for (sweep_index = 0U; sweep_index < LAYOUT_ORDER_SWEEPS; sweep_index++) {
-        layout_component_sweep_order(&component, true);
-        layout_component_sweep_order(&component, false);
+        layout_component_sweep_order(component, true);
+        layout_component_sweep_order(component, false);
     }
 
-    layout_component_place_nodes(&component);
-    return layout_component_finalize_positions(&component, component_top, positions);
+    layout_component_place_nodes(component);
+    return layout_component_finalize_positions(component, component_top, positions);
 }
 
+// Scratch memory comes from `scratch` and is proportional to the circuit;
+// the caller releases it.
 bool circuit_layout_resolve_positions(
     const CircuitLayoutNode *nodes,
     uint32_t node_count,
     const CircuitLayoutEdge *edges,
     uint32_t edge_count,
-    Vector2 *positions
+    CircuitPosition *positions,
+    Arena *scratch
 ) {
-    GraphComponent components[MAX_NODES];
+    GraphComponent *components;
+    LayoutComponent *component;
     uint32_t component_count;
     float component_top;
     uint32_t component_index;
 
-    if (!nodes || !positions) {
+    if (!nodes || !positions || !scratch) {
         return false;
     }
     if (node_count == 0U) {
         return true;
     }
 
-    collect_graph_components(node_count, edges, edge_count, components, &component_count);
+    components = (GraphComponent *)arena_alloc(scratch, node_count * sizeof(*components));
+    component = (LayoutComponent *)arena_alloc(scratch, sizeof(*component));
+    if (!components || !component || !layout_component_alloc(component, scratch, node_count, edge_count)) {
+        return false;
+    }
+    if (!collect_graph_components(node_count, edges, edge_count, scratch, components, &component_count)) {
+        return false;
+    }
+
     component_top = LAYOUT_CANVAS_TOP;
     for (component_index = 0U; component_index < component_count; component_index++) {
         float component_bottom;
 
         component_bottom = layout_resolve_component(
+            component,
             nodes,
             edges,
             edge_count,
@@ -0,0 +1,38 @@
+#ifndef CIRCUIT_SPEC_H
+#define CIRCUIT_SPEC_H
+
+#include <stdint.h>
+#include "logic.h"
+
+// Top-left corner of a node on the canvas, in world units.
+typedef struct {
+    float x;
+    float y;
+} CircuitPosition;
+
+typedef struct {
+    const char *name;
+    NodeType type;
+    uint8_t input_count;
+    uint8_t output_count;
+    uint8_t _padding[2];
+} CircuitLayoutNode;
+
+typedef struct {
+    uint32_t source_node_index;
+    uint32_t sink_node_index;
+    uint8_t source_pin_index;
+    uint8_t sink_pin_index;
+    uint8_t _padding[2];
+} CircuitLayoutEdge;
+
+// Format-neutral circuit: what the loaders hand to layout and the graph.
+typedef struct {
+    CircuitLayoutNode *nodes;
+    CircuitLayoutEdge *edges;
+    CircuitPosition *positions; // NULL when there is no cached layout
+    uint32_t node_count;
+    uint32_t edge_count;
+} CircuitSpec;
+
+#endif // CIRCUIT_SPEC_H
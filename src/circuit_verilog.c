@@ -0,0 +1,620 @@
+#include "circuit_verilog.h"
+#include "circuit_import.h"
+#include "mem.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Parentheses and ~ nest this deep at most, so a hostile file cannot run the
+// recursive descent off the loader thread's stack.
+#define VERILOG_MAX_NESTING 256U
+
+typedef enum {
+    VERILOG_TOKEN_END,
+    VERILOG_TOKEN_NAME,
+    VERILOG_TOKEN_NUMBER,
+    VERILOG_TOKEN_SYMBOL
+} VerilogTokenKind;
+
+typedef struct {
+    const char *text;
+    size_t length;
+    VerilogTokenKind kind;
+    unsigned int line;
+} VerilogToken;
+
+typedef enum {
+    VERILOG_PORT_NONE,
+    VERILOG_PORT_INPUT,
+    VERILOG_PORT_OUTPUT
+} VerilogPortDirection;
+
+typedef struct {
+    CircuitImport import;
+    const char *cursor;
+    const char *end;
+    VerilogToken token;
+    uint32_t *terminals; // primitive inputs being collected
+    uint32_t terminal_count;
+    uint32_t terminal_capacity;
+    unsigned int line;
+    uint32_t depth; // open parentheses and ~ in the current expression
+} VerilogParser;
+
+static bool verilog_or_expression(VerilogParser *parser, uint32_t *net);
+
+static bool verilog_is_name_start(char c) {
+    return isalpha((unsigned char)c) || c == '_';
+}
+
+static bool verilog_is_name_char(char c) {
+    return isalnum((unsigned char)c) || c == '_' || c == '$';
+}
+
+// Whitespace, // and /* */ comments, and (* attribute *) blocks.
+static void verilog_skip_space(VerilogParser *parser) {
+    while (parser->cursor < parser->end) {
+        char c;
+
+        c = *parser->cursor;
+        if (c == '\n') {
+            parser->line++;
+            parser->cursor++;
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\f' || c == '\v') {
+            parser->cursor++;
+        } else if (c == '/' && parser->cursor + 1 < parser->end && parser->cursor[1] == '/') {
+            while (parser->cursor < parser->end && *parser->cursor != '\n') {
+                parser->cursor++;
+            }
+        } else if ((c == '/' || c == '(') && parser->cursor + 1 < parser->end && parser->cursor[1] == '*') {
+            char close;
+
+            close = c == '/' ? '/' : ')';
+            parser->cursor += 2;
+            while (parser->cursor < parser->end &&
+                   !(*parser->cursor == '*' && parser->cursor + 1 < parser->end && parser->cursor[1] == close)) {
+                if (*parser->cursor == '\n') {
+                    parser->line++;
+                }
+                parser->cursor++;
+            }
+            parser->cursor = parser->cursor + 2 <= parser->end ? parser->cursor + 2 : parser->end;
+        } else {
+            return;
+        }
+    }
+}
+
+static void verilog_next(VerilogParser *parser) {
+    const char *start;
+    char c;
+
+    verilog_skip_space(parser);
+    parser->token.line = parser->line;
+    parser->token.text = parser->cursor;
+    parser->token.length = 0U;
+    if (parser->cursor >= parser->end) {
+        parser->token.kind = VERILOG_TOKEN_END;
+        return;
+    }
+
+    start = parser->cursor;
+    c = *start;
+    if (verilog_is_name_start(c)) {
+        while (parser->cursor < parser->end && verilog_is_name_char(*parser->cursor)) {
+            parser->cursor++;
+        }
+        parser->token.kind = VERILOG_TOKEN_NAME;
+    } else if (c == '\\') {
+        // Escaped identifier: everything up to the next whitespace.
+        start++;
+        parser->cursor++;
+        while (parser->cursor < parser->end && !isspace((unsigned char)*parser->cursor)) {
+            parser->cursor++;
+        }
+        parser->token.kind = VERILOG_TOKEN_NAME;
+    } else if (isdigit((unsigned char)c)) {
+        while (parser->cursor < parser->end &&
+               (isalnum((unsigned char)*parser->cursor) || *parser->cursor == '_' || *parser->cursor == '\'' || *parser->cursor == '?')) {
+            parser->cursor++;
+        }
+        parser->token.kind = VERILOG_TOKEN_NUMBER;
+    } else {
+        parser->cursor++;
+        parser->token.kind = VERILOG_TOKEN_SYMBOL;
+    }
+    parser->token.text = start;
+    parser->token.length = (size_t)(parser->cursor - start);
+}
+
+static bool verilog_is(const VerilogParser *parser, const char *name) {
+    size_t length;
+
+    length = strlen(name);
+    return parser->token.kind == VERILOG_TOKEN_NAME &&
+        parser->token.length == length &&
+        memcmp(parser->token.text, name, length) == 0;
+}
+
+static bool verilog_is_folded(const VerilogParser *parser, const char *name) {
+    size_t length;
+    size_t index;
+
+    length = strlen(name);
+    if (parser->token.kind != VERILOG_TOKEN_NAME || parser->token.length != length) {
+        return false;
+    }
+    for (index = 0U; index < length; index++) {
+        if (tolower((unsigned char)parser->token.text[index]) != name[index]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool verilog_is_symbol(const VerilogParser *parser, char symbol) {
+    return parser->token.kind == VERILOG_TOKEN_SYMBOL && parser->token.text[0] == symbol;
+}
+
+static bool verilog_fail(VerilogParser *parser, const char *message) {
+    return circuit_import_fail(&parser->import, parser->token.line, message, NULL, 0U);
+}
+
+static bool verilog_expect(VerilogParser *parser, char symbol, const char *message) {
+    if (!verilog_is_symbol(parser, symbol)) {
+        return verilog_fail(parser, message);
+    }
+    verilog_next(parser);
+    return true;
+}
+
+// Reads a scalar net name into `net`.
+static bool verilog_net(VerilogParser *parser, uint32_t *net) {
+    if (parser->token.kind != VERILOG_TOKEN_NAME) {
+        return verilog_fail(parser, parser->token.kind == VERILOG_TOKEN_NUMBER ? "constants are not supported" : "expected a net name");
+    }
+    if (!circuit_import_net(&parser->import, parser->token.text, parser->token.length, parser->token.line, net)) {
+        return false;
+    }
+    verilog_next(parser);
+    if (verilog_is_symbol(parser, '[')) {
+        return verilog_fail(parser, "bit selects are not supported");
+    }
+    return true;
+}
+
+static bool verilog_operator(VerilogParser *parser, CircuitImportGate gate, uint32_t a, uint32_t b, uint32_t *net) {
+    uint32_t inputs[2];
+
+    inputs[0] = a;
+    inputs[1] = b;
+    return circuit_import_new_net(&parser->import, parser->token.line, net) &&
+        circuit_import_gate(&parser->import, gate, NULL, 0U, *net, inputs, b == CIRCUIT_IMPORT_NONE ? 1U : 2U, parser->token.line);
+}
+
+static bool verilog_unary_expression(VerilogParser *parser, uint32_t *net) {
+    uint32_t operand;
+    bool parsed;
+
+    if (!verilog_is_symbol(parser, '~') && !verilog_is_symbol(parser, '(')) {
+        return verilog_net(parser, net);
+    }
+    if (parser->depth >= VERILOG_MAX_NESTING) {
+        return verilog_fail(parser, "expression nested too deeply");
+    }
+    parser->depth++;
+    if (verilog_is_symbol(parser, '~')) {
+        verilog_next(parser);
+        parsed = verilog_unary_expression(parser, &operand) &&
+            verilog_operator(parser, CIRCUIT_IMPORT_NOT, operand, CIRCUIT_IMPORT_NONE, net);
+    } else {
+        verilog_next(parser);
+        parsed = verilog_or_expression(parser, net) && verilog_expect(parser, ')', "expected ')'");
+    }
+    parser->depth--;
+    return parsed;
+}
+
+static bool verilog_and_expression(VerilogParser *parser, uint32_t *net) {
+    uint32_t right;
+
+    if (!verilog_unary_expression(parser, net)) {
+        return false;
+    }
+    while (verilog_is_symbol(parser, '&')) {
+        verilog_next(parser);
+        if (!verilog_unary_expression(parser, &right) || !verilog_operator(parser, CIRCUIT_IMPORT_AND, *net, right, net)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool verilog_xor_expression(VerilogParser *parser, uint32_t *net) {
+    uint32_t right;
+
+    if (!verilog_and_expression(parser, net)) {
+        return false;
+    }
+    while (verilog_is_symbol(parser, '^')) {
+        verilog_next(parser);
+        if (!verilog_and_expression(parser, &right) || !verilog_operator(parser, CIRCUIT_IMPORT_XOR, *net, right, net)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool verilog_or_expression(VerilogParser *parser, uint32_t *net) {
+    uint32_t right;
+
+    if (!verilog_xor_expression(parser, net)) {
+        return false;
+    }
+    while (verilog_is_symbol(parser, '|')) {
+        verilog_next(parser);
+        if (!verilog_xor_expression(parser, &right) || !verilog_operator(parser, CIRCUIT_IMPORT_OR, *net, right, net)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// `lhs = expression`, as in assign statements and wire declarations.
+static bool verilog_assignment(VerilogParser *parser, uint32_t lhs) {
+    uint32_t value;
+    unsigned int line;
+
+    line = parser->token.line;
+    return verilog_expect(parser, '=', "expected '='") &&
+        verilog_or_expression(parser, &value) &&
+        circuit_import_alias(&parser->import, lhs, value, line);
+}
+
+static bool verilog_declare(VerilogParser *parser, VerilogPortDirection direction) {
+    bool declared;
+
+    if (parser->token.kind != VERILOG_TOKEN_NAME) {
+        return verilog_fail(parser, "expected a port name");
+    }
+    declared = direction == VERILOG_PORT_INPUT
+        ? circuit_import_input(&parser->import, parser->token.text, parser->token.length, parser->token.line)
+        : circuit_import_output(&parser->import, parser->token.text, parser->token.length, parser->token.line);
+    verilog_next(parser);
+    return declared;
+}
+
+// After `input`/`output`: an optional `wire`, then no range.
+static bool verilog_port_type(VerilogParser *parser) {
+    if (verilog_is(parser, "wire")) {
+        verilog_next(parser);
+    }
+    if (verilog_is(parser, "reg")) {
+        return verilog_fail(parser, "reg ports are not supported");
+    }
+    if (verilog_is_symbol(parser, '[')) {
+        return verilog_fail(parser, "vector ports are not supported");
+    }
+    return true;
+}
+
+static bool verilog_port_declaration(VerilogParser *parser) {
+    VerilogPortDirection direction;
+
+    direction = verilog_is(parser, "input") ? VERILOG_PORT_INPUT : VERILOG_PORT_OUTPUT;
+    verilog_next(parser);
+    if (!verilog_port_type(parser)) {
+        return false;
+    }
+    for (;;) {
+        if (!verilog_declare(parser, direction)) {
+            return false;
+        }
+        if (!verilog_is_symbol(parser, ',')) {
+            break;
+        }
+        verilog_next(parser);
+    }
+    return verilog_expect(parser, ';', "expected ';'");
+}
+
+// `module name (ports);` in either the old style (names only, declared in the
+// body) or ANSI style (directions in the list).
+static bool verilog_module_header(VerilogParser *parser) {
+    VerilogPortDirection direction;
+
+    if (!verilog_is(parser, "module")) {
+        return verilog_fail(parser, "expected 'module'");
+    }
+    verilog_next(parser);
+    if (parser->token.kind != VERILOG_TOKEN_NAME) {
+        return verilog_fail(parser, "expected a module name");
+    }
+    verilog_next(parser);
+    if (verilog_is_symbol(parser, '#')) {
+        return verilog_fail(parser, "module parameters are not supported");
+    }
+
+    if (verilog_is_symbol(parser, '(')) {
+        verilog_next(parser);
+        direction = VERILOG_PORT_NONE;
+        while (!verilog_is_symbol(parser, ')')) {
+            if (verilog_is(parser, "input") || verilog_is(parser, "output")) {
+                direction = verilog_is(parser, "input") ? VERILOG_PORT_INPUT : VERILOG_PORT_OUTPUT;
+                verilog_next(parser);
+                if (!verilog_port_type(parser)) {
+                    return false;
+                }
+            }
+            if (direction != VERILOG_PORT_NONE) {
+                if (!verilog_declare(parser, direction)) {
+                    return false;
+                }
+            } else if (parser->token.kind == VERILOG_TOKEN_NAME) {
+                verilog_next(parser);
+            } else {
+                return verilog_fail(parser, "expected a port name");
+            }
+            if (!verilog_is_symbol(parser, ',')) {
+                break;
+            }
+            verilog_next(parser);
+        }
+        if (!verilog_expect(parser, ')', "expected ')' after the port list")) {
+            return false;
+        }
+    }
+    return verilog_expect(parser, ';', "expected ';'");
+}
+
+static bool verilog_wire_declaration(VerilogParser *parser) {
+    uint32_t net;
+
+    verilog_next(parser);
+    if (verilog_is_symbol(parser, '[')) {
+        return verilog_fail(parser, "vector wires are not supported");
+    }
+    for (;;) {
+        if (!verilog_net(parser, &net)) {
+            return false;
+        }
+        if (verilog_is_symbol(parser, '=') && !verilog_assignment(parser, net)) {
+            return false;
+        }
+        if (!verilog_is_symbol(parser, ',')) {
+            break;
+        }
+        verilog_next(parser);
+    }
+    return verilog_expect(parser, ';', "expected ';'");
+}
+
+static bool verilog_assign_statement(VerilogParser *parser) {
+    uint32_t net;
+
+    verilog_next(parser);
+    for (;;) {
+        if (!verilog_net(parser, &net) || !verilog_assignment(parser, net)) {
+            return false;
+        }
+        if (!verilog_is_symbol(parser, ',')) {
+            break;
+        }
+        verilog_next(parser);
+    }
+    return verilog_expect(parser, ';', "expected ';'");
+}
+
+static bool verilog_push_terminal(VerilogParser *parser, uint32_t net) {
+    if (parser->terminal_count >= parser->terminal_capacity) {
+        uint32_t capacity;
+        uint32_t *terminals;
+
+        capacity = parser->terminal_capacity < 16U ? 16U : parser->terminal_capacity * 2U;
+        terminals = (uint32_t *)mem_realloc(MEM_TAG_LOADER, parser->terminals, capacity * sizeof(*terminals));
+        if (!terminals) {
+            return verilog_fail(parser, "out of memory");
+        }
+        parser->terminals = terminals;
+        parser->terminal_capacity = capacity;
+    }
+    parser->terminals[parser->terminal_count++] = net;
+    return true;
+}
+
+// `and [name] (out, in, in, ...) [, [name] (...)] ;`
+static bool verilog_primitive(VerilogParser *parser, CircuitImportGate gate) {
+    verilog_next(parser);
+    if (verilog_is_symbol(parser, '#')) {
+        return verilog_fail(parser, "delays are not supported");
+    }
+
+    for (;;) {
+        const char *name;
+        size_t name_length;
+        uint32_t output;
+        unsigned int line;
+
+        name = NULL;
+        name_length = 0U;
+        line = parser->token.line;
+        if (parser->token.kind == VERILOG_TOKEN_NAME) {
+            name = parser->token.text;
+            name_length = parser->token.length;
+            verilog_next(parser);
+        }
+        if (!verilog_expect(parser, '(', "expected '(' after the gate") || !verilog_net(parser, &output)) {
+            return false;
+        }
+        parser->terminal_count = 0U;
+        while (verilog_is_symbol(parser, ',')) {
+            uint32_t input;
+
+            verilog_next(parser);
+            if (!verilog_or_expression(parser, &input) || !verilog_push_terminal(parser, input)) {
+                return false;
+            }
+        }
+        if (!verilog_expect(parser, ')', "expected ')' after the gate terminals") ||
+            !circuit_import_gate(&parser->import, gate, name, name_length, output, parser->terminals, parser->terminal_count, line)) {
+            return false;
+        }
+        if (!verilog_is_symbol(parser, ',')) {
+            break;
+        }
+        verilog_next(parser);
+    }
+    return verilog_expect(parser, ';', "expected ';'");
+}
+
+// `dff name (q, d, clk);` or `dff name (.Q(q), .D(d), .CK(clk));`
+static bool verilog_cell(VerilogParser *parser) {
+    const char *name;
+    size_t name_length;
+    uint32_t pins[3];
+    unsigned int line;
+    uint32_t index;
+
+    line = parser->token.line;
+    if (!verilog_is_folded(parser, "dff") && !verilog_is(parser, "$_DFF_P_")) {
+        return circuit_import_fail(&parser->import, line, "unsupported cell", parser->token.text, parser->token.length);
+    }
+    verilog_next(parser);
+
+    name = NULL;
+    name_length = 0U;
+    if (parser->token.kind == VERILOG_TOKEN_NAME) {
+        name = parser->token.text;
+        name_length = parser->token.length;
+        verilog_next(parser);
+    }
+    if (!verilog_expect(parser, '(', "expected '(' after the cell")) {
+        return false;
+    }
+
+    pins[0] = CIRCUIT_IMPORT_NONE;
+    pins[1] = CIRCUIT_IMPORT_NONE;
+    pins[2] = CIRCUIT_IMPORT_NONE;
+    for (index = 0U; !verilog_is_symbol(parser, ')'); index++) {
+        uint32_t pin;
+
+        if (verilog_is_symbol(parser, '.')) {
+            verilog_next(parser);
+            if (verilog_is_folded(parser, "q")) {
+                pin = 0U;
+            } else if (verilog_is_folded(parser, "d")) {
+                pin = 1U;
+            } else if (verilog_is_folded(parser, "c") || verilog_is_folded(parser, "ck") || verilog_is_folded(parser, "clk")) {
+                pin = 2U;
+            } else {
+                return circuit_import_fail(&parser->import, parser->token.line, "unknown dff port", parser->token.text, parser->token.length);
+            }
+            verilog_next(parser);
+            if (!verilog_expect(parser, '(', "expected '(' after the port name") ||
+                !verilog_net(parser, &pins[pin]) ||
+                !verilog_expect(parser, ')', "expected ')' after the port net")) {
+                return false;
+            }
+        } else {
+            if (index >= 3U) {
+                return verilog_fail(parser, "dff takes Q, D and an optional clock");
+            }
+            if (!verilog_net(parser, &pins[index])) {
+                return false;
+            }
+        }
+        if (!verilog_is_symbol(parser, ',')) {
+            break;
+        }
+        verilog_next(parser);
+    }
+    if (!verilog_expect(parser, ')', "expected ')' after the cell ports") || !verilog_expect(parser, ';', "expected ';'")) {
+        return false;
+    }
+    if (pins[0] == CIRCUIT_IMPORT_NONE || pins[1] == CIRCUIT_IMPORT_NONE) {
+        return circuit_import_fail(&parser->import, line, "dff needs Q and D", name, name_length);
+    }
+    return circuit_import_dff(&parser->import, name, name_length, pins[0], pins[1], pins[2], line);
+}
+
+static bool verilog_primitive_gate(const VerilogParser *parser, CircuitImportGate *gate) {
+    static const char *keywords[] = { "and", "or", "xor", "nand", "nor", "xnor", "not", "buf" };
+    static const CircuitImportGate gates[] = {
+        CIRCUIT_IMPORT_AND,
+        CIRCUIT_IMPORT_OR,
+        CIRCUIT_IMPORT_XOR,
+        CIRCUIT_IMPORT_NAND,
+        CIRCUIT_IMPORT_NOR,
+        CIRCUIT_IMPORT_XNOR,
+        CIRCUIT_IMPORT_NOT,
+        CIRCUIT_IMPORT_BUF
+    };
+    size_t index;
+
+    for (index = 0U; index < sizeof(keywords) / sizeof(keywords[0]); index++) {
+        if (verilog_is(parser, keywords[index])) {
+            *gate = gates[index];
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool verilog_module(VerilogParser *parser) {
+    if (!verilog_module_header(parser)) {
+        return false;
+    }
+
+    while (!verilog_is(parser, "endmodule")) {
+        CircuitImportGate gate;
+        bool handled;
+
+        if (parser->token.kind == VERILOG_TOKEN_END) {
+            return verilog_fail(parser, "missing 'endmodule'");
+        }
+        if (verilog_is(parser, "input") || verilog_is(parser, "output")) {
+            handled = verilog_port_declaration(parser);
+        } else if (verilog_is(parser, "wire")) {
+            handled = verilog_wire_declaration(parser);
+        } else if (verilog_is(parser, "assign")) {
+            handled = verilog_assign_statement(parser);
+        } else if (verilog_is(parser, "reg") || verilog_is(parser, "always") || verilog_is(parser, "initial")) {
+            return verilog_fail(parser, "only structural Verilog is supported");
+        } else if (verilog_primitive_gate(parser, &gate)) {
+            handled = verilog_primitive(parser, gate);
+        } else if (parser->token.kind == VERILOG_TOKEN_NAME) {
+            handled = verilog_cell(parser);
+        } else {
+            return verilog_fail(parser, "unexpected symbol");
+        }
+        if (!handled) {
+            return false;
+        }
+    }
+
+    verilog_next(parser);
+    if (verilog_is(parser, "module")) {
+        return verilog_fail(parser, "only one module per file is supported");
+    }
+    if (parser->token.kind != VERILOG_TOKEN_END) {
+        return verilog_fail(parser, "unexpected text after 'endmodule'");
+    }
+    return true;
+}
+
+bool circuit_verilog_parse(const char *data, size_t size, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size) {
+    VerilogParser parser;
+    bool parsed;
+
+    memset(&parser, 0, sizeof(parser));
+    circuit_import_init(&parser.import, arena, error_message, error_message_size);
+    parser.cursor = data;
+    parser.end = data + size;
+    parser.line = 1U;
+    verilog_next(&parser);
+
+    parsed = verilog_module(&parser) && circuit_import_finish(&parser.import, spec);
+    mem_free(parser.terminals);
+    circuit_import_release(&parser.import);
+    return parsed;
+}
@@ -0,0 +1,15 @@
+#ifndef CIRCUIT_VERILOG_H
+#define CIRCUIT_VERILOG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "arena.h"
+#include "circuit_spec.h"
+
+// Structural gate-level Verilog, one module per file: scalar input/output/
+// wire declarations, the and/or/xor/nand/nor/xnor/not/buf primitives (any
+// fan-in), `assign` with ~ & ^ | and parentheses, and `dff` cells connected
+// positionally (Q, D, CLK) or by name (.Q .D .C/.CK/.CLK).
+bool circuit_verilog_parse(const char *data, size_t size, Arena *arena, CircuitSpec *spec, char *error_message, size_t error_message_size);
+
+#endif // CIRCUIT_VERILOG_H
@@ -1,8 +1,15 @@
 #include "draw_util.h"
+#include "rlgl.h"
 #include <stdio.h>
 #include <string.h>
 
 #define TEXT_WRAP_BUFFER_MAX 1024
+#define DRAW_STATS_BATCH_QUADS 32768 // 4x raylib's default, so large circuits rarely overflow
+
+static rlRenderBatch draw_stats_batch;
+static bool draw_stats_attached;
+static uint32_t draw_stats_calls;
+static uint32_t draw_stats_vertices;
 
 static void copy_text(char *buffer, size_t buffer_size, const char *text) {
     if (!buffer || buffer_size == 0U) {
@@ -331,6 +338,62 @@ bool begin_scissor_rect(Rectangle rect) {
         return false;
     }
 
+    draw_flush();
     BeginScissorMode(pixel(rect.x), pixel(rect.y), pixel(rect.width), pixel(rect.height));
     return true;
 }
+
+void end_scissor(void) {
+    draw_flush();
+    EndScissorMode();
+}
+
+void begin_canvas_mode(Camera2D camera) {
+    draw_flush();
+    BeginMode2D(camera);
+}
+
+void end_canvas_mode(void) {
+    draw_flush();
+    EndMode2D();
+}
+
+void draw_stats_attach(void) {
+    if (draw_stats_attached) {
+        return;
+    }
+    draw_stats_batch = rlLoadRenderBatch(1, DRAW_STATS_BATCH_QUADS);
+    rlSetRenderBatchActive(&draw_stats_batch);
+    draw_stats_attached = true;
+}
+
+void draw_stats_detach(void) {
+    if (!draw_stats_attached) {
+        return;
+    }
+    rlSetRenderBatchActive(NULL);
+    rlUnloadRenderBatch(draw_stats_batch);
+    draw_stats_attached = false;
+}
+
+// Each non-empty entry in the batch becomes one glDrawArrays/glDrawElements.
+void draw_flush(void) {
+    int index;
+
+    if (draw_stats_attached) {
+        for (index = 0; index < draw_stats_batch.drawCounter; index++) {
+            if (draw_stats_batch.draws[index].vertexCount > 0) {
+                draw_stats_calls++;
+                draw_stats_vertices += (uint32_t)draw_stats_batch.draws[index].vertexCount;
+            }
+        }
+    }
+    rlDrawRenderBatchActive();
+}
+
+void draw_stats_take(uint32_t *draw_calls, uint32_t *vertices) {
+    *draw_calls = draw_stats_calls;
+    *vertices = draw_stats_vertices;
+    draw_stats_calls = 0U;
+    draw_stats_vertices = 0U;
+}
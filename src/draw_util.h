@@ -37,5 +37,20 @@ float draw_wrapped_text_block(
     Color color
 );
 bool begin_scissor_rect(Rectangle rect);
+void end_scissor(void);
+// BeginMode2D/EndMode2D for the canvas camera, counted like the scissor pair.
+void begin_canvas_mode(Camera2D camera);
+void end_canvas_mode(void);
+
+// Draw-call accounting for the performance overlay. Once attached, the app
+// draws through a render batch of its own, and every flush that goes through
+// draw_flush, the scissor pair or the canvas-mode pair is counted before it
+// is submitted. raylib's own Begin/End*Mode calls flush uncounted, so the app
+// switches modes only through these wrappers; a batch that overflows
+// mid-frame also flushes uncounted.
+void draw_stats_attach(void);
+void draw_stats_detach(void);
+void draw_flush(void);
+void draw_stats_take(uint32_t *draw_calls, uint32_t *vertices);
 
 #endif // DRAW_UTIL_H
@@ -2,8 +2,10 @@
 #include "app_analysis.h"
 #include "app_canvas.h"
 #include "app_commands.h"
+#include "circuit_file_app.h"
 #include "ui.h"
 #include "raylib.h"
+#include <stdio.h>
 #include <string.h>
 
 static int mouse_cursor_for_handle(WorkspaceResizeHandle handle) {
@@ -27,7 +29,7 @@ static LogicNode *find_node_at(AppContext *app, Vector2 mouse_pos) {
         if (node->type == (NodeType)-1) {
             continue;
         }
-        if (CheckCollisionPointRec(mouse_pos, node->rect)) {
+        if (CheckCollisionPointRec(mouse_pos, app_node_rect(app, node))) {
             return node;
         }
     }
@@ -78,6 +80,9 @@ static void queue_keyboard_commands(AppContext *app) {
     if (IsKeyPressed(KEY_PERIOD)) {
         app_queue_command(app, EDITOR_COMMAND_SIM_STEP);
     }
+    if (IsKeyPressed(KEY_H)) {
+        app_queue_command(app, EDITOR_COMMAND_TOGGLE_HEATMAP);
+    }
     if (IsKeyPressed(KEY_ESCAPE)) {
         app_queue_command(app, EDITOR_COMMAND_CANCEL);
     }
@@ -111,6 +116,27 @@ static void queue_keyboard_commands(AppContext *app) {
     }
 }
 
+// Saves over the open file, or to circuit.circ when nothing was loaded, and
+// watches what was written so outside edits keep reloading.
+static void save_circuit(AppContext *app, SourceWatch *source_watch) {
+    char error_message[APP_STATUS_MESSAGE_MAX];
+    char status_message[APP_STATUS_MESSAGE_MAX];
+    char path[APP_SOURCE_PATH_MAX];
+
+    snprintf(path, sizeof(path), "%s", app->source.path[0] != '\0' ? app->source.path : "circuit.circ");
+    if (!circuit_file_save(&app->graph, app->geometry.positions, path, error_message, sizeof(error_message))) {
+        snprintf(status_message, sizeof(status_message), "Save failed: %s", error_message);
+        app_set_source_status(app, status_message);
+        return;
+    }
+
+    app_set_source_path(app, path);
+    if (!source_watch->active || strcmp(source_watch->path, path) != 0) {
+        source_watch_start(source_watch, path);
+    }
+    app_set_source_status(app, "Saved");
+}
+
 static void process_command_queue(AppContext *app) {
     EditorCommand command;
 
@@ -247,9 +273,17 @@ void editor_input_process_frame(
     } else if (state->shortcuts_open && IsKeyPressed(KEY_ESCAPE)) {
         state->shortcuts_open = false;
     }
+    if (IsKeyPressed(KEY_F3)) {
+        state->perf_hud_open = !state->perf_hud_open;
+    }
     if (!state->shortcuts_open && IsKeyPressed(KEY_HOME)) {
         app_reset_canvas_view(app);
     }
+    if (!state->shortcuts_open &&
+        (IsKeyDown(KEY_LEFT_CONTROL) || IsKeyDown(KEY_RIGHT_CONTROL) || IsKeyDown(KEY_LEFT_SUPER) || IsKeyDown(KEY_RIGHT_SUPER)) &&
+        IsKeyPressed(KEY_S)) {
+        save_circuit(app, source_watch);
+    }
     if (!state->shortcuts_open &&
         (canvas_hovered || app->selection.focused_panel == APP_PANEL_CANVAS) &&
         (IsKeyPressed(KEY_EQUAL) || IsKeyPressed(KEY_KP_ADD))) {
@@ -350,8 +384,8 @@ void editor_input_process_frame(
                 app->selection.selected_node = hit_node;
                 app->selection.selected_wire_sink = NULL;
                 app->canvas.drag_offset = (Vector2){
-                    world_mouse_pos.x - hit_node->pos.x,
-                    world_mouse_pos.y - hit_node->pos.y
+                    world_mouse_pos.x - app_node_position(app, hit_node).x,
+                    world_mouse_pos.y - app_node_position(app, hit_node).y
                 };
                 state->click_start_pos = mouse_pos;
                 state->click_moved = false;
@@ -413,9 +447,7 @@ void editor_input_process_frame(
                 world_mouse_pos.x - app->canvas.drag_offset.x,
                 world_mouse_pos.y - app->canvas.drag_offset.y
             };
-            app->canvas.drag_node->pos = app_snap_live_node_position(app, app->canvas.drag_node, dragged_position);
-            app->canvas.drag_node->rect.x = app->canvas.drag_node->pos.x;
-            app->canvas.drag_node->rect.y = app->canvas.drag_node->pos.y;
+            app_set_node_position(app, app->canvas.drag_node, app_snap_live_node_position(app, app->canvas.drag_node, dragged_position));
         }
     }
 
@@ -465,3 +497,7 @@ WorkspaceResizeHandle editor_input_active_resize_handle(const EditorInputState *
 bool editor_input_shortcuts_open(const EditorInputState *state) {
     return state->shortcuts_open;
 }
+
+bool editor_input_perf_hud_open(const EditorInputState *state) {
+    return state->perf_hud_open;
+}
@@ -19,6 +19,7 @@ typedef struct {
     bool click_moved;
     bool layout_save_pending;
     bool shortcuts_open;
+    bool perf_hud_open;
 } EditorInputState;
 
 #if defined(__clang__)
@@ -37,5 +38,6 @@ void editor_input_process_frame(
 );
 WorkspaceResizeHandle editor_input_active_resize_handle(const EditorInputState *state);
 bool editor_input_shortcuts_open(const EditorInputState *state);
+bool editor_input_perf_hud_open(const EditorInputState *state);
 
 #endif // EDITOR_INPUT_H
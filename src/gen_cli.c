@@ -0,0 +1,135 @@
+#include "gen_cli.h"
+#include "circuit_gen.h"
+#include "logic.h"
+#include "mem.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool gen_cli_parse_count(const char *text, uint32_t *count) {
+    char *end;
+    unsigned long value;
+
+    if (text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+    value = strtoul(text, &end, 10);
+    if (*end != '\0' || value > UINT32_MAX) {
+        return false;
+    }
+    *count = (uint32_t)value;
+    return true;
+}
+
+static uint32_t *gen_cli_option(CircuitGenParams *params, const char *flag) {
+    if (strcmp(flag, "--bits") == 0) {
+        return &params->bits;
+    }
+    if (strcmp(flag, "--seed") == 0) {
+        return &params->seed;
+    }
+    if (strcmp(flag, "--inputs") == 0) {
+        return &params->inputs;
+    }
+    if (strcmp(flag, "--gates") == 0) {
+        return &params->gates;
+    }
+    if (strcmp(flag, "--outputs") == 0) {
+        return &params->outputs;
+    }
+    if (strcmp(flag, "--depth") == 0) {
+        return &params->depth;
+    }
+    if (strcmp(flag, "--fanout") == 0) {
+        return &params->max_fanout;
+    }
+    if (strcmp(flag, "--skew") == 0) {
+        return &params->fanout_skew;
+    }
+    return NULL;
+}
+
+static void gen_cli_usage(void) {
+    uint32_t kind;
+
+    fprintf(stderr, "usage: logicsim-gen KIND OUTPUT [--bits N]\n");
+    fprintf(stderr, "       logicsim-gen random-dag OUTPUT [--inputs N] [--gates N] [--outputs N] [--depth N] [--fanout N] [--skew PCT] [--seed N]\n");
+    fprintf(stderr, "  OUTPUT ending in .circb is written binary, anything else as .circ\n  kinds:");
+    for (kind = 0U; kind < CIRCUIT_GEN_KIND_COUNT; kind++) {
+        fprintf(stderr, " %s", circuit_gen_kind_name((CircuitGenKind)kind));
+    }
+    fprintf(stderr, "\n");
+}
+
+// Sinks per driven signal, so the fanout options can be checked at a glance.
+static void gen_cli_print_summary(const LogicGraph *graph, const char *path, FILE *stream) {
+    uint32_t histogram[MAX_PINS + 1];
+    uint32_t wires;
+    uint32_t index;
+
+    memset(histogram, 0, sizeof(histogram));
+    wires = 0U;
+    for (index = 0U; index < graph->node_count; index++) {
+        if (graph->nodes[index].output_count > 0U) {
+            histogram[0]++;
+        }
+    }
+    for (index = 0U; index < graph->net_count; index++) {
+        if (graph->nets[index].source) {
+            histogram[0]--;
+            histogram[graph->nets[index].sink_count]++;
+            wires += graph->nets[index].sink_count;
+        }
+    }
+
+    fprintf(stream, "%s: %u nodes, %u wires, fanout", path, graph->node_count, wires);
+    for (index = 0U; index <= MAX_PINS; index++) {
+        if (histogram[index] > 0U) {
+            fprintf(stream, " %u:%u", index, histogram[index]);
+        }
+    }
+    fprintf(stream, "\n");
+}
+
+int gen_cli_main(int argc, char **argv) {
+    CircuitGenParams params;
+    CircuitGenKind kind;
+    LogicGraph *graph;
+    char error_message[256];
+    int status;
+    int arg;
+
+    if (argc < 3 || !circuit_gen_kind_from_name(argv[1], &kind) || argv[2][0] == '-') {
+        gen_cli_usage();
+        return 2;
+    }
+    circuit_gen_params_init(&params, kind);
+    for (arg = 3; arg < argc; arg++) {
+        uint32_t *value;
+
+        value = gen_cli_option(&params, argv[arg]);
+        if (!value || arg + 1 >= argc || !gen_cli_parse_count(argv[arg + 1], value)) {
+            gen_cli_usage();
+            return 2;
+        }
+        arg++;
+    }
+
+    graph = (LogicGraph *)mem_calloc(MEM_TAG_GRAPH, 1U, sizeof(*graph));
+    if (!graph) {
+        fprintf(stderr, "logicsim-gen: out of memory\n");
+        return 1;
+    }
+    logic_init_graph(graph);
+    status = 0;
+    if (!circuit_gen_build(graph, &params, error_message, sizeof(error_message)) ||
+        !circuit_gen_save(graph, argv[2], error_message, sizeof(error_message))) {
+        fprintf(stderr, "logicsim-gen: %s\n", error_message);
+        status = 1;
+    } else {
+        gen_cli_print_summary(graph, argv[2], stdout);
+    }
+    logic_clear_graph(graph);
+    mem_free(graph);
+    return status;
+}
@@ -0,0 +1,8 @@
+#ifndef GEN_CLI_H
+#define GEN_CLI_H
+
+// logicsim-gen: builds one circuit_gen circuit and writes it as .circ or
+// .circb, then prints its size and fanout histogram.
+int gen_cli_main(int argc, char **argv);
+
+#endif // GEN_CLI_H
@@ -1,8 +1,22 @@
 #include "logic.h"
+#include "logic_activity.h"
+#include "mem.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+static pthread_mutex_t logic_revision_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t logic_last_revision;
+
+// Revisions come from one process-wide counter, so a graph that is cleared,
+// rebuilt or moved never shows a revision a cache has already seen.
+static void logic_bump_revision(LogicGraph *graph) {
+    pthread_mutex_lock(&logic_revision_lock);
+    graph->revision = ++logic_last_revision;
+    pthread_mutex_unlock(&logic_revision_lock);
+}
+
 static void logic_node_init_pins(LogicNode *node) {
     uint8_t i;
 
@@ -257,6 +271,51 @@ static void build_node_expr(LogicGraph *graph, LogicNode *node, char *buf, size_
 
 void logic_init_graph(LogicGraph *graph) {
     memset(graph, 0, sizeof(LogicGraph));
+    logic_bump_revision(graph);
+}
+
+void logic_clear_graph(LogicGraph *graph) {
+    uint32_t i;
+
+    for (i = 0; i < graph->node_count; i++) {
+        mem_free(graph->nodes[i].name);
+        graph->nodes[i].name = NULL;
+    }
+
+    logic_init_graph(graph);
+}
+
+// Hands every node, name and net in `source` over to `destination` (whose
+// previous contents are freed), re-pointing pins and nets into the new copy.
+// `source` is left empty. Net sources are output pins and sinks input pins.
+void logic_move_graph(LogicGraph *destination, LogicGraph *source) {
+    uint32_t i;
+    uint32_t pin;
+
+    logic_clear_graph(destination);
+    memcpy(destination, source, sizeof(LogicGraph));
+
+    for (i = 0; i < destination->node_count; i++) {
+        for (pin = 0; pin < MAX_PINS; pin++) {
+            destination->nodes[i].inputs[pin].node = &destination->nodes[i];
+            destination->nodes[i].outputs[pin].node = &destination->nodes[i];
+        }
+    }
+
+    for (i = 0; i < destination->net_count; i++) {
+        LogicNet *net;
+
+        net = &destination->nets[i];
+        if (net->source) {
+            net->source = &destination->nodes[net->source->node - source->nodes].outputs[net->source->index];
+        }
+        for (pin = 0; pin < net->sink_count; pin++) {
+            net->sinks[pin] = &destination->nodes[net->sinks[pin]->node - source->nodes].inputs[net->sinks[pin]->index];
+        }
+    }
+    logic_bump_revision(destination);
+
+    logic_init_graph(source);
 }
 
 LogicNode* logic_add_node(LogicGraph *graph, NodeType type, const char *name) {
@@ -270,11 +329,12 @@ LogicNode* logic_add_node(LogicGraph *graph, NodeType type, const char *name) {
     memset(node, 0, sizeof(LogicNode));
     node->type = type;
     if (name) {
-        node->name = strdup(name);
+        node->name = mem_strdup(MEM_TAG_NAMES, name);
     }
 
     logic_node_init_pins(node);
     logic_node_set_pin_counts(node, type);
+    logic_bump_revision(graph);
     return node;
 }
 
@@ -288,6 +348,7 @@ LogicNet* logic_add_net(LogicGraph *graph) {
     net = &graph->nets[graph->net_count++];
     memset(net, 0, sizeof(LogicNet));
     net->value = LOGIC_UNKNOWN;
+    logic_bump_revision(graph);
     return net;
 }
 
@@ -342,6 +403,7 @@ bool logic_connect(LogicGraph *graph, LogicPin *src, LogicPin *sink) {
     }
 
     net->sinks[net->sink_count++] = sink;
+    logic_bump_revision(graph);
     return true;
 }
 
@@ -371,6 +433,7 @@ bool logic_disconnect_sink(LogicGraph *graph, LogicPin *sink) {
             if (net->sink_count == 0) {
                 logic_remove_net_at(graph, i);
             }
+            logic_bump_revision(graph);
             return true;
         }
     }
@@ -393,7 +456,7 @@ bool logic_remove_node(LogicGraph *graph, LogicNode *node) {
         i++;
     }
 
-    free(node->name);
+    mem_free(node->name);
     node->name = NULL;
     node->type = (NodeType)-1;
     node->input_count = 0;
@@ -403,8 +466,7 @@ bool logic_remove_node(LogicGraph *graph, LogicNode *node) {
     node->evaluated = false;
     node->state_changed = false;
     node->inputs_changed = false;
-    node->rect = (Rectangle){ 0 };
-    node->pos = (Vector2){ 0 };
+    logic_bump_revision(graph);
 
     return true;
 }
@@ -484,15 +546,28 @@ uint32_t logic_topological_sort(LogicGraph *graph, LogicNode **sorted_nodes) {
     return count;
 }
 
+static LogicValue logic_node_observed_value(const LogicNode *node) {
+    return node->type == NODE_OUTPUT ? node->inputs[0].value : node->outputs[0].value;
+}
+
 void logic_evaluate(LogicGraph *graph) {
     LogicNode *sorted[MAX_NODES];
+    LogicActivity *activity;
     uint32_t count;
+    uint32_t evaluated;
     uint32_t i;
 
+    activity = graph->activity;
+    if (activity) {
+        activity->passes++;
+    }
+    evaluated = 0U;
     count = logic_topological_sort(graph, sorted);
     for (i = 0; i < count; i++) {
         LogicNode *node;
         LogicValue inputs[MAX_PINS];
+        LogicValue before;
+        uint64_t started;
         uint8_t j;
 
         node = sorted[i];
@@ -502,6 +577,14 @@ void logic_evaluate(LogicGraph *graph) {
         if (node->type == NODE_INPUT) {
             continue;
         }
+        evaluated++;
+        // Clocks only change in logic_tick, which records them.
+        started = 0U;
+        before = LOGIC_UNKNOWN;
+        if (activity && node->type != NODE_GATE_CLOCK) {
+            before = logic_node_observed_value(node);
+            started = logic_activity_begin(activity);
+        }
 
         for (j = 0; j < node->input_count; j++) {
             LogicValue value;
@@ -529,7 +612,11 @@ void logic_evaluate(LogicGraph *graph) {
         } else if (node->type != NODE_GATE_CLOCK) {
             node->outputs[0].value = logic_eval_gate(node->type, inputs, node->input_count);
         }
+        if (activity && node->type != NODE_GATE_CLOCK) {
+            logic_activity_end(activity, (uint32_t)(node - graph->nodes), before != logic_node_observed_value(node), started);
+        }
     }
+    graph->node_evaluations += evaluated;
 }
 
 void logic_tick(LogicGraph *graph) {
@@ -577,6 +664,9 @@ void logic_tick(LogicGraph *graph) {
             node->state = (node->state == LOGIC_HIGH) ? LOGIC_LOW : LOGIC_HIGH;
             node->outputs[0].value = node->state;
             node->state_changed = true;
+            if (graph->activity) {
+                logic_activity_end(graph->activity, i, true, 0U);
+            }
         } else {
             node->state_changed = false;
         }
@@ -585,16 +675,10 @@ void logic_tick(LogicGraph *graph) {
     logic_evaluate(graph);
 }
 
-TruthTable* logic_generate_truth_table(LogicGraph *graph) {
-    TruthTable *table;
-    uint32_t cols;
+// Picks the inputs and outputs and sizes the table; the caller allocates data.
+static uint32_t truth_table_collect(LogicGraph *graph, TruthTable *table) {
     uint32_t r;
 
-    table = (TruthTable *)calloc(1, sizeof(TruthTable));
-    if (!table) {
-        return NULL;
-    }
-
     for (r = 0; r < graph->node_count; r++) {
         LogicNode *node;
 
@@ -607,13 +691,14 @@ TruthTable* logic_generate_truth_table(LogicGraph *graph) {
     }
 
     table->row_count = 1U << table->input_count;
-    cols = (uint32_t)table->input_count + (uint32_t)table->output_count;
-    table->data = (LogicValue *)calloc(table->row_count * cols, sizeof(LogicValue));
-    if (!table->data) {
-        free(table);
-        return NULL;
-    }
+    return table->row_count * ((uint32_t)table->input_count + (uint32_t)table->output_count);
+}
+
+static void truth_table_fill(LogicGraph *graph, TruthTable *table) {
+    uint32_t cols;
+    uint32_t r;
 
+    cols = (uint32_t)table->input_count + (uint32_t)table->output_count;
     for (r = 0; r < table->row_count; r++) {
         uint8_t i;
 
@@ -636,7 +721,44 @@ TruthTable* logic_generate_truth_table(LogicGraph *graph) {
                 table->outputs[i]->inputs[0].value;
         }
     }
+}
+
+TruthTable* logic_generate_truth_table(LogicGraph *graph) {
+    TruthTable *table;
+    uint32_t cells;
+
+    table = (TruthTable *)mem_calloc(MEM_TAG_TRUTH_TABLE, 1, sizeof(TruthTable));
+    if (!table) {
+        return NULL;
+    }
+
+    cells = truth_table_collect(graph, table);
+    table->data = (LogicValue *)mem_calloc(MEM_TAG_TRUTH_TABLE, cells, sizeof(LogicValue));
+    if (!table->data) {
+        mem_free(table);
+        return NULL;
+    }
+
+    truth_table_fill(graph, table);
+    return table;
+}
+
+TruthTable *logic_generate_truth_table_in(LogicGraph *graph, Arena *arena) {
+    TruthTable *table;
+    uint32_t cells;
+
+    table = (TruthTable *)arena_alloc(arena, sizeof(TruthTable));
+    if (!table) {
+        return NULL;
+    }
+
+    cells = truth_table_collect(graph, table);
+    table->data = (LogicValue *)arena_alloc(arena, cells * sizeof(LogicValue));
+    if (!table->data) {
+        return NULL;
+    }
 
+    truth_table_fill(graph, table);
     return table;
 }
 
@@ -648,7 +770,25 @@ char* logic_generate_expression(LogicGraph *graph, LogicNode *output_node) {
         return NULL;
     }
 
-    buf = (char *)calloc(1024, sizeof(char));
+    buf = (char *)mem_calloc(MEM_TAG_EXPRESSIONS, 1024, sizeof(char));
+    if (!buf) {
+        return NULL;
+    }
+
+    pos = 0;
+    build_pin_expr(graph, &output_node->inputs[0], buf, &pos, 1024U, false);
+    return buf;
+}
+
+char *logic_generate_expression_in(LogicGraph *graph, LogicNode *output_node, Arena *arena) {
+    char *buf;
+    size_t pos;
+
+    if (!output_node || output_node->type != NODE_OUTPUT) {
+        return NULL;
+    }
+
+    buf = (char *)arena_alloc(arena, 1024U);
     if (!buf) {
         return NULL;
     }
@@ -748,9 +888,38 @@ bool logic_format_equation_resolved(LogicGraph *graph, LogicNode *node, char *ou
     return true;
 }
 
+void logic_truth_table_pack_column(const TruthTable *table, uint32_t column, TruthColumn *packed) {
+    uint32_t cols;
+    uint32_t row;
+
+    memset(packed, 0, sizeof(*packed));
+    if (!table || !table->data) {
+        return;
+    }
+
+    cols = (uint32_t)table->input_count + (uint32_t)table->output_count;
+    if (column >= cols) {
+        return;
+    }
+
+    for (row = 0U; row < table->row_count; row++) {
+        uint32_t value;
+        uint64_t bit;
+
+        value = (uint32_t)table->data[(row * cols) + column];
+        bit = 1ULL << (row & 63U);
+        if ((value & 1U) != 0U) {
+            packed->planes[0][row >> 6U] |= bit;
+        }
+        if ((value & 2U) != 0U) {
+            packed->planes[1][row >> 6U] |= bit;
+        }
+    }
+}
+
 void logic_free_truth_table(TruthTable *table) {
     if (table) {
-        free(table->data);
-        free(table);
+        mem_free(table->data);
+        mem_free(table);
     }
 }
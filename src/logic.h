@@ -1,6 +1,7 @@
 #ifndef LOGIC_H
 #define LOGIC_H
 
+#include "arena.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -29,11 +30,12 @@ typedef enum {
 #define MAX_PINS 8
 #define MAX_NODES 1024
 #define MAX_NETS 2048
-
-#include "raylib.h"
+#define TRUTH_TABLE_MAX_ROWS (1U << MAX_PINS)
+#define TRUTH_COLUMN_WORDS (TRUTH_TABLE_MAX_ROWS / 64U)
 
 typedef struct LogicNode LogicNode;
 typedef struct LogicNet LogicNet;
+typedef struct LogicActivity LogicActivity;
 
 typedef struct {
     LogicNode *node;
@@ -54,8 +56,6 @@ struct LogicNode {
     char *name;
     LogicPin inputs[MAX_PINS];
     LogicPin outputs[MAX_PINS];
-    Rectangle rect;
-    Vector2 pos;
     NodeType type;
     LogicValue state;
     LogicValue prev_state;
@@ -72,6 +72,10 @@ typedef struct {
     LogicNet nets[MAX_NETS];
     uint32_t node_count;
     uint32_t net_count;
+    uint32_t revision; // Changes on every structural edit, clear and move; never repeats within a process
+    uint8_t _padding[4];
+    uint64_t node_evaluations; // Gates, outputs and flip-flops settled so far, for profiling
+    LogicActivity *activity; // Per-node counters (logic_activity.h), NULL unless attached
 } LogicGraph;
 
 typedef struct {
@@ -84,8 +88,16 @@ typedef struct {
     uint8_t _padding[2];
 } TruthTable;
 
+// One truth-table column packed as two bit planes holding bit 0 and bit 1 of
+// each row's LogicValue, so two columns are equal iff both planes are equal.
+typedef struct {
+    uint64_t planes[2][TRUTH_COLUMN_WORDS];
+} TruthColumn;
+
 // Core Logic Engine API
 void logic_init_graph(LogicGraph *graph);
+void logic_clear_graph(LogicGraph *graph);
+void logic_move_graph(LogicGraph *destination, LogicGraph *source);
 LogicNode* logic_add_node(LogicGraph *graph, NodeType type, const char *name);
 LogicNet* logic_add_net(LogicGraph *graph);
 bool logic_connect(LogicGraph *graph, LogicPin *src, LogicPin *sink);
@@ -101,9 +113,13 @@ uint32_t logic_topological_sort(LogicGraph *graph, LogicNode **sorted_nodes);
 // Truth Table API
 TruthTable* logic_generate_truth_table(LogicGraph *graph);
 void logic_free_truth_table(TruthTable *table);
+// Allocated from `arena` instead; never pass the result to logic_free_truth_table.
+TruthTable *logic_generate_truth_table_in(LogicGraph *graph, Arena *arena);
+void logic_truth_table_pack_column(const TruthTable *table, uint32_t column, TruthColumn *packed);
 
-// Expression API
+// Expression API; release the result with mem_free
 char* logic_generate_expression(LogicGraph *graph, LogicNode *output_node);
+char *logic_generate_expression_in(LogicGraph *graph, LogicNode *output_node, Arena *arena);
 bool logic_format_equation_symbolic(LogicGraph *graph, LogicNode *node, char *out, size_t len);
 bool logic_format_equation_values(LogicGraph *graph, LogicNode *node, char *out, size_t len);
 bool logic_format_equation_resolved(LogicGraph *graph, LogicNode *node, char *out, size_t len);
@@ -0,0 +1,87 @@
+#include "logic_activity.h"
+#include <string.h>
+#include <time.h>
+
+static uint64_t logic_activity_now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+void logic_activity_reset(LogicActivity *activity, uint32_t sample_interval) {
+    memset(activity, 0, sizeof(*activity));
+    activity->sample_interval = sample_interval > 0U ? sample_interval : LOGIC_ACTIVITY_SAMPLE_INTERVAL;
+    activity->sample_countdown = activity->sample_interval;
+    activity->sample_seed = 1U;
+}
+
+void logic_activity_attach(LogicGraph *graph, LogicActivity *activity) {
+    graph->activity = activity;
+}
+
+double logic_activity_node_seconds(const LogicActivity *activity, uint32_t node_index) {
+    const LogicNodeActivity *node;
+
+    node = &activity->nodes[node_index];
+    if (node->samples == 0U) {
+        return 0.0;
+    }
+    return ((double)node->sampled_ns / (double)node->samples) * (double)node->evaluations / 1e9;
+}
+
+void logic_activity_summarize(const LogicGraph *graph, const LogicActivity *activity, LogicActivitySummary *summary) {
+    uint32_t index;
+
+    memset(summary, 0, sizeof(*summary));
+    for (index = 0U; index < graph->node_count; index++) {
+        const LogicNodeActivity *node;
+
+        node = &activity->nodes[index];
+        if (graph->nodes[index].type == (NodeType)-1 || node->evaluations == 0U) {
+            continue;
+        }
+        summary->active_nodes++;
+        summary->evaluations += node->evaluations;
+        summary->toggles += node->toggles;
+        summary->estimated_seconds += logic_activity_node_seconds(activity, index);
+        if (node->toggles == 0U) {
+            summary->idle_nodes++;
+        } else if (node->toggles > summary->peak_toggles) {
+            summary->peak_toggles = node->toggles;
+            summary->hottest_node = index;
+        }
+    }
+    if (summary->evaluations > 0U) {
+        summary->activity_factor = (double)summary->toggles / (double)summary->evaluations;
+    }
+}
+
+// The gap to the next sample is drawn from interval/2 .. 3*interval/2. A
+// fixed stride would keep landing on the same node whenever the evaluations
+// per pass divide it.
+uint64_t logic_activity_begin(LogicActivity *activity) {
+    uint32_t interval;
+
+    if (--activity->sample_countdown > 0U) {
+        return 0U;
+    }
+    interval = activity->sample_interval;
+    activity->sample_seed = (activity->sample_seed * 1664525U) + 1013904223U;
+    activity->sample_countdown = (interval - (interval / 2U)) + ((activity->sample_seed >> 16) % interval);
+    return logic_activity_now_ns();
+}
+
+void logic_activity_end(LogicActivity *activity, uint32_t node_index, bool toggled, uint64_t started_ns) {
+    LogicNodeActivity *node;
+
+    node = &activity->nodes[node_index];
+    node->evaluations++;
+    if (toggled) {
+        node->toggles++;
+    }
+    if (started_ns != 0U) {
+        node->sampled_ns += logic_activity_now_ns() - started_ns;
+        node->samples++;
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef LOGIC_ACTIVITY_H
+#define LOGIC_ACTIVITY_H
+
+#include "logic.h"
+
+#define LOGIC_ACTIVITY_SAMPLE_INTERVAL 64U // time one node evaluation in this many, on average
+
+// Per-node counters for finding hot logic, glitchy cones and idle regions.
+// A toggle is any change of the node's observed value (its output, or an
+// output node's input), including to and from X.
+typedef struct {
+    uint64_t evaluations;
+    uint64_t toggles;
+    uint64_t sampled_ns; // total time of the sampled evaluations
+    uint32_t samples;
+    uint8_t _padding[4];
+} LogicNodeActivity;
+
+// Indexed like LogicGraph.nodes. Recording is off unless a record is
+// attached; logic_clear_graph detaches it.
+struct LogicActivity {
+    LogicNodeActivity nodes[MAX_NODES];
+    uint64_t passes; // logic_evaluate calls and stimulus settles recorded
+    uint32_t sample_interval;
+    uint32_t sample_countdown;
+    uint32_t sample_seed; // jitters the gap between samples
+    uint8_t _padding[4];
+};
+
+typedef struct {
+    uint64_t evaluations;
+    uint64_t toggles;
+    uint64_t peak_toggles;
+    double activity_factor; // toggles per evaluation; low favours event-driven evaluation
+    double estimated_seconds;
+    uint32_t active_nodes; // evaluated at least once
+    uint32_t idle_nodes; // evaluated but never toggled
+    uint32_t hottest_node; // most toggles; meaningless when toggles == 0
+    uint8_t _padding[4];
+} LogicActivitySummary;
+
+void logic_activity_reset(LogicActivity *activity, uint32_t sample_interval);
+// NULL detaches. The record is only written while the graph is evaluated.
+void logic_activity_attach(LogicGraph *graph, LogicActivity *activity);
+// Sampled time scaled up to every evaluation of the node.
+double logic_activity_node_seconds(const LogicActivity *activity, uint32_t node_index);
+void logic_activity_summarize(const LogicGraph *graph, const LogicActivity *activity, LogicActivitySummary *summary);
+
+// Evaluation hooks, called around each node the engine settles while a
+// record is attached. begin returns 0 unless this evaluation is timed.
+uint64_t logic_activity_begin(LogicActivity *activity);
+void logic_activity_end(LogicActivity *activity, uint32_t node_index, bool toggled, uint64_t started_ns);
+
+#endif // LOGIC_ACTIVITY_H
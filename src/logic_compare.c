@@ -0,0 +1,211 @@
+#include "logic_compare.h"
+#include <string.h>
+
+static bool logic_compare_target_is_fresh(const LogicCompareTarget *target, const LogicGraph *graph) {
+    return target->table &&
+        target->graph == graph &&
+        target->graph_revision == graph->revision;
+}
+
+static bool logic_compare_names_match(const LogicNode *left, const LogicNode *right) {
+    return left && right && left->name && right->name && strcmp(left->name, right->name) == 0;
+}
+
+// Pairs every compared column with a reference column of the same name, then
+// hands out the remaining reference columns in declaration order.
+static void logic_compare_match_columns(LogicNode *const *nodes, LogicNode *const *reference_nodes, uint8_t count, uint8_t *map) {
+    bool taken[MAX_PINS];
+    bool matched[MAX_PINS];
+    uint8_t index;
+    uint8_t next_free;
+
+    memset(taken, 0, sizeof(taken));
+    memset(matched, 0, sizeof(matched));
+    for (index = 0U; index < count; index++) {
+        uint8_t reference_index;
+
+        for (reference_index = 0U; reference_index < count; reference_index++) {
+            if (!taken[reference_index] && logic_compare_names_match(nodes[index], reference_nodes[reference_index])) {
+                map[index] = reference_index;
+                taken[reference_index] = true;
+                matched[index] = true;
+                break;
+            }
+        }
+    }
+
+    next_free = 0U;
+    for (index = 0U; index < count; index++) {
+        if (matched[index]) {
+            continue;
+        }
+        while (taken[next_free]) {
+            next_free++;
+        }
+        map[index] = next_free;
+        taken[next_free] = true;
+    }
+}
+
+static void logic_compare_permute_column(const TruthColumn *source, const uint8_t *row_map, uint32_t row_count, TruthColumn *permuted) {
+    uint32_t row;
+
+    memset(permuted, 0, sizeof(*permuted));
+    for (row = 0U; row < row_count; row++) {
+        uint32_t source_row;
+        uint64_t bit;
+        uint8_t plane;
+
+        source_row = row_map[row];
+        bit = 1ULL << (row & 63U);
+        for (plane = 0U; plane < 2U; plane++) {
+            if (((source->planes[plane][source_row >> 6U] >> (source_row & 63U)) & 1U) != 0U) {
+                permuted->planes[plane][row >> 6U] |= bit;
+            }
+        }
+    }
+}
+
+// Rebuilds the alignment at most once per compared revision; the caller has
+// already checked that the column counts agree.
+static void logic_compare_refresh_alignment(LogicCompareTarget *target, const TruthTable *table, uint32_t table_revision) {
+    uint8_t row_map[TRUTH_TABLE_MAX_ROWS];
+    uint32_t row;
+    uint8_t index;
+
+    if (target->aligned && target->aligned_revision == table_revision) {
+        return;
+    }
+
+    logic_compare_match_columns(table->inputs, target->table->inputs, table->input_count, target->input_map);
+    logic_compare_match_columns(table->outputs, target->table->outputs, table->output_count, target->output_map);
+
+    for (row = 0U; row < table->row_count; row++) {
+        uint32_t reference_row;
+
+        reference_row = 0U;
+        for (index = 0U; index < table->input_count; index++) {
+            uint32_t bit;
+            uint32_t reference_bit;
+
+            bit = (uint32_t)table->input_count - 1U - (uint32_t)index;
+            reference_bit = (uint32_t)table->input_count - 1U - (uint32_t)target->input_map[index];
+            if ((row & (1U << bit)) != 0U) {
+                reference_row |= 1U << reference_bit;
+            }
+        }
+        row_map[row] = (uint8_t)reference_row;
+    }
+
+    for (index = 0U; index < table->output_count; index++) {
+        logic_compare_permute_column(
+            &target->columns[target->output_map[index]],
+            row_map,
+            table->row_count,
+            &target->aligned_columns[index]
+        );
+    }
+
+    target->aligned_revision = table_revision;
+    target->aligned = true;
+}
+
+bool logic_compare_target_refresh(LogicCompareTarget *target, LogicGraph *graph) {
+    uint8_t output_index;
+
+    if (!target || !graph) {
+        return false;
+    }
+    if (logic_compare_target_is_fresh(target, graph)) {
+        return true;
+    }
+
+    target->aligned = false;
+    logic_free_truth_table(target->table);
+    target->table = logic_generate_truth_table(graph);
+    target->graph = graph;
+    target->graph_revision = graph->revision;
+    if (!target->table) {
+        return false;
+    }
+
+    for (output_index = 0U; output_index < target->table->output_count; output_index++) {
+        logic_truth_table_pack_column(
+            target->table,
+            (uint32_t)target->table->input_count + (uint32_t)output_index,
+            &target->columns[output_index]
+        );
+    }
+
+    return true;
+}
+
+void logic_compare_target_release(LogicCompareTarget *target) {
+    if (!target) {
+        return;
+    }
+
+    logic_free_truth_table(target->table);
+    memset(target, 0, sizeof(*target));
+}
+
+void logic_compare_target_invalidate_alignment(LogicCompareTarget *target) {
+    if (target) {
+        target->aligned = false;
+    }
+}
+
+LogicCompareResult logic_compare_with_table(LogicCompareTarget *target, const TruthTable *table, uint32_t table_revision) {
+    LogicCompareResult result;
+    uint64_t row_differences[TRUTH_COLUMN_WORDS];
+    uint32_t word_index;
+    uint8_t output_index;
+
+    memset(&result, 0, sizeof(result));
+    if (!target || !target->table || !table) {
+        return result;
+    }
+
+    result.comparable = true;
+    if (table->input_count != target->table->input_count || table->output_count != target->table->output_count) {
+        return result;
+    }
+
+    // The reference side is packed and aligned once per revision, so each call only packs the compared columns.
+    result.shapes_match = true;
+    logic_compare_refresh_alignment(target, table, table_revision);
+    memset(row_differences, 0, sizeof(row_differences));
+    for (output_index = 0U; output_index < table->output_count; output_index++) {
+        TruthColumn column;
+
+        logic_truth_table_pack_column(table, (uint32_t)table->input_count + (uint32_t)output_index, &column);
+        for (word_index = 0U; word_index < TRUTH_COLUMN_WORDS; word_index++) {
+            row_differences[word_index] |=
+                (column.planes[0][word_index] ^ target->aligned_columns[output_index].planes[0][word_index]) |
+                (column.planes[1][word_index] ^ target->aligned_columns[output_index].planes[1][word_index]);
+        }
+    }
+
+    result.equivalent = true;
+    for (word_index = 0U; word_index < TRUTH_COLUMN_WORDS; word_index++) {
+        if (row_differences[word_index] != 0U) {
+            result.equivalent = false;
+            result.first_failing_row = (word_index * 64U) + (uint32_t)__builtin_ctzll(row_differences[word_index]);
+            break;
+        }
+    }
+
+    return result;
+}
+
+LogicValue logic_compare_expected_value(const LogicCompareTarget *target, uint8_t output_index, uint32_t row) {
+    uint32_t value;
+
+    if (!target || !target->aligned || output_index >= MAX_PINS || row >= TRUTH_TABLE_MAX_ROWS) {
+        return LOGIC_UNKNOWN;
+    }
+
+    value = (uint32_t)((target->aligned_columns[output_index].planes[0][row >> 6U] >> (row & 63U)) & 1U);
+    value |= (uint32_t)((target->aligned_columns[output_index].planes[1][row >> 6U] >> (row & 63U)) & 1U) << 1U;
+    return (LogicValue)value;
+}
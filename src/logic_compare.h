@@ -0,0 +1,35 @@
+#ifndef LOGIC_COMPARE_H
+#define LOGIC_COMPARE_H
+
+#include "logic.h"
+
+// Analysis artifacts of a reference graph, cached until the graph's revision
+// changes, plus the name-based alignment against the last compared table.
+typedef struct {
+    TruthTable *table;
+    const LogicGraph *graph;
+    TruthColumn columns[MAX_PINS];
+    TruthColumn aligned_columns[MAX_PINS]; // columns permuted into the compared table's row/output order
+    uint32_t graph_revision;
+    uint32_t aligned_revision;
+    uint8_t input_map[MAX_PINS]; // compared input index -> reference input index
+    uint8_t output_map[MAX_PINS]; // compared output index -> reference output index
+    bool aligned;
+    uint8_t _padding[7];
+} LogicCompareTarget;
+
+typedef struct {
+    uint32_t first_failing_row;
+    bool comparable;
+    bool shapes_match;
+    bool equivalent;
+    uint8_t _padding;
+} LogicCompareResult;
+
+bool logic_compare_target_refresh(LogicCompareTarget *target, LogicGraph *graph);
+void logic_compare_target_release(LogicCompareTarget *target);
+void logic_compare_target_invalidate_alignment(LogicCompareTarget *target);
+LogicCompareResult logic_compare_with_table(LogicCompareTarget *target, const TruthTable *table, uint32_t table_revision);
+LogicValue logic_compare_expected_value(const LogicCompareTarget *target, uint8_t output_index, uint32_t row);
+
+#endif // LOGIC_COMPARE_H
@@ -0,0 +1,206 @@
+#include "logic_fault.h"
+#include "mem.h"
+#include <stdlib.h>
+#include <string.h>
+
+static uint64_t logic_fault_block_mask(uint32_t row_count, uint32_t block) {
+    uint32_t remaining;
+
+    remaining = row_count - (block * 64U);
+    return remaining >= 64U ? ~0ULL : ((1ULL << remaining) - 1ULL);
+}
+
+// A faulty evaluation only writes the fault site and the outputs of the gates
+// after it; gate outputs are numbered in gate order, so that is one tail range.
+static void logic_fault_restore(const LogicNetlist *netlist, const LogicFault *fault, const uint64_t *good, uint64_t *faulty) {
+    uint32_t first_signal;
+
+    faulty[fault->signal] = good[fault->signal];
+    first_signal = netlist->signal_gates[fault->signal] == LOGIC_NETLIST_NO_GATE
+        ? (uint32_t)netlist->input_count
+        : (uint32_t)fault->signal + 1U;
+    if (first_signal < netlist->signal_count) {
+        memcpy(&faulty[first_signal], &good[first_signal], (netlist->signal_count - first_signal) * sizeof(*faulty));
+    }
+}
+
+// Stem faults: every input and gate output stuck at 0 and at 1.
+uint32_t logic_fault_list(const LogicNetlist *netlist, LogicFault *faults) {
+    uint32_t signal;
+    uint32_t count;
+
+    count = 0U;
+    for (signal = 0U; signal < netlist->signal_count; signal++) {
+        memset(&faults[count], 0, 2U * sizeof(*faults));
+        faults[count].signal = (uint16_t)signal;
+        faults[count].stuck_value = 0U;
+        faults[count + 1U].signal = (uint16_t)signal;
+        faults[count + 1U].stuck_value = 1U;
+        count += 2U;
+    }
+    return count;
+}
+
+// Parallel-pattern single-fault propagation: 64 patterns per pass, and a fault
+// is dropped as soon as any pattern shows it on an output.
+bool logic_fault_coverage(const LogicNetlist *netlist, const uint32_t *rows, uint32_t row_count, LogicFaultReport *report) {
+    LogicFault *faults;
+    uint64_t *good;
+    uint64_t *faulty;
+    bool *detected;
+    uint32_t block;
+    uint32_t index;
+
+    if (!netlist || !report || (!rows && row_count > 0U)) {
+        return false;
+    }
+
+    memset(report, 0, sizeof(*report));
+    faults = (LogicFault *)mem_alloc(MEM_TAG_ANALYSIS, LOGIC_FAULT_MAX * sizeof(*faults));
+    good = (uint64_t *)mem_calloc(MEM_TAG_ANALYSIS, netlist->signal_count + 1U, sizeof(*good));
+    faulty = (uint64_t *)mem_calloc(MEM_TAG_ANALYSIS, netlist->signal_count + 1U, sizeof(*faulty));
+    detected = (bool *)mem_calloc(MEM_TAG_ANALYSIS, LOGIC_FAULT_MAX, sizeof(*detected));
+    if (!faults || !good || !faulty || !detected) {
+        mem_free(faults);
+        mem_free(good);
+        mem_free(faulty);
+        mem_free(detected);
+        return false;
+    }
+
+    report->fault_count = logic_fault_list(netlist, faults);
+    for (block = 0U; block * 64U < row_count; block++) {
+        uint64_t mask;
+
+        mask = logic_fault_block_mask(row_count, block);
+        logic_netlist_load_rows(netlist, &rows[block * 64U], row_count - (block * 64U), good);
+        logic_netlist_eval(netlist, good, NULL);
+        memcpy(faulty, good, netlist->signal_count * sizeof(*faulty));
+
+        for (index = 0U; index < report->fault_count; index++) {
+            uint8_t output;
+
+            if (detected[index]) {
+                continue;
+            }
+            logic_netlist_eval(netlist, faulty, &faults[index]);
+            for (output = 0U; output < netlist->output_count; output++) {
+                uint16_t signal;
+
+                signal = netlist->output_signals[output];
+                if (((faulty[signal] ^ good[signal]) & mask) != 0U) {
+                    detected[index] = true;
+                    break;
+                }
+            }
+            logic_fault_restore(netlist, &faults[index], good, faulty);
+        }
+    }
+
+    for (index = 0U; index < report->fault_count; index++) {
+        if (detected[index]) {
+            report->detected_count++;
+        } else {
+            report->undetected[report->undetected_count] = faults[index];
+            report->undetected_count++;
+        }
+    }
+
+    mem_free(faults);
+    mem_free(good);
+    mem_free(faulty);
+    mem_free(detected);
+    return true;
+}
+
+// Finds the single stuck-at fault whose behaviour over all `row_count` rows
+// is closest to `expected` (one packed column per output, already in this
+// netlist's row and output order). Rows the expected side leaves unknown are
+// ignored. Returns false when no fault does better than the circuit itself.
+bool logic_fault_explain(const LogicNetlist *netlist, const TruthColumn *expected, uint32_t row_count, LogicFault *best_fault, uint32_t *mismatched_rows) {
+    LogicFault *faults;
+    uint64_t *good;
+    uint64_t *faulty;
+    uint64_t care[MAX_PINS][TRUTH_COLUMN_WORDS];
+    uint32_t block_count;
+    uint32_t fault_count;
+    uint32_t best;
+    uint32_t block;
+    uint32_t index;
+    uint8_t output;
+    bool found;
+
+    if (!netlist || !expected || !best_fault || row_count == 0U || row_count > TRUTH_TABLE_MAX_ROWS) {
+        return false;
+    }
+
+    block_count = (row_count + 63U) / 64U;
+    faults = (LogicFault *)mem_alloc(MEM_TAG_ANALYSIS, LOGIC_FAULT_MAX * sizeof(*faults));
+    good = (uint64_t *)mem_calloc(MEM_TAG_ANALYSIS, (size_t)block_count * (netlist->signal_count + 1U), sizeof(*good));
+    faulty = (uint64_t *)mem_calloc(MEM_TAG_ANALYSIS, (size_t)block_count * (netlist->signal_count + 1U), sizeof(*faulty));
+    if (!faults || !good || !faulty) {
+        mem_free(faults);
+        mem_free(good);
+        mem_free(faulty);
+        return false;
+    }
+
+    best = 0U;
+    for (block = 0U; block < block_count; block++) {
+        uint64_t *signals;
+        uint32_t rows[64];
+        uint64_t difference;
+
+        for (index = 0U; index < 64U; index++) {
+            rows[index] = (block * 64U) + index;
+        }
+        signals = &good[block * (netlist->signal_count + 1U)];
+        logic_netlist_load_rows(netlist, rows, row_count - (block * 64U), signals);
+        logic_netlist_eval(netlist, signals, NULL);
+        memcpy(&faulty[block * (netlist->signal_count + 1U)], signals, netlist->signal_count * sizeof(*signals));
+
+        difference = 0U;
+        for (output = 0U; output < netlist->output_count; output++) {
+            care[output][block] = ~expected[output].planes[1][block] & logic_fault_block_mask(row_count, block);
+            difference |= (signals[netlist->output_signals[output]] ^ expected[output].planes[0][block]) & care[output][block];
+        }
+        best += (uint32_t)__builtin_popcountll(difference);
+    }
+
+    found = false;
+    fault_count = logic_fault_list(netlist, faults);
+    for (index = 0U; index < fault_count && best > 0U; index++) {
+        uint32_t mismatches;
+
+        mismatches = 0U;
+        for (block = 0U; block < block_count && mismatches < best; block++) {
+            uint64_t *block_good;
+            uint64_t *block_faulty;
+            uint64_t difference;
+
+            block_good = &good[block * (netlist->signal_count + 1U)];
+            block_faulty = &faulty[block * (netlist->signal_count + 1U)];
+            logic_netlist_eval(netlist, block_faulty, &faults[index]);
+            difference = 0U;
+            for (output = 0U; output < netlist->output_count; output++) {
+                difference |= (block_faulty[netlist->output_signals[output]] ^ expected[output].planes[0][block]) & care[output][block];
+            }
+            mismatches += (uint32_t)__builtin_popcountll(difference);
+            logic_fault_restore(netlist, &faults[index], block_good, block_faulty);
+        }
+
+        if (mismatches < best) {
+            best = mismatches;
+            *best_fault = faults[index];
+            found = true;
+        }
+    }
+
+    if (mismatched_rows) {
+        *mismatched_rows = best;
+    }
+    mem_free(faults);
+    mem_free(good);
+    mem_free(faulty);
+    return found;
+}
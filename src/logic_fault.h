@@ -0,0 +1,20 @@
+#ifndef LOGIC_FAULT_H
+#define LOGIC_FAULT_H
+
+#include "logic_netlist.h"
+
+#define LOGIC_FAULT_MAX (MAX_NODES * 2U)
+
+typedef struct {
+    LogicFault undetected[LOGIC_FAULT_MAX];
+    uint32_t fault_count;
+    uint32_t detected_count;
+    uint32_t undetected_count;
+    uint8_t _padding[4];
+} LogicFaultReport;
+
+uint32_t logic_fault_list(const LogicNetlist *netlist, LogicFault *faults);
+bool logic_fault_coverage(const LogicNetlist *netlist, const uint32_t *rows, uint32_t row_count, LogicFaultReport *report);
+bool logic_fault_explain(const LogicNetlist *netlist, const TruthColumn *expected, uint32_t row_count, LogicFault *best_fault, uint32_t *mismatched_rows);
+
+#endif // LOGIC_FAULT_H
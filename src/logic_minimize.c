@@ -0,0 +1,530 @@
+#include "logic_minimize.h"
+#include "mem.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Branch-and-bound nodes spent per output before the greedy cover is kept.
+// Essential primes usually leave nothing to search; this caps a random
+// 8-input function at roughly a millisecond per output.
+#define LOGIC_MINIMIZE_SEARCH_BUDGET 4000U
+
+typedef struct {
+    uint64_t words[TRUTH_COLUMN_WORDS];
+} LogicRowSet;
+
+typedef struct {
+    LogicRowSet rows; // ON-set rows covered by the prime
+    LogicCube cube;
+    uint32_t literal_count;
+} LogicPrime;
+
+typedef struct {
+    const LogicPrime *primes;
+    const uint32_t *candidates; // primes still useful after the essentials, best coverage first
+    uint32_t candidate_count;
+    uint32_t budget;
+    uint32_t max_rows_per_prime;
+    uint32_t best_count;
+    uint32_t best_literals;
+    bool exhausted;
+    uint8_t _padding[3];
+    uint32_t chosen[LOGIC_COVER_MAX_CUBES];
+    uint32_t best[LOGIC_COVER_MAX_CUBES];
+} LogicMinimizeSearch;
+
+static bool row_set_test(const LogicRowSet *set, uint32_t row) {
+    return ((set->words[row >> 6U] >> (row & 63U)) & 1U) != 0U;
+}
+
+static void row_set_add(LogicRowSet *set, uint32_t row) {
+    set->words[row >> 6U] |= 1ULL << (row & 63U);
+}
+
+static uint32_t row_set_count(const LogicRowSet *set) {
+    uint32_t count;
+    uint32_t word;
+
+    count = 0U;
+    for (word = 0U; word < TRUTH_COLUMN_WORDS; word++) {
+        count += (uint32_t)__builtin_popcountll(set->words[word]);
+    }
+    return count;
+}
+
+static uint32_t row_set_count_common(const LogicRowSet *left, const LogicRowSet *right) {
+    uint32_t count;
+    uint32_t word;
+
+    count = 0U;
+    for (word = 0U; word < TRUTH_COLUMN_WORDS; word++) {
+        count += (uint32_t)__builtin_popcountll(left->words[word] & right->words[word]);
+    }
+    return count;
+}
+
+static void row_set_remove(LogicRowSet *set, const LogicRowSet *rows) {
+    uint32_t word;
+
+    for (word = 0U; word < TRUTH_COLUMN_WORDS; word++) {
+        set->words[word] &= ~rows->words[word];
+    }
+}
+
+static bool row_set_first(const LogicRowSet *set, uint32_t *row) {
+    uint32_t word;
+
+    for (word = 0U; word < TRUTH_COLUMN_WORDS; word++) {
+        if (set->words[word] != 0U) {
+            *row = (word * 64U) + (uint32_t)__builtin_ctzll(set->words[word]);
+            return true;
+        }
+    }
+    return false;
+}
+
+static uint32_t literal_count(uint16_t care) {
+    return (uint32_t)__builtin_popcount((unsigned int)care);
+}
+
+// Enumerates every implicant as a ternary cube index (digit i: 0, 1 or free
+// for row bit i). A cube with a free digit is an implicant exactly when both
+// of its halves are, and both halves have smaller indices, so one forward pass
+// replaces QM's pairwise merge rounds. Primes are the implicants that stop
+// being implicants when any fixed literal is dropped.
+static LogicPrime *collect_primes(const LogicRowSet *on, const LogicRowSet *allowed, uint8_t input_count, uint32_t *prime_count) {
+    LogicPrime *primes;
+    uint8_t *implicant;
+    uint32_t cube_total;
+    uint32_t capacity;
+    uint32_t index;
+    uint8_t bit;
+
+    cube_total = 1U;
+    for (bit = 0U; bit < input_count; bit++) {
+        cube_total *= 3U;
+    }
+
+    implicant = (uint8_t *)mem_calloc(MEM_TAG_ANALYSIS, cube_total, sizeof(*implicant));
+    if (!implicant) {
+        return NULL;
+    }
+
+    for (index = 0U; index < cube_total; index++) {
+        uint32_t remainder;
+        uint32_t weight;
+        uint32_t free_weight;
+        uint32_t row;
+
+        remainder = index;
+        weight = 1U;
+        free_weight = 0U;
+        row = 0U;
+        for (bit = 0U; bit < input_count; bit++) {
+            uint32_t digit;
+
+            digit = remainder % 3U;
+            remainder /= 3U;
+            if (digit == 2U) {
+                if (free_weight == 0U) {
+                    free_weight = weight;
+                }
+            } else if (digit == 1U) {
+                row |= 1U << bit;
+            }
+            weight *= 3U;
+        }
+
+        if (free_weight != 0U) {
+            implicant[index] = (uint8_t)(implicant[index - (2U * free_weight)] && implicant[index - free_weight]);
+        } else {
+            implicant[index] = row_set_test(allowed, row) ? 1U : 0U;
+        }
+    }
+
+    primes = NULL;
+    capacity = 0U;
+    *prime_count = 0U;
+    for (index = 0U; index < cube_total; index++) {
+        LogicPrime prime;
+        uint32_t remainder;
+        uint32_t weight;
+        uint32_t free_rows;
+        uint32_t subset;
+        bool is_prime;
+
+        if (!implicant[index]) {
+            continue;
+        }
+
+        memset(&prime, 0, sizeof(prime));
+        remainder = index;
+        weight = 1U;
+        is_prime = true;
+        for (bit = 0U; bit < input_count; bit++) {
+            uint32_t digit;
+
+            digit = remainder % 3U;
+            remainder /= 3U;
+            if (digit != 2U) {
+                prime.cube.care = (uint16_t)(prime.cube.care | (1U << bit));
+                if (digit == 1U) {
+                    prime.cube.value = (uint16_t)(prime.cube.value | (1U << bit));
+                }
+                if (implicant[index + ((2U - digit) * weight)]) {
+                    is_prime = false;
+                }
+            }
+            weight *= 3U;
+        }
+        if (!is_prime) {
+            continue;
+        }
+
+        free_rows = ((1U << input_count) - 1U) & ~(uint32_t)prime.cube.care;
+        subset = free_rows;
+        for (;;) {
+            uint32_t row;
+
+            row = (uint32_t)prime.cube.value | subset;
+            if (row_set_test(on, row)) {
+                row_set_add(&prime.rows, row);
+            }
+            if (subset == 0U) {
+                break;
+            }
+            subset = (subset - 1U) & free_rows;
+        }
+        if (row_set_count(&prime.rows) == 0U) {
+            continue; // only covers don't-care rows
+        }
+        prime.literal_count = literal_count(prime.cube.care);
+
+        if (*prime_count == capacity) {
+            LogicPrime *grown;
+
+            capacity = capacity == 0U ? 64U : capacity * 2U;
+            grown = (LogicPrime *)mem_realloc(MEM_TAG_ANALYSIS, primes, capacity * sizeof(*primes));
+            if (!grown) {
+                mem_free(primes);
+                mem_free(implicant);
+                return NULL;
+            }
+            primes = grown;
+        }
+        primes[*prime_count] = prime;
+        (*prime_count)++;
+    }
+
+    mem_free(implicant);
+    if (!primes) {
+        primes = (LogicPrime *)mem_alloc(MEM_TAG_ANALYSIS, sizeof(*primes));
+    }
+    return primes;
+}
+
+// Exact cover of the rows left after the essential primes. Branches on the
+// lowest uncovered row; bounds on cube count, then literal count.
+static void search_cover(LogicMinimizeSearch *search, const LogicRowSet *remaining, uint32_t depth, uint32_t literals) {
+    uint32_t uncovered;
+    uint32_t lower_bound;
+    uint32_t branch_row;
+    uint32_t index;
+
+    if (search->budget == 0U) {
+        search->exhausted = true;
+        return;
+    }
+    search->budget--;
+
+    if (!row_set_first(remaining, &branch_row)) {
+        if (depth < search->best_count || (depth == search->best_count && literals < search->best_literals)) {
+            memcpy(search->best, search->chosen, depth * sizeof(search->chosen[0]));
+            search->best_count = depth;
+            search->best_literals = literals;
+        }
+        return;
+    }
+
+    uncovered = row_set_count(remaining);
+    lower_bound = depth + ((uncovered + search->max_rows_per_prime - 1U) / search->max_rows_per_prime);
+    if (lower_bound > search->best_count || (lower_bound == search->best_count && literals >= search->best_literals)) {
+        return;
+    }
+
+    for (index = 0U; index < search->candidate_count && !search->exhausted; index++) {
+        const LogicPrime *prime;
+        LogicRowSet next;
+
+        prime = &search->primes[search->candidates[index]];
+        if (!row_set_test(&prime->rows, branch_row)) {
+            continue;
+        }
+
+        next = *remaining;
+        row_set_remove(&next, &prime->rows);
+        search->chosen[depth] = search->candidates[index];
+        search_cover(search, &next, depth + 1U, literals + prime->literal_count);
+    }
+}
+
+static uint32_t greedy_cover(const LogicPrime *primes, const uint32_t *candidates, uint32_t candidate_count, LogicRowSet remaining, uint32_t *chosen, uint32_t *literals) {
+    uint32_t count;
+
+    count = 0U;
+    *literals = 0U;
+    while (row_set_count(&remaining) > 0U && count < LOGIC_COVER_MAX_CUBES) {
+        uint32_t best_index;
+        uint32_t best_gain;
+        uint32_t index;
+
+        best_index = 0U;
+        best_gain = 0U;
+        for (index = 0U; index < candidate_count; index++) {
+            uint32_t gain;
+
+            gain = row_set_count_common(&primes[candidates[index]].rows, &remaining);
+            if (gain > best_gain ||
+                (gain == best_gain && gain > 0U && primes[candidates[index]].literal_count < primes[candidates[best_index]].literal_count)) {
+                best_gain = gain;
+                best_index = index;
+            }
+        }
+        if (best_gain == 0U) {
+            break;
+        }
+
+        chosen[count] = candidates[best_index];
+        *literals += primes[candidates[best_index]].literal_count;
+        count++;
+        row_set_remove(&remaining, &primes[candidates[best_index]].rows);
+    }
+    return count;
+}
+
+// Orders terms the way they read best: per input from the first, complemented
+// literal, then plain literal, then absent.
+static int compare_cubes(const void *left, const void *right) {
+    const LogicCube *a;
+    const LogicCube *b;
+    int bit;
+
+    a = (const LogicCube *)left;
+    b = (const LogicCube *)right;
+    for (bit = 15; bit >= 0; bit--) {
+        int rank_a;
+        int rank_b;
+
+        rank_a = ((a->care >> bit) & 1U) == 0U ? 2 : (int)((a->value >> bit) & 1U);
+        rank_b = ((b->care >> bit) & 1U) == 0U ? 2 : (int)((b->value >> bit) & 1U);
+        if (rank_a != rank_b) {
+            return rank_a - rank_b;
+        }
+    }
+    return 0;
+}
+
+bool logic_minimize_column(const TruthColumn *column, uint8_t input_count, LogicCover *cover) {
+    LogicMinimizeSearch *search;
+    LogicPrime *primes;
+    LogicRowSet on;
+    LogicRowSet allowed;
+    LogicRowSet remaining;
+    uint32_t *candidates;
+    uint32_t essential[LOGIC_COVER_MAX_CUBES];
+    uint32_t essential_count;
+    uint32_t prime_count;
+    uint32_t candidate_count;
+    uint32_t row_count;
+    uint32_t word;
+    uint32_t index;
+    uint32_t row;
+
+    if (!column || !cover || input_count > MAX_PINS) {
+        return false;
+    }
+
+    memset(cover, 0, sizeof(*cover));
+    cover->exact = true;
+    row_count = 1U << input_count;
+    for (word = 0U; word < TRUTH_COLUMN_WORDS; word++) {
+        uint64_t valid;
+
+        if ((word + 1U) * 64U <= row_count) {
+            valid = ~0ULL;
+        } else if (word * 64U < row_count) {
+            valid = (1ULL << (row_count - (word * 64U))) - 1ULL;
+        } else {
+            valid = 0U;
+        }
+        // LOW is 00, HIGH is 01; UNKNOWN and ERROR rows are don't-cares.
+        on.words[word] = column->planes[0][word] & ~column->planes[1][word] & valid;
+        allowed.words[word] = (column->planes[0][word] | column->planes[1][word]) & valid;
+    }
+    if (row_set_count(&on) == 0U) {
+        return true;
+    }
+
+    primes = collect_primes(&on, &allowed, input_count, &prime_count);
+    if (!primes) {
+        return false;
+    }
+
+    // Essential primes: the only prime covering some ON row.
+    remaining = on;
+    essential_count = 0U;
+    for (row = 0U; row < row_count; row++) {
+        uint32_t cover_count;
+        uint32_t last;
+
+        if (!row_set_test(&remaining, row)) {
+            continue;
+        }
+        cover_count = 0U;
+        last = 0U;
+        for (index = 0U; index < prime_count && cover_count < 2U; index++) {
+            if (row_set_test(&primes[index].rows, row)) {
+                cover_count++;
+                last = index;
+            }
+        }
+        if (cover_count == 1U) {
+            essential[essential_count] = last;
+            essential_count++;
+            row_set_remove(&remaining, &primes[last].rows);
+        }
+    }
+
+    search = NULL;
+    candidates = (uint32_t *)mem_alloc(MEM_TAG_ANALYSIS, (prime_count + 1U) * sizeof(*candidates));
+    if (candidates) {
+        search = (LogicMinimizeSearch *)mem_calloc(MEM_TAG_ANALYSIS, 1U, sizeof(*search));
+    }
+    if (!search) {
+        mem_free(candidates);
+        mem_free(primes);
+        return false;
+    }
+
+    candidate_count = 0U;
+    for (index = 0U; index < prime_count; index++) {
+        uint32_t gain;
+        uint32_t slot;
+
+        gain = row_set_count_common(&primes[index].rows, &remaining);
+        if (gain == 0U) {
+            continue;
+        }
+        if (gain > search->max_rows_per_prime) {
+            search->max_rows_per_prime = gain;
+        }
+        // Insertion sort by coverage so the search tries big primes first.
+        slot = candidate_count;
+        while (slot > 0U && row_set_count_common(&primes[candidates[slot - 1U]].rows, &remaining) < gain) {
+            candidates[slot] = candidates[slot - 1U];
+            slot--;
+        }
+        candidates[slot] = index;
+        candidate_count++;
+    }
+
+    search->primes = primes;
+    search->candidates = candidates;
+    search->candidate_count = candidate_count;
+    search->budget = LOGIC_MINIMIZE_SEARCH_BUDGET;
+    search->best_count = greedy_cover(primes, candidates, candidate_count, remaining, search->best, &search->best_literals);
+    if (candidate_count > 0U) {
+        search_cover(search, &remaining, 0U, 0U);
+    }
+    cover->exact = !search->exhausted;
+
+    for (index = 0U; index < essential_count && cover->cube_count < LOGIC_COVER_MAX_CUBES; index++) {
+        cover->cubes[cover->cube_count] = primes[essential[index]].cube;
+        cover->cube_count++;
+    }
+    for (index = 0U; index < search->best_count && cover->cube_count < LOGIC_COVER_MAX_CUBES; index++) {
+        cover->cubes[cover->cube_count] = primes[search->best[index]].cube;
+        cover->cube_count++;
+    }
+    qsort(cover->cubes, cover->cube_count, sizeof(cover->cubes[0]), compare_cubes);
+
+    mem_free(search);
+    mem_free(candidates);
+    mem_free(primes);
+    return true;
+}
+
+static void format_append(char *buffer, size_t buffer_size, size_t *length, const char *text) {
+    size_t text_length;
+
+    text_length = strlen(text);
+    if (buffer && *length < buffer_size) {
+        size_t room;
+
+        room = buffer_size - *length - 1U;
+        memcpy(buffer + *length, text, text_length < room ? text_length : room);
+        buffer[*length + (text_length < room ? text_length : room)] = '\0';
+    }
+    *length += text_length;
+}
+
+// snprintf-style: returns the full length, writes what fits. Single-letter
+// input names are concatenated (AB'), longer ones are space-separated.
+size_t logic_cover_format(const LogicCover *cover, LogicNode *const *inputs, uint8_t input_count, char *buffer, size_t buffer_size) {
+    const char *separator;
+    size_t length;
+    uint32_t cube_index;
+    uint8_t input_index;
+
+    length = 0U;
+    if (buffer && buffer_size > 0U) {
+        buffer[0] = '\0';
+    }
+    if (!cover) {
+        return 0U;
+    }
+    if (cover->cube_count == 0U) {
+        format_append(buffer, buffer_size, &length, "0");
+        return length;
+    }
+
+    separator = "";
+    for (input_index = 0U; input_index < input_count; input_index++) {
+        if (!inputs[input_index] || !inputs[input_index]->name || strlen(inputs[input_index]->name) != 1U) {
+            separator = " ";
+        }
+    }
+
+    for (cube_index = 0U; cube_index < cover->cube_count; cube_index++) {
+        const LogicCube *cube;
+        bool first_literal;
+
+        cube = &cover->cubes[cube_index];
+        if (cube_index > 0U) {
+            format_append(buffer, buffer_size, &length, " OR ");
+        }
+        if (cube->care == 0U) {
+            format_append(buffer, buffer_size, &length, "1");
+            continue;
+        }
+
+        first_literal = true;
+        for (input_index = 0U; input_index < input_count; input_index++) {
+            uint32_t bit;
+
+            bit = (uint32_t)input_count - 1U - (uint32_t)input_index;
+            if (((cube->care >> bit) & 1U) == 0U) {
+                continue;
+            }
+            if (!first_literal) {
+                format_append(buffer, buffer_size, &length, separator);
+            }
+            format_append(buffer, buffer_size, &length, inputs[input_index] && inputs[input_index]->name ? inputs[input_index]->name : "?");
+            if (((cube->value >> bit) & 1U) == 0U) {
+                format_append(buffer, buffer_size, &length, "'");
+            }
+            first_literal = false;
+        }
+    }
+
+    return length;
+}
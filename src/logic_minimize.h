@@ -0,0 +1,25 @@
+#ifndef LOGIC_MINIMIZE_H
+#define LOGIC_MINIMIZE_H
+
+#include "logic.h"
+
+// One cube per row is always enough, even for a greedy cover.
+#define LOGIC_COVER_MAX_CUBES TRUTH_TABLE_MAX_ROWS
+
+// Product term over truth-table row bits: input i of n is bit (n - 1 - i).
+typedef struct {
+    uint16_t value; // polarity of each literal in `care`
+    uint16_t care; // bits that appear as literals; the rest are free
+} LogicCube;
+
+typedef struct {
+    LogicCube cubes[LOGIC_COVER_MAX_CUBES];
+    uint32_t cube_count; // 0 means the constant 0
+    bool exact; // false when the covering search ran out of budget and kept the greedy cover
+    uint8_t _padding[3];
+} LogicCover;
+
+bool logic_minimize_column(const TruthColumn *column, uint8_t input_count, LogicCover *cover);
+size_t logic_cover_format(const LogicCover *cover, LogicNode *const *inputs, uint8_t input_count, char *buffer, size_t buffer_size);
+
+#endif // LOGIC_MINIMIZE_H
@@ -0,0 +1,255 @@
+#include "logic_netlist.h"
+#include <string.h>
+
+#define LOGIC_NETLIST_NO_NODE UINT16_MAX
+#define LOGIC_NETLIST_NO_SIGNAL UINT16_MAX
+
+typedef enum {
+    NETLIST_NODE_UNSEEN = 0,
+    NETLIST_NODE_ACTIVE = 1,
+    NETLIST_NODE_DONE = 2
+} NetlistNodeState;
+
+static bool logic_netlist_is_gate(NodeType type) {
+    switch (type) {
+        case NODE_GATE_AND:
+        case NODE_GATE_OR:
+        case NODE_GATE_NOT:
+        case NODE_GATE_XOR:
+        case NODE_GATE_NAND:
+        case NODE_GATE_NOR:
+            return true;
+        case NODE_INPUT:
+        case NODE_OUTPUT:
+        case NODE_GATE_DFF:
+        case NODE_GATE_LATCH:
+        case NODE_GATE_CLOCK:
+        default:
+            return false;
+    }
+}
+
+// Gates with an unconnected input (and everything they feed) get no signal;
+// compilation only fails if such a gate reaches an output.
+bool logic_netlist_compile(LogicGraph *graph, LogicNetlist *netlist) {
+    uint16_t drivers[MAX_NODES][2];
+    uint16_t node_signals[MAX_NODES];
+    uint16_t stack[MAX_NODES];
+    uint8_t next_pin[MAX_NODES];
+    uint8_t state[MAX_NODES];
+    uint32_t index;
+
+    if (!graph || !netlist) {
+        return false;
+    }
+
+    memset(netlist, 0, sizeof(*netlist));
+    memset(drivers, 0xFF, sizeof(drivers));
+    memset(node_signals, 0xFF, sizeof(node_signals));
+    memset(next_pin, 0, sizeof(next_pin));
+    memset(state, 0, sizeof(state));
+
+    for (index = 0U; index < graph->net_count; index++) {
+        const LogicNet *net;
+        uint8_t sink;
+
+        net = &graph->nets[index];
+        if (!net->source || !net->source->node) {
+            continue;
+        }
+        for (sink = 0U; sink < net->sink_count; sink++) {
+            uint32_t sink_node;
+
+            sink_node = (uint32_t)(net->sinks[sink]->node - graph->nodes);
+            if (net->sinks[sink]->index < 2U) {
+                drivers[sink_node][net->sinks[sink]->index] = (uint16_t)(net->source->node - graph->nodes);
+            }
+        }
+    }
+
+    // Inputs take the first signals, in the order the truth table lists them.
+    for (index = 0U; index < graph->node_count; index++) {
+        LogicNode *node;
+
+        node = &graph->nodes[index];
+        if (node->type == (NodeType)-1) {
+            continue;
+        }
+        if (node->type == NODE_GATE_DFF || node->type == NODE_GATE_LATCH || node->type == NODE_GATE_CLOCK) {
+            return false;
+        }
+        if (logic_netlist_is_gate(node->type) && node->input_count > 2U) {
+            return false;
+        }
+        if (node->type == NODE_INPUT) {
+            if (netlist->input_count >= MAX_PINS) {
+                return false;
+            }
+            node_signals[index] = (uint16_t)netlist->signal_count;
+            netlist->signal_nodes[netlist->signal_count] = node;
+            netlist->signal_gates[netlist->signal_count] = LOGIC_NETLIST_NO_GATE;
+            netlist->signal_count++;
+            netlist->input_count++;
+            state[index] = NETLIST_NODE_DONE;
+        }
+    }
+
+    // Iterative post-order DFS over drivers; a driver still on the stack is a cycle.
+    for (index = 0U; index < graph->node_count; index++) {
+        uint32_t depth;
+
+        if (state[index] != NETLIST_NODE_UNSEEN || !logic_netlist_is_gate(graph->nodes[index].type)) {
+            continue;
+        }
+
+        depth = 0U;
+        stack[depth++] = (uint16_t)index;
+        state[index] = NETLIST_NODE_ACTIVE;
+        while (depth > 0U) {
+            LogicNode *node;
+            uint16_t current;
+
+            current = stack[depth - 1U];
+            node = &graph->nodes[current];
+            if (next_pin[current] < node->input_count) {
+                uint16_t driver;
+
+                driver = drivers[current][next_pin[current]];
+                next_pin[current]++;
+                if (driver == LOGIC_NETLIST_NO_NODE) {
+                    continue;
+                }
+                if (state[driver] == NETLIST_NODE_ACTIVE) {
+                    return false;
+                }
+                if (state[driver] == NETLIST_NODE_UNSEEN && logic_netlist_is_gate(graph->nodes[driver].type)) {
+                    state[driver] = NETLIST_NODE_ACTIVE;
+                    stack[depth++] = driver;
+                }
+                continue;
+            }
+
+            depth--;
+            state[current] = NETLIST_NODE_DONE;
+            {
+                LogicNetlistGate *gate;
+                uint8_t pin;
+                bool resolved;
+
+                resolved = true;
+                for (pin = 0U; pin < node->input_count; pin++) {
+                    if (drivers[current][pin] == LOGIC_NETLIST_NO_NODE || node_signals[drivers[current][pin]] == LOGIC_NETLIST_NO_SIGNAL) {
+                        resolved = false;
+                    }
+                }
+                if (!resolved) {
+                    continue;
+                }
+
+                gate = &netlist->gates[netlist->gate_count];
+                gate->type = (uint8_t)node->type;
+                gate->input_count = node->input_count;
+                for (pin = 0U; pin < node->input_count; pin++) {
+                    gate->inputs[pin] = node_signals[drivers[current][pin]];
+                }
+                gate->output = (uint16_t)netlist->signal_count;
+                node_signals[current] = gate->output;
+                netlist->signal_nodes[netlist->signal_count] = node;
+                netlist->signal_gates[netlist->signal_count] = (uint16_t)netlist->gate_count;
+                netlist->signal_count++;
+                netlist->gate_count++;
+            }
+        }
+    }
+
+    for (index = 0U; index < graph->node_count; index++) {
+        uint16_t driver;
+
+        if (graph->nodes[index].type != NODE_OUTPUT || netlist->output_count >= MAX_PINS) {
+            continue;
+        }
+        driver = drivers[index][0];
+        if (driver == LOGIC_NETLIST_NO_NODE || node_signals[driver] == LOGIC_NETLIST_NO_SIGNAL) {
+            return false;
+        }
+        netlist->output_signals[netlist->output_count] = node_signals[driver];
+        netlist->output_count++;
+    }
+
+    return true;
+}
+
+// Packs up to 64 truth-table row indices into the input signal words.
+void logic_netlist_load_rows(const LogicNetlist *netlist, const uint32_t *rows, uint32_t row_count, uint64_t *signals) {
+    uint32_t pattern;
+    uint8_t input;
+
+    for (input = 0U; input < netlist->input_count; input++) {
+        uint32_t bit;
+        uint64_t word;
+
+        bit = (uint32_t)netlist->input_count - 1U - (uint32_t)input;
+        word = 0U;
+        for (pattern = 0U; pattern < row_count && pattern < 64U; pattern++) {
+            if (((rows[pattern] >> bit) & 1U) != 0U) {
+                word |= 1ULL << pattern;
+            }
+        }
+        signals[input] = word;
+    }
+}
+
+// Without a fault this evaluates every gate. With one, `signals` must already
+// hold the fault-free values for the same patterns: only the gates after the
+// fault site are re-evaluated.
+void logic_netlist_eval(const LogicNetlist *netlist, uint64_t *signals, const LogicFault *fault) {
+    uint32_t gate_index;
+
+    gate_index = 0U;
+    if (fault) {
+        signals[fault->signal] = fault->stuck_value ? ~0ULL : 0ULL;
+        if (netlist->signal_gates[fault->signal] != LOGIC_NETLIST_NO_GATE) {
+            gate_index = (uint32_t)netlist->signal_gates[fault->signal] + 1U;
+        }
+    }
+
+    for (; gate_index < netlist->gate_count; gate_index++) {
+        const LogicNetlistGate *gate;
+        uint64_t a;
+        uint64_t b;
+        uint64_t value;
+
+        gate = &netlist->gates[gate_index];
+        a = signals[gate->inputs[0]];
+        b = gate->input_count > 1U ? signals[gate->inputs[1]] : 0U;
+        switch ((NodeType)gate->type) {
+            case NODE_GATE_AND:
+                value = a & b;
+                break;
+            case NODE_GATE_OR:
+                value = a | b;
+                break;
+            case NODE_GATE_NOT:
+                value = ~a;
+                break;
+            case NODE_GATE_XOR:
+                value = a ^ b;
+                break;
+            case NODE_GATE_NAND:
+                value = ~(a & b);
+                break;
+            case NODE_GATE_NOR:
+                value = ~(a | b);
+                break;
+            case NODE_INPUT:
+            case NODE_OUTPUT:
+            case NODE_GATE_DFF:
+            case NODE_GATE_LATCH:
+            case NODE_GATE_CLOCK:
+            default:
+                value = 0U;
+                break;
+        }
+        signals[gate->output] = value;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef LOGIC_NETLIST_H
+#define LOGIC_NETLIST_H
+
+#include "logic.h"
+
+#define LOGIC_NETLIST_NO_GATE UINT16_MAX
+
+typedef struct {
+    uint16_t inputs[2]; // signal indices; only the first input_count are used
+    uint16_t output; // signal driven by this gate
+    uint8_t type; // NodeType
+    uint8_t input_count;
+} LogicNetlistGate;
+
+typedef struct {
+    uint16_t signal;
+    uint8_t stuck_value; // 0 or 1
+    uint8_t _padding;
+} LogicFault;
+
+// Fully connected combinational graph flattened into topologically ordered
+// gates over dense signal indices. Primary inputs are signals 0..input_count-1
+// in truth-table column order. Signal values are bit-sliced: each uint64_t
+// holds one signal across 64 input patterns.
+typedef struct {
+    LogicNetlistGate gates[MAX_NODES];
+    LogicNode *signal_nodes[MAX_NODES]; // node that drives each signal
+    uint16_t signal_gates[MAX_NODES]; // gate driving each signal, LOGIC_NETLIST_NO_GATE for inputs
+    uint16_t output_signals[MAX_PINS]; // signal observed by each output node
+    uint32_t gate_count;
+    uint32_t signal_count;
+    uint8_t input_count;
+    uint8_t output_count;
+    uint8_t _padding[6];
+} LogicNetlist;
+
+bool logic_netlist_compile(LogicGraph *graph, LogicNetlist *netlist);
+void logic_netlist_load_rows(const LogicNetlist *netlist, const uint32_t *rows, uint32_t row_count, uint64_t *signals);
+void logic_netlist_eval(const LogicNetlist *netlist, uint64_t *signals, const LogicFault *fault);
+
+#endif // LOGIC_NETLIST_H
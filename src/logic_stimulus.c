@@ -0,0 +1,874 @@
+#include "logic_stimulus.h"
+#include "logic_activity.h"
+#include "mem.h"
+#include "name_index.h"
+#include "text_util.h"
+#include "trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LOGIC_STIMULUS_INITIAL_OPS 64U
+#define LOGIC_STIMULUS_DELETED 0xFFU
+
+typedef struct {
+    LogicStimulus *stimulus;
+    NameIndex names;
+    uint64_t samples[LOGIC_STIMULUS_MAX_DEPTH + 1U]; // per open block
+    uint32_t open_ops[LOGIC_STIMULUS_MAX_DEPTH];
+    uint16_t clocks[LOGIC_STIMULUS_MAX_CLOCKS];
+    uint32_t depth;
+    uint32_t clock_count;
+} StimulusParser;
+
+static uint64_t stimulus_add(uint64_t a, uint64_t b) {
+    return a > UINT64_MAX - b ? UINT64_MAX : a + b;
+}
+
+static uint64_t stimulus_multiply(uint64_t a, uint64_t b) {
+    return (b != 0U && a > UINT64_MAX / b) ? UINT64_MAX : a * b;
+}
+
+static LogicStimulusOp *stimulus_push_op(LogicStimulus *stimulus, LogicStimulusOpKind kind) {
+    LogicStimulusOp *op;
+
+    if (stimulus->op_count == stimulus->op_capacity) {
+        LogicStimulusOp *grown;
+        uint32_t capacity;
+
+        capacity = stimulus->op_capacity == 0U ? LOGIC_STIMULUS_INITIAL_OPS : stimulus->op_capacity * 2U;
+        grown = (LogicStimulusOp *)mem_realloc(MEM_TAG_SIMULATION, stimulus->ops, capacity * sizeof(*grown));
+        if (!grown) {
+            return NULL;
+        }
+        stimulus->ops = grown;
+        stimulus->op_capacity = capacity;
+    }
+
+    op = &stimulus->ops[stimulus->op_count++];
+    memset(op, 0, sizeof(*op));
+    op->kind = (uint8_t)kind;
+    op->node = LOGIC_STIMULUS_NO_NODE;
+    return op;
+}
+
+static const char *stimulus_skip_space(const char *cursor, const char *end) {
+    while (cursor < end && (*cursor == ' ' || *cursor == '\t' || *cursor == '\r')) {
+        cursor++;
+    }
+    return cursor;
+}
+
+static const char *stimulus_token_end(const char *cursor, const char *end) {
+    while (cursor < end && *cursor != ' ' && *cursor != '\t' && *cursor != '\r' && *cursor != '#') {
+        cursor++;
+    }
+    return cursor;
+}
+
+static bool stimulus_token_is(const char *cursor, const char *token_end, const char *word) {
+    size_t length;
+
+    length = strlen(word);
+    return (size_t)(token_end - cursor) == length && strncmp(cursor, word, length) == 0;
+}
+
+static bool stimulus_at_line_end(const char *cursor, const char *end) {
+    cursor = stimulus_skip_space(cursor, end);
+    return cursor >= end || *cursor == '#';
+}
+
+static bool stimulus_parse_count(const char *text, size_t length, uint32_t *count) {
+    uint64_t value;
+    size_t index;
+
+    if (length == 0U || length > 9U) {
+        return false;
+    }
+    value = 0U;
+    for (index = 0U; index < length; index++) {
+        if (text[index] < '0' || text[index] > '9') {
+            return false;
+        }
+        value = (value * 10U) + (uint64_t)(text[index] - '0');
+    }
+    *count = (uint32_t)value;
+    return true;
+}
+
+// Reads an optional count after a keyword; `*cursor` moves past it.
+static bool stimulus_parse_optional_count(const char **cursor, const char *end, uint32_t *count) {
+    const char *token_end;
+
+    *cursor = stimulus_skip_space(*cursor, end);
+    token_end = stimulus_token_end(*cursor, end);
+    if (token_end > *cursor && !stimulus_parse_count(*cursor, (size_t)(token_end - *cursor), count)) {
+        return false;
+    }
+    *cursor = token_end;
+    return true;
+}
+
+static void stimulus_add_samples(StimulusParser *parser, uint64_t samples) {
+    parser->samples[parser->depth] = stimulus_add(parser->samples[parser->depth], samples);
+}
+
+static bool stimulus_parse_repeat(
+    StimulusParser *parser,
+    const char *cursor,
+    const char *end,
+    unsigned int line,
+    char *error_message,
+    size_t error_message_size
+) {
+    const char *token_end;
+    LogicStimulusOp *op;
+    uint32_t count;
+
+    cursor = stimulus_skip_space(cursor, end);
+    token_end = stimulus_token_end(cursor, end);
+    if (!stimulus_parse_count(cursor, (size_t)(token_end - cursor), &count)) {
+        set_error(error_message, error_message_size, "repeat count must be a number", line);
+        return false;
+    }
+    cursor = stimulus_skip_space(token_end, end);
+    if (cursor >= end || *cursor != '{' || !stimulus_at_line_end(cursor + 1, end)) {
+        set_error(error_message, error_message_size, "expected { to end the repeat line", line);
+        return false;
+    }
+    if (parser->depth == LOGIC_STIMULUS_MAX_DEPTH) {
+        set_error(error_message, error_message_size, "repeat blocks nest too deep", line);
+        return false;
+    }
+
+    op = stimulus_push_op(parser->stimulus, LOGIC_STIMULUS_REPEAT);
+    if (!op) {
+        set_error(error_message, error_message_size, "out of memory", line);
+        return false;
+    }
+    op->count = count;
+    parser->open_ops[parser->depth++] = parser->stimulus->op_count - 1U;
+    parser->samples[parser->depth] = 0U;
+    return true;
+}
+
+static bool stimulus_parse_close(StimulusParser *parser, const char *cursor, const char *end, unsigned int line, char *error_message, size_t error_message_size) {
+    LogicStimulusOp *op;
+    uint32_t repeat;
+    uint64_t body;
+
+    if (!stimulus_at_line_end(cursor, end)) {
+        set_error(error_message, error_message_size, "} must be alone on its line", line);
+        return false;
+    }
+    if (parser->depth == 0U) {
+        set_error(error_message, error_message_size, "} without a matching repeat", line);
+        return false;
+    }
+
+    repeat = parser->open_ops[--parser->depth];
+    op = stimulus_push_op(parser->stimulus, LOGIC_STIMULUS_END);
+    if (!op) {
+        set_error(error_message, error_message_size, "out of memory", line);
+        return false;
+    }
+    op->target = repeat;
+    parser->stimulus->ops[repeat].target = parser->stimulus->op_count - 1U;
+
+    // A body that never samples only sets inputs and clocks, so running it
+    // once is the same as running it N times.
+    body = parser->samples[parser->depth + 1U];
+    if (body == 0U && parser->stimulus->ops[repeat].count > 1U) {
+        parser->stimulus->ops[repeat].count = 1U;
+    }
+    stimulus_add_samples(parser, stimulus_multiply(body, parser->stimulus->ops[repeat].count));
+    return true;
+}
+
+static bool stimulus_parse_clock(
+    StimulusParser *parser,
+    const char *cursor,
+    const char *end,
+    unsigned int line,
+    char *error_message,
+    size_t error_message_size
+) {
+    const char *token_end;
+    LogicStimulusOp *op;
+    uint32_t period;
+    uint32_t index;
+    uint16_t node;
+
+    cursor = stimulus_skip_space(cursor, end);
+    token_end = stimulus_token_end(cursor, end);
+    if (token_end == cursor) {
+        set_error(error_message, error_message_size, "clock needs an input name", line);
+        return false;
+    }
+    if (!name_index_find(&parser->names, cursor, (size_t)(token_end - cursor), &node)) {
+        set_error(error_message, error_message_size, "unknown input", line);
+        return false;
+    }
+    for (index = 0U; index < parser->clock_count && parser->clocks[index] != node; index++) {
+    }
+    if (index == parser->clock_count) {
+        if (parser->clock_count == LOGIC_STIMULUS_MAX_CLOCKS) {
+            set_error(error_message, error_message_size, "too many clocked inputs", line);
+            return false;
+        }
+        parser->clocks[parser->clock_count++] = node;
+    }
+    period = 1U;
+    cursor = token_end;
+    if (!stimulus_parse_optional_count(&cursor, end, &period) || !stimulus_at_line_end(cursor, end)) {
+        set_error(error_message, error_message_size, "clock period must be a number", line);
+        return false;
+    }
+
+    op = stimulus_push_op(parser->stimulus, LOGIC_STIMULUS_CLOCK);
+    if (!op) {
+        set_error(error_message, error_message_size, "out of memory", line);
+        return false;
+    }
+    op->node = node;
+    op->count = period;
+    return true;
+}
+
+// Input assignments, then an optional `tick [N]`.
+static bool stimulus_parse_vector(
+    StimulusParser *parser,
+    const char *cursor,
+    const char *end,
+    unsigned int line,
+    char *error_message,
+    size_t error_message_size
+) {
+    LogicStimulusOp *op;
+    bool assigned;
+
+    assigned = false;
+    for (;;) {
+        const char *token_end;
+        const char *equals;
+        uint16_t node;
+
+        cursor = stimulus_skip_space(cursor, end);
+        if (cursor >= end || *cursor == '#') {
+            break;
+        }
+        token_end = stimulus_token_end(cursor, end);
+
+        if (stimulus_token_is(cursor, token_end, "tick")) {
+            uint32_t ticks;
+
+            ticks = 1U;
+            cursor = token_end;
+            if (!stimulus_parse_optional_count(&cursor, end, &ticks)) {
+                set_error(error_message, error_message_size, "tick count must be a number", line);
+                return false;
+            }
+            if (!stimulus_at_line_end(cursor, end)) {
+                set_error(error_message, error_message_size, "tick must end the line", line);
+                return false;
+            }
+            op = stimulus_push_op(parser->stimulus, LOGIC_STIMULUS_TICK);
+            if (!op) {
+                set_error(error_message, error_message_size, "out of memory", line);
+                return false;
+            }
+            op->count = ticks;
+            stimulus_add_samples(parser, ticks);
+            return true;
+        }
+
+        equals = (const char *)memchr(cursor, '=', (size_t)(token_end - cursor));
+        if (!equals || token_end - equals != 2 || (equals[1] != '0' && equals[1] != '1')) {
+            set_error(error_message, error_message_size, "expected NAME=0, NAME=1 or tick", line);
+            return false;
+        }
+        if (!name_index_find(&parser->names, cursor, (size_t)(equals - cursor), &node)) {
+            set_error(error_message, error_message_size, "unknown input", line);
+            return false;
+        }
+        op = stimulus_push_op(parser->stimulus, LOGIC_STIMULUS_SET);
+        if (!op) {
+            set_error(error_message, error_message_size, "out of memory", line);
+            return false;
+        }
+        op->node = node;
+        op->value = (uint8_t)(equals[1] == '1' ? LOGIC_HIGH : LOGIC_LOW);
+        assigned = true;
+        cursor = token_end;
+    }
+
+    if (assigned) {
+        if (!stimulus_push_op(parser->stimulus, LOGIC_STIMULUS_EVAL)) {
+            set_error(error_message, error_message_size, "out of memory", line);
+            return false;
+        }
+        stimulus_add_samples(parser, 1U);
+    }
+    return true;
+}
+
+static bool stimulus_parse_line(
+    StimulusParser *parser,
+    const char *cursor,
+    const char *end,
+    unsigned int line,
+    char *error_message,
+    size_t error_message_size
+) {
+    const char *token_end;
+
+    cursor = stimulus_skip_space(cursor, end);
+    token_end = stimulus_token_end(cursor, end);
+    if (stimulus_token_is(cursor, token_end, "repeat")) {
+        return stimulus_parse_repeat(parser, token_end, end, line, error_message, error_message_size);
+    }
+    if (token_end - cursor == 1 && *cursor == '}') {
+        return stimulus_parse_close(parser, token_end, end, line, error_message, error_message_size);
+    }
+    if (stimulus_token_is(cursor, token_end, "clock")) {
+        return stimulus_parse_clock(parser, token_end, end, line, error_message, error_message_size);
+    }
+    return stimulus_parse_vector(parser, cursor, end, line, error_message, error_message_size);
+}
+
+bool logic_stimulus_parse(
+    LogicStimulus *stimulus,
+    const LogicGraph *graph,
+    const char *data,
+    size_t size,
+    char *error_message,
+    size_t error_message_size
+) {
+    NameIndexSlot slots[2U * MAX_NODES];
+    StimulusParser parser;
+    const char *cursor;
+    const char *end;
+    unsigned int line;
+    uint32_t index;
+
+    memset(stimulus, 0, sizeof(*stimulus));
+    memset(&parser, 0, sizeof(parser));
+    parser.stimulus = stimulus;
+    name_index_init(&parser.names, slots, name_index_capacity_for(MAX_NODES));
+    for (index = 0U; index < graph->node_count; index++) {
+        const LogicNode *node;
+
+        node = &graph->nodes[index];
+        if (node->type == NODE_INPUT && node->name) {
+            name_index_insert(&parser.names, node->name, strlen(node->name), (uint16_t)index);
+        }
+    }
+
+    cursor = data;
+    end = data + size;
+    line = 0U;
+    while (cursor < end) {
+        const char *newline;
+        const char *line_end;
+
+        line++;
+        newline = (const char *)memchr(cursor, '\n', (size_t)(end - cursor));
+        line_end = newline ? newline : end;
+        if (!stimulus_parse_line(&parser, cursor, line_end, line, error_message, error_message_size)) {
+            logic_stimulus_release(stimulus);
+            return false;
+        }
+        cursor = line_end + (newline ? 1 : 0);
+    }
+
+    if (parser.depth > 0U) {
+        set_error(error_message, error_message_size, "repeat block is missing its }", line);
+        logic_stimulus_release(stimulus);
+        return false;
+    }
+    stimulus->sample_count = parser.samples[0];
+    return true;
+}
+
+bool logic_stimulus_load(LogicStimulus *stimulus, const LogicGraph *graph, const char *path, char *error_message, size_t error_message_size) {
+    FILE *file;
+    char *data;
+    long length;
+    bool ok;
+
+    memset(stimulus, 0, sizeof(*stimulus));
+    file = fopen(path, "rb");
+    if (!file) {
+        set_error(error_message, error_message_size, "could not read stimulus file", 0U);
+        return false;
+    }
+    if (fseek(file, 0, SEEK_END) != 0 || (length = ftell(file)) < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        set_error(error_message, error_message_size, "could not read stimulus file", 0U);
+        return false;
+    }
+    data = (char *)mem_alloc(MEM_TAG_LOADER, (size_t)length + 1U);
+    if (!data || fread(data, 1U, (size_t)length, file) != (size_t)length) {
+        mem_free(data);
+        fclose(file);
+        set_error(error_message, error_message_size, "could not read stimulus file", 0U);
+        return false;
+    }
+    fclose(file);
+
+    ok = logic_stimulus_parse(stimulus, graph, data, (size_t)length, error_message, error_message_size);
+    mem_free(data);
+    return ok;
+}
+
+void logic_stimulus_release(LogicStimulus *stimulus) {
+    if (!stimulus) {
+        return;
+    }
+    mem_free(stimulus->ops);
+    memset(stimulus, 0, sizeof(*stimulus));
+}
+
+// Builds the dense arrays from the graph's structure: type, arity and the
+// driver of every input pin (the first net listing the pin as a sink, like
+// logic_evaluate's lookup), plus logic_evaluate's order.
+static void stimulus_compile(LogicStimulusRun *run) {
+    LogicNode *sorted[MAX_NODES];
+    LogicGraph *graph;
+    uint32_t count;
+    uint32_t index;
+    uint8_t slot;
+
+    graph = run->graph;
+    for (index = 0U; index < MAX_NODES; index++) {
+        for (slot = 0U; slot < MAX_PINS; slot++) {
+            run->drivers[index][slot] = LOGIC_STIMULUS_OPEN_PIN;
+        }
+    }
+    run->node_count = graph->node_count;
+    for (index = 0U; index < graph->node_count; index++) {
+        const LogicNode *node;
+
+        node = &graph->nodes[index];
+        run->types[index] = node->type == (NodeType)-1 ? (uint8_t)LOGIC_STIMULUS_DELETED : (uint8_t)node->type;
+        run->input_counts[index] = node->input_count;
+    }
+
+    for (index = 0U; index < graph->net_count; index++) {
+        const LogicNet *net;
+        uint8_t sink;
+
+        net = &graph->nets[index];
+        if (!net->source || !net->source->node) {
+            continue;
+        }
+        for (sink = 0U; sink < net->sink_count; sink++) {
+            const LogicPin *pin;
+            ptrdiff_t pin_index;
+            size_t node_index;
+
+            pin = net->sinks[sink];
+            if (!pin || !pin->node) {
+                continue;
+            }
+            node_index = (size_t)(pin->node - graph->nodes);
+            pin_index = pin - pin->node->inputs;
+            if (pin_index >= 0 && pin_index < MAX_PINS && run->drivers[node_index][pin_index] == LOGIC_STIMULUS_OPEN_PIN) {
+                run->drivers[node_index][pin_index] = (uint16_t)(net->source->node - graph->nodes);
+            }
+        }
+    }
+
+    count = logic_topological_sort(graph, sorted);
+    run->step_count = 0U;
+    for (index = 0U; index < count; index++) {
+        LogicStimulusStep *step;
+        uint16_t node;
+        uint8_t type;
+
+        node = (uint16_t)(sorted[index] - graph->nodes);
+        type = run->types[node];
+        if (type == NODE_INPUT || type == NODE_GATE_CLOCK) {
+            continue;
+        }
+        step = &run->steps[run->step_count++];
+        step->node = node;
+        step->a = run->drivers[node][0];
+        step->b = run->drivers[node][1];
+        step->lut = 0U;
+        if (type == NODE_OUTPUT) {
+            step->kind = LOGIC_STIMULUS_STEP_LUT;
+            step->lut = (uint8_t)(LOGIC_STIMULUS_GATE_TYPES + NODE_OUTPUT);
+        } else if (type == NODE_GATE_DFF) {
+            step->kind = LOGIC_STIMULUS_STEP_DFF;
+        } else if (type == NODE_GATE_LATCH) {
+            step->kind = LOGIC_STIMULUS_STEP_LATCH;
+        } else if (run->input_counts[node] <= 2U) {
+            step->kind = LOGIC_STIMULUS_STEP_LUT;
+            step->lut = (uint8_t)((run->input_counts[node] * LOGIC_STIMULUS_GATE_TYPES) + type);
+        } else {
+            step->kind = LOGIC_STIMULUS_STEP_WIDE;
+        }
+    }
+
+    run->probe_count = 0U;
+    for (index = 0U; index < graph->node_count; index++) {
+        if (run->types[index] == NODE_INPUT || run->types[index] == NODE_GATE_CLOCK) {
+            run->probes[run->probe_count++] = (uint16_t)index;
+        }
+    }
+    run->driver_count = run->probe_count;
+    for (index = 0U; index < graph->node_count; index++) {
+        if (run->types[index] == NODE_OUTPUT) {
+            run->probes[run->probe_count++] = (uint16_t)index;
+        }
+    }
+
+    run->values[LOGIC_STIMULUS_OPEN_PIN] = LOGIC_UNKNOWN;
+    run->state_changed[LOGIC_STIMULUS_OPEN_PIN] = 0U;
+    run->revision = graph->revision;
+    run->compiled = true;
+}
+
+static void stimulus_load_values(LogicStimulusRun *run) {
+    uint32_t index;
+
+    for (index = 0U; index < run->node_count; index++) {
+        const LogicNode *node;
+
+        node = &run->graph->nodes[index];
+        run->values[index] = (uint8_t)(node->type == NODE_OUTPUT ? node->inputs[0].value : node->outputs[0].value);
+        run->states[index] = (uint8_t)node->state;
+        run->prev_states[index] = (uint8_t)node->prev_state;
+        run->state_changed[index] = node->state_changed ? 1U : 0U;
+    }
+}
+
+static void stimulus_store_values(LogicStimulusRun *run) {
+    uint32_t index;
+
+    for (index = 0U; index < run->node_count; index++) {
+        LogicNode *node;
+
+        if (run->types[index] == LOGIC_STIMULUS_DELETED) {
+            continue;
+        }
+        node = &run->graph->nodes[index];
+        if (run->types[index] == NODE_OUTPUT) {
+            node->inputs[0].value = (LogicValue)run->values[index];
+        } else {
+            node->outputs[0].value = (LogicValue)run->values[index];
+        }
+        node->state = (LogicValue)run->states[index];
+        node->prev_state = (LogicValue)run->prev_states[index];
+        node->state_changed = run->state_changed[index] != 0U;
+    }
+}
+
+// logic_eval_gate over the byte-wide values.
+static uint8_t stimulus_eval_gate(uint8_t type, const uint8_t *inputs, uint8_t count) {
+    bool any_low;
+    bool any_high;
+    uint8_t index;
+
+    if (count == 0U) {
+        return LOGIC_UNKNOWN;
+    }
+    any_low = false;
+    any_high = false;
+    for (index = 0U; index < count; index++) {
+        if (inputs[index] > LOGIC_HIGH) {
+            return inputs[index];
+        }
+        any_low = any_low || inputs[index] == LOGIC_LOW;
+        any_high = any_high || inputs[index] == LOGIC_HIGH;
+    }
+
+    switch ((NodeType)type) {
+        case NODE_GATE_AND:
+            return any_low ? LOGIC_LOW : LOGIC_HIGH;
+        case NODE_GATE_OR:
+            return any_high ? LOGIC_HIGH : LOGIC_LOW;
+        case NODE_GATE_NOT:
+            return inputs[0] == LOGIC_HIGH ? LOGIC_LOW : LOGIC_HIGH;
+        case NODE_GATE_XOR:
+            return (count > 1U && inputs[0] != inputs[1]) ? LOGIC_HIGH : LOGIC_LOW;
+        case NODE_GATE_NAND:
+            return any_low ? LOGIC_HIGH : LOGIC_LOW;
+        case NODE_GATE_NOR:
+            return any_high ? LOGIC_LOW : LOGIC_HIGH;
+        case NODE_INPUT:
+        case NODE_OUTPUT:
+        case NODE_GATE_DFF:
+        case NODE_GATE_LATCH:
+        case NODE_GATE_CLOCK:
+        default:
+            return LOGIC_UNKNOWN;
+    }
+}
+
+// logic_evaluate over the compiled arrays.
+static void stimulus_settle(LogicStimulusRun *run) {
+    LogicActivity *activity;
+    uint8_t *values;
+    uint32_t position;
+
+    values = run->values;
+    activity = run->graph->activity;
+    if (activity) {
+        activity->passes++;
+    }
+    for (position = 0U; position < run->step_count; position++) {
+        const LogicStimulusStep *step;
+        uint64_t started;
+        uint8_t before;
+
+        step = &run->steps[position];
+        started = 0U;
+        before = values[step->node];
+        if (activity) {
+            started = logic_activity_begin(activity);
+        }
+        if (step->kind == LOGIC_STIMULUS_STEP_LUT) {
+            values[step->node] = run->gate_luts[step->lut][(values[step->a] << 2U) | values[step->b]];
+        } else if (step->kind == LOGIC_STIMULUS_STEP_DFF) {
+            values[step->node] = run->states[step->node];
+        } else if (step->kind == LOGIC_STIMULUS_STEP_LATCH) {
+            if (values[step->b] == LOGIC_HIGH) {
+                run->states[step->node] = values[step->a];
+            }
+            values[step->node] = run->states[step->node];
+        } else {
+            uint8_t inputs[MAX_PINS];
+            uint8_t count;
+            uint8_t pin;
+
+            count = run->input_counts[step->node];
+            for (pin = 0U; pin < count; pin++) {
+                inputs[pin] = values[run->drivers[step->node][pin]];
+            }
+            values[step->node] = stimulus_eval_gate(run->types[step->node], inputs, count);
+        }
+        if (activity) {
+            logic_activity_end(activity, step->node, before != values[step->node], started);
+        }
+    }
+    run->graph->node_evaluations += run->step_count;
+    run->dirty = false;
+}
+
+// logic_tick over the compiled arrays.
+static void stimulus_tick(LogicStimulusRun *run) {
+    uint32_t node;
+
+    for (node = 0U; node < run->node_count; node++) {
+        uint8_t type;
+
+        type = run->types[node];
+        if (type == NODE_GATE_DFF) {
+            uint16_t d_driver;
+            uint16_t clk_driver;
+            uint8_t d;
+            uint8_t clk;
+
+            d_driver = run->drivers[node][0];
+            clk_driver = run->drivers[node][1];
+            d = run->values[d_driver];
+            clk = run->values[clk_driver];
+            run->state_changed[node] = 0U;
+            if (run->prev_states[node] == LOGIC_LOW && clk == LOGIC_HIGH) {
+                run->states[node] = run->state_changed[d_driver] ? (uint8_t)LOGIC_ERROR : d;
+                run->state_changed[node] = 1U;
+            }
+            run->prev_states[node] = clk;
+        } else if (type == NODE_GATE_CLOCK) {
+            run->states[node] = run->states[node] == LOGIC_HIGH ? (uint8_t)LOGIC_LOW : (uint8_t)LOGIC_HIGH;
+            run->values[node] = run->states[node];
+            run->state_changed[node] = 1U;
+            if (run->graph->activity) {
+                logic_activity_end(run->graph->activity, node, true, 0U);
+            }
+        } else if (type != LOGIC_STIMULUS_DELETED) {
+            run->state_changed[node] = 0U;
+        }
+    }
+
+    stimulus_settle(run);
+}
+
+// Stimulus clocks toggle just before the tick that ends their period.
+static void stimulus_step_clocks(LogicStimulusRun *run) {
+    uint32_t index;
+
+    for (index = 0U; index < run->clock_count; index++) {
+        uint16_t node;
+
+        if (run->clock_periods[index] == 0U || ++run->clock_phases[index] < run->clock_periods[index]) {
+            continue;
+        }
+        run->clock_phases[index] = 0U;
+        node = run->clock_nodes[index];
+        if (node < run->node_count && run->types[node] == NODE_INPUT) {
+            run->values[node] = run->values[node] == LOGIC_HIGH ? (uint8_t)LOGIC_LOW : (uint8_t)LOGIC_HIGH;
+            run->dirty = true;
+        }
+    }
+}
+
+static void stimulus_set_clock(LogicStimulusRun *run, uint16_t node, uint32_t period) {
+    uint32_t index;
+
+    for (index = 0U; index < run->clock_count; index++) {
+        if (run->clock_nodes[index] == node) {
+            break;
+        }
+    }
+    if (index == run->clock_count) {
+        if (run->clock_count == LOGIC_STIMULUS_MAX_CLOCKS) {
+            return;
+        }
+        run->clock_count++;
+    }
+    run->clock_nodes[index] = node;
+    run->clock_periods[index] = period;
+    run->clock_phases[index] = 0U;
+}
+
+static void stimulus_record(const LogicStimulusRun *run, uint8_t *row) {
+    uint32_t index;
+
+    if (!row) {
+        return;
+    }
+    for (index = 0U; index < run->probe_count; index++) {
+        row[index] = run->values[run->probes[index]];
+    }
+}
+
+// Gates with up to two inputs (nearly all of them) and outputs evaluate by
+// table lookup; the gate tables come from logic_eval_gate itself so the
+// semantics cannot drift.
+static void stimulus_build_luts(LogicStimulusRun *run) {
+    LogicValue inputs[2];
+    uint32_t arity;
+    uint32_t type;
+    uint32_t key;
+
+    for (key = 0U; key < 16U; key++) {
+        inputs[0] = (LogicValue)(key >> 2U);
+        inputs[1] = (LogicValue)(key & 3U);
+        for (arity = 0U; arity < 3U; arity++) {
+            for (type = NODE_GATE_AND; type <= NODE_GATE_NOR; type++) {
+                LogicValue value;
+
+                value = logic_eval_gate((NodeType)type, inputs, (uint8_t)arity);
+                run->gate_luts[(arity * LOGIC_STIMULUS_GATE_TYPES) + type][key] = (uint8_t)value;
+            }
+        }
+        run->gate_luts[LOGIC_STIMULUS_GATE_TYPES + NODE_OUTPUT][key] = (uint8_t)inputs[0];
+    }
+}
+
+void logic_stimulus_run_init(LogicStimulusRun *run, LogicGraph *graph, const LogicStimulus *stimulus) {
+    memset(run, 0, sizeof(*run));
+    run->graph = graph;
+    run->stimulus = stimulus;
+    stimulus_build_luts(run);
+    stimulus_compile(run);
+}
+
+bool logic_stimulus_run_done(const LogicStimulusRun *run) {
+    return !run->stimulus || run->pc >= run->stimulus->op_count;
+}
+
+uint32_t logic_apply_stimulus_batch(LogicStimulusRun *run, uint8_t *results, uint32_t max_samples) {
+    const LogicStimulusOp *ops;
+    uint32_t op_count;
+    uint32_t produced;
+
+    if (logic_stimulus_run_done(run) || max_samples == 0U) {
+        return 0U;
+    }
+    TRACE_BEGIN("logic_apply_stimulus_batch");
+    if (!run->compiled || run->revision != run->graph->revision || run->node_count != run->graph->node_count) {
+        stimulus_compile(run);
+    }
+    stimulus_load_values(run);
+
+    ops = run->stimulus->ops;
+    op_count = run->stimulus->op_count;
+    produced = 0U;
+    while (produced < max_samples && run->pc < op_count) {
+        const LogicStimulusOp *op;
+
+        op = &ops[run->pc];
+        switch ((LogicStimulusOpKind)op->kind) {
+            case LOGIC_STIMULUS_SET:
+                if (op->node < run->node_count && run->types[op->node] == NODE_INPUT) {
+                    run->values[op->node] = op->value;
+                    run->dirty = true;
+                }
+                run->pc++;
+                break;
+            case LOGIC_STIMULUS_EVAL:
+                stimulus_settle(run);
+                stimulus_record(run, results ? results + ((size_t)produced * run->probe_count) : NULL);
+                produced++;
+                run->pc++;
+                break;
+            case LOGIC_STIMULUS_TICK:
+                if (run->ticks_left == 0U) {
+                    run->ticks_left = op->count;
+                    if (op->count == 0U) {
+                        run->pc++;
+                        break;
+                    }
+                }
+                stimulus_step_clocks(run);
+                if (run->dirty) {
+                    stimulus_settle(run);
+                }
+                stimulus_tick(run);
+                stimulus_record(run, results ? results + ((size_t)produced * run->probe_count) : NULL);
+                produced++;
+                if (--run->ticks_left == 0U) {
+                    run->pc++;
+                }
+                break;
+            case LOGIC_STIMULUS_CLOCK:
+                stimulus_set_clock(run, op->node, op->count);
+                run->pc++;
+                break;
+            case LOGIC_STIMULUS_REPEAT:
+                if (op->count == 0U) {
+                    run->pc = op->target + 1U;
+                    break;
+                }
+                run->loop_ops[run->depth] = run->pc;
+                run->loop_left[run->depth] = op->count;
+                run->depth++;
+                run->pc++;
+                break;
+            case LOGIC_STIMULUS_END:
+                if (run->depth > 0U && --run->loop_left[run->depth - 1U] > 0U) {
+                    run->pc = run->loop_ops[run->depth - 1U] + 1U;
+                } else {
+                    if (run->depth > 0U) {
+                        run->depth--;
+                    }
+                    run->pc++;
+                }
+                break;
+            default:
+                run->pc++;
+                break;
+        }
+    }
+
+    if (run->dirty && logic_stimulus_run_done(run)) {
+        stimulus_settle(run);
+    }
+    stimulus_store_values(run);
+    TRACE_END();
+    return produced;
+}
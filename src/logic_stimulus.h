@@ -0,0 +1,122 @@
+#ifndef LOGIC_STIMULUS_H
+#define LOGIC_STIMULUS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "logic.h"
+
+#define LOGIC_STIMULUS_MAX_CLOCKS 16U
+#define LOGIC_STIMULUS_MAX_DEPTH 16U
+#define LOGIC_STIMULUS_NO_NODE UINT16_MAX
+#define LOGIC_STIMULUS_OPEN_PIN MAX_NODES // driver slot of an unconnected pin, always LOGIC_UNKNOWN
+#define LOGIC_STIMULUS_GATE_TYPES 16U
+
+typedef enum {
+    LOGIC_STIMULUS_SET, // input `node` takes `value`
+    LOGIC_STIMULUS_EVAL, // settle and take one sample
+    LOGIC_STIMULUS_TICK, // `count` clock ticks, one sample each
+    LOGIC_STIMULUS_CLOCK, // input `node` toggles every `count` ticks from here on
+    LOGIC_STIMULUS_REPEAT, // run the ops up to `target` (its END) `count` times
+    LOGIC_STIMULUS_END // `target` is the matching REPEAT
+} LogicStimulusOpKind;
+
+typedef struct {
+    uint32_t count;
+    uint32_t target;
+    uint16_t node;
+    uint8_t kind; // LogicStimulusOpKind
+    uint8_t value; // LogicValue
+    uint8_t _padding[4];
+} LogicStimulusOp;
+
+// A parsed stimulus file, with names already resolved to node indices of the
+// graph it was parsed against. The text has one step per line:
+//
+//   A=1 B=0          set inputs, settle, take one sample
+//   tick [N]         N clock ticks (default 1), one sample each
+//   A=1 tick 4       both: set, then tick
+//   clock A [N]      from here on, input A toggles every N ticks (default 1)
+//   repeat N {       the lines up to the matching `}` run N times; nests
+//   }
+//
+// `#` starts a comment.
+typedef struct {
+    LogicStimulusOp *ops;
+    uint64_t sample_count; // samples the whole program produces
+    uint32_t op_count;
+    uint32_t op_capacity;
+} LogicStimulus;
+
+typedef enum {
+    LOGIC_STIMULUS_STEP_LUT, // values[node] = gate_luts[lut][values[a] << 2 | values[b]]
+    LOGIC_STIMULUS_STEP_DFF,
+    LOGIC_STIMULUS_STEP_LATCH,
+    LOGIC_STIMULUS_STEP_WIDE // gate with more than two inputs
+} LogicStimulusStepKind;
+
+// One node of the compiled evaluation order.
+typedef struct {
+    uint16_t node;
+    uint16_t a; // drivers of in0 and in1
+    uint16_t b;
+    uint8_t lut; // row of gate_luts: arity * LOGIC_STIMULUS_GATE_TYPES + type
+    uint8_t kind; // LogicStimulusStepKind
+} LogicStimulusStep;
+
+// Playback state: the graph flattened into dense per-node arrays (values,
+// storage state and the node driving each input pin), so a batch touches no
+// LogicNode or LogicNet until it writes the result back at the end. Each
+// batch re-reads the graph's values first and recompiles if its revision
+// moved, so interactive edits between batches are picked up.
+typedef struct {
+    LogicGraph *graph;
+    const LogicStimulus *stimulus;
+    uint16_t drivers[MAX_NODES][MAX_PINS]; // source node per input pin, LOGIC_STIMULUS_OPEN_PIN if open
+    LogicStimulusStep steps[MAX_NODES]; // logic_evaluate's order, inputs, clocks and deleted nodes dropped
+    uint16_t probes[MAX_NODES]; // inputs and clocks, then outputs, in graph order
+    uint16_t clock_nodes[LOGIC_STIMULUS_MAX_CLOCKS];
+    uint32_t clock_periods[LOGIC_STIMULUS_MAX_CLOCKS];
+    uint32_t clock_phases[LOGIC_STIMULUS_MAX_CLOCKS];
+    uint32_t loop_ops[LOGIC_STIMULUS_MAX_DEPTH];
+    uint32_t loop_left[LOGIC_STIMULUS_MAX_DEPTH];
+    uint32_t node_count;
+    uint32_t step_count;
+    uint32_t probe_count;
+    uint32_t driver_count; // probes[0..driver_count) are inputs and clocks
+    uint32_t clock_count;
+    uint32_t depth;
+    uint32_t pc; // next op
+    uint32_t ticks_left; // of the TICK op at pc, 0 when not started
+    uint32_t revision; // graph revision the arrays were built from
+    uint8_t _padding0[4];
+    uint8_t gate_luts[3U * LOGIC_STIMULUS_GATE_TYPES][16]; // logic_eval_gate by arity and type, keyed by in0 << 2 | in1
+    uint8_t types[MAX_NODES];
+    uint8_t input_counts[MAX_NODES];
+    uint8_t states[MAX_NODES];
+    uint8_t prev_states[MAX_NODES];
+    uint8_t values[MAX_NODES + 1U]; // output value; an output node's observed input
+    uint8_t state_changed[MAX_NODES + 1U];
+    bool compiled;
+    bool dirty; // inputs set since the last settle
+    uint8_t _padding1[4];
+} LogicStimulusRun;
+
+bool logic_stimulus_parse(
+    LogicStimulus *stimulus,
+    const LogicGraph *graph,
+    const char *data,
+    size_t size,
+    char *error_message,
+    size_t error_message_size
+);
+bool logic_stimulus_load(LogicStimulus *stimulus, const LogicGraph *graph, const char *path, char *error_message, size_t error_message_size);
+void logic_stimulus_release(LogicStimulus *stimulus);
+
+void logic_stimulus_run_init(LogicStimulusRun *run, LogicGraph *graph, const LogicStimulus *stimulus);
+bool logic_stimulus_run_done(const LogicStimulusRun *run);
+// Plays up to `max_samples` samples, writing probe_count values per sample
+// to `results` (which may be NULL), and returns how many it produced.
+uint32_t logic_apply_stimulus_batch(LogicStimulusRun *run, uint8_t *results, uint32_t max_samples);
+
+#endif // LOGIC_STIMULUS_H
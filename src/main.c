@@ -3,13 +3,18 @@
 #include "app_analysis.h"
 #include "app_canvas.h"
 #include "app_commands.h"
+#include "batch_grade.h"
+#include "circuit_file_app.h"
 #include "draw_util.h"
 #include "editor_input.h"
+#include "perf_hud.h"
 #include "source_watch.h"
 #include "topbar.h"
+#include "trace.h"
 #include "ui.h"
 #include "workspace_layout.h"
 #include <stdio.h>
+#include <string.h>
 
 static void draw_resize_seam(Rectangle rect, WorkspaceResizeHandle handle) {
     Color seam_color;
@@ -71,12 +76,12 @@ static void draw_resize_handle(Rectangle rect, WorkspaceResizeHandle handle, boo
     DrawRectangleRounded(grip, 1.0f, 12, grip_color);
 }
 
-static void draw_footer(const AppContext *app, Rectangle footer_rect) {
-    char footer_text[APP_SOURCE_PATH_MAX + 96];
+static void draw_footer(const AppContext *app, const PerfHud *hud, Rectangle footer_rect) {
+    char footer_text[APP_SOURCE_PATH_MAX + 128];
     const char *file_label;
     uint32_t live_count;
     uint32_t node_index;
-    char sim_segment[48];
+    char sim_segment[64];
     char selected_label[64];
     char selected_segment[80];
 
@@ -92,7 +97,17 @@ static void draw_footer(const AppContext *app, Rectangle footer_rect) {
     }
 
     sim_segment[0] = '\0';
-    snprintf(sim_segment, sizeof(sim_segment), "  |  sim @ %.0f Hz", (double)app->simulation.speed);
+    if (hud->shown.requested_hz > 0.0) {
+        snprintf(
+            sim_segment,
+            sizeof(sim_segment),
+            "  |  sim %.1f of %.0f Hz",
+            hud->shown.ticks_per_second,
+            (double)app->simulation.speed
+        );
+    } else {
+        snprintf(sim_segment, sizeof(sim_segment), "  |  sim @ %.0f Hz", (double)app->simulation.speed);
+    }
 
     selected_label[0] = '\0';
     if (app->selection.selected_wire_sink && app->selection.selected_wire_sink->node &&
@@ -114,10 +129,31 @@ static void draw_footer(const AppContext *app, Rectangle footer_rect) {
         snprintf(selected_segment, sizeof(selected_segment), "  |  selected %s", selected_label);
     }
 
-    snprintf(footer_text, sizeof(footer_text), "FILE: %s  |  %u gates%s%s", file_label, live_count, sim_segment, selected_segment);
+    snprintf(
+        footer_text,
+        sizeof(footer_text),
+        "FILE: %s  |  %u gates%s  |  %.1f ms/frame%s",
+        file_label,
+        live_count,
+        sim_segment,
+        hud->shown.frame_avg_ms,
+        selected_segment
+    );
     draw_text_at(footer_text, footer_rect.x + 12.0f, footer_rect.y + 6.0f, 11, (Color){ 150, 150, 150, 255 });
 }
 
+static void save_trace(AppContext *app, const char *path) {
+    char error_message[128];
+    char status[320];
+
+    if (trace_save(path, error_message, sizeof(error_message))) {
+        snprintf(status, sizeof(status), "Trace written to %s", path);
+    } else {
+        snprintf(status, sizeof(status), "Trace failed: %s", error_message);
+    }
+    app_set_source_status(app, status);
+}
+
 static void draw_shortcuts_overlay(const WorkspaceFrame *frame, Vector2 mouse_pos, bool *shortcuts_open) {
     Rectangle card;
     float card_w;
@@ -136,6 +172,10 @@ static void draw_shortcuts_overlay(const WorkspaceFrame *frame, Vector2 mouse_po
         "Arrows     Move selected node on grid",
         "+ / -      Zoom canvas",
         "Home       Reset canvas view",
+        "Ctrl+S     Save circuit (Cmd+S on macOS)",
+        "H          Toggle the activity heatmap",
+        "F3         Toggle the performance overlay",
+        "F9         Write a timing trace for Perfetto",
         "Del        Delete selected node or wire",
         "Esc        Cancel or close this panel",
         "/          Toggle this panel",
@@ -146,7 +186,7 @@ static void draw_shortcuts_overlay(const WorkspaceFrame *frame, Vector2 mouse_po
     DrawRectangle(0, 0, frame->window_width, frame->window_height, (Color){ 0, 0, 0, 160 });
 
     card_w = 520.0f;
-    card_h = 350.0f;
+    card_h = 430.0f;
     card = (Rectangle){
         ((float)frame->window_width - card_w) * 0.5f,
         ((float)frame->window_height - card_h) * 0.5f,
@@ -177,13 +217,32 @@ int main(int argc, char **argv) {
     WorkspaceResizeHandles resize_handles;
     TopbarLayout topbar_layout;
     SourceWatch source_watch;
+    PerfHud perf_hud;
     const char *load_path;
+    const char *stimulus_path;
+    const char *trace_path;
+    int arg;
+
+    if (batch_grade_requested(argc, argv)) {
+        return batch_grade_main(argc, argv);
+    }
+    if (argc == 4 && strcmp(argv[1], "--convert") == 0) {
+        char error_message[256];
+
+        if (!circuit_file_convert(argv[2], argv[3], error_message, sizeof(error_message))) {
+            fprintf(stderr, "Convert failed: %s\n", error_message);
+            return 1;
+        }
+        return 0;
+    }
 
     SetConfigFlags(FLAG_WINDOW_RESIZABLE);
     InitWindow(WORKSPACE_WINDOW_START_WIDTH, WORKSPACE_WINDOW_START_HEIGHT, "LogicSim");
     SetWindowMinSize(WORKSPACE_WINDOW_MIN_WIDTH, WORKSPACE_WINDOW_MIN_HEIGHT);
     SetTargetFPS(60);
     SetExitKey(KEY_NULL);
+    trace_set_thread_name("main");
+    draw_stats_attach();
 
     workspace_layout_init_defaults(&layout_prefs);
     workspace_layout_load_prefs(&layout_prefs);
@@ -196,6 +255,7 @@ int main(int argc, char **argv) {
     app_update_logic(&app);
     editor_input_init(&input_state);
     source_watch_init(&source_watch);
+    perf_hud_init(&perf_hud);
 
     load_path = source_watch_parse_load_path(argc, argv);
     if (load_path && source_watch_load_circuit(&app, load_path, "Loaded from file", frame_layout.canvas_rect)) {
@@ -203,15 +263,41 @@ int main(int argc, char **argv) {
         app.source.live_reload = true;
     }
 
+    stimulus_path = NULL;
+    trace_path = NULL;
+    for (arg = 1; arg + 1 < argc; arg++) {
+        if (strcmp(argv[arg], "--stimulus") == 0) {
+            stimulus_path = argv[arg + 1];
+        }
+        if (strcmp(argv[arg], "--trace") == 0) {
+            trace_path = argv[arg + 1];
+        }
+    }
+    if (stimulus_path) {
+        char error_message[256];
+        char status[320];
+
+        if (app_load_stimulus(&app, stimulus_path, error_message, sizeof(error_message))) {
+            app_set_source_status(&app, "Stimulus loaded: Space plays it, . steps it");
+        } else {
+            snprintf(status, sizeof(status), "Stimulus failed: %s", error_message);
+            app_set_source_status(&app, status);
+        }
+    }
+
     while (!WindowShouldClose()) {
         WorkspaceResizeHandle hovered_resize_handle;
         Vector2 mouse_pos;
+        uint32_t draw_calls;
+        uint32_t vertices;
 
+        TRACE_BEGIN("frame");
         workspace_layout_sanitize_prefs(&layout_prefs, GetScreenWidth(), GetScreenHeight());
         frame_layout = workspace_layout_compute_frame(&layout_prefs, GetScreenWidth(), GetScreenHeight());
         resize_handles = workspace_layout_compute_handles(&frame_layout);
         topbar_layout = topbar_compute_layout(&frame_layout);
 
+        TRACE_BEGIN("editor_input_process_frame");
         editor_input_process_frame(
             &app,
             &input_state,
@@ -221,6 +307,10 @@ int main(int argc, char **argv) {
             &topbar_layout,
             &source_watch
         );
+        TRACE_END();
+        if (IsKeyPressed(KEY_F9)) {
+            save_trace(&app, trace_path ? trace_path : "logicsim-trace.json");
+        }
 
         mouse_pos = GetMousePosition();
         hovered_resize_handle = workspace_layout_hit_test_handle(&resize_handles, mouse_pos);
@@ -228,23 +318,35 @@ int main(int argc, char **argv) {
         BeginDrawing();
         ClearBackground((Color){ 24, 24, 24, 255 });
 
+        TRACE_BEGIN("topbar_draw");
         topbar_draw(&app, &topbar_layout, mouse_pos, editor_input_shortcuts_open(&input_state), frame_layout.window_width);
+        TRACE_END();
 
         if (begin_scissor_rect(frame_layout.canvas_rect)) {
+            TRACE_BEGIN("ui_draw_circuit");
             ui_draw_circuit(&app, frame_layout.canvas_rect);
+            TRACE_END();
+            TRACE_BEGIN("ui_draw_placement_ghost");
             ui_draw_placement_ghost(&app, frame_layout.canvas_rect, mouse_pos);
-            EndScissorMode();
+            TRACE_END();
+            end_scissor();
         }
+        TRACE_BEGIN("ui_draw_toolbox");
         ui_draw_toolbox(&app, frame_layout.toolbox_rect);
+        TRACE_END();
         if (begin_scissor_rect(frame_layout.wave_rect)) {
+            TRACE_BEGIN("ui_draw_waveforms");
             ui_draw_waveforms(&app, frame_layout.wave_rect);
-            EndScissorMode();
+            TRACE_END();
+            end_scissor();
         }
 
         DrawRectangleRec(frame_layout.side_panel_rect, (Color){ 23, 23, 23, 255 });
         if (begin_scissor_rect(frame_layout.side_panel_rect)) {
+            TRACE_BEGIN("ui_draw_context_panel");
             ui_draw_context_panel(&app, frame_layout.side_panel_rect);
-            EndScissorMode();
+            TRACE_END();
+            end_scissor();
         }
 
         draw_resize_seam(resize_handles.toolbox, WORKSPACE_RESIZE_HANDLE_TOOLBOX);
@@ -270,7 +372,15 @@ int main(int argc, char **argv) {
             editor_input_active_resize_handle(&input_state) == WORKSPACE_RESIZE_HANDLE_WAVE_PANEL
         );
 
-        draw_footer(&app, frame_layout.footer_rect);
+        if (editor_input_perf_hud_open(&input_state)) {
+            TRACE_BEGIN("perf_hud_draw");
+            perf_hud_draw(&perf_hud, frame_layout.canvas_rect);
+            TRACE_END();
+        }
+
+        TRACE_BEGIN("draw_footer");
+        draw_footer(&app, &perf_hud, frame_layout.footer_rect);
+        TRACE_END();
         if (editor_input_shortcuts_open(&input_state)) {
             bool shortcuts_open;
 
@@ -281,10 +391,26 @@ int main(int argc, char **argv) {
             }
         }
 
+        draw_flush();
+        // Includes the wait for vsync and the frame limiter.
+        TRACE_BEGIN("EndDrawing");
         EndDrawing();
+        TRACE_END();
+        draw_stats_take(&draw_calls, &vertices);
+        perf_hud_end_frame(&perf_hud, &app, GetFrameTime(), draw_calls, vertices, GetTime());
+        TRACE_END();
     }
 
+    if (trace_path) {
+        char error_message[128];
+
+        if (!trace_save(trace_path, error_message, sizeof(error_message))) {
+            fprintf(stderr, "Trace failed: %s\n", error_message);
+        }
+    }
+    source_watch_stop(&source_watch);
     workspace_layout_save_prefs(&layout_prefs);
+    draw_stats_detach();
     CloseWindow();
     return 0;
 }
@@ -0,0 +1,279 @@
+#include "mem.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MEM_HEADER_SIZE 16U // keeps the caller's bytes 16-byte aligned
+
+// Sits in front of every block so mem_free knows what to take off the books
+// and which hooks to hand it back to.
+typedef struct {
+    size_t size; // caller's bytes, without the header
+    uint32_t tag;
+    uint32_t hooks; // index into mem_hook_sets
+} MemHeader;
+
+static void *mem_default_allocate(size_t size, bool zeroed, void *user) {
+    (void)user;
+    return zeroed ? calloc(1U, size) : malloc(size);
+}
+
+static void *mem_default_reallocate(void *memory, size_t size, void *user) {
+    (void)user;
+    return realloc(memory, size);
+}
+
+static void mem_default_release(void *memory, void *user) {
+    (void)user;
+    free(memory);
+}
+
+static const MemHooks mem_default_hooks = {
+    mem_default_allocate,
+    mem_default_reallocate,
+    mem_default_release,
+    NULL,
+};
+
+static pthread_mutex_t mem_lock = PTHREAD_MUTEX_INITIALIZER;
+// Every set ever installed, never removed, so a block can always reach the
+// hooks that allocated it. Slot 0 is malloc and free. An entry is written
+// before mem_current_hooks first points at it.
+static MemHooks mem_hook_sets[MEM_MAX_HOOK_SETS] = {
+    {
+        mem_default_allocate,
+        mem_default_reallocate,
+        mem_default_release,
+        NULL,
+    },
+};
+static uint32_t mem_hook_set_count = 1U;
+static uint32_t mem_current_hooks;
+static MemReport mem_totals;
+
+static void mem_account(MemTag tag, uint64_t added, uint64_t removed, bool new_block, bool freed_block) {
+    MemTagStats *stats;
+
+    pthread_mutex_lock(&mem_lock);
+    stats = &mem_totals.tags[tag];
+    stats->current_bytes = stats->current_bytes + added - removed;
+    mem_totals.current_bytes = mem_totals.current_bytes + added - removed;
+    if (added > 0U) {
+        stats->allocations++;
+    }
+    if (new_block) {
+        stats->live_blocks++;
+    }
+    if (freed_block) {
+        stats->live_blocks--;
+    }
+    if (stats->current_bytes > stats->peak_bytes) {
+        stats->peak_bytes = stats->current_bytes;
+    }
+    if (mem_totals.current_bytes > mem_totals.peak_bytes) {
+        mem_totals.peak_bytes = mem_totals.current_bytes;
+    }
+    pthread_mutex_unlock(&mem_lock);
+}
+
+static MemHeader *mem_header(void *memory) {
+    return (MemHeader *)(void *)((uint8_t *)memory - MEM_HEADER_SIZE);
+}
+
+static void *mem_allocate(MemTag tag, size_t size, bool zeroed) {
+    const MemHooks *hooks;
+    MemHeader *header;
+    uint32_t hooks_index;
+    void *block;
+
+    if (size == 0U) {
+        size = 1U;
+    }
+    if (size > SIZE_MAX - MEM_HEADER_SIZE) {
+        return NULL;
+    }
+    hooks_index = __atomic_load_n(&mem_current_hooks, __ATOMIC_ACQUIRE);
+    hooks = &mem_hook_sets[hooks_index];
+    block = hooks->allocate(size + MEM_HEADER_SIZE, zeroed, hooks->user);
+    if (!block) {
+        return NULL;
+    }
+    header = (MemHeader *)block;
+    header->size = size;
+    header->tag = (uint32_t)tag;
+    header->hooks = hooks_index;
+    mem_account(tag, size, 0U, true, false);
+    return (uint8_t *)block + MEM_HEADER_SIZE;
+}
+
+static bool mem_hooks_equal(const MemHooks *a, const MemHooks *b) {
+    return a->allocate == b->allocate && a->reallocate == b->reallocate && a->release == b->release && a->user == b->user;
+}
+
+bool mem_set_hooks(const MemHooks *hooks) {
+    uint32_t index;
+
+    if (!hooks) {
+        hooks = &mem_default_hooks;
+    }
+    pthread_mutex_lock(&mem_lock);
+    index = 0U;
+    while (index < mem_hook_set_count && !mem_hooks_equal(&mem_hook_sets[index], hooks)) {
+        index++;
+    }
+    if (index == mem_hook_set_count) {
+        if (mem_hook_set_count == MEM_MAX_HOOK_SETS) {
+            pthread_mutex_unlock(&mem_lock);
+            return false;
+        }
+        mem_hook_sets[mem_hook_set_count++] = *hooks;
+    }
+    __atomic_store_n(&mem_current_hooks, index, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&mem_lock);
+    return true;
+}
+
+void *mem_alloc(MemTag tag, size_t size) {
+    return mem_allocate(tag, size, false);
+}
+
+void *mem_calloc(MemTag tag, size_t count, size_t size) {
+    if (size > 0U && count > SIZE_MAX / size) {
+        return NULL;
+    }
+    return mem_allocate(tag, count * size, true);
+}
+
+void *mem_realloc(MemTag tag, void *memory, size_t size) {
+    const MemHooks *hooks;
+    MemHeader *header;
+    size_t old_size;
+    void *block;
+
+    if (!memory) {
+        return mem_allocate(tag, size, false);
+    }
+    if (size == 0U) {
+        size = 1U;
+    }
+    if (size > SIZE_MAX - MEM_HEADER_SIZE) {
+        return NULL;
+    }
+    header = mem_header(memory);
+    old_size = header->size;
+    tag = (MemTag)header->tag;
+    hooks = &mem_hook_sets[header->hooks];
+    block = hooks->reallocate(header, size + MEM_HEADER_SIZE, hooks->user);
+    if (!block) {
+        return NULL;
+    }
+    header = (MemHeader *)block;
+    header->size = size;
+    mem_account(tag, size, old_size, false, false);
+    return (uint8_t *)block + MEM_HEADER_SIZE;
+}
+
+char *mem_strdup(MemTag tag, const char *text) {
+    char *copy;
+    size_t length;
+
+    length = strlen(text) + 1U;
+    copy = (char *)mem_allocate(tag, length, false);
+    if (copy) {
+        memcpy(copy, text, length);
+    }
+    return copy;
+}
+
+void mem_free(void *memory) {
+    const MemHooks *hooks;
+    MemHeader *header;
+
+    if (!memory) {
+        return;
+    }
+    header = mem_header(memory);
+    hooks = &mem_hook_sets[header->hooks];
+    mem_account((MemTag)header->tag, 0U, header->size, false, true);
+    hooks->release(header, hooks->user);
+}
+
+void mem_set_fixed(MemTag tag, size_t bytes) {
+    pthread_mutex_lock(&mem_lock);
+    mem_totals.fixed_bytes = mem_totals.fixed_bytes - mem_totals.tags[tag].fixed_bytes + bytes;
+    mem_totals.tags[tag].fixed_bytes = bytes;
+    pthread_mutex_unlock(&mem_lock);
+}
+
+const char *mem_tag_name(MemTag tag) {
+    switch (tag) {
+    case MEM_TAG_GRAPH:
+        return "graph";
+    case MEM_TAG_NAMES:
+        return "names";
+    case MEM_TAG_TRUTH_TABLE:
+        return "truth table";
+    case MEM_TAG_EXPRESSIONS:
+        return "expressions";
+    case MEM_TAG_WAVEFORMS:
+        return "waveforms";
+    case MEM_TAG_LOADER:
+        return "loader";
+    case MEM_TAG_LAYOUT:
+        return "layout";
+    case MEM_TAG_SIMULATION:
+        return "simulation";
+    case MEM_TAG_ANALYSIS:
+        return "analysis";
+    case MEM_TAG_TRACE:
+        return "trace";
+    case MEM_TAG_OTHER:
+        return "other";
+    case MEM_TAG_COUNT:
+    default:
+        return "?";
+    }
+}
+
+void mem_report(MemReport *report) {
+    pthread_mutex_lock(&mem_lock);
+    *report = mem_totals;
+    pthread_mutex_unlock(&mem_lock);
+}
+
+void mem_write_report(FILE *stream) {
+    MemReport report;
+    uint32_t tag;
+
+    mem_report(&report);
+    fprintf(stream, "%-12s %12s %12s %8s %10s %12s\n", "memory", "current", "peak", "live", "allocs", "fixed");
+    for (tag = 0U; tag < (uint32_t)MEM_TAG_COUNT; tag++) {
+        const MemTagStats *stats;
+
+        stats = &report.tags[tag];
+        if (stats->allocations == 0U && stats->fixed_bytes == 0U) {
+            continue;
+        }
+        fprintf(
+            stream,
+            "%-12s %12" PRIu64 " %12" PRIu64 " %8" PRIu64 " %10" PRIu64 " %12" PRIu64 "\n",
+            mem_tag_name((MemTag)tag),
+            stats->current_bytes,
+            stats->peak_bytes,
+            stats->live_blocks,
+            stats->allocations,
+            stats->fixed_bytes
+        );
+    }
+    fprintf(
+        stream,
+        "%-12s %12" PRIu64 " %12" PRIu64 " %8s %10s %12" PRIu64 "\n",
+        "total",
+        report.current_bytes,
+        report.peak_bytes,
+        "",
+        "",
+        report.fixed_bytes
+    );
+}
@@ -0,0 +1,74 @@
+#ifndef MEM_H
+#define MEM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Tagged heap allocation with per-subsystem accounting, for sizing
+// deployments and spotting leaks and churn. Every block from mem_* must go
+// back through mem_free, never free().
+typedef enum {
+    MEM_TAG_GRAPH,
+    MEM_TAG_NAMES,
+    MEM_TAG_TRUTH_TABLE,
+    MEM_TAG_EXPRESSIONS,
+    MEM_TAG_WAVEFORMS,
+    MEM_TAG_LOADER,
+    MEM_TAG_LAYOUT,
+    MEM_TAG_SIMULATION,
+    MEM_TAG_ANALYSIS,
+    MEM_TAG_TRACE,
+    MEM_TAG_OTHER,
+    MEM_TAG_COUNT
+} MemTag;
+
+// Where the bytes come from. allocate must return zeroed memory when asked
+// to; all three see the block header as well as the caller's bytes.
+typedef struct {
+    void *(*allocate)(size_t size, bool zeroed, void *user);
+    void *(*reallocate)(void *memory, size_t size, void *user);
+    void (*release)(void *memory, void *user);
+    void *user;
+} MemHooks;
+
+typedef struct {
+    uint64_t current_bytes;
+    uint64_t peak_bytes;
+    uint64_t live_blocks;
+    uint64_t allocations; // every allocate and reallocate call, so churn shows
+    uint64_t fixed_bytes; // inline buffers registered with mem_set_fixed
+} MemTagStats;
+
+typedef struct {
+    MemTagStats tags[MEM_TAG_COUNT];
+    uint64_t current_bytes; // heap only, all tags
+    uint64_t peak_bytes; // of the heap total, not the sum of per-tag peaks
+    uint64_t fixed_bytes;
+} MemReport;
+
+#define MEM_MAX_HOOK_SETS 8U // distinct hook sets a process may ever install, malloc included
+
+// New blocks come from `hooks`; blocks already out are still reallocated and
+// released through the hooks that allocated them. NULL restores malloc and
+// free. False, changing nothing, once MEM_MAX_HOOK_SETS sets are in use.
+bool mem_set_hooks(const MemHooks *hooks);
+
+void *mem_alloc(MemTag tag, size_t size);
+void *mem_calloc(MemTag tag, size_t count, size_t size);
+// A block keeps the tag it was first allocated with.
+void *mem_realloc(MemTag tag, void *memory, size_t size);
+char *mem_strdup(MemTag tag, const char *text);
+void mem_free(void *memory);
+
+// Records the size of a buffer that lives inside a larger struct, such as
+// the app's waveform history, so the report covers it. Replaces, not adds.
+void mem_set_fixed(MemTag tag, size_t bytes);
+
+const char *mem_tag_name(MemTag tag);
+void mem_report(MemReport *report);
+// One row per tag that has ever held memory, then the totals.
+void mem_write_report(FILE *stream);
+
+#endif // MEM_H
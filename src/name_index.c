@@ -0,0 +1,97 @@
+#include "name_index.h"
+#include <string.h>
+
+static uint32_t name_index_hash(const char *name, size_t length) {
+    uint32_t hash;
+    size_t offset;
+
+    // FNV-1a
+    hash = 2166136261U;
+    for (offset = 0U; offset < length; offset++) {
+        hash ^= (uint32_t)(unsigned char)name[offset];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+// Slot holding `name`, or the empty slot where it would go; `capacity` only if
+// the table is completely full.
+static uint32_t name_index_probe(const NameIndex *index, const char *name, size_t length, uint32_t hash) {
+    uint32_t slot;
+    uint32_t probes;
+
+    slot = hash & (index->capacity - 1U);
+    for (probes = 0U; probes < index->capacity; probes++) {
+        const NameIndexSlot *entry;
+
+        entry = &index->slots[slot];
+        if (!entry->name ||
+            (entry->hash == hash && entry->length == length && memcmp(entry->name, name, length) == 0)) {
+            return slot;
+        }
+        slot = (slot + 1U) & (index->capacity - 1U);
+    }
+    return index->capacity;
+}
+
+// Smallest power of two that keeps the table at most half full.
+uint32_t name_index_capacity_for(uint32_t name_count) {
+    uint32_t capacity;
+
+    capacity = 16U;
+    while (capacity < name_count * 2U) {
+        capacity *= 2U;
+    }
+    return capacity;
+}
+
+// `slots` must hold `capacity` entries, a power of two; they are cleared here.
+void name_index_init(NameIndex *index, NameIndexSlot *slots, uint32_t capacity) {
+    index->slots = slots;
+    index->capacity = capacity;
+    index->count = 0U;
+    memset(slots, 0, capacity * sizeof(*slots));
+}
+
+// Returns false for a duplicate name, an over-long name, or a full table.
+bool name_index_insert(NameIndex *index, const char *name, size_t length, uint16_t value) {
+    NameIndexSlot *entry;
+    uint32_t hash;
+    uint32_t slot;
+
+    if (!index || !name || length > UINT16_MAX || index->count >= index->capacity / 2U) {
+        return false;
+    }
+
+    hash = name_index_hash(name, length);
+    slot = name_index_probe(index, name, length, hash);
+    if (slot >= index->capacity || index->slots[slot].name) {
+        return false;
+    }
+
+    entry = &index->slots[slot];
+
+    entry->name = name;
+    entry->hash = hash;
+    entry->length = (uint16_t)length;
+    entry->value = value;
+    index->count++;
+    return true;
+}
+
+bool name_index_find(const NameIndex *index, const char *name, size_t length, uint16_t *value) {
+    uint32_t slot;
+
+    if (!index || !name || length > UINT16_MAX || index->capacity == 0U) {
+        return false;
+    }
+
+    slot = name_index_probe(index, name, length, name_index_hash(name, length));
+    if (slot >= index->capacity || !index->slots[slot].name) {
+        return false;
+    }
+    if (value) {
+        *value = index->slots[slot].value;
+    }
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const char *name; // NULL when the slot is empty; not owned
+    uint32_t hash;
+    uint16_t length;
+    uint16_t value;
+} NameIndexSlot;
+
+// Open-addressing (linear probing) map from a name to a small index. Keys are
+// (pointer, length) pairs, so both NUL-terminated names and views into a
+// larger buffer work; the caller keeps the key and slot storage alive.
+typedef struct {
+    NameIndexSlot *slots;
+    uint32_t capacity; // power of two
+    uint32_t count;
+} NameIndex;
+
+uint32_t name_index_capacity_for(uint32_t name_count);
+void name_index_init(NameIndex *index, NameIndexSlot *slots, uint32_t capacity);
+bool name_index_insert(NameIndex *index, const char *name, size_t length, uint16_t value);
+bool name_index_find(const NameIndex *index, const char *name, size_t length, uint16_t *value);
+
+#endif // NAME_INDEX_H
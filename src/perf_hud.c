@@ -0,0 +1,319 @@
+#include "perf_hud.h"
+#include "draw_util.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define PERF_HUD_WIDTH 300.0f
+#define PERF_HUD_LINE_HEIGHT 16.0f
+#define PERF_HUD_HISTOGRAM_HEIGHT 34.0f
+#define PERF_HUD_FRAME_BUDGET_MS 16.7 // 60 fps
+
+static int compare_frame_ms(const void *left, const void *right) {
+    float a;
+    float b;
+
+    a = *(const float *)left;
+    b = *(const float *)right;
+    return (a > b) - (a < b);
+}
+
+// Read at refresh time only. Linux reports the current resident set; other
+// platforms fall back to the peak, which getrusage gives in bytes on macOS.
+static uint64_t perf_hud_resident_bytes(void) {
+    struct rusage usage;
+#if defined(__linux__)
+    FILE *stream;
+    unsigned long size_pages;
+    unsigned long resident_pages;
+    long page_size;
+
+    stream = fopen("/proc/self/statm", "r");
+    if (stream) {
+        int matched;
+
+        matched = fscanf(stream, "%lu %lu", &size_pages, &resident_pages);
+        fclose(stream);
+        page_size = sysconf(_SC_PAGESIZE);
+        if (matched == 2 && page_size > 0) {
+            return (uint64_t)resident_pages * (uint64_t)page_size;
+        }
+    }
+#endif
+    if (getrusage(RUSAGE_SELF, &usage) != 0 || usage.ru_maxrss < 0) {
+        return 0U;
+    }
+#if defined(__APPLE__)
+    return (uint64_t)usage.ru_maxrss;
+#else
+    return (uint64_t)usage.ru_maxrss * 1024U;
+#endif
+}
+
+static void perf_hud_open_window(PerfHud *hud, const AppContext *app, double now) {
+    hud->window_start = now;
+    hud->window_ticks = app->perf.ticks;
+    hud->window_evaluations = app->perf.tick_evaluations;
+    hud->window_draw_calls = 0U;
+    hud->window_vertices = 0U;
+    hud->window_frames = 0U;
+}
+
+static void perf_hud_refresh(PerfHud *hud, const AppContext *app, double elapsed) {
+    PerfHudSnapshot *shown;
+    float sorted[PERF_HUD_FRAME_SAMPLES];
+    double total_ms;
+    uint64_t ticks;
+    uint32_t index;
+
+    shown = &hud->shown;
+    memset(shown->histogram, 0, sizeof(shown->histogram));
+    shown->histogram_total = hud->frame_count;
+    total_ms = 0.0;
+    for (index = 0U; index < hud->frame_count; index++) {
+        uint32_t bucket;
+
+        sorted[index] = hud->frame_ms[index];
+        total_ms += (double)hud->frame_ms[index];
+        bucket = (uint32_t)((double)hud->frame_ms[index] / PERF_HUD_BUCKET_MS);
+        if (bucket >= PERF_HUD_HISTOGRAM_BUCKETS) {
+            bucket = PERF_HUD_HISTOGRAM_BUCKETS - 1U;
+        }
+        shown->histogram[bucket]++;
+    }
+    shown->frame_avg_ms = 0.0;
+    shown->frame_p99_ms = 0.0;
+    if (hud->frame_count > 0U) {
+        qsort(sorted, hud->frame_count, sizeof(sorted[0]), compare_frame_ms);
+        shown->frame_avg_ms = total_ms / (double)hud->frame_count;
+        shown->frame_p99_ms = (double)sorted[((hud->frame_count * 99U) + 99U) / 100U - 1U];
+    }
+
+    ticks = app->perf.ticks - hud->window_ticks;
+    shown->ticks_per_second = (double)ticks / elapsed;
+    shown->requested_hz = app->simulation.active ? (double)app->simulation.speed : 0.0;
+    if (ticks > 0U) {
+        shown->evaluations_per_tick = (double)(app->perf.tick_evaluations - hud->window_evaluations) / (double)ticks;
+    }
+    shown->update_logic_ms = app->perf.update_logic_seconds * 1000.0;
+    shown->truth_table_ms = app->perf.truth_table_seconds * 1000.0;
+    shown->draw_calls = hud->window_frames > 0U ? (uint32_t)(hud->window_draw_calls / hud->window_frames) : 0U;
+    shown->vertices = hud->window_frames > 0U ? (uint32_t)(hud->window_vertices / hud->window_frames) : 0U;
+    shown->memory_bytes = perf_hud_resident_bytes();
+    mem_report(&shown->heap);
+}
+
+void perf_hud_init(PerfHud *hud) {
+    memset(hud, 0, sizeof(*hud));
+    hud->window_start = -1.0;
+}
+
+void perf_hud_end_frame(
+    PerfHud *hud,
+    const AppContext *app,
+    float frame_seconds,
+    uint32_t draw_calls,
+    uint32_t vertices,
+    double now
+) {
+    hud->frame_ms[hud->frame_cursor] = frame_seconds * 1000.0f;
+    hud->frame_cursor = (hud->frame_cursor + 1U) % PERF_HUD_FRAME_SAMPLES;
+    if (hud->frame_count < PERF_HUD_FRAME_SAMPLES) {
+        hud->frame_count++;
+    }
+
+    if (hud->window_start < 0.0) {
+        perf_hud_open_window(hud, app, now);
+        return;
+    }
+    hud->window_frames++;
+    hud->window_draw_calls += draw_calls;
+    hud->window_vertices += vertices;
+    if (now - hud->window_start < PERF_HUD_REFRESH_SECONDS) {
+        return;
+    }
+
+    perf_hud_refresh(hud, app, now - hud->window_start);
+    perf_hud_open_window(hud, app, now);
+}
+
+static void format_bytes(char *text, size_t text_size, uint64_t bytes) {
+    if (bytes >= 1024U * 1024U) {
+        snprintf(text, text_size, "%.1f MB", (double)bytes / (1024.0 * 1024.0));
+    } else if (bytes >= 1024U) {
+        snprintf(text, text_size, "%.1f KB", (double)bytes / 1024.0);
+    } else {
+        snprintf(text, text_size, "%u B", (unsigned int)bytes);
+    }
+}
+
+// Tags that have held memory; inline buffers count as always resident.
+static uint32_t heap_rows(const MemReport *heap) {
+    uint32_t rows;
+    uint32_t tag;
+
+    rows = 0U;
+    for (tag = 0U; tag < (uint32_t)MEM_TAG_COUNT; tag++) {
+        if (heap->tags[tag].allocations > 0U || heap->tags[tag].fixed_bytes > 0U) {
+            rows++;
+        }
+    }
+    return rows;
+}
+
+static void draw_heap_table(const MemReport *heap, float x, float y, Color label_color, Color value_color) {
+    char text[32];
+    uint32_t tag;
+
+    draw_text_at("by subsystem", x, y, 11, label_color);
+    draw_text_at("now", x + 100.0f, y, 10, label_color);
+    draw_text_at("peak", x + 160.0f, y, 10, label_color);
+    draw_text_at("allocs", x + 220.0f, y, 10, label_color);
+    for (tag = 0U; tag < (uint32_t)MEM_TAG_COUNT; tag++) {
+        const MemTagStats *stats;
+
+        stats = &heap->tags[tag];
+        if (stats->allocations == 0U && stats->fixed_bytes == 0U) {
+            continue;
+        }
+        y += PERF_HUD_LINE_HEIGHT;
+        draw_text_at(mem_tag_name((MemTag)tag), x + 8.0f, y, 11, label_color);
+        format_bytes(text, sizeof(text), stats->current_bytes + stats->fixed_bytes);
+        draw_text_at(text, x + 100.0f, y, 11, value_color);
+        format_bytes(text, sizeof(text), stats->peak_bytes + stats->fixed_bytes);
+        draw_text_at(text, x + 160.0f, y, 11, value_color);
+        snprintf(text, sizeof(text), "%.0f", (double)stats->allocations);
+        draw_text_at(text, x + 220.0f, y, 11, value_color);
+    }
+}
+
+static void draw_histogram(const PerfHudSnapshot *shown, Rectangle area) {
+    float bar_width;
+    uint32_t peak;
+    uint32_t bucket;
+
+    peak = 1U;
+    for (bucket = 0U; bucket < PERF_HUD_HISTOGRAM_BUCKETS; bucket++) {
+        if (shown->histogram[bucket] > peak) {
+            peak = shown->histogram[bucket];
+        }
+    }
+
+    DrawRectangleRec(area, (Color){ 20, 20, 20, 255 });
+    bar_width = area.width / (float)PERF_HUD_HISTOGRAM_BUCKETS;
+    for (bucket = 0U; bucket < PERF_HUD_HISTOGRAM_BUCKETS; bucket++) {
+        float bar_height;
+        bool over_budget;
+
+        if (shown->histogram[bucket] == 0U) {
+            continue;
+        }
+        bar_height = area.height * ((float)shown->histogram[bucket] / (float)peak);
+        if (bar_height < 1.0f) {
+            bar_height = 1.0f;
+        }
+        over_budget = ((double)(bucket + 1U) * PERF_HUD_BUCKET_MS) > PERF_HUD_FRAME_BUDGET_MS;
+        DrawRectangleRec(
+            (Rectangle){
+                area.x + ((float)bucket * bar_width) + 1.0f,
+                area.y + area.height - bar_height,
+                bar_width - 2.0f,
+                bar_height,
+            },
+            over_budget ? (Color){ 245, 185, 50, 230 } : (Color){ 90, 200, 120, 230 }
+        );
+    }
+}
+
+void perf_hud_draw(const PerfHud *hud, Rectangle canvas_rect) {
+    const PerfHudSnapshot *shown;
+    Rectangle panel;
+    Color label_color;
+    Color value_color;
+    char line[96];
+    char text[32];
+    float x;
+    float y;
+
+    shown = &hud->shown;
+    panel = (Rectangle){
+        canvas_rect.x + canvas_rect.width - PERF_HUD_WIDTH - 12.0f,
+        canvas_rect.y + 12.0f,
+        PERF_HUD_WIDTH,
+        (PERF_HUD_LINE_HEIGHT * (float)(10U + heap_rows(&shown->heap))) + PERF_HUD_HISTOGRAM_HEIGHT + 38.0f,
+    };
+    if (panel.x < canvas_rect.x) {
+        panel.x = canvas_rect.x;
+    }
+    DrawRectangleRounded(panel, 0.06f, 8, (Color){ 30, 30, 30, 225 });
+    DrawRectangleRoundedLinesEx(panel, 0.06f, 8, 1.0f, (Color){ 80, 80, 80, 255 });
+
+    label_color = (Color){ 150, 150, 150, 255 };
+    value_color = (Color){ 220, 220, 220, 255 };
+    x = panel.x + 14.0f;
+    y = panel.y + 12.0f;
+    draw_text_at("PERFORMANCE", x, y, 12, (Color){ 240, 240, 240, 255 });
+    draw_text_at("F3 to hide", panel.x + panel.width - 76.0f, y, 11, label_color);
+    y += PERF_HUD_LINE_HEIGHT + 4.0f;
+
+    snprintf(line, sizeof(line), "%.2f ms avg   %.2f ms p99", shown->frame_avg_ms, shown->frame_p99_ms);
+    draw_text_at("frame", x, y, 11, label_color);
+    draw_text_at(line, x + 78.0f, y, 11, value_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    draw_histogram(shown, (Rectangle){ x, y, panel.width - 28.0f, PERF_HUD_HISTOGRAM_HEIGHT });
+    y += PERF_HUD_HISTOGRAM_HEIGHT + 2.0f;
+    draw_text_at("0", x, y, 10, label_color);
+    snprintf(line, sizeof(line), "%.0f+ ms", (double)(PERF_HUD_HISTOGRAM_BUCKETS - 1U) * PERF_HUD_BUCKET_MS);
+    draw_text_at(line, x + panel.width - 28.0f - text_width(line, 10), y, 10, label_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    if (shown->requested_hz > 0.0) {
+        snprintf(line, sizeof(line), "%.1f of %.0f ticks/s", shown->ticks_per_second, shown->requested_hz);
+    } else {
+        snprintf(line, sizeof(line), "stopped");
+    }
+    draw_text_at("simulation", x, y, 11, label_color);
+    draw_text_at(line, x + 78.0f, y, 11, value_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "%.0f node evaluations", shown->evaluations_per_tick);
+    draw_text_at("per tick", x, y, 11, label_color);
+    draw_text_at(line, x + 78.0f, y, 11, value_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "%.2f ms", shown->update_logic_ms);
+    draw_text_at("update", x, y, 11, label_color);
+    draw_text_at(line, x + 78.0f, y, 11, value_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "%.2f ms", shown->truth_table_ms);
+    draw_text_at("truth table", x, y, 11, label_color);
+    draw_text_at(line, x + 78.0f, y, 11, value_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    snprintf(line, sizeof(line), "%u calls   %u vertices", shown->draw_calls, shown->vertices);
+    draw_text_at("draw", x, y, 11, label_color);
+    draw_text_at(line, x + 78.0f, y, 11, value_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    if (shown->memory_bytes > 0U) {
+        snprintf(line, sizeof(line), "%.1f MB resident", (double)shown->memory_bytes / (1024.0 * 1024.0));
+    } else {
+        snprintf(line, sizeof(line), "unavailable");
+    }
+    draw_text_at("memory", x, y, 11, label_color);
+    draw_text_at(line, x + 78.0f, y, 11, value_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    format_bytes(line, sizeof(line), shown->heap.current_bytes);
+    format_bytes(text, sizeof(text), shown->heap.peak_bytes);
+    snprintf(line + strlen(line), sizeof(line) - strlen(line), " now, %s peak", text);
+    draw_text_at("heap", x, y, 11, label_color);
+    draw_text_at(line, x + 78.0f, y, 11, value_color);
+    y += PERF_HUD_LINE_HEIGHT;
+
+    draw_heap_table(&shown->heap, x, y, label_color, value_color);
+}
@@ -0,0 +1,65 @@
+#ifndef PERF_HUD_H
+#define PERF_HUD_H
+
+#include "app.h"
+#include "mem.h"
+
+#define PERF_HUD_FRAME_SAMPLES 240U // about 4 s at 60 fps
+#define PERF_HUD_HISTOGRAM_BUCKETS 12U
+#define PERF_HUD_BUCKET_MS 4.0 // the last bucket collects everything slower
+#define PERF_HUD_REFRESH_SECONDS 0.25
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wpadded"
+#endif
+
+// What the overlay shows, recomputed once per refresh window so the numbers
+// stay readable.
+typedef struct {
+    double frame_avg_ms;
+    double frame_p99_ms;
+    double ticks_per_second; // achieved over the last window
+    double requested_hz; // simulation.speed while running, else 0
+    double evaluations_per_tick;
+    double update_logic_ms;
+    double truth_table_ms;
+    uint64_t memory_bytes; // resident set size, 0 where unavailable
+    MemReport heap; // tagged allocations, see mem.h
+    uint32_t draw_calls; // per frame, averaged over the window
+    uint32_t vertices;
+    uint32_t histogram[PERF_HUD_HISTOGRAM_BUCKETS]; // over the last PERF_HUD_FRAME_SAMPLES frames
+    uint32_t histogram_total;
+} PerfHudSnapshot;
+
+typedef struct {
+    PerfHudSnapshot shown;
+    float frame_ms[PERF_HUD_FRAME_SAMPLES];
+    uint32_t frame_cursor;
+    uint32_t frame_count;
+    double window_start;
+    uint64_t window_ticks; // app->perf totals when the window opened
+    uint64_t window_evaluations;
+    uint64_t window_draw_calls;
+    uint64_t window_vertices;
+    uint32_t window_frames;
+} PerfHud;
+
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+void perf_hud_init(PerfHud *hud);
+// Call once per frame after EndDrawing; refreshes `shown` every
+// PERF_HUD_REFRESH_SECONDS of `now`.
+void perf_hud_end_frame(
+    PerfHud *hud,
+    const AppContext *app,
+    float frame_seconds,
+    uint32_t draw_calls,
+    uint32_t vertices,
+    double now
+);
+void perf_hud_draw(const PerfHud *hud, Rectangle canvas_rect);
+
+#endif // PERF_HUD_H
@@ -0,0 +1,425 @@
+#include "sim_cli.h"
+#include "circuit_file.h"
+#include "logic.h"
+#include "logic_activity.h"
+#include "logic_stimulus.h"
+#include "mem.h"
+#include "text_util.h"
+#include "trace.h"
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIM_CLI_TRUTH_TABLE_MAX_INPUTS MAX_PINS
+#define SIM_CLI_BATCH_SAMPLES 4096U
+#define SIM_CLI_ACTIVITY_TOP 10U
+
+// Probes are the playback's: every input and clock (the "drivers"), then
+// every output, in graph order. `last` holds what VCD output last reported
+// for each.
+typedef struct {
+    LogicGraph *graph;
+    FILE *stream;
+    LogicActivity *activity; // NULL unless profiling
+    LogicStimulusRun playback;
+    LogicValue last[MAX_NODES];
+    uint32_t step;
+    SimCliFormat format;
+} SimCliRun;
+
+static char sim_cli_value_char(LogicValue value, bool vcd) {
+    switch (value) {
+        case LOGIC_LOW:
+            return '0';
+        case LOGIC_HIGH:
+            return '1';
+        case LOGIC_UNKNOWN:
+            return vcd ? 'x' : 'X';
+        case LOGIC_ERROR:
+            return vcd ? 'x' : 'E';
+        default:
+            return '?';
+    }
+}
+
+static const char *sim_cli_probe_name(const LogicNode *node) {
+    return node->name ? node->name : "?";
+}
+
+// VCD identifiers: base-94 over the printable range starting at '!'.
+static void sim_cli_vcd_id(uint32_t index, char *id, size_t id_size) {
+    size_t length;
+
+    length = 0U;
+    do {
+        if (length + 1U < id_size) {
+            id[length++] = (char)('!' + (index % 94U));
+        }
+        index /= 94U;
+    } while (index > 0U);
+    id[length] = '\0';
+}
+
+static const char *sim_cli_probe_label(const SimCliRun *run, uint32_t probe) {
+    return sim_cli_probe_name(&run->graph->nodes[run->playback.probes[probe]]);
+}
+
+static void sim_cli_write_header(SimCliRun *run, const char *circuit_path) {
+    uint32_t index;
+    char id[8];
+
+    if (run->format == SIM_CLI_FORMAT_VCD) {
+        fprintf(run->stream, "$comment %s $end\n", circuit_path);
+        fprintf(run->stream, "$timescale 1 ns $end\n");
+        fprintf(run->stream, "$scope module top $end\n");
+        for (index = 0U; index < run->playback.probe_count; index++) {
+            sim_cli_vcd_id(index, id, sizeof(id));
+            fprintf(run->stream, "$var wire 1 %s %s $end\n", id, sim_cli_probe_label(run, index));
+        }
+        fprintf(run->stream, "$upscope $end\n$enddefinitions $end\n");
+        return;
+    }
+
+    fprintf(run->stream, "step");
+    for (index = 0U; index < run->playback.probe_count; index++) {
+        fprintf(run->stream, "%s %s", index == run->playback.driver_count ? " |" : "", sim_cli_probe_label(run, index));
+    }
+    fputc('\n', run->stream);
+}
+
+// Reports one sample row (probe_count values) as time `run->step`, then
+// moves to the next.
+static void sim_cli_sample(SimCliRun *run, const uint8_t *row) {
+    uint32_t index;
+    char id[8];
+
+    if (run->format == SIM_CLI_FORMAT_VCD) {
+        fprintf(run->stream, "#%u\n", run->step);
+        for (index = 0U; index < run->playback.probe_count; index++) {
+            LogicValue value;
+
+            value = (LogicValue)row[index];
+            if (run->step > 0U && sim_cli_value_char(value, true) == sim_cli_value_char(run->last[index], true)) {
+                continue;
+            }
+            run->last[index] = value;
+            sim_cli_vcd_id(index, id, sizeof(id));
+            fprintf(run->stream, "%c%s\n", sim_cli_value_char(value, true), id);
+        }
+        run->step++;
+        return;
+    }
+
+    fprintf(run->stream, "%4u", run->step);
+    for (index = 0U; index < run->playback.probe_count; index++) {
+        fprintf(
+            run->stream,
+            "%s %*c",
+            index == run->playback.driver_count ? " |" : "",
+            (int)strlen(sim_cli_probe_label(run, index)),
+            sim_cli_value_char((LogicValue)row[index], false)
+        );
+    }
+    fputc('\n', run->stream);
+    run->step++;
+}
+
+// Step 0 is the settled state before any stimulus.
+static void sim_cli_sample_graph(SimCliRun *run, uint8_t *row) {
+    uint32_t index;
+
+    for (index = 0U; index < run->playback.probe_count; index++) {
+        const LogicNode *node;
+
+        node = &run->graph->nodes[run->playback.probes[index]];
+        row[index] = (uint8_t)(node->type == NODE_OUTPUT ? node->inputs[0].value : node->outputs[0].value);
+    }
+    sim_cli_sample(run, row);
+}
+
+static bool sim_cli_parse_count(const char *text, uint32_t *count) {
+    char *end;
+    unsigned long value;
+
+    if (text[0] < '0' || text[0] > '9') {
+        return false;
+    }
+    value = strtoul(text, &end, 10);
+    if (*end != '\0' || value > UINT32_MAX) {
+        return false;
+    }
+    *count = (uint32_t)value;
+    return true;
+}
+
+static bool sim_cli_play(SimCliRun *run, const LogicStimulus *stimulus, const char *circuit_path, char *error_message, size_t error_message_size) {
+    uint8_t *rows;
+    uint32_t produced;
+    uint32_t sample;
+    uint32_t index;
+
+    logic_stimulus_run_init(&run->playback, run->graph, stimulus);
+    rows = (uint8_t *)mem_alloc(MEM_TAG_SIMULATION, (size_t)SIM_CLI_BATCH_SAMPLES * (run->playback.probe_count + 1U));
+    if (!rows) {
+        set_error(error_message, error_message_size, "out of memory", 0U);
+        return false;
+    }
+
+    for (index = 0U; index < run->playback.driver_count; index++) {
+        LogicNode *node;
+
+        node = &run->graph->nodes[run->playback.probes[index]];
+        if (node->type == NODE_INPUT) {
+            node->outputs[0].value = LOGIC_LOW;
+        }
+    }
+    logic_evaluate(run->graph);
+    sim_cli_write_header(run, circuit_path);
+    sim_cli_sample_graph(run, rows);
+
+    logic_activity_attach(run->graph, run->activity);
+    do {
+        produced = logic_apply_stimulus_batch(&run->playback, rows, SIM_CLI_BATCH_SAMPLES);
+        for (sample = 0U; sample < produced; sample++) {
+            sim_cli_sample(run, rows + ((size_t)sample * run->playback.probe_count));
+        }
+    } while (produced > 0U);
+    logic_activity_attach(run->graph, NULL);
+
+    mem_free(rows);
+    return true;
+}
+
+// The busiest nodes first, so hot cones and glitching logic stand out.
+static void sim_cli_write_activity(const LogicGraph *graph, const LogicActivity *activity, FILE *stream) {
+    LogicActivitySummary summary;
+    bool listed[MAX_NODES];
+    uint32_t rank;
+
+    logic_activity_summarize(graph, activity, &summary);
+    fprintf(
+        stream,
+        "activity: %" PRIu64 " evaluations over %" PRIu64 " passes, %.1f%% changed a value, %u of %u evaluated nodes idle\n",
+        summary.evaluations,
+        activity->passes,
+        summary.activity_factor * 100.0,
+        summary.idle_nodes,
+        summary.active_nodes
+    );
+    fprintf(stream, "  (the lower the share that changes, the more an event-driven simulator would skip)\n");
+    fprintf(stream, "%-16s %12s %12s %10s\n", "node", "evaluations", "toggles", "est. us");
+
+    memset(listed, 0, sizeof(listed));
+    for (rank = 0U; rank < SIM_CLI_ACTIVITY_TOP; rank++) {
+        const LogicNodeActivity *best;
+        uint32_t best_index;
+        uint32_t index;
+
+        best = NULL;
+        best_index = 0U;
+        for (index = 0U; index < graph->node_count; index++) {
+            const LogicNodeActivity *node;
+
+            node = &activity->nodes[index];
+            if (listed[index] || graph->nodes[index].type == (NodeType)-1 || node->evaluations == 0U) {
+                continue;
+            }
+            if (!best || node->toggles > best->toggles) {
+                best = node;
+                best_index = index;
+            }
+        }
+        if (!best) {
+            break;
+        }
+        listed[best_index] = true;
+        fprintf(
+            stream,
+            "%-16s %12" PRIu64 " %12" PRIu64 " %10.1f\n",
+            sim_cli_probe_name(&graph->nodes[best_index]),
+            best->evaluations,
+            best->toggles,
+            logic_activity_node_seconds(activity, best_index) * 1e6
+        );
+    }
+}
+
+static bool sim_cli_write_truth_table(LogicGraph *graph, FILE *stream, char *error_message, size_t error_message_size) {
+    TruthTable *table;
+    uint32_t input_count;
+    uint32_t row;
+    uint32_t column;
+    uint32_t column_count;
+    uint32_t index;
+
+    input_count = 0U;
+    for (index = 0U; index < graph->node_count; index++) {
+        if (graph->nodes[index].type == NODE_INPUT) {
+            input_count++;
+        }
+    }
+    if (input_count > SIM_CLI_TRUTH_TABLE_MAX_INPUTS) {
+        set_error(error_message, error_message_size, "truth tables are limited to 8 inputs", 0U);
+        return false;
+    }
+
+    table = logic_generate_truth_table(graph);
+    if (!table) {
+        set_error(error_message, error_message_size, "out of memory", 0U);
+        return false;
+    }
+
+    column_count = (uint32_t)table->input_count + (uint32_t)table->output_count;
+    for (column = 0U; column < column_count; column++) {
+        const LogicNode *node;
+
+        node = column < table->input_count ? table->inputs[column] : table->outputs[column - table->input_count];
+        fprintf(stream, "%s%s", column == 0U ? "" : (column == table->input_count ? " | " : " "), sim_cli_probe_name(node));
+    }
+    fputc('\n', stream);
+    for (row = 0U; row < table->row_count; row++) {
+        for (column = 0U; column < column_count; column++) {
+            const LogicNode *node;
+
+            node = column < table->input_count ? table->inputs[column] : table->outputs[column - table->input_count];
+            fprintf(
+                stream,
+                "%s%*c",
+                column == 0U ? "" : (column == table->input_count ? " | " : " "),
+                (int)strlen(sim_cli_probe_name(node)),
+                sim_cli_value_char(table->data[(row * column_count) + column], false)
+            );
+        }
+        fputc('\n', stream);
+    }
+
+    logic_free_truth_table(table);
+    return true;
+}
+
+bool sim_cli_run(const SimCliOptions *options, FILE *stream, char *error_message, size_t error_message_size) {
+    LogicStimulus stimulus;
+    SimCliRun *run;
+    bool ok;
+
+    if (!options || !options->circuit_path || !stream) {
+        set_error(error_message, error_message_size, "missing circuit or output", 0U);
+        return false;
+    }
+
+    run = (SimCliRun *)mem_calloc(MEM_TAG_OTHER, 1U, sizeof(*run));
+    if (!run) {
+        set_error(error_message, error_message_size, "out of memory", 0U);
+        return false;
+    }
+    run->graph = (LogicGraph *)mem_calloc(MEM_TAG_GRAPH, 1U, sizeof(*run->graph));
+    if (!run->graph) {
+        mem_free(run);
+        set_error(error_message, error_message_size, "out of memory", 0U);
+        return false;
+    }
+    run->stream = stream;
+    run->format = options->format;
+
+    logic_init_graph(run->graph);
+    ok = circuit_file_load_graph(run->graph, options->circuit_path, error_message, error_message_size);
+    if (ok && options->format == SIM_CLI_FORMAT_TABLE) {
+        ok = sim_cli_write_truth_table(run->graph, stream, error_message, error_message_size);
+    } else if (ok) {
+        if (options->stimulus_path) {
+            ok = logic_stimulus_load(&stimulus, run->graph, options->stimulus_path, error_message, error_message_size);
+        } else {
+            char ticks[32];
+            int length;
+
+            length = snprintf(ticks, sizeof(ticks), "tick %u\n", options->ticks);
+            ok = logic_stimulus_parse(&stimulus, run->graph, ticks, (size_t)length, error_message, error_message_size);
+        }
+        if (ok && options->activity_stream) {
+            run->activity = (LogicActivity *)mem_alloc(MEM_TAG_SIMULATION, sizeof(*run->activity));
+            if (run->activity) {
+                logic_activity_reset(run->activity, LOGIC_ACTIVITY_SAMPLE_INTERVAL);
+            } else {
+                logic_stimulus_release(&stimulus);
+                set_error(error_message, error_message_size, "out of memory", 0U);
+                ok = false;
+            }
+        }
+        if (ok) {
+            ok = sim_cli_play(run, &stimulus, options->circuit_path, error_message, error_message_size);
+            logic_stimulus_release(&stimulus);
+        }
+        if (ok && run->activity) {
+            sim_cli_write_activity(run->graph, run->activity, options->activity_stream);
+        }
+    }
+
+    logic_clear_graph(run->graph);
+    mem_free(run->activity);
+    mem_free(run->graph);
+    mem_free(run);
+    // Only the trace rings outlive the run; any other current bytes are a leak.
+    if (options->memory_stream) {
+        mem_write_report(options->memory_stream);
+    }
+    return ok;
+}
+
+static void sim_cli_usage(void) {
+    fprintf(stderr, "usage: logicsim-cli CIRCUIT [--stimulus FILE | --ticks N] [--table | --vcd] [--activity] [--memory] [--trace FILE]\n");
+    fprintf(stderr, "  --activity reports per-node evaluations and toggles on stderr after the run\n");
+    fprintf(stderr, "  --memory reports current and peak allocations per subsystem on stderr after the run\n");
+    fprintf(stderr, "  prints one line of input, clock and output values per step by default\n");
+}
+
+int sim_cli_main(int argc, char **argv) {
+    SimCliOptions options;
+    const char *trace_path;
+    char error_message[256];
+    int arg;
+
+    memset(&options, 0, sizeof(options));
+    options.format = SIM_CLI_FORMAT_OUTPUTS;
+    trace_path = NULL;
+    for (arg = 1; arg < argc; arg++) {
+        if (strcmp(argv[arg], "--stimulus") == 0 && arg + 1 < argc) {
+            options.stimulus_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--ticks") == 0 && arg + 1 < argc) {
+            if (!sim_cli_parse_count(argv[arg + 1], &options.ticks)) {
+                sim_cli_usage();
+                return 2;
+            }
+            arg++;
+        } else if (strcmp(argv[arg], "--trace") == 0 && arg + 1 < argc) {
+            trace_path = argv[++arg];
+        } else if (strcmp(argv[arg], "--activity") == 0) {
+            options.activity_stream = stderr;
+        } else if (strcmp(argv[arg], "--memory") == 0) {
+            options.memory_stream = stderr;
+        } else if (strcmp(argv[arg], "--table") == 0) {
+            options.format = SIM_CLI_FORMAT_TABLE;
+        } else if (strcmp(argv[arg], "--vcd") == 0) {
+            options.format = SIM_CLI_FORMAT_VCD;
+        } else if (argv[arg][0] == '-' || options.circuit_path) {
+            sim_cli_usage();
+            return 2;
+        } else {
+            options.circuit_path = argv[arg];
+        }
+    }
+
+    if (!options.circuit_path) {
+        sim_cli_usage();
+        return 2;
+    }
+    trace_set_thread_name("main");
+    if (!sim_cli_run(&options, stdout, error_message, sizeof(error_message))) {
+        fprintf(stderr, "logicsim-cli: %s\n", error_message);
+        return 1;
+    }
+    if (trace_path && !trace_save(trace_path, error_message, sizeof(error_message))) {
+        fprintf(stderr, "logicsim-cli: %s\n", error_message);
+        return 1;
+    }
+    return 0;
+}
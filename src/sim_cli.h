@@ -0,0 +1,29 @@
+#ifndef SIM_CLI_H
+#define SIM_CLI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum {
+    SIM_CLI_FORMAT_OUTPUTS, // one line of probe values per step
+    SIM_CLI_FORMAT_TABLE, // exhaustive truth table, no simulation
+    SIM_CLI_FORMAT_VCD
+} SimCliFormat;
+
+typedef struct {
+    const char *circuit_path;
+    const char *stimulus_path; // NULL runs `ticks` clock ticks with every input low
+    FILE *activity_stream; // non-NULL profiles per-node activity during the run and reports it here
+    FILE *memory_stream; // non-NULL writes the tagged allocation report (mem.h) here after the run
+    uint32_t ticks;
+    SimCliFormat format;
+} SimCliOptions;
+
+// Windowless simulation for scripts and regression runs. Inputs start low;
+// the stimulus format is described in logic_stimulus.h.
+bool sim_cli_run(const SimCliOptions *options, FILE *stream, char *error_message, size_t error_message_size);
+int sim_cli_main(int argc, char **argv);
+
+#endif // SIM_CLI_H
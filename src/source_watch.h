@@ -1,21 +1,61 @@
 #ifndef SOURCE_WATCH_H
 #define SOURCE_WATCH_H
 
+#include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <sys/types.h>
 #include <time.h>
 #include "app.h"
 
+// What a change looks like from stat(): nanosecond mtime, size and inode (an
+// atomic rename-over save swaps the inode even when the rest matches).
+typedef struct {
+    int64_t modified_seconds;
+    int64_t modified_nanoseconds;
+    int64_t size;
+    uint64_t inode;
+} SourceWatchStamp;
+
+// On Linux a thread blocks on inotify for the file's directory and flags the
+// main loop, so an idle frame makes no syscalls. Elsewhere, or if inotify is
+// unavailable, the file is stat()ed every SOURCE_WATCH_POLL_MS.
+//
+// A finished background load: the graph and where its nodes sit.
+typedef struct {
+    LogicGraph graph;
+    GraphGeometry geometry;
+} SourceWatchLoad;
+
+// Reloads are parsed, laid out and built into a fresh graph on a loader
+// thread; the main loop swaps the result in at the start of a later frame.
+// Each change bumps `requested_generation`, and a load that finishes for an
+// older generation is thrown away and restarted.
 typedef struct {
     char path[APP_SOURCE_PATH_MAX];
-    time_t modified_time;
-    off_t size;
+    char load_error[APP_STATUS_MESSAGE_MAX];
+    SourceWatchStamp stamp;
+    pthread_mutex_t lock;
+    pthread_t thread;
+    pthread_t loader;
+    SourceWatchLoad *loaded; // finished load waiting to be swapped in, NULL if it failed
+    double next_poll_ms;
+    int notify_fd; // -1 when polling
+    int stop_pipe[2];
+    uint32_t name_offset; // file name within path, matched against directory events
+    uint32_t requested_generation;
+    uint32_t loaded_generation;
     bool active;
-    uint8_t _padding[7];
+    bool threaded;
+    bool pending; // set by the watcher thread, under lock
+    bool loading; // loader thread running or not yet joined
+    bool load_done; // loader has published a result, under lock
+    uint8_t _padding[3];
 } SourceWatch;
 
 void source_watch_init(SourceWatch *watch);
 bool source_watch_start(SourceWatch *watch, const char *path);
+void source_watch_stop(SourceWatch *watch);
 bool source_watch_load_circuit(AppContext *app, const char *path, const char *status, Rectangle canvas_rect);
 bool source_watch_reload_if_changed(SourceWatch *watch, AppContext *app, Rectangle canvas_rect);
 const char *source_watch_parse_load_path(int argc, char **argv);
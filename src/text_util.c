@@ -0,0 +1,25 @@
+#include "text_util.h"
+#include <stdio.h>
+#include <string.h>
+
+void set_error(char *error_message, size_t error_message_size, const char *message, unsigned int line_number) {
+    if (!error_message || error_message_size == 0U) {
+        return;
+    }
+
+    if (line_number == 0U) {
+        snprintf(error_message, error_message_size, "%s", message);
+        return;
+    }
+
+    snprintf(error_message, error_message_size, "Line %u: %s", line_number, message);
+}
+
+bool path_has_suffix(const char *path, const char *suffix) {
+    size_t path_length;
+    size_t suffix_length;
+
+    path_length = strlen(path);
+    suffix_length = strlen(suffix);
+    return path_length >= suffix_length && strcmp(path + path_length - suffix_length, suffix) == 0;
+}
@@ -0,0 +1,14 @@
+#ifndef TEXT_UTIL_H
+#define TEXT_UTIL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Helpers the loaders, writers and command-line front ends share.
+
+// Formats `message` into the caller's buffer, as "Line N: message" when
+// `line_number` is not 0. NULL or empty buffers are left alone.
+void set_error(char *error_message, size_t error_message_size, const char *message, unsigned int line_number);
+bool path_has_suffix(const char *path, const char *suffix);
+
+#endif // TEXT_UTIL_H
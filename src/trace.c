@@ -0,0 +1,224 @@
+#include "trace.h"
+#include "mem.h"
+#include "text_util.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct {
+    const char *name;
+    uint64_t start_ns; // since trace_epoch_ns
+    uint64_t duration_ns;
+} TraceEvent;
+
+// Written only by the owning thread. `head` counts every event ever closed
+// and is published with release order after the event it covers, so a reader
+// that loads it with acquire order sees complete events below it. The owner
+// may lap the ring while a dump reads it; the dump re-reads `head` after each
+// copy, seqlock style, and drops any slot that was reused meanwhile.
+typedef struct {
+    TraceEvent events[TRACE_RING_EVENTS];
+    const char *open_names[TRACE_MAX_DEPTH];
+    uint64_t open_starts[TRACE_MAX_DEPTH];
+    const char *thread_name;
+    uint64_t head;
+    uint32_t depth;
+    uint32_t tid;
+    // Owned by a live thread. Once its thread exits a ring is kept for the
+    // dump until another thread takes it, which clears it first: the events
+    // carry no thread of their own.
+    bool in_use;
+    uint8_t _padding[7];
+} TraceRing;
+
+static TraceRing *trace_rings[TRACE_MAX_THREADS];
+static pthread_mutex_t trace_registry_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t trace_once = PTHREAD_ONCE_INIT;
+static pthread_key_t trace_key;
+static bool trace_key_ready;
+static uint64_t trace_epoch_ns;
+static char trace_untraced; // thread-specific value of threads that found no free ring
+
+static uint64_t trace_now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return ((uint64_t)now.tv_sec * 1000000000ULL) + (uint64_t)now.tv_nsec;
+}
+
+static void trace_release_ring(void *value) {
+    if (value == &trace_untraced) {
+        return;
+    }
+    pthread_mutex_lock(&trace_registry_lock);
+    ((TraceRing *)value)->in_use = false;
+    pthread_mutex_unlock(&trace_registry_lock);
+}
+
+static void trace_init(void) {
+    trace_epoch_ns = trace_now_ns();
+    trace_key_ready = pthread_key_create(&trace_key, trace_release_ring) == 0;
+}
+
+// The registry lock is only taken the first time a thread records, never
+// per zone.
+static TraceRing *trace_thread_ring(void) {
+    TraceRing *ring;
+    void *value;
+    uint32_t index;
+
+    pthread_once(&trace_once, trace_init);
+    if (!trace_key_ready) {
+        return NULL;
+    }
+    value = pthread_getspecific(trace_key);
+    if (value) {
+        return value == &trace_untraced ? NULL : (TraceRing *)value;
+    }
+
+    ring = NULL;
+    pthread_mutex_lock(&trace_registry_lock);
+    for (index = 0U; index < TRACE_MAX_THREADS && !ring; index++) {
+        if (!trace_rings[index]) {
+            trace_rings[index] = (TraceRing *)mem_calloc(MEM_TAG_TRACE, 1U, sizeof(TraceRing));
+            if (!trace_rings[index]) {
+                break;
+            }
+            trace_rings[index]->tid = index + 1U;
+        } else if (trace_rings[index]->in_use) {
+            continue;
+        }
+        ring = trace_rings[index];
+        ring->in_use = true;
+        ring->depth = 0U;
+        __atomic_store_n(&ring->thread_name, NULL, __ATOMIC_RELEASE);
+        __atomic_store_n(&ring->head, 0U, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&trace_registry_lock);
+
+    pthread_setspecific(trace_key, ring ? (void *)ring : (void *)&trace_untraced);
+    return ring;
+}
+
+void trace_begin(const char *name) {
+    TraceRing *ring;
+
+    ring = trace_thread_ring();
+    if (!ring) {
+        return;
+    }
+    if (ring->depth < TRACE_MAX_DEPTH) {
+        ring->open_names[ring->depth] = name;
+        ring->open_starts[ring->depth] = trace_now_ns();
+    }
+    ring->depth++;
+}
+
+void trace_end(void) {
+    TraceRing *ring;
+    TraceEvent *event;
+
+    ring = trace_thread_ring();
+    if (!ring || ring->depth == 0U) {
+        return;
+    }
+    ring->depth--;
+    if (ring->depth >= TRACE_MAX_DEPTH) {
+        return;
+    }
+    // The fence keeps a dump that sees any of these stores from missing the
+    // `head` that marked the slot as being reused.
+    event = &ring->events[ring->head & (TRACE_RING_EVENTS - 1U)];
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&event->name, ring->open_names[ring->depth], __ATOMIC_RELAXED);
+    __atomic_store_n(&event->start_ns, ring->open_starts[ring->depth] - trace_epoch_ns, __ATOMIC_RELAXED);
+    __atomic_store_n(&event->duration_ns, trace_now_ns() - ring->open_starts[ring->depth], __ATOMIC_RELAXED);
+    __atomic_store_n(&ring->head, ring->head + 1U, __ATOMIC_RELEASE);
+}
+
+void trace_set_thread_name(const char *name) {
+    TraceRing *ring;
+
+    ring = trace_thread_ring();
+    if (ring) {
+        __atomic_store_n(&ring->thread_name, name, __ATOMIC_RELEASE);
+    }
+}
+
+// Complete ("X") events in microseconds, plus a thread_name record per ring.
+// A wrapped ring is read from its newest half only, leaving the owner half a
+// ring of headroom before it overwrites a slot the dump has yet to copy.
+bool trace_write_chrome_json(FILE *stream) {
+    bool first;
+    uint32_t index;
+
+    first = true;
+    fprintf(stream, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    pthread_mutex_lock(&trace_registry_lock);
+    for (index = 0U; index < TRACE_MAX_THREADS; index++) {
+        TraceRing *ring;
+        const char *thread_name;
+        uint64_t head;
+        uint64_t event_index;
+
+        ring = trace_rings[index];
+        if (!ring) {
+            continue;
+        }
+        thread_name = __atomic_load_n(&ring->thread_name, __ATOMIC_ACQUIRE);
+        fprintf(
+            stream,
+            "%s{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"%s\"}}",
+            first ? "" : ",\n",
+            ring->tid,
+            thread_name ? thread_name : "thread"
+        );
+        first = false;
+
+        head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        event_index = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS / 2U : 0U;
+        for (; event_index < head; event_index++) {
+            TraceEvent *slot;
+            TraceEvent event;
+
+            slot = &ring->events[event_index & (TRACE_RING_EVENTS - 1U)];
+            event.name = __atomic_load_n(&slot->name, __ATOMIC_RELAXED);
+            event.start_ns = __atomic_load_n(&slot->start_ns, __ATOMIC_RELAXED);
+            event.duration_ns = __atomic_load_n(&slot->duration_ns, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&ring->head, __ATOMIC_RELAXED) >= event_index + TRACE_RING_EVENTS) {
+                continue; // the owner has started reusing this slot
+            }
+            fprintf(
+                stream,
+                ",\n{\"name\": \"%s\", \"cat\": \"logicsim\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                event.name,
+                ring->tid,
+                (double)event.start_ns / 1000.0,
+                (double)event.duration_ns / 1000.0
+            );
+        }
+    }
+    pthread_mutex_unlock(&trace_registry_lock);
+    fprintf(stream, "\n]}\n");
+    return !ferror(stream);
+}
+
+bool trace_save(const char *path, char *error_message, size_t error_message_size) {
+    FILE *stream;
+    bool saved;
+
+    stream = fopen(path, "w");
+    if (!stream) {
+        set_error(error_message, error_message_size, "could not open trace file", 0U);
+        return false;
+    }
+    saved = trace_write_chrome_json(stream);
+    if (fclose(stream) != 0) {
+        saved = false;
+    }
+    if (!saved) {
+        set_error(error_message, error_message_size, "could not write trace file", 0U);
+    }
+    return saved;
+}
@@ -0,0 +1,41 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Scoped timing zones for finding stutters, dumped as Chrome trace JSON that
+// opens in Perfetto (ui.perfetto.dev) or chrome://tracing. Build with
+// LOGICSIM_TRACE=0 (make TRACE=0) and the zones compile away entirely.
+#ifndef LOGICSIM_TRACE
+#define LOGICSIM_TRACE 1
+#endif
+
+#define TRACE_RING_EVENTS 8192U // per thread, power of two; the oldest are overwritten
+#define TRACE_MAX_THREADS 16U // threads past this many live at once go untraced
+#define TRACE_MAX_DEPTH 32U // deeper zones are timed by their parents only
+
+// Every TRACE_BEGIN needs a TRACE_END on the same thread before the function
+// returns. Names must outlive the dump, so pass string literals.
+#if LOGICSIM_TRACE
+#define TRACE_BEGIN(name) trace_begin(name)
+#define TRACE_END() trace_end()
+#else
+#define TRACE_BEGIN(name) ((void)0)
+#define TRACE_END() ((void)0)
+#endif
+
+void trace_begin(const char *name);
+void trace_end(void);
+void trace_set_thread_name(const char *name);
+
+// Closed zones still in the rings, oldest first per thread; a ring that has
+// wrapped gives only its newest TRACE_RING_EVENTS / 2. An exited thread's
+// zones last until a new thread reuses its ring. Threads keep recording while
+// this runs, and a zone they overwrite before it is copied is left out.
+bool trace_write_chrome_json(FILE *stream);
+bool trace_save(const char *path, char *error_message, size_t error_message_size);
+
+#endif // TRACE_H
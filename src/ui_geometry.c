@@ -53,26 +53,32 @@ static float ui_point_segment_distance(Vector2 point, Vector2 start, Vector2 end
     return sqrtf((dx * dx) + (dy * dy));
 }
 
-Vector2 ui_input_pin_position(const LogicPin *pin) {
+Vector2 ui_input_pin_position(const AppContext *app, const LogicPin *pin) {
+    Vector2 position;
+
+    position = app_node_position(app, pin->node);
     return (Vector2){
-        pin->node->pos.x,
-        pin->node->pos.y + app_node_pin_offset_y(pin->node, false, pin->index)
+        position.x,
+        position.y + app_node_pin_offset_y(pin->node, false, pin->index)
     };
 }
 
-Vector2 ui_output_pin_position(const LogicPin *pin) {
+Vector2 ui_output_pin_position(const AppContext *app, const LogicPin *pin) {
+    Rectangle rect;
+
+    rect = app_node_rect(app, pin->node);
     return (Vector2){
-        pin->node->pos.x + pin->node->rect.width,
-        pin->node->pos.y + app_node_pin_offset_y(pin->node, true, pin->index)
+        rect.x + rect.width,
+        rect.y + app_node_pin_offset_y(pin->node, true, pin->index)
     };
 }
 
-Vector2 ui_pin_position(const LogicPin *pin) {
+Vector2 ui_pin_position(const AppContext *app, const LogicPin *pin) {
     if (pin->index < pin->node->input_count && &pin->node->inputs[pin->index] == pin) {
-        return ui_input_pin_position(pin);
+        return ui_input_pin_position(app, pin);
     }
 
-    return ui_output_pin_position(pin);
+    return ui_output_pin_position(app, pin);
 }
 
 UiWirePath ui_orthogonal_wire_path(Vector2 start, Vector2 end) {
@@ -103,16 +109,16 @@ float ui_point_to_wire_distance(Vector2 point, UiWirePath path) {
     return distance;
 }
 
-bool ui_find_incoming_wire_path(const LogicGraph *graph, const LogicPin *sink_pin, UiWirePath *path) {
+bool ui_find_incoming_wire_path(const AppContext *app, const LogicPin *sink_pin, UiWirePath *path) {
     const LogicNet *incoming;
 
-    incoming = ui_find_incoming_net(graph, sink_pin);
+    incoming = ui_find_incoming_net(&app->graph, sink_pin);
     if (!incoming || !incoming->source) {
         return false;
     }
 
     if (path) {
-        *path = ui_orthogonal_wire_path(ui_output_pin_position(incoming->source), ui_input_pin_position(sink_pin));
+        *path = ui_orthogonal_wire_path(ui_output_pin_position(app, incoming->source), ui_input_pin_position(app, sink_pin));
         path->source = incoming->source;
         path->sink = sink_pin;
     }
@@ -1,7 +1,7 @@
 #ifndef UI_GEOMETRY_H
 #define UI_GEOMETRY_H
 
-#include "logic.h"
+#include "app.h"
 
 typedef struct {
     const LogicPin *source;
@@ -12,11 +12,11 @@ typedef struct {
     Vector2 end;
 } UiWirePath;
 
-Vector2 ui_input_pin_position(const LogicPin *pin);
-Vector2 ui_output_pin_position(const LogicPin *pin);
-Vector2 ui_pin_position(const LogicPin *pin);
+Vector2 ui_input_pin_position(const AppContext *app, const LogicPin *pin);
+Vector2 ui_output_pin_position(const AppContext *app, const LogicPin *pin);
+Vector2 ui_pin_position(const AppContext *app, const LogicPin *pin);
 UiWirePath ui_orthogonal_wire_path(Vector2 start, Vector2 end);
 float ui_point_to_wire_distance(Vector2 point, UiWirePath path);
-bool ui_find_incoming_wire_path(const LogicGraph *graph, const LogicPin *sink_pin, UiWirePath *path);
+bool ui_find_incoming_wire_path(const AppContext *app, const LogicPin *sink_pin, UiWirePath *path);
 
 #endif // UI_GEOMETRY_H
@@ -181,6 +181,7 @@ UiContextPanelLayout ui_measure_context_panel(const AppContext *app, Rectangle p
     float cursor_y;
     float remaining_height;
     float section_width;
+    float kmap_height;
     float kmap_total_height;
     float why_height;
     float truth_height;
@@ -188,7 +189,10 @@ UiContextPanelLayout ui_measure_context_panel(const AppContext *app, Rectangle p
     memset(&layout, 0, sizeof(layout));
     layout.panel_rect = panel;
     layout.show_compare = app && app->mode == MODE_COMPARE;
-    layout.show_kmap = app && app->analysis.truth_table && app->analysis.truth_table->input_count == 2;
+    layout.show_kmap = app && app->analysis.truth_table &&
+        app->analysis.truth_table->input_count >= 2U && app->analysis.truth_table->input_count <= 4U &&
+        app->analysis.truth_table->output_count > 0U;
+    kmap_height = (layout.show_kmap && app->analysis.truth_table->input_count == 4U) ? CONTEXT_KMAP_TALL_HEIGHT : CONTEXT_KMAP_HEIGHT;
 
     section_width = panel.width - (CONTEXT_PANEL_PADDING * 2.0f);
     if (section_width < 0.0f) {
@@ -214,7 +218,7 @@ UiContextPanelLayout ui_measure_context_panel(const AppContext *app, Rectangle p
         remaining_height = 0.0f;
     }
 
-    kmap_total_height = layout.show_kmap ? (CONTEXT_KMAP_HEIGHT + CONTEXT_PANEL_GAP) : 0.0f;
+    kmap_total_height = layout.show_kmap ? (kmap_height + CONTEXT_PANEL_GAP) : 0.0f;
     why_height = CONTEXT_WHY_MIN_HEIGHT;
     truth_height = remaining_height - kmap_total_height - CONTEXT_PANEL_GAP - why_height;
 
@@ -238,8 +242,8 @@ UiContextPanelLayout ui_measure_context_panel(const AppContext *app, Rectangle p
     cursor_y += layout.truth_table_rect.height + CONTEXT_PANEL_GAP;
 
     if (layout.show_kmap) {
-        layout.kmap_rect = ui_make_rect(panel.x + CONTEXT_PANEL_PADDING, cursor_y, section_width, CONTEXT_KMAP_HEIGHT);
-        cursor_y += CONTEXT_KMAP_HEIGHT + CONTEXT_PANEL_GAP;
+        layout.kmap_rect = ui_make_rect(panel.x + CONTEXT_PANEL_PADDING, cursor_y, section_width, kmap_height);
+        cursor_y += kmap_height + CONTEXT_PANEL_GAP;
     }
 
     layout.why_rect = ui_make_rect(panel.x + CONTEXT_PANEL_PADDING, cursor_y, section_width, bottom - cursor_y);
@@ -291,7 +295,7 @@ LogicPin* ui_get_wire_at(AppContext *app, Rectangle canvas, Vector2 mouse_pos) {
                 continue;
             }
 
-            path = ui_orthogonal_wire_path(ui_pin_position(net->source), ui_input_pin_position(sink_pin));
+            path = ui_orthogonal_wire_path(ui_pin_position(app, net->source), ui_input_pin_position(app, sink_pin));
             distance = ui_point_to_wire_distance(world_pos, path);
             if (distance < best_distance) {
                 best_distance = distance;
@@ -324,7 +328,7 @@ LogicPin* ui_get_pin_at(AppContext *app, Rectangle canvas, Vector2 mouse_pos) {
         for (pin_index = 0; pin_index < node->input_count; pin_index++) {
             Vector2 pin_pos;
 
-            pin_pos = ui_input_pin_position(&node->inputs[pin_index]);
+            pin_pos = ui_input_pin_position(app, &node->inputs[pin_index]);
             if (CheckCollisionPointCircle(world_pos, pin_pos, hit_radius)) {
                 return &node->inputs[pin_index];
             }
@@ -333,7 +337,7 @@ LogicPin* ui_get_pin_at(AppContext *app, Rectangle canvas, Vector2 mouse_pos) {
         for (pin_index = 0; pin_index < node->output_count; pin_index++) {
             Vector2 pin_pos;
 
-            pin_pos = ui_output_pin_position(&node->outputs[pin_index]);
+            pin_pos = ui_output_pin_position(app, &node->outputs[pin_index]);
             if (CheckCollisionPointCircle(world_pos, pin_pos, hit_radius)) {
                 return &node->outputs[pin_index];
             }
@@ -13,12 +13,13 @@ static const Color UI_SELECT_VIOLET = { 200, 170, 255, 255 };
 static const float CONTEXT_PANEL_PADDING = 12.0f;
 static const float CONTEXT_PANEL_GAP = 10.0f;
 static const float CONTEXT_STATUS_HEIGHT = 62.0f;
-static const float CONTEXT_COMPARE_HEIGHT = 76.0f;
+static const float CONTEXT_COMPARE_HEIGHT = 92.0f;
 static const float CONTEXT_EQUATION_HEIGHT = 90.0f;
 static const float CONTEXT_TRUTH_MIN_HEIGHT = 120.0f;
 static const float CONTEXT_WHY_MIN_HEIGHT = 80.0f;
 static const float CONTEXT_WHY_FLOOR_HEIGHT = 48.0f;
 static const float CONTEXT_KMAP_HEIGHT = 140.0f;
+static const float CONTEXT_KMAP_TALL_HEIGHT = 190.0f;
 static const float TRUTH_TABLE_HEADER_Y = 38.0f;
 static const float TRUTH_TABLE_BODY_Y = 62.0f;
 static const float TRUTH_TABLE_BOTTOM_PADDING = 10.0f;
@@ -1,6 +1,7 @@
 #include "ui_internal.h"
 #include "app_canvas.h"
 #include "app_commands.h"
+#include "logic_activity.h"
 #include <math.h>
 #include <stddef.h>
 #include <stdio.h>
@@ -384,10 +385,66 @@ static void draw_gate_symbol(NodeType type, Rectangle rect, Color color, Color b
     DrawRectangleRoundedLinesEx(rect, 0.2f, 10, border_thick, border_color);
 }
 
+// Toggles relative to the busiest node, square-rooted so moderately active
+// logic still reads as warm. Evaluated nodes that never toggled go cold blue.
+static Color heatmap_color(const LogicNodeActivity *node, uint64_t peak_toggles) {
+    float heat;
+
+    if (node->toggles == 0U || peak_toggles == 0U) {
+        return (Color){ 30, 44, 76, 255 };
+    }
+    heat = sqrtf((float)node->toggles / (float)peak_toggles);
+    return (Color){
+        (unsigned char)(90.0f + (150.0f * heat)),
+        (unsigned char)(62.0f + (10.0f * heat)),
+        (unsigned char)(34.0f + (6.0f * heat)),
+        255
+    };
+}
+
+static void draw_heatmap_legend(const AppContext *app, const LogicActivitySummary *summary, Rectangle canvas) {
+    Rectangle legend;
+    char line[160];
+    uint32_t step;
+
+    legend = (Rectangle){ canvas.x + 20.0f, canvas.y + canvas.height - 78.0f, 440.0f, 58.0f };
+    DrawRectangleRounded(legend, 0.2f, 10, (Color){ 18, 18, 18, 228 });
+    DrawRectangleRoundedLinesEx(legend, 0.2f, 10, 1.0f, (Color){ 240, 110, 50, 110 });
+    draw_text_at("Heatmap: toggles while simulating (H to hide)", legend.x + 12.0f, legend.y + 10.0f, 12, WHITE);
+
+    for (step = 0U; step < 8U; step++) {
+        LogicNodeActivity sample;
+
+        memset(&sample, 0, sizeof(sample));
+        sample.toggles = step;
+        DrawRectangleRec(
+            (Rectangle){ legend.x + 12.0f + ((float)step * 10.0f), legend.y + 30.0f, 10.0f, 14.0f },
+            heatmap_color(&sample, 7U)
+        );
+    }
+
+    if (summary->evaluations == 0U) {
+        snprintf(line, sizeof(line), "Run or step the simulation to collect activity.");
+    } else {
+        snprintf(
+            line,
+            sizeof(line),
+            "%.0f%% of evaluations toggle, %u idle, hottest %s",
+            summary->activity_factor * 100.0,
+            summary->idle_nodes,
+            summary->toggles > 0U && app->graph.nodes[summary->hottest_node].name ?
+                app->graph.nodes[summary->hottest_node].name :
+                "-"
+        );
+    }
+    draw_text_at(line, legend.x + 100.0f, legend.y + 32.0f, 11, LIGHTGRAY);
+}
+
 void ui_draw_circuit(AppContext *app, Rectangle canvas) {
     static const float grid_size = 20.0f;
     Camera2D camera;
     LogicGraph *graph;
+    LogicActivitySummary activity_summary;
     Vector2 world_min;
     Vector2 world_max;
     uint32_t i;
@@ -395,6 +452,10 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
     float y;
 
     graph = &app->graph;
+    memset(&activity_summary, 0, sizeof(activity_summary));
+    if (app->simulation.activity) {
+        logic_activity_summarize(graph, app->simulation.activity, &activity_summary);
+    }
     camera = app_canvas_camera(app, canvas);
     world_min = app_canvas_screen_to_world(app, canvas, (Vector2){ canvas.x, canvas.y });
     world_max = app_canvas_screen_to_world(
@@ -403,7 +464,7 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
         (Vector2){ canvas.x + canvas.width, canvas.y + canvas.height }
     );
 
-    BeginMode2D(camera);
+    begin_canvas_mode(camera);
 
     for (x = grid_start(world_min.x, grid_size); x <= world_max.x + grid_size; x += grid_size) {
         draw_line_at(x, world_min.y, x, world_max.y, (Color){ 30, 30, 30, 255 });
@@ -423,7 +484,7 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
             continue;
         }
 
-        start = ui_pin_position(net->source);
+        start = ui_pin_position(app, net->source);
         wire_color = ui_logic_color(net->source->value);
 
         for (sink_index = 0; sink_index < net->sink_count; sink_index++) {
@@ -436,7 +497,7 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
                 continue;
             }
 
-            end = ui_input_pin_position(sink_pin);
+            end = ui_input_pin_position(app, sink_pin);
             is_selected = app->selection.selected_wire_sink == sink_pin;
             if (is_selected) {
                 draw_orthogonal_wire(start, end, UI_SELECT_VIOLET, 5.0f);
@@ -455,9 +516,9 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
         bool valid_target;
 
         if (app->interaction.wire_drag_pin->node->output_count > 0) {
-            start = ui_output_pin_position(app->interaction.wire_drag_pin);
+            start = ui_output_pin_position(app, app->interaction.wire_drag_pin);
         } else {
-            start = ui_input_pin_position(app->interaction.wire_drag_pin);
+            start = ui_input_pin_position(app, app->interaction.wire_drag_pin);
         }
 
         end = app->interaction.wire_drag_pos;
@@ -467,7 +528,7 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
                 (app->interaction.wire_drag_pin->node->output_count > 0 && app->interaction.wire_hover_pin->node->input_count > 0) ||
                 (app->interaction.wire_drag_pin->node->input_count > 0 && app->interaction.wire_hover_pin->node->output_count > 0);
             wire_color = valid_target ? UI_SELECT_VIOLET : (Color){ 200, 50, 50, 255 };
-            end = ui_pin_position(app->interaction.wire_hover_pin);
+            end = ui_pin_position(app, app->interaction.wire_hover_pin);
         } else {
             wire_color = (Color){ 0, 191, 255, 220 };
         }
@@ -481,6 +542,7 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
 
     for (i = 0; i < graph->node_count; i++) {
         LogicNode *node;
+        Rectangle rect;
         Color background;
         Color border;
         bool selected;
@@ -490,19 +552,27 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
         if (node->type == (NodeType)-1) {
             continue;
         }
+        rect = app_node_rect(app, node);
 
         background = (node->type == NODE_INPUT || node->type == NODE_OUTPUT) ?
             (Color){ 56, 56, 56, 255 } :
             (Color){ 40, 40, 40, 255 };
+        if (app->simulation.activity && app->simulation.activity->nodes[i].evaluations > 0U) {
+            background = heatmap_color(&app->simulation.activity->nodes[i], activity_summary.peak_toggles);
+        }
         selected = app->selection.selected_node == node;
         border = selected ? UI_SELECT_VIOLET : (Color){ 100, 100, 100, 255 };
         border_thick = selected ? 3.0f : 2.0f;
+        if (!selected && app->mode == MODE_COMPARE && app->comparison.divergence_node == node) {
+            border = (Color){ 220, 60, 60, 255 };
+            border_thick = 3.0f;
+        }
 
-        draw_gate_symbol(node->type, node->rect, background, border, border_thick);
+        draw_gate_symbol(node->type, rect, background, border, border_thick);
 
         if (node->type == NODE_GATE_CLOCK) {
             LogicValue live = node->output_count > 0 ? node->outputs[0].value : LOGIC_UNKNOWN;
-            draw_clock_glyph(node->rect, live);
+            draw_clock_glyph(rect, live);
         }
 
         if (node->type == NODE_INPUT || node->type == NODE_OUTPUT) {
@@ -534,8 +604,8 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
 
             text_size = 28;
             digit_width = MeasureText(digit, text_size);
-            text_x = node->pos.x + ((node->rect.width - (float)digit_width) / 2.0f);
-            text_y = node->pos.y + ((node->rect.height - (float)text_size) / 2.0f);
+            text_x = rect.x + ((rect.width - (float)digit_width) / 2.0f);
+            text_y = rect.y + ((rect.height - (float)text_size) / 2.0f);
             digit_color = (live == LOGIC_HIGH || live == LOGIC_LOW)
                 ? ui_logic_color(live)
                 : (Color){ 200, 200, 200, 255 };
@@ -552,14 +622,14 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
 
                 text_size = 12;
                 label_width = MeasureText(label, text_size);
-                text_x = node->pos.x + ((node->rect.width - (float)label_width) / 2.0f);
-                text_y = node->pos.y + ((node->rect.height - (float)text_size) / 2.0f);
+                text_x = rect.x + ((rect.width - (float)label_width) / 2.0f);
+                text_y = rect.y + ((rect.height - (float)text_size) / 2.0f);
                 draw_text_at(label, text_x, text_y, text_size, LIGHTGRAY);
             }
         }
 
         if (node->name) {
-            draw_text_at(node->name, node->pos.x, node->pos.y - 15.0f, 10, GRAY);
+            draw_text_at(node->name, rect.x, rect.y - 15.0f, 10, GRAY);
         }
 
         {
@@ -570,7 +640,7 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
                 bool is_hovered;
                 Color outline;
 
-                pin_pos = ui_input_pin_position(&node->inputs[pin_index]);
+                pin_pos = ui_input_pin_position(app, &node->inputs[pin_index]);
                 is_hovered = app->interaction.wire_drag_pin == &node->inputs[pin_index] ||
                     app->interaction.wire_hover_pin == &node->inputs[pin_index];
                 outline = (Color){ 30, 30, 30, 255 };
@@ -594,7 +664,7 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
                 bool is_hovered;
                 Color outline;
 
-                pin_pos = ui_output_pin_position(&node->outputs[pin_index]);
+                pin_pos = ui_output_pin_position(app, &node->outputs[pin_index]);
                 is_hovered = app->interaction.wire_drag_pin == &node->outputs[pin_index] ||
                     app->interaction.wire_hover_pin == &node->outputs[pin_index];
                 outline = (Color){ 30, 30, 30, 255 };
@@ -611,7 +681,11 @@ void ui_draw_circuit(AppContext *app, Rectangle canvas) {
         }
     }
 
-    EndMode2D();
+    end_canvas_mode();
+
+    if (app->simulation.activity) {
+        draw_heatmap_legend(app, &activity_summary, canvas);
+    }
 
     if (app->interaction.wire_drag_active || app_tool_places_node(app->active_tool)) {
         Rectangle hint_rect;
@@ -773,112 +847,199 @@ void ui_draw_expression(AppContext *app, Rectangle panel) {
     }
 }
 
+static uint32_t kmap_gray_code(uint32_t index) {
+    return index ^ (index >> 1U);
+}
+
+static void kmap_axis_names(const TruthTable *table, uint8_t first, uint8_t count, char *buffer, size_t buffer_size) {
+    size_t length;
+    uint8_t index;
+
+    length = 0U;
+    buffer[0] = '\0';
+    for (index = first; index < first + count && length < buffer_size; index++) {
+        int written;
+
+        written = snprintf(buffer + length, buffer_size - length, "%s", table->inputs[index]->name ? table->inputs[index]->name : "?");
+        if (written > 0) {
+            length += (size_t)written;
+        }
+    }
+}
+
+static void kmap_axis_code(uint32_t code, uint8_t bits, char *buffer) {
+    uint8_t bit;
+
+    for (bit = 0U; bit < bits; bit++) {
+        buffer[bit] = ((code >> (bits - 1U - bit)) & 1U) != 0U ? '1' : '0';
+    }
+    buffer[bits] = '\0';
+}
+
+// Draws one rounded rect per contiguous run of columns x rows, so groups that
+// wrap around the map edge show up as two (or four) pieces.
+static void draw_kmap_group(const KMapGroup *group, uint32_t column_mask, uint32_t row_mask, uint32_t map_cols, uint32_t map_rows, int origin_x, int origin_y, int size) {
+    uint32_t col_start;
+
+    col_start = 0U;
+    while (col_start < map_cols) {
+        uint32_t col_end;
+        uint32_t row_start;
+
+        if ((column_mask & (1U << col_start)) == 0U) {
+            col_start++;
+            continue;
+        }
+        col_end = col_start;
+        while (col_end + 1U < map_cols && (column_mask & (1U << (col_end + 1U))) != 0U) {
+            col_end++;
+        }
+
+        row_start = 0U;
+        while (row_start < map_rows) {
+            uint32_t row_end;
+            Rectangle rect;
+
+            if ((row_mask & (1U << row_start)) == 0U) {
+                row_start++;
+                continue;
+            }
+            row_end = row_start;
+            while (row_end + 1U < map_rows && (row_mask & (1U << (row_end + 1U))) != 0U) {
+                row_end++;
+            }
+
+            rect = (Rectangle){
+                (float)(origin_x + ((int)col_start * size)) + 3.0f,
+                (float)(origin_y + ((int)row_start * size)) + 3.0f,
+                (float)((int)(col_end - col_start + 1U) * size) - 6.0f,
+                (float)((int)(row_end - row_start + 1U) * size) - 6.0f
+            };
+            DrawRectangleRounded(rect, 0.3f, 10, group->color);
+            DrawRectangleRoundedLines(rect, 0.3f, 10, (Color){ group->color.r, group->color.g, group->color.b, 255 });
+            row_start = row_end + 1U;
+        }
+        col_start = col_end + 1U;
+    }
+}
+
 void ui_draw_kmap(AppContext *app, Rectangle panel) {
+    const TruthTable *table;
+    char corner[64];
+    char row_names[32];
+    char col_names[32];
     uint32_t cols;
+    uint32_t map_cols;
+    uint32_t map_rows;
+    uint32_t col;
+    uint32_t row;
+    uint8_t col_vars;
+    uint8_t row_vars;
+    uint8_t group_index;
     int size;
+    int font_size;
     int origin_x;
     int origin_y;
-    int b;
 
-    if (!app->analysis.truth_table || app->analysis.truth_table->input_count != 2) {
-        draw_text_at("Available when the circuit has exactly two inputs.", panel.x, panel.y + 18.0f, 13, GRAY);
+    table = app->analysis.truth_table;
+    if (!table || table->input_count < 2U || table->input_count > 4U || table->output_count == 0U) {
+        draw_text_at("Available when the circuit has two to four inputs.", panel.x, panel.y + 18.0f, 13, GRAY);
         return;
     }
 
+    // Leading inputs run across the columns, the rest down the rows, both in Gray code order.
+    col_vars = (uint8_t)((table->input_count + 1U) / 2U);
+    row_vars = (uint8_t)(table->input_count / 2U);
+    map_cols = 1U << col_vars;
+    map_rows = 1U << row_vars;
+
     size = 34;
+    if ((int)((panel.width - 44.0f) / (float)map_cols) < size) {
+        size = (int)((panel.width - 44.0f) / (float)map_cols);
+    }
+    if ((int)((panel.height - 28.0f) / (float)map_rows) < size) {
+        size = (int)((panel.height - 28.0f) / (float)map_rows);
+    }
+    if (size < 14) {
+        size = 14;
+    }
+    font_size = size >= 28 ? 15 : 12;
     origin_x = pixel(panel.x) + 44;
     origin_y = pixel(panel.y) + 28;
-    draw_text_at("B \\ A", (float)(origin_x - 40), (float)(origin_y - 20), 12, GRAY);
-    draw_text_at("0", (float)(origin_x + (size / 2)), (float)(origin_y - 20), 12, GRAY);
-    draw_text_at("1", (float)(origin_x + size + (size / 2)), (float)(origin_y - 20), 12, GRAY);
-    draw_text_at("0", (float)(origin_x - 20), (float)(origin_y + (size / 2)), 12, GRAY);
-    draw_text_at("1", (float)(origin_x - 20), (float)(origin_y + size + (size / 2)), 12, GRAY);
 
-    cols = (uint32_t)app->analysis.truth_table->input_count + (uint32_t)app->analysis.truth_table->output_count;
-    for (b = 0; b < 2; b++) {
-        int a;
+    kmap_axis_names(table, col_vars, row_vars, row_names, sizeof(row_names));
+    kmap_axis_names(table, 0U, col_vars, col_names, sizeof(col_names));
+    snprintf(corner, sizeof(corner), "%s \\ %s", row_names, col_names);
+    draw_text_at(corner, (float)(origin_x - 40), (float)(origin_y - 20), 12, GRAY);
+
+    for (col = 0U; col < map_cols; col++) {
+        char code[5];
 
-        for (a = 0; a < 2; a++) {
-            int row_index;
+        kmap_axis_code(kmap_gray_code(col), col_vars, code);
+        draw_text_at(code, (float)(origin_x + ((int)col * size) + (size / 2) - ((int)col_vars * 3)), (float)(origin_y - 20), 12, GRAY);
+    }
+    for (row = 0U; row < map_rows; row++) {
+        char code[5];
+
+        kmap_axis_code(kmap_gray_code(row), row_vars, code);
+        draw_text_at(code, (float)(origin_x - 12 - ((int)row_vars * 7)), (float)(origin_y + ((int)row * size) + (size / 2) - 6), 12, GRAY);
+    }
+
+    cols = (uint32_t)table->input_count + (uint32_t)table->output_count;
+    for (row = 0U; row < map_rows; row++) {
+        for (col = 0U; col < map_cols; col++) {
+            uint32_t row_index;
             LogicValue value;
             Rectangle cell_rect;
             const char *value_text;
 
-            row_index = (a << 1) | b;
-            value = app->analysis.truth_table->data[((uint32_t)row_index * cols) + 2U];
+            row_index = (kmap_gray_code(col) << row_vars) | kmap_gray_code(row);
+            value = table->data[(row_index * cols) + table->input_count];
             cell_rect = (Rectangle){
-                (float)(origin_x + (a * size)),
-                (float)(origin_y + (b * size)),
+                (float)(origin_x + ((int)col * size)),
+                (float)(origin_y + ((int)row * size)),
                 (float)size,
                 (float)size
             };
             DrawRectangleLinesEx(cell_rect, 1.0f, (Color){ 80, 80, 80, 255 });
-            if (app->selection.view.row_valid && app->selection.view.live_row_index == (uint32_t)row_index) {
+            if (app->selection.view.row_valid && app->selection.view.live_row_index == row_index) {
                 DrawRectangleRec(cell_rect, (Color){ 245, 185, 50, 50 });
             }
-            if (app->selection.selected_row == (uint32_t)row_index &&
-                (!app->selection.view.row_valid || app->selection.view.live_row_index != (uint32_t)row_index)) {
+            if (app->selection.selected_row == row_index &&
+                (!app->selection.view.row_valid || app->selection.view.live_row_index != row_index)) {
                 DrawRectangleLinesEx(cell_rect, 2.0f, UI_SELECT_VIOLET);
             }
             value_text = (value == LOGIC_HIGH) ? "1" : "0";
-            draw_text_at(value_text, cell_rect.x + ((float)size / 2.0f) - 5.0f, cell_rect.y + ((float)size / 2.0f) - 7.0f, 15, WHITE);
+            draw_text_at(
+                value_text,
+                cell_rect.x + ((float)size / 2.0f) - ((float)font_size / 3.0f),
+                cell_rect.y + ((float)size / 2.0f) - ((float)font_size / 2.0f),
+                font_size,
+                WHITE
+            );
         }
     }
 
-    {
-        uint8_t group_index;
-
-        for (group_index = 0; group_index < app->analysis.kmap_group_count; group_index++) {
-            KMapGroup *group;
-            float min_x;
-            float min_y;
-            float max_x;
-            float max_y;
-            int cell;
-
-            group = &app->analysis.kmap_groups[group_index];
-            min_x = 10000.0f;
-            min_y = 10000.0f;
-            max_x = 0.0f;
-            max_y = 0.0f;
-
-            for (cell = 0; cell < 4; cell++) {
-                uint8_t cell_mask;
-
-                cell_mask = (uint8_t)(1U << (uint32_t)cell);
-                if ((group->cell_mask & cell_mask) != 0U) {
-                    int a;
-                    int b_index;
-                    float x;
-                    float y;
-
-                    a = cell >> 1;
-                    b_index = cell & 1;
-                    x = (float)(origin_x + (a * size));
-                    y = (float)(origin_y + (b_index * size));
-                    if (x < min_x) {
-                        min_x = x;
-                    }
-                    if (y < min_y) {
-                        min_y = y;
-                    }
-                    if (x + (float)size > max_x) {
-                        max_x = x + (float)size;
-                    }
-                    if (y + (float)size > max_y) {
-                        max_y = y + (float)size;
-                    }
-                }
-            }
+    for (group_index = 0U; group_index < app->analysis.kmap_group_count; group_index++) {
+        const KMapGroup *group;
+        uint32_t column_mask;
+        uint32_t row_mask;
 
-            {
-                Rectangle rect;
+        group = &app->analysis.kmap_groups[group_index];
+        column_mask = 0U;
+        row_mask = 0U;
+        for (row = 0U; row < map_rows; row++) {
+            for (col = 0U; col < map_cols; col++) {
+                uint32_t row_index;
 
-                rect = (Rectangle){ min_x + 3.0f, min_y + 3.0f, (max_x - min_x) - 6.0f, (max_y - min_y) - 6.0f };
-                DrawRectangleRounded(rect, 0.3f, 10, group->color);
-                DrawRectangleRoundedLines(rect, 0.3f, 10, (Color){ group->color.r, group->color.g, group->color.b, 255 });
+                row_index = (kmap_gray_code(col) << row_vars) | kmap_gray_code(row);
+                if ((group->cell_mask & (1U << row_index)) != 0U) {
+                    column_mask |= 1U << col;
+                    row_mask |= 1U << row;
+                }
             }
         }
+        draw_kmap_group(group, column_mask, row_mask, map_cols, map_rows, origin_x, origin_y, size);
     }
 }
 
@@ -1176,6 +1337,16 @@ static void draw_context_compare(AppContext *app, Rectangle rect) {
         draw_text_at("Mismatch detected.", rect.x + 14.0f, rect.y + 32.0f, 14, (Color){ 220, 60, 60, 255 });
         snprintf(line, sizeof(line), "First failing row: %u", app->comparison.first_failing_row);
         draw_text_at(line, rect.x + 14.0f, rect.y + 52.0f, 12, GRAY);
+        if (app->comparison.divergence_node) {
+            snprintf(
+                line,
+                sizeof(line),
+                "Suspect: %s acting stuck-at-%u",
+                app->comparison.divergence_node->name ? app->comparison.divergence_node->name : "node",
+                (unsigned int)app->comparison.divergence_stuck_value
+            );
+            draw_text_at(line, rect.x + 14.0f, rect.y + 70.0f, 12, (Color){ 220, 120, 120, 255 });
+        }
     }
 }
 
@@ -1363,12 +1534,12 @@ void ui_draw_placement_ghost(AppContext *app, Rectangle canvas, Vector2 mouse_po
     ghost = (Rectangle){ snapped.x, snapped.y, width, height };
 
     camera = app_canvas_camera(app, canvas);
-    BeginMode2D(camera);
+    begin_canvas_mode(camera);
     draw_gate_symbol(type, ghost, (Color){ 200, 170, 255, 80 }, (Color){ 200, 170, 255, 180 }, 1.0f);
     if (type == NODE_GATE_CLOCK) {
         draw_clock_glyph(ghost, LOGIC_UNKNOWN);
     }
-    EndMode2D();
+    end_canvas_mode();
 }
 
 void ui_draw_status_strip(AppContext *app, Rectangle panel) {
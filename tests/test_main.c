@@ -1,16 +1,29 @@
 #include <assert.h>
 #include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include "../src/app.h"
 #include "../src/app_analysis.h"
 #include "../src/app_canvas.h"
 #include "../src/app_commands.h"
-#include "../src/circuit_file.h"
+#include "../src/batch_grade.h"
+#include "../src/circuit_file_app.h"
+#include "../src/circuit_gen.h"
 #include "../src/draw_util.h"
 #include "../src/logic.h"
+#include "../src/logic_activity.h"
+#include "../src/logic_fault.h"
+#include "../src/logic_minimize.h"
+#include "../src/logic_stimulus.h"
+#include "../src/mem.h"
+#include "../src/name_index.h"
+#include "../src/perf_hud.h"
+#include "../src/sim_cli.h"
+#include "../src/trace.h"
 #include "../src/ui.h"
 #include "../src/ui_geometry.h"
 #include "../src/workspace_layout.h"
@@ -127,7 +140,7 @@ static void test_expression(void) {
     assert(expression != NULL);
     assert(strcmp(expression, "(A AND B)") == 0);
 
-    free(expression);
+    mem_free(expression);
     printf("test_expression passed!\n");
 }
 
@@ -228,13 +241,15 @@ static const LogicNet *find_incoming_net_for_sink(const AppContext *app, const L
     return NULL;
 }
 
-static bool node_is_snapped_to_grid(const LogicNode *node) {
+static bool node_is_snapped_to_grid(const AppContext *app, const LogicNode *node) {
+    Vector2 position;
     float snapped_x;
     float snapped_y;
 
-    snapped_x = roundf(node->pos.x / 20.0f) * 20.0f;
-    snapped_y = roundf(node->pos.y / 20.0f) * 20.0f;
-    return fabsf(node->pos.x - snapped_x) < 0.001f && fabsf(node->pos.y - snapped_y) < 0.001f;
+    position = app_node_position(app, node);
+    snapped_x = roundf(position.x / 20.0f) * 20.0f;
+    snapped_y = roundf(position.y / 20.0f) * 20.0f;
+    return fabsf(position.x - snapped_x) < 0.001f && fabsf(position.y - snapped_y) < 0.001f;
 }
 
 static bool rectangles_overlap(Rectangle left, Rectangle right) {
@@ -263,8 +278,8 @@ static OrthogonalWirePath orthogonal_wire_path_for_sink(const AppContext *app, c
 
     path.source = incoming->source;
     path.sink = sink_pin;
-    path.start = ui_output_pin_position(incoming->source);
-    path.end = ui_input_pin_position(sink_pin);
+    path.start = ui_output_pin_position(app, incoming->source);
+    path.end = ui_input_pin_position(app, sink_pin);
     path.mid_1 = (Vector2){ (path.start.x + path.end.x) * 0.5f, path.start.y };
     path.mid_2 = (Vector2){ (path.start.x + path.end.x) * 0.5f, path.end.y };
     return path;
@@ -316,7 +331,7 @@ static void assert_loaded_layout_is_readable(const AppContext *app) {
             continue;
         }
 
-        assert(node_is_snapped_to_grid(left_node));
+        assert(node_is_snapped_to_grid(app, left_node));
         for (right_index = left_index + 1U; right_index < app->graph.node_count; right_index++) {
             const LogicNode *right_node;
 
@@ -325,7 +340,7 @@ static void assert_loaded_layout_is_readable(const AppContext *app) {
                 continue;
             }
 
-            assert(!rectangles_overlap(left_node->rect, right_node->rect));
+            assert(!rectangles_overlap(app_node_rect(app, left_node), app_node_rect(app, right_node)));
         }
     }
 
@@ -342,8 +357,8 @@ static void assert_loaded_layout_is_readable(const AppContext *app) {
 
             sink_pin = net->sinks[sink_index];
             assert(sink_pin != NULL);
-            start = ui_output_pin_position(net->source);
-            end = ui_input_pin_position(sink_pin);
+            start = ui_output_pin_position(app, net->source);
+            end = ui_input_pin_position(app, sink_pin);
             assert(start.x < end.x);
         }
     }
@@ -368,7 +383,7 @@ static void assert_loaded_layout_is_readable(const AppContext *app) {
                     continue;
                 }
                 for (sink_index = 0U; sink_index < net->sink_count; sink_index++) {
-                    assert(node->pos.x < net->sinks[sink_index]->node->pos.x);
+                    assert(app_node_position(app, node).x < app_node_position(app, net->sinks[sink_index]->node).x);
                 }
             }
         }
@@ -379,7 +394,7 @@ static void assert_loaded_layout_is_readable(const AppContext *app) {
             incoming = find_incoming_net_for_sink(app, &node->inputs[0]);
             assert(incoming != NULL);
             assert(incoming->source != NULL);
-            assert(incoming->source->node->pos.x < node->pos.x);
+            assert(app_node_position(app, incoming->source->node).x < app_node_position(app, node).x);
         }
     }
 }
@@ -464,28 +479,30 @@ static Rectangle named_nodes_bounds(AppContext *app, const char * const *names,
     max_y = 0.0f;
     for (name_index = 0U; name_index < name_count; name_index++) {
         LogicNode *node;
+        Rectangle rect;
 
         node = find_node_by_name(app, names[name_index]);
         assert(node != NULL);
+        rect = app_node_rect(app, node);
         if (name_index == 0U) {
-            min_x = node->rect.x;
-            min_y = node->rect.y;
-            max_x = node->rect.x + node->rect.width;
-            max_y = node->rect.y + node->rect.height;
+            min_x = rect.x;
+            min_y = rect.y;
+            max_x = rect.x + rect.width;
+            max_y = rect.y + rect.height;
             continue;
         }
 
-        if (node->rect.x < min_x) {
-            min_x = node->rect.x;
+        if (rect.x < min_x) {
+            min_x = rect.x;
         }
-        if (node->rect.y < min_y) {
-            min_y = node->rect.y;
+        if (rect.y < min_y) {
+            min_y = rect.y;
         }
-        if (node->rect.x + node->rect.width > max_x) {
-            max_x = node->rect.x + node->rect.width;
+        if (rect.x + rect.width > max_x) {
+            max_x = rect.x + rect.width;
         }
-        if (node->rect.y + node->rect.height > max_y) {
-            max_y = node->rect.y + node->rect.height;
+        if (rect.y + rect.height > max_y) {
+            max_y = rect.y + rect.height;
         }
     }
 
@@ -509,8 +526,8 @@ static void assert_named_node_positions_match(
         right_node = find_node_by_name(right_app, names[name_index]);
         assert(left_node != NULL);
         assert(right_node != NULL);
-            assert(fabsf(left_node->pos.x - right_node->pos.x) < 0.001f);
-            assert(fabsf(left_node->pos.y - right_node->pos.y) < 0.001f);
+            assert(fabsf(app_node_position(left_app, left_node).x - app_node_position(right_app, right_node).x) < 0.001f);
+            assert(fabsf(app_node_position(left_app, left_node).y - app_node_position(right_app, right_node).y) < 0.001f);
     }
 }
 
@@ -548,7 +565,7 @@ static void test_interactive_construction_flow(void) {
     LogicNode *b;
     LogicNode *out;
     LogicNode *and_gate;
-    char *explanation;
+    char explanation[256];
 
     app_init(&app);
     a = app_add_node(&app, NODE_INPUT, (Vector2){ 140.0f, 160.0f });
@@ -573,10 +590,8 @@ static void test_interactive_construction_flow(void) {
     assert(out->inputs[0].value == LOGIC_LOW);
     assert(app.selection.view.row_valid);
     assert(app.selection.view.live_row_index == 2U);
-    explanation = app_get_node_explanation(&app, and_gate);
-    assert(explanation != NULL);
+    assert(app_get_node_explanation(and_gate, explanation, sizeof(explanation)));
     assert(strstr(explanation, "at least one input is 0") != NULL);
-    free(explanation);
 
     app_select_row(&app, 3U);
     app_apply_selected_row_to_inputs(&app);
@@ -611,6 +626,122 @@ static void test_compare_mode_without_target(void) {
     printf("test_compare_mode_without_target passed!\n");
 }
 
+static void build_two_input_gate_graph(LogicGraph *graph, NodeType gate_type) {
+    LogicNode *a;
+    LogicNode *b;
+    LogicNode *gate;
+    LogicNode *output;
+
+    logic_init_graph(graph);
+    a = logic_add_node(graph, NODE_INPUT, "A");
+    b = logic_add_node(graph, NODE_INPUT, "B");
+    gate = logic_add_node(graph, gate_type, "G1");
+    output = logic_add_node(graph, NODE_OUTPUT, "Z");
+    assert(logic_connect(graph, &a->outputs[0], &gate->inputs[0]));
+    assert(logic_connect(graph, &b->outputs[0], &gate->inputs[1]));
+    assert(logic_connect(graph, &gate->outputs[0], &output->inputs[0]));
+}
+
+static void test_compare_mode_caches_target_table(void) {
+    AppContext app;
+    LogicGraph target;
+    LogicNode *a;
+    LogicNode *b;
+    LogicNode *gate;
+    LogicNode *out;
+    TruthTable *cached_table;
+
+    build_two_input_gate_graph(&target, NODE_GATE_AND);
+
+    app_init(&app);
+    a = app_add_node(&app, NODE_INPUT, (Vector2){ 100.0f, 100.0f });
+    b = app_add_node(&app, NODE_INPUT, (Vector2){ 100.0f, 160.0f });
+    gate = app_add_node(&app, NODE_GATE_OR, (Vector2){ 220.0f, 130.0f });
+    out = app_add_node(&app, NODE_OUTPUT, (Vector2){ 340.0f, 130.0f });
+    assert(app_connect_pins(&app, &a->outputs[0], &gate->inputs[0]));
+    assert(app_connect_pins(&app, &b->outputs[0], &gate->inputs[1]));
+    assert(app_connect_pins(&app, &gate->outputs[0], &out->inputs[0]));
+
+    app_compare_with_target(&app, &target);
+    assert(app.comparison.status == APP_COMPARE_MISMATCH);
+    assert(app.comparison.first_failing_row == 1U);
+    cached_table = app.comparison.target.table;
+    assert(cached_table != NULL);
+
+    app_set_mode(&app, MODE_COMPARE);
+    app_update_logic(&app);
+    assert(app.comparison.target.table == cached_table);
+
+    logic_remove_node(&target, &target.nodes[2]);
+    assert(logic_add_node(&target, NODE_GATE_OR, "G2") != NULL);
+    assert(logic_connect(&target, &target.nodes[0].outputs[0], &target.nodes[4].inputs[0]));
+    assert(logic_connect(&target, &target.nodes[1].outputs[0], &target.nodes[4].inputs[1]));
+    assert(logic_connect(&target, &target.nodes[4].outputs[0], &target.nodes[3].inputs[0]));
+    app_update_logic(&app);
+    assert(app.comparison.status == APP_COMPARE_EQUIVALENT);
+    assert(app.comparison.equivalent);
+
+    app_release_compare_target(&app);
+    assert(app.comparison.target.table == NULL);
+    app_clear_graph(&app);
+    printf("test_compare_mode_caches_target_table passed!\n");
+}
+
+static void test_compare_mode_matches_columns_by_name(void) {
+    AppContext app;
+    LogicGraph target;
+    LogicNode *target_not;
+    LogicNode *b;
+    LogicNode *a;
+    LogicNode *not_gate;
+    LogicNode *and_gate;
+    LogicNode *out;
+
+    // Target: Z = A AND NOT B, declared A then B.
+    logic_init_graph(&target);
+    assert(logic_add_node(&target, NODE_INPUT, "A") != NULL);
+    assert(logic_add_node(&target, NODE_INPUT, "B") != NULL);
+    target_not = logic_add_node(&target, NODE_GATE_NOT, "N1");
+    assert(logic_add_node(&target, NODE_GATE_AND, "G1") != NULL);
+    assert(logic_add_node(&target, NODE_OUTPUT, "Z") != NULL);
+    assert(logic_connect(&target, &target.nodes[1].outputs[0], &target_not->inputs[0]));
+    assert(logic_connect(&target, &target.nodes[0].outputs[0], &target.nodes[3].inputs[0]));
+    assert(logic_connect(&target, &target_not->outputs[0], &target.nodes[3].inputs[1]));
+    assert(logic_connect(&target, &target.nodes[3].outputs[0], &target.nodes[4].inputs[0]));
+
+    // Same function, but the user declared B before A.
+    app_init(&app);
+    b = app_add_named_node(&app, NODE_INPUT, "B", (Vector2){ 100.0f, 100.0f });
+    a = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 100.0f, 160.0f });
+    not_gate = app_add_node(&app, NODE_GATE_NOT, (Vector2){ 200.0f, 100.0f });
+    and_gate = app_add_node(&app, NODE_GATE_AND, (Vector2){ 300.0f, 130.0f });
+    out = app_add_named_node(&app, NODE_OUTPUT, "Z", (Vector2){ 420.0f, 130.0f });
+    assert(app_connect_pins(&app, &b->outputs[0], &not_gate->inputs[0]));
+    assert(app_connect_pins(&app, &a->outputs[0], &and_gate->inputs[0]));
+    assert(app_connect_pins(&app, &not_gate->outputs[0], &and_gate->inputs[1]));
+    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+
+    app_compare_with_target(&app, &target);
+    assert(app.comparison.status == APP_COMPARE_EQUIVALENT);
+    assert(app.comparison.target.input_map[0] == 1U);
+    assert(app.comparison.target.input_map[1] == 0U);
+
+    // Unmatched names fall back to declaration order, which no longer lines up.
+    mem_free(a->name);
+    a->name = mem_strdup(MEM_TAG_NAMES, "X");
+    mem_free(b->name);
+    b->name = mem_strdup(MEM_TAG_NAMES, "Y");
+    logic_disconnect_sink(&app.graph, &out->inputs[0]);
+    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+    app_compare_with_target(&app, &target);
+    assert(app.comparison.target.input_map[0] == 0U);
+    assert(app.comparison.status == APP_COMPARE_MISMATCH);
+
+    app_release_compare_target(&app);
+    app_clear_graph(&app);
+    printf("test_compare_mode_matches_columns_by_name passed!\n");
+}
+
 static void test_circuit_file_load(void) {
     AppContext app;
     char temp_path[] = "/tmp/mlvd-test-XXXXXX";
@@ -758,20 +889,20 @@ static void test_example_circuits_load(void) {
     assert(gate != NULL);
     output = find_node_by_name(&app, "Z");
     assert(output != NULL);
-    assert(gate->pos.x < output->pos.x);
+    assert(app_node_position(&app, gate).x < app_node_position(&app, output).x);
     expression = logic_generate_expression(&app.graph, output);
     assert(expression != NULL);
     assert(strcmp(expression, "(A AND B)") == 0);
-    free(expression);
+    mem_free(expression);
 
     b = find_node_by_name(&app, "B");
     assert(b != NULL);
     app.selection.selected_node = b;
     assert(app_move_selected_node(&app, 0, 1));
     assert(app.graph.nets[1].source == &b->outputs[0]);
-    moved_pin_pos = ui_output_pin_position(&b->outputs[0]);
-    assert(fabsf(moved_pin_pos.x - (b->pos.x + b->rect.width)) < 0.001f);
-    assert(fabsf(moved_pin_pos.y - (b->pos.y + app_node_pin_offset_y(b, true, 0U))) < 0.001f);
+    moved_pin_pos = ui_output_pin_position(&app, &b->outputs[0]);
+    assert(fabsf(moved_pin_pos.x - (app_node_position(&app, b).x + app_node_rect(&app, b).width)) < 0.001f);
+    assert(fabsf(moved_pin_pos.y - (app_node_position(&app, b).y + app_node_pin_offset_y(b, true, 0U))) < 0.001f);
     app_clear_graph(&app);
 
     app_init(&app);
@@ -792,18 +923,18 @@ static void test_example_circuits_load(void) {
     assert(output != NULL);
     carry = find_node_by_name(&app, "CARRY");
     assert(carry != NULL);
-    assert(xor_gate->pos.y < gate->pos.y);
-    assert(output->pos.y < carry->pos.y);
+    assert(app_node_position(&app, xor_gate).y < app_node_position(&app, gate).y);
+    assert(app_node_position(&app, output).y < app_node_position(&app, carry).y);
     assert(fabsf(
-        (xor_gate->rect.y + (xor_gate->rect.height * 0.5f)) -
-        (gate->rect.y + (gate->rect.height * 0.5f))
+        (app_node_rect(&app, xor_gate).y + (app_node_rect(&app, xor_gate).height * 0.5f)) -
+        (app_node_rect(&app, gate).y + (app_node_rect(&app, gate).height * 0.5f))
     ) >= 120.0f);
     assert(fabsf(
-        (output->rect.y + (output->rect.height * 0.5f)) -
-        (carry->rect.y + (carry->rect.height * 0.5f))
+        (app_node_rect(&app, output).y + (app_node_rect(&app, output).height * 0.5f)) -
+        (app_node_rect(&app, carry).y + (app_node_rect(&app, carry).height * 0.5f))
     ) >= 100.0f);
-    assert(output->pos.x > xor_gate->pos.x);
-    assert(carry->pos.x > gate->pos.x);
+    assert(app_node_position(&app, output).x > app_node_position(&app, xor_gate).x);
+    assert(app_node_position(&app, carry).x > app_node_position(&app, gate).x);
     assert(table_output_value(&app, 0U, 0U) == LOGIC_LOW);
     assert(table_output_value(&app, 0U, 1U) == LOGIC_LOW);
     assert(table_output_value(&app, 1U, 0U) == LOGIC_HIGH);
@@ -818,12 +949,12 @@ static void test_example_circuits_load(void) {
     expression = logic_generate_expression(&app.graph, output);
     assert(expression != NULL);
     assert(strcmp(expression, "(A XOR B)") == 0);
-    free(expression);
+    mem_free(expression);
 
     expression = logic_generate_expression(&app.graph, carry);
     assert(expression != NULL);
     assert(strcmp(expression, "(A AND B)") == 0);
-    free(expression);
+    mem_free(expression);
 
     app_clear_graph(&app);
     printf("test_example_circuits_load passed!\n");
@@ -906,10 +1037,10 @@ static void test_circuit_file_load_uses_declaration_order_for_symmetric_layers(v
     assert(carry_first_sum != NULL);
     assert(carry_first_carry != NULL);
 
-    assert(sum_first_xor->pos.y < sum_first_and->pos.y);
-    assert(sum_first_sum->pos.y < sum_first_carry->pos.y);
-    assert(carry_first_and->pos.y < carry_first_xor->pos.y);
-    assert(carry_first_carry->pos.y < carry_first_sum->pos.y);
+    assert(app_node_position(&sum_first_app, sum_first_xor).y < app_node_position(&sum_first_app, sum_first_and).y);
+    assert(app_node_position(&sum_first_app, sum_first_sum).y < app_node_position(&sum_first_app, sum_first_carry).y);
+    assert(app_node_position(&carry_first_app, carry_first_and).y < app_node_position(&carry_first_app, carry_first_xor).y);
+    assert(app_node_position(&carry_first_app, carry_first_carry).y < app_node_position(&carry_first_app, carry_first_sum).y);
     assert_loaded_layout_is_readable(&sum_first_app);
     assert_loaded_layout_is_readable(&carry_first_app);
     assert_wire_paths_do_not_cross(&sum_first_app);
@@ -969,6 +1100,43 @@ static void test_circuit_file_load_packs_disconnected_components(void) {
     printf("test_circuit_file_load_packs_disconnected_components passed!\n");
 }
 
+static void test_circuit_file_reads_small_files_and_maps_large_ones(void) {
+    char temp_path[] = "/tmp/mlvd-test-map-XXXXXX";
+    CircuitFileText text;
+    CircuitSpec spec;
+    Arena arena;
+    FILE *stream;
+    char error_message[128];
+    uint32_t line;
+    int fd;
+
+    fd = mkstemp(temp_path);
+    assert(fd >= 0);
+    close(fd);
+
+    // Hand-edited sizes are copied so a truncating editor cannot fault the parse.
+    write_text_file(temp_path, "input A\noutput Z\nwire A -> Z.in0\n");
+    assert(circuit_file_open_spec(temp_path, &text, &arena, &spec, error_message, sizeof(error_message)));
+    assert(text.mapping == NULL && text.buffer != NULL);
+    assert(spec.node_count == 2U);
+    circuit_file_close_spec(&text, &arena);
+
+    stream = fopen(temp_path, "w");
+    assert(stream != NULL);
+    fputs("input A\noutput Z\nwire A -> Z.in0\n", stream);
+    for (line = 0U; line < 20000U; line++) {
+        fputs("# padding the file past the mapping threshold ......\n", stream);
+    }
+    fclose(stream);
+    assert(circuit_file_open_spec(temp_path, &text, &arena, &spec, error_message, sizeof(error_message)));
+    assert(text.mapping != NULL && text.buffer == NULL);
+    assert(spec.node_count == 2U);
+    circuit_file_close_spec(&text, &arena);
+
+    unlink(temp_path);
+    printf("test_circuit_file_reads_small_files_and_maps_large_ones passed!\n");
+}
+
 static void test_circuit_file_load_handles_feedback_cycles(void) {
     AppContext app;
     char temp_path[] = "/tmp/mlvd-test-cycle-XXXXXX";
@@ -995,206 +1163,1934 @@ static void test_circuit_file_load_handles_feedback_cycles(void) {
     right = find_node_by_name(&app, "N2");
     assert(left != NULL);
     assert(right != NULL);
-    assert(node_is_snapped_to_grid(left));
-    assert(node_is_snapped_to_grid(right));
-    assert(!rectangles_overlap(left->rect, right->rect));
-    assert(fabsf(left->pos.x - right->pos.x) >= 0.001f || fabsf(left->pos.y - right->pos.y) >= 0.001f);
+    assert(node_is_snapped_to_grid(&app, left));
+    assert(node_is_snapped_to_grid(&app, right));
+    assert(!rectangles_overlap(app_node_rect(&app, left), app_node_rect(&app, right)));
+    assert(fabsf(app_node_position(&app, left).x - app_node_position(&app, right).x) >= 0.001f || fabsf(app_node_position(&app, left).y - app_node_position(&app, right).y) >= 0.001f);
 
     unlink(temp_path);
     app_clear_graph(&app);
     printf("test_circuit_file_load_handles_feedback_cycles passed!\n");
 }
 
-static void test_connected_nodes_can_snap_to_straight_wire_alignment(void) {
-    AppContext app;
-    LogicNode *gate;
-    LogicNode *output;
-    Vector2 snapped;
-    Vector2 gate_pin;
-    Vector2 output_pin;
+static uint32_t test_mem_hook_calls[3];
 
-    app_init(&app);
-    gate = app_add_named_node(&app, NODE_GATE_AND, "G1", (Vector2){ 340.0f, 220.0f });
-    output = app_add_named_node(&app, NODE_OUTPUT, "Z", (Vector2){ 560.0f, 240.0f });
+static void *test_mem_allocate(size_t size, bool zeroed, void *user) {
+    (void)user;
+    test_mem_hook_calls[0]++;
+    return zeroed ? calloc(1U, size) : malloc(size);
+}
 
-    assert(gate != NULL);
-    assert(output != NULL);
-    assert(app_connect_pins(&app, &gate->outputs[0], &output->inputs[0]));
+static void *test_mem_reallocate(void *memory, size_t size, void *user) {
+    (void)user;
+    test_mem_hook_calls[1]++;
+    return realloc(memory, size);
+}
 
-    snapped = app_snap_live_node_position(&app, output, (Vector2){ 560.0f, 236.0f });
-    assert(snapped.x == 560.0f);
-    assert(snapped.y == 240.0f);
+static void test_mem_release(void *memory, void *user) {
+    (void)user;
+    test_mem_hook_calls[2]++;
+    free(memory);
+}
 
-    output->pos = snapped;
-    output->rect.x = snapped.x;
-    output->rect.y = snapped.y;
-    gate_pin = ui_output_pin_position(&gate->outputs[0]);
-    output_pin = ui_input_pin_position(&output->inputs[0]);
-    assert(fabsf(gate_pin.y - output_pin.y) < 0.001f);
+static uint32_t test_grade_graph_allocations;
 
-    app_clear_graph(&app);
-    printf("test_connected_nodes_can_snap_to_straight_wire_alignment passed!\n");
+// Lets the reference graph through and fails every worker graph after it.
+static void *test_grade_allocate(size_t size, bool zeroed, void *user) {
+    if (size >= sizeof(LogicGraph) && test_grade_graph_allocations++ > 0U) {
+        return NULL;
+    }
+    return test_mem_allocate(size, zeroed, user);
 }
 
-static void test_multi_input_gate_can_snap_to_connected_inputs_centerline(void) {
-    AppContext app;
-    LogicNode *a;
-    LogicNode *b;
-    LogicNode *gate;
-    Vector2 snapped;
-    Vector2 a_pin;
-    Vector2 b_pin;
-    Vector2 gate_in_0;
-    Vector2 gate_in_1;
-    float source_midpoint;
-    float gate_midpoint;
+static void test_batch_grade_reports_each_candidate(void) {
+    char paths[5][40] = {
+        "/tmp/mlvd-grade-ref-XXXXXX",
+        "/tmp/mlvd-grade-swap-XXXXXX",
+        "/tmp/mlvd-grade-or-XXXXXX",
+        "/tmp/mlvd-grade-not-XXXXXX",
+        "/tmp/mlvd-grade-bad-XXXXXX",
+    };
+    const char *candidates[4];
+    BatchGradeOptions options;
+    BatchGradeResult results[4];
+    MemHooks hooks;
+    FILE *report;
+    char line[256];
+    char error_message[128];
+    uint32_t index;
+    int fd;
 
-    app_init(&app);
-    a = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 180.0f, 200.0f });
-    b = app_add_named_node(&app, NODE_INPUT, "B", (Vector2){ 180.0f, 300.0f });
-    gate = app_add_named_node(&app, NODE_GATE_AND, "G1", (Vector2){ 440.0f, 220.0f });
+    for (index = 0U; index < 5U; index++) {
+        fd = mkstemp(paths[index]);
+        assert(fd >= 0);
+        close(fd);
+    }
 
-    assert(a != NULL);
-    assert(b != NULL);
-    assert(gate != NULL);
-    assert(app_connect_pins(&app, &a->outputs[0], &gate->inputs[0]));
-    assert(app_connect_pins(&app, &b->outputs[0], &gate->inputs[1]));
+    write_text_file(paths[0], "input A\ninput B\nand G1\noutput Z\nwire A -> G1.in0\nwire B -> G1.in1\nwire G1.out0 -> Z.in0\n");
+    write_text_file(paths[1], "input B\ninput A\nand G1\noutput Z\nwire B -> G1.in0\nwire A -> G1.in1\nwire G1.out0 -> Z.in0\n");
+    write_text_file(paths[2], "input A\ninput B\nor G1\noutput Z\nwire A -> G1.in0\nwire B -> G1.in1\nwire G1.out0 -> Z.in0\n");
+    write_text_file(paths[3], "input A\nnot N1\noutput Z\nwire A -> N1.in0\nwire N1.out0 -> Z.in0\n");
+    write_text_file(paths[4], "input A\nwire A -> MISSING.in0\n");
 
-    snapped = app_snap_live_node_position(&app, gate, (Vector2){ 440.0f, 232.0f });
-    assert(snapped.x == 440.0f);
-    assert(snapped.y == 230.0f);
+    for (index = 0U; index < 4U; index++) {
+        candidates[index] = paths[index + 1U];
+    }
+    memset(&options, 0, sizeof(options));
+    options.reference_path = paths[0];
+    options.candidate_paths = candidates;
+    options.candidate_count = 4U;
+    options.jobs = 2U;
+    assert(batch_grade_run(&options, results, error_message, sizeof(error_message)));
+
+    assert(results[0].status == BATCH_GRADE_EQUIVALENT);
+    assert(results[1].status == BATCH_GRADE_MISMATCH);
+    assert(results[1].first_failing_row == 1U);
+    assert(strcmp(results[1].detail, "A=0 B=1 -> Z=1 (expected 0)") == 0);
+    assert(results[2].status == BATCH_GRADE_SHAPE_MISMATCH);
+    assert(results[3].status == BATCH_GRADE_ERROR);
+    assert(results[3].detail[0] != '\0');
+
+    // A worker that cannot allocate its graph leaves its slots as errors.
+    memset(results, 0, sizeof(results));
+    options.candidate_count = 1U;
+    options.jobs = 1U;
+    hooks.allocate = test_grade_allocate;
+    hooks.reallocate = test_mem_reallocate;
+    hooks.release = test_mem_release;
+    hooks.user = NULL;
+    test_grade_graph_allocations = 0U;
+    assert(mem_set_hooks(&hooks));
+    assert(batch_grade_run(&options, results, error_message, sizeof(error_message)));
+    assert(mem_set_hooks(NULL));
+    assert(results[0].status == BATCH_GRADE_ERROR);
+    assert(results[0].path == candidates[0]);
+    assert(strstr(results[0].detail, "not graded") != NULL);
+    report = tmpfile();
+    assert(report != NULL);
+    batch_grade_write_csv(report, results, 1U);
+    rewind(report);
+    assert(fgets(line, sizeof(line), report) && fgets(line, sizeof(line), report));
+    assert(strstr(line, ",error,") != NULL);
+    fclose(report);
+
+    for (index = 0U; index < 5U; index++) {
+        unlink(paths[index]);
+    }
+    printf("test_batch_grade_reports_each_candidate passed!\n");
+}
 
-    gate->pos = snapped;
-    gate->rect.x = snapped.x;
-    gate->rect.y = snapped.y;
+static void set_column_row(TruthColumn *column, uint32_t row, LogicValue value) {
+    uint64_t bit;
 
-    a_pin = ui_output_pin_position(&a->outputs[0]);
-    b_pin = ui_output_pin_position(&b->outputs[0]);
-    gate_in_0 = ui_input_pin_position(&gate->inputs[0]);
-    gate_in_1 = ui_input_pin_position(&gate->inputs[1]);
+    bit = 1ULL << (row & 63U);
+    column->planes[0][row >> 6U] &= ~bit;
+    column->planes[1][row >> 6U] &= ~bit;
+    if (((uint32_t)value & 1U) != 0U) {
+        column->planes[0][row >> 6U] |= bit;
+    }
+    if (((uint32_t)value & 2U) != 0U) {
+        column->planes[1][row >> 6U] |= bit;
+    }
+}
 
-    source_midpoint = (a_pin.y + b_pin.y) * 0.5f;
-    gate_midpoint = (gate_in_0.y + gate_in_1.y) * 0.5f;
-    assert(fabsf(gate_midpoint - source_midpoint) < 0.001f);
+static bool cover_contains_row(const LogicCover *cover, uint32_t row) {
+    uint32_t index;
 
-    app_clear_graph(&app);
-    printf("test_multi_input_gate_can_snap_to_connected_inputs_centerline passed!\n");
+    for (index = 0U; index < cover->cube_count; index++) {
+        if ((row & cover->cubes[index].care) == cover->cubes[index].value) {
+            return true;
+        }
+    }
+    return false;
 }
 
-static void test_view_context_matches_live_state(void) {
-    AppContext app;
-    LogicNode *a;
-    LogicNode *b;
-    LogicNode *out;
-    LogicNode *and_gate;
+static void test_logic_minimize_column(void) {
+    TruthColumn column;
+    LogicCover cover;
+    LogicNode nodes[3];
+    LogicNode *inputs[3];
+    char text[64];
+    uint32_t seed;
+    uint32_t trial;
+    uint32_t row;
+
+    memset(nodes, 0, sizeof(nodes));
+    nodes[0].name = "A";
+    nodes[1].name = "B";
+    nodes[2].name = "C";
+    inputs[0] = &nodes[0];
+    inputs[1] = &nodes[1];
+    inputs[2] = &nodes[2];
+
+    // Majority of three.
+    memset(&column, 0, sizeof(column));
+    for (row = 0U; row < 8U; row++) {
+        set_column_row(&column, row, (__builtin_popcount(row) >= 2) ? LOGIC_HIGH : LOGIC_LOW);
+    }
+    assert(logic_minimize_column(&column, 3U, &cover));
+    assert(cover.exact);
+    assert(cover.cube_count == 3U);
+    logic_cover_format(&cover, inputs, 3U, text, sizeof(text));
+    assert(strcmp(text, "AB OR AC OR BC") == 0);
+
+    // Unknown rows are don't-cares: row 3 alone is A'BC, the X on row 1 lets it grow to A'C.
+    memset(&column, 0, sizeof(column));
+    set_column_row(&column, 3U, LOGIC_HIGH);
+    set_column_row(&column, 1U, LOGIC_UNKNOWN);
+    assert(logic_minimize_column(&column, 3U, &cover));
+    logic_cover_format(&cover, inputs, 3U, text, sizeof(text));
+    assert(strcmp(text, "A'C") == 0);
+
+    // Four-input parity has no merges at all.
+    memset(&column, 0, sizeof(column));
+    for (row = 0U; row < 16U; row++) {
+        set_column_row(&column, row, (__builtin_popcount(row) & 1) ? LOGIC_HIGH : LOGIC_LOW);
+    }
+    assert(logic_minimize_column(&column, 4U, &cover));
+    assert(cover.cube_count == 8U);
+
+    // Cyclic core with no essential primes: 6 minterms, 6 primes, 3 needed.
+    memset(&column, 0, sizeof(column));
+    set_column_row(&column, 0U, LOGIC_HIGH);
+    set_column_row(&column, 1U, LOGIC_HIGH);
+    set_column_row(&column, 2U, LOGIC_HIGH);
+    set_column_row(&column, 5U, LOGIC_HIGH);
+    set_column_row(&column, 6U, LOGIC_HIGH);
+    set_column_row(&column, 7U, LOGIC_HIGH);
+    assert(logic_minimize_column(&column, 3U, &cover));
+    assert(cover.exact);
+    assert(cover.cube_count == 3U);
+
+    // Random eight-input functions: the cover must reproduce every ON row and no OFF row.
+    seed = 12345U;
+    for (trial = 0U; trial < 20U; trial++) {
+        memset(&column, 0, sizeof(column));
+        for (row = 0U; row < 256U; row++) {
+            seed = (seed * 1103515245U) + 12345U;
+            set_column_row(&column, row, ((seed >> 16U) & 3U) == 0U ? LOGIC_HIGH : LOGIC_LOW);
+        }
+        assert(logic_minimize_column(&column, 8U, &cover));
+        for (row = 0U; row < 256U; row++) {
+            bool on;
 
-    app_init(&app);
-    a = app_add_node(&app, NODE_INPUT, (Vector2){ 140.0f, 160.0f });
-    b = app_add_node(&app, NODE_INPUT, (Vector2){ 140.0f, 260.0f });
-    and_gate = app_add_node(&app, NODE_GATE_AND, (Vector2){ 320.0f, 220.0f });
-    out = app_add_node(&app, NODE_OUTPUT, (Vector2){ 520.0f, 220.0f });
-    assert(app_connect_pins(&app, &a->outputs[0], &and_gate->inputs[0]));
-    assert(app_connect_pins(&app, &b->outputs[0], &and_gate->inputs[1]));
-    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+            on = ((column.planes[0][row >> 6U] >> (row & 63U)) & 1U) != 0U;
+            assert(cover_contains_row(&cover, row) == on);
+        }
+    }
+    printf("test_logic_minimize_column passed!\n");
+}
 
-    a->outputs[0].value = LOGIC_HIGH;
-    b->outputs[0].value = LOGIC_HIGH;
-    logic_evaluate(&app.graph);
-    app_compute_view_context(&app);
+static void test_kmap_groups_for_three_inputs(void) {
+    AppContext app;
+    char temp_path[] = "/tmp/mlvd-test-kmap3-XXXXXX";
+    char error_message[128];
+    UiContextPanelLayout layout;
+    int fd;
 
-    assert(app.selection.view.row_valid);
-    assert(app.selection.view.live_row_index == 3U);
+    fd = mkstemp(temp_path);
+    assert(fd >= 0);
+    close(fd);
+    write_text_file(
+        temp_path,
+        "input A\ninput B\ninput C\nand G1\nor G2\noutput Z\n"
+        "wire A -> G1.in0\nwire B -> G1.in1\nwire G1.out0 -> G2.in0\nwire C -> G2.in1\nwire G2.out0 -> Z.in0\n"
+    );
 
-    app.selection.selected_row = 0U;
-    app_compute_view_context(&app);
-    assert(app.selection.view.live_row_index == 3U);
-    assert(a->outputs[0].value == LOGIC_HIGH);
-    assert(b->outputs[0].value == LOGIC_HIGH);
+    app_init(&app);
+    assert(circuit_file_load(&app, temp_path, error_message, sizeof(error_message)));
+    assert(app.analysis.simplified_expression != NULL);
+    assert(strcmp(app.analysis.simplified_expression, "AB OR C") == 0);
+    assert(app.analysis.kmap_group_count == 2U);
+    assert(app.analysis.kmap_groups[0].cell_mask == 0xC0U);
+    assert(app.analysis.kmap_groups[1].cell_mask == 0xAAU);
 
-    app.selection.selected_node = and_gate;
-    app_compute_view_context(&app);
-    assert(app.selection.view.output_valid);
-    assert(app.selection.view.live_output == LOGIC_HIGH);
+    layout = ui_measure_context_panel(&app, (Rectangle){ 770.0f, 50.0f, 330.0f, 646.0f });
+    assert(layout.show_kmap);
 
+    unlink(temp_path);
     app_clear_graph(&app);
-    printf("test_view_context_matches_live_state passed!\n");
+    printf("test_kmap_groups_for_three_inputs passed!\n");
 }
 
-static void test_equation_resolved(void) {
+static void test_fault_coverage_reports_undetected_faults(void) {
+    LogicGraph graph;
+    LogicNetlist *netlist;
+    LogicFaultReport *report;
+    uint32_t all_rows[4] = { 0U, 1U, 2U, 3U };
+    uint32_t high_row[1] = { 3U };
+
+    build_two_input_gate_graph(&graph, NODE_GATE_AND);
+    netlist = (LogicNetlist *)calloc(1U, sizeof(*netlist));
+    report = (LogicFaultReport *)calloc(1U, sizeof(*report));
+    assert(netlist != NULL);
+    assert(report != NULL);
+    assert(logic_netlist_compile(&graph, netlist));
+    assert(netlist->input_count == 2U);
+    assert(netlist->output_count == 1U);
+    assert(netlist->gate_count == 1U);
+
+    assert(logic_fault_coverage(netlist, all_rows, 4U, report));
+    assert(report->fault_count == 6U);
+    assert(report->detected_count == 6U);
+    assert(report->undetected_count == 0U);
+
+    // A=B=1 only exposes the stuck-at-0 faults.
+    assert(logic_fault_coverage(netlist, high_row, 1U, report));
+    assert(report->detected_count == 3U);
+    assert(report->undetected_count == 3U);
+    assert(report->undetected[0].stuck_value == 1U);
+
+    free(report);
+    free(netlist);
+    logic_clear_graph(&graph);
+    printf("test_fault_coverage_reports_undetected_faults passed!\n");
+}
+
+static void test_compare_mode_blames_single_stuck_node(void) {
     AppContext app;
+    LogicGraph target;
     LogicNode *a;
-    LogicNode *b;
-    LogicNode *and_gate;
-    LogicNode *out;
-    char buf[256];
+    LogicNode *z;
+    LogicNode *gate;
+
+    // Target is Z = A with B unused; the user's AND matches it iff B is stuck at 1.
+    logic_init_graph(&target);
+    a = logic_add_node(&target, NODE_INPUT, "A");
+    assert(logic_add_node(&target, NODE_INPUT, "B") != NULL);
+    z = logic_add_node(&target, NODE_OUTPUT, "Z");
+    assert(logic_connect(&target, &a->outputs[0], &z->inputs[0]));
 
     app_init(&app);
-    a = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 140.0f, 160.0f });
-    b = app_add_named_node(&app, NODE_INPUT, "B", (Vector2){ 140.0f, 260.0f });
-    and_gate = app_add_named_node(&app, NODE_GATE_AND, "AND1", (Vector2){ 320.0f, 220.0f });
-    out = app_add_named_node(&app, NODE_OUTPUT, "Z", (Vector2){ 520.0f, 220.0f });
-    assert(app_connect_pins(&app, &a->outputs[0], &and_gate->inputs[0]));
-    assert(app_connect_pins(&app, &b->outputs[0], &and_gate->inputs[1]));
-    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+    build_two_input_gate_graph(&app.graph, NODE_GATE_AND);
+    app_update_logic(&app);
+    app_compare_with_target(&app, &target);
+    assert(app.comparison.status == APP_COMPARE_MISMATCH);
+    assert(app.comparison.divergence_node != NULL);
+    assert(strcmp(app.comparison.divergence_node->name, "B") == 0);
+    assert(app.comparison.divergence_stuck_value == 1U);
+
+    // The search runs once per revision: comparing again keeps its answer,
+    // and only an edit searches again.
+    app.comparison.divergence_stuck_value = 7U;
+    app_compare_with_target(&app, &target);
+    assert(app.comparison.divergence_stuck_value == 7U);
+    gate = find_node_by_name(&app, "G1");
+    assert(logic_disconnect_sink(&app.graph, &gate->inputs[1]));
+    assert(logic_connect(&app.graph, &find_node_by_name(&app, "B")->outputs[0], &gate->inputs[1]));
+    app_update_logic(&app);
+    assert(app.comparison.status == APP_COMPARE_MISMATCH);
+    assert(strcmp(app.comparison.divergence_node->name, "B") == 0);
+    assert(app.comparison.divergence_stuck_value == 1U);
 
-    a->outputs[0].value = LOGIC_HIGH;
-    b->outputs[0].value = LOGIC_HIGH;
-    logic_evaluate(&app.graph);
+    app_release_compare_target(&app);
+    app_clear_graph(&app);
+    logic_clear_graph(&target);
+    printf("test_compare_mode_blames_single_stuck_node passed!\n");
+}
 
-    assert(logic_format_equation_resolved(&app.graph, out, buf, sizeof(buf)));
-    assert(strcmp(buf, "Z = (A AND B) = (1 AND 1) = 1") == 0);
+static void test_name_index_lookup_and_duplicate_names(void) {
+    NameIndexSlot slots[16];
+    NameIndex index;
+    static LogicGraph graph;
+    const char *line = "G1 -> G10";
+    char temp_path[] = "/tmp/mlvd-test-names-XXXXXX";
+    char error_message[128];
+    uint16_t value;
+    int fd;
 
-    assert(logic_format_equation_resolved(&app.graph, and_gate, buf, sizeof(buf)));
-    assert(strcmp(buf, "AND1 = (A AND B) = (1 AND 1) = 1") == 0);
+    assert(name_index_capacity_for(8U) == 16U);
+    assert(name_index_capacity_for(9U) == 32U);
+    name_index_init(&index, slots, 16U);
+    assert(name_index_insert(&index, "G1", 2U, 3U));
+    assert(name_index_insert(&index, "G10", 3U, 7U));
+    assert(!name_index_insert(&index, "G1", 2U, 9U));
+    assert(name_index_find(&index, line, 2U, &value) && value == 3U);
+    assert(name_index_find(&index, line + 6, 3U, &value) && value == 7U);
+    assert(!name_index_find(&index, "G", 1U, &value));
+    assert(index.count == 2U);
 
-    a->outputs[0].value = LOGIC_LOW;
-    logic_evaluate(&app.graph);
-    assert(logic_format_equation_resolved(&app.graph, out, buf, sizeof(buf)));
-    assert(strcmp(buf, "Z = (A AND B) = (0 AND 1) = 0") == 0);
+    fd = mkstemp(temp_path);
+    assert(fd >= 0);
+    close(fd);
+    write_text_file(temp_path, "input A\nnot N1\nnot N1\nwire A -> N1.in0\n");
 
-    app_clear_graph(&app);
-    printf("test_equation_resolved passed!\n");
-}
+    logic_init_graph(&graph);
+    assert(!circuit_file_load_graph(&graph, temp_path, error_message, sizeof(error_message)));
+    assert(strstr(error_message, "Line 3") != NULL);
+    assert(strstr(error_message, "duplicate node name") != NULL);
 
-static void test_equation_symbolic_and_values(void) {
-    AppContext app;
-    LogicNode *a;
-    LogicNode *b;
-    LogicNode *and_gate;
-    LogicNode *out;
-    char buf[256];
+    unlink(temp_path);
+    logic_clear_graph(&graph);
+    printf("test_name_index_lookup_and_duplicate_names passed!\n");
+}
 
-    app_init(&app);
-    a = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 140.0f, 160.0f });
-    b = app_add_named_node(&app, NODE_INPUT, "B", (Vector2){ 140.0f, 260.0f });
-    and_gate = app_add_named_node(&app, NODE_GATE_AND, "AND1", (Vector2){ 320.0f, 220.0f });
-    out = app_add_named_node(&app, NODE_OUTPUT, "Z", (Vector2){ 520.0f, 220.0f });
-    assert(app_connect_pins(&app, &a->outputs[0], &and_gate->inputs[0]));
-    assert(app_connect_pins(&app, &b->outputs[0], &and_gate->inputs[1]));
-    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+static void test_circuit_file_tokenizer_handles_edge_cases(void) {
+    static LogicGraph graph;
+    char temp_path[] = "/tmp/mlvd-test-tokens-XXXXXX";
+    char error_message[128];
+    int fd;
 
-    a->outputs[0].value = LOGIC_HIGH;
-    b->outputs[0].value = LOGIC_HIGH;
-    logic_evaluate(&app.graph);
+    fd = mkstemp(temp_path);
+    assert(fd >= 0);
+    close(fd);
 
-    assert(logic_format_equation_symbolic(&app.graph, out, buf, sizeof(buf)));
-    assert(strcmp(buf, "Z = (A AND B)") == 0);
+    write_text_file(
+        temp_path,
+        "# comment only\r\n"
+        "  input\tA at 1.5e2 , -2.5   # trailing comment\r\n"
+        "input B at .5,3.\r\n"
+        "and G1\r\n"
+        "output Z\r\n"
+        "wire A -> G1.in0\r\n"
+        "wire B -> G1.in1\r\n"
+        "wire G1.out0 -> Z"
+    );
+    logic_init_graph(&graph);
+    assert(circuit_file_load_graph(&graph, temp_path, error_message, sizeof(error_message)));
+    assert(graph.node_count == 4U);
+    assert(graph.net_count == 3U);
 
-    assert(logic_format_equation_values(&app.graph, out, buf, sizeof(buf)));
-    assert(strcmp(buf, "(1 AND 1) -> 1") == 0);
+    write_text_file(temp_path, "input A\ninput B at 1e,2\n");
+    assert(!circuit_file_load_graph(&graph, temp_path, error_message, sizeof(error_message)));
+    assert(strstr(error_message, "Line 2") != NULL);
 
-    assert(logic_format_equation_symbolic(&app.graph, and_gate, buf, sizeof(buf)));
-    assert(strcmp(buf, "AND1 = (A AND B)") == 0);
+    write_text_file(temp_path, "input A\nnot N\nwire A -> N.in256\n");
+    assert(!circuit_file_load_graph(&graph, temp_path, error_message, sizeof(error_message)));
+    assert(strstr(error_message, "invalid sink endpoint") != NULL);
 
-    assert(logic_format_equation_values(&app.graph, and_gate, buf, sizeof(buf)));
-    assert(strcmp(buf, "(1 AND 1) -> 1") == 0);
+    write_text_file(temp_path, "");
+    assert(circuit_file_load_graph(&graph, temp_path, error_message, sizeof(error_message)));
+    assert(graph.node_count == 0U);
 
-    app_clear_graph(&app);
-    printf("test_equation_symbolic_and_values passed!\n");
+    unlink(temp_path);
+    logic_clear_graph(&graph);
+    printf("test_circuit_file_tokenizer_handles_edge_cases passed!\n");
 }
 
-static void test_equation_values_with_unknown_inputs(void) {
-    AppContext app;
+static void test_circuit_binary_round_trip(void) {
+    static LogicGraph text_graph;
+    static LogicGraph binary_graph;
+    static AppContext app;
+    char text_path[] = "/tmp/mlvd-test-circ-XXXXXX";
+    char binary_path[64];
+    char back_path[64];
+    char error_message[128];
+    LogicNode *sum;
+    FILE *file;
+    int fd;
+
+    fd = mkstemp(text_path);
+    assert(fd >= 0);
+    close(fd);
+    snprintf(binary_path, sizeof(binary_path), "%s.circb", text_path);
+    snprintf(back_path, sizeof(back_path), "%s.circ", text_path);
+    write_text_file(
+        text_path,
+        "input A\n"
+        "input B\n"
+        "xor X1\n"
+        "and G1\n"
+        "output SUM\n"
+        "output CARRY\n"
+        "wire A -> X1.in0\n"
+        "wire B -> X1.in1\n"
+        "wire A -> G1.in0\n"
+        "wire B -> G1.in1\n"
+        "wire X1 -> SUM\n"
+        "wire G1 -> CARRY\n"
+    );
+
+    assert(circuit_file_convert(text_path, binary_path, error_message, sizeof(error_message)));
+    assert(circuit_file_convert(binary_path, back_path, error_message, sizeof(error_message)));
+    logic_init_graph(&text_graph);
+    logic_init_graph(&binary_graph);
+    assert(circuit_file_load_graph(&text_graph, text_path, error_message, sizeof(error_message)));
+    assert(circuit_file_load_graph(&binary_graph, binary_path, error_message, sizeof(error_message)));
+    assert(binary_graph.node_count == text_graph.node_count);
+    assert(binary_graph.net_count == text_graph.net_count);
+    assert(strcmp(binary_graph.nodes[4].name, "SUM") == 0);
+    assert(circuit_file_load_graph(&binary_graph, back_path, error_message, sizeof(error_message)));
+    assert(binary_graph.net_count == text_graph.net_count);
+
+    app_init(&app);
+    assert(circuit_file_load(&app, binary_path, error_message, sizeof(error_message)));
+    sum = find_node_by_name(&app, "SUM");
+    assert(sum != NULL);
+    assert(app.analysis.truth_table != NULL && app.analysis.truth_table->row_count == 4U);
+
+    file = fopen(binary_path, "r+b");
+    assert(file != NULL);
+    assert(fseek(file, 12L, SEEK_SET) == 0);
+    assert(fputc(0x7F, file) != EOF);
+    fclose(file);
+    assert(!circuit_file_load_graph(&binary_graph, binary_path, error_message, sizeof(error_message)));
+    assert(strstr(error_message, ".circb") != NULL);
+
+    unlink(text_path);
+    unlink(binary_path);
+    unlink(back_path);
+    app_clear_graph(&app);
+    logic_clear_graph(&text_graph);
+    logic_clear_graph(&binary_graph);
+    printf("test_circuit_binary_round_trip passed!\n");
+}
+
+static void test_circuit_file_build_graph_swaps_into_app(void) {
+    static LogicGraph graph;
+    static GraphGeometry geometry;
+    static AppContext app;
+    char path[] = "/tmp/mlvd-test-circ-XXXXXX";
+    char error_message[128];
+    LogicNode *sum;
+    LogicNode *gate;
+    uint32_t index;
+    int fd;
+
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    write_text_file(
+        path,
+        "input A\n"
+        "input B\n"
+        "xor X1\n"
+        "output SUM\n"
+        "wire A -> X1.in0\n"
+        "wire B -> X1.in1\n"
+        "wire X1 -> SUM\n"
+    );
+
+    logic_init_graph(&graph);
+    assert(circuit_file_build_graph(&graph, &geometry, path, error_message, sizeof(error_message)));
+    assert(graph.node_count == 4U && graph.net_count == 3U);
+    assert(geometry.positions[2].x > geometry.positions[0].x);
+
+    app_init(&app);
+    app_add_named_node(&app, NODE_GATE_AND, "OLD", (Vector2){ 0.0f, 0.0f });
+    circuit_file_swap_graph(&app, &graph, &geometry);
+    assert(graph.node_count == 0U);
+    assert(find_node_by_name(&app, "OLD") == NULL);
+    sum = find_node_by_name(&app, "SUM");
+    gate = find_node_by_name(&app, "X1");
+    assert(sum != NULL && gate != NULL);
+    assert(gate->inputs[1].node == gate && sum->inputs[0].node == sum);
+    assert(fabsf(app_node_position(&app, gate).x - geometry.positions[2].x) < 0.001f);
+    for (index = 0U; index < app.graph.net_count; index++) {
+        assert(app.graph.nets[index].source->node >= app.graph.nodes);
+        assert(app.graph.nets[index].source->node < app.graph.nodes + app.graph.node_count);
+    }
+    assert(app.analysis.truth_table != NULL && app.analysis.truth_table->row_count == 4U);
+
+    write_text_file(path, "input A\nwire A -> NOPE.in0\n");
+    assert(!circuit_file_build_graph(&graph, &geometry, path, error_message, sizeof(error_message)));
+    assert(graph.node_count == 0U);
+
+    unlink(path);
+    app_clear_graph(&app);
+    printf("test_circuit_file_build_graph_swaps_into_app passed!\n");
+}
+
+static void test_graph_revisions_never_repeat_across_clear_and_move(void) {
+    static LogicGraph graph;
+    static LogicGraph moved;
+    uint32_t built;
+    uint32_t before_move;
+
+    logic_init_graph(&graph);
+    logic_init_graph(&moved);
+    assert(logic_add_node(&graph, NODE_INPUT, "a"));
+    built = graph.revision;
+
+    // Rebuilding the same edits after a clear must not look fresh to a cache.
+    logic_clear_graph(&graph);
+    assert(graph.revision != built);
+    assert(logic_add_node(&graph, NODE_INPUT, "a"));
+    assert(graph.revision != built);
+
+    before_move = graph.revision;
+    logic_move_graph(&moved, &graph);
+    assert(moved.revision != before_move);
+    assert(graph.revision != before_move && graph.revision != moved.revision);
+    assert(moved.node_count == 1U);
+    logic_clear_graph(&moved);
+    printf("test_graph_revisions_never_repeat_across_clear_and_move passed!\n");
+}
+
+static void test_circuit_file_reload_edits_graph_in_place(void) {
+    static AppContext app;
+    char path[] = "/tmp/mlvd-test-circ-XXXXXX";
+    char error_message[128];
+    LogicNode *gate;
+    LogicNode *flop;
+    LogicNode *input_c;
+    uint32_t revision;
+    uint32_t index;
+    bool rewired;
+    int fd;
+
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    write_text_file(
+        path,
+        "input A\n"
+        "input B\n"
+        "and G1\n"
+        "dff D1\n"
+        "output Y\n"
+        "wire A -> G1.in0\n"
+        "wire B -> G1.in1\n"
+        "wire G1 -> Y\n"
+    );
+
+    app_init(&app);
+    assert(circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    app_set_source_path(&app, path);
+    gate = find_node_by_name(&app, "G1");
+    flop = find_node_by_name(&app, "D1");
+    assert(gate != NULL && flop != NULL);
+    app_set_node_position(&app, gate, (Vector2){ 500.0f, 500.0f });
+    flop->state = LOGIC_HIGH;
+
+    revision = app.graph.revision;
+    assert(circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    assert(app.graph.revision == revision);
+
+    write_text_file(
+        path,
+        "input A\n"
+        "input C\n"
+        "and G1\n"
+        "dff D1\n"
+        "output Y\n"
+        "wire A -> G1.in0\n"
+        "wire C -> G1.in1\n"
+        "wire G1 -> Y\n"
+    );
+    assert(circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    assert(find_node_by_name(&app, "G1") == gate);
+    assert(fabsf(app_node_position(&app, gate).x - 500.0f) < 0.001f && fabsf(app_node_position(&app, gate).y - 500.0f) < 0.001f);
+    assert(flop->state == LOGIC_HIGH);
+    assert(find_node_by_name(&app, "B") == NULL);
+    input_c = find_node_by_name(&app, "C");
+    assert(input_c != NULL);
+
+    rewired = false;
+    for (index = 0U; index < app.graph.net_count; index++) {
+        if (app.graph.nets[index].source == &input_c->outputs[0]) {
+            rewired = app.graph.nets[index].sink_count == 1U && app.graph.nets[index].sinks[0] == &gate->inputs[1];
+        }
+    }
+    assert(rewired);
+    assert(app.analysis.truth_table != NULL && app.analysis.truth_table->row_count == 4U);
+
+    unlink(path);
+    app_clear_graph(&app);
+    printf("test_circuit_file_reload_edits_graph_in_place passed!\n");
+}
+
+static void test_circuit_file_save_round_trips_atomically(void) {
+    static LogicGraph loaded;
+    static AppContext app;
+    char path[] = "/tmp/mlvd-test-circ-XXXXXX";
+    char error_message[128];
+    char text[512];
+    LogicNode *a;
+    LogicNode *gate;
+    LogicNode *out;
+    FILE *file;
+    size_t length;
+    int fd;
+
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    app_init(&app);
+    a = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 140.0f, 160.0f });
+    gate = app_add_named_node(&app, NODE_GATE_NOT, "N1", (Vector2){ 320.0f, -40.0f });
+    out = app_add_named_node(&app, NODE_OUTPUT, "Y", (Vector2){ 520.5f, 160.0f });
+    assert(logic_connect(&app.graph, &a->outputs[0], &gate->inputs[0]));
+    assert(logic_connect(&app.graph, &gate->outputs[0], &out->inputs[0]));
+    assert(circuit_file_save(&app.graph, app.geometry.positions, path, error_message, sizeof(error_message)));
+
+    file = fopen(path, "r");
+    assert(file != NULL);
+    length = fread(text, 1U, sizeof(text) - 1U, file);
+    fclose(file);
+    text[length] = '\0';
+    assert(strstr(text, "not N1 at 320,-40\n") != NULL);
+    assert(strstr(text, "output Y at 520.5,160\n") != NULL);
+    assert(strstr(text, "wire N1.out0 -> Y.in0\n") != NULL);
+
+    logic_init_graph(&loaded);
+    assert(circuit_file_load_graph(&loaded, path, error_message, sizeof(error_message)));
+    assert(loaded.node_count == 3U && loaded.net_count == 2U);
+
+    // Headless saves carry no geometry and leave the "at" clauses out.
+    assert(circuit_file_save(&loaded, NULL, path, error_message, sizeof(error_message)));
+    file = fopen(path, "r");
+    assert(file != NULL);
+    length = fread(text, 1U, sizeof(text) - 1U, file);
+    fclose(file);
+    text[length] = '\0';
+    assert(strstr(text, "not N1\n") != NULL);
+    assert(strstr(text, " at ") == NULL);
+
+    app_add_named_node(&app, NODE_GATE_AND, "G 2", (Vector2){ 0.0f, 0.0f });
+    assert(!circuit_file_save(&app.graph, app.geometry.positions, path, error_message, sizeof(error_message)));
+    assert(circuit_file_load_graph(&loaded, path, error_message, sizeof(error_message)));
+    assert(loaded.node_count == 3U);
+
+    unlink(path);
+    app_clear_graph(&app);
+    logic_clear_graph(&loaded);
+    printf("test_circuit_file_save_round_trips_atomically passed!\n");
+}
+
+// `assign y = ` with `depth` copies of `open` around a, closed by `close`.
+static void write_nested_verilog(const char *path, uint32_t depth, char open, char close) {
+    char *text;
+    size_t length;
+    uint32_t index;
+
+    text = (char *)malloc((size_t)depth * 2U + 128U);
+    assert(text != NULL);
+    length = (size_t)snprintf(text, 128U, "module top(a, y);\n  input a;\n  output y;\n  assign y = ");
+    for (index = 0U; index < depth; index++) {
+        text[length++] = open;
+    }
+    text[length++] = 'a';
+    for (index = 0U; close != '\0' && index < depth; index++) {
+        text[length++] = close;
+    }
+    snprintf(text + length, 128U, ";\nendmodule\n");
+    write_text_file(path, text);
+    free(text);
+}
+
+static void test_circuit_verilog_import(void) {
+    static AppContext app;
+    char base[] = "/tmp/mlvd-test-circ-XXXXXX";
+    char path[64];
+    char error_message[128];
+    LogicNode *q;
+    LogicNode *y;
+    int fd;
+
+    fd = mkstemp(base);
+    assert(fd >= 0);
+    close(fd);
+    snprintf(path, sizeof(path), "%s.v", base);
+
+    write_text_file(
+        path,
+        "// a wide nand, an xnor expression and a flip-flop\n"
+        "module top(a, b, c, y, q);\n"
+        "  input a, b, c;\n"
+        "  output y, q;\n"
+        "  wire n;\n"
+        "  nand g1 (n, a, b, c);\n"
+        "  assign y = ~(a ^ n);\n"
+        "  dff r1 (.Q(q), .D(y), .CLK(c));\n"
+        "endmodule\n"
+    );
+    app_init(&app);
+    assert(circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    assert(app.graph.node_count == 10U && app.graph.net_count == 8U);
+    // The node driving a widened gate's output keeps the gate's name.
+    assert(find_node_by_name(&app, "g1")->type == NODE_GATE_NAND);
+    assert(find_node_by_name(&app, "g1$1")->type == NODE_GATE_AND);
+    assert(find_incoming_net_for_sink(&app, &find_node_by_name(&app, "g1")->inputs[0])->source->node == find_node_by_name(&app, "g1$1"));
+    y = find_node_by_name(&app, "y");
+    assert(find_incoming_net_for_sink(&app, &y->inputs[0])->source->node->type == NODE_GATE_NOT);
+    q = find_node_by_name(&app, "r1");
+    assert(q->type == NODE_GATE_DFF);
+    assert(find_incoming_net_for_sink(&app, &q->inputs[0]) == find_incoming_net_for_sink(&app, &y->inputs[0]));
+    assert(strcmp(find_incoming_net_for_sink(&app, &q->inputs[1])->source->node->name, "c") == 0);
+
+    write_text_file(
+        path,
+        "module top(a, b, c, y);\n"
+        "  input a, b, c;\n"
+        "  output y;\n"
+        "  xnor g2 (y, a, b, c);\n"
+        "endmodule\n"
+    );
+    assert(circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    assert(find_node_by_name(&app, "g2")->type == NODE_GATE_NOT);
+    assert(find_incoming_net_for_sink(&app, &find_node_by_name(&app, "y")->inputs[0])->source->node == find_node_by_name(&app, "g2"));
+    assert(find_incoming_net_for_sink(&app, &find_node_by_name(&app, "g2")->inputs[0])->source->node->type == NODE_GATE_XOR);
+
+    write_text_file(
+        path,
+        "module top(a, y);\n"
+        "  input a;\n"
+        "  output y;\n"
+        "  reg r;\n"
+        "endmodule\n"
+    );
+    assert(!circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    assert(strstr(error_message, "Line 4:") != NULL);
+
+    // Deep nesting is an error, not a stack overflow.
+    write_nested_verilog(path, 256U, '(', ')');
+    assert(circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    write_nested_verilog(path, 257U, '(', ')');
+    assert(!circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    assert(strcmp(error_message, "Line 4: expression nested too deeply") == 0);
+    write_nested_verilog(path, 300000U, '~', '\0');
+    assert(!circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    assert(strstr(error_message, "nested too deeply") != NULL);
+
+    unlink(path);
+    unlink(base);
+    app_clear_graph(&app);
+    printf("test_circuit_verilog_import passed!\n");
+}
+
+static void test_circuit_bench_and_blif_import(void) {
+    static AppContext app;
+    char base[] = "/tmp/mlvd-test-circ-XXXXXX";
+    char path[64];
+    char error_message[128];
+    const char *input_names[] = { "1", "2", "3", "6", "7" };
+    LogicNode *y;
+    uint32_t index;
+    int fd;
+
+    app_init(&app);
+    assert(circuit_file_load(&app, "examples/c17.bench", error_message, sizeof(error_message)));
+    assert(app.graph.node_count == 13U && app.graph.net_count == 11U);
+    for (index = 0U; index < 5U; index++) {
+        find_node_by_name(&app, input_names[index])->outputs[0].value = LOGIC_HIGH;
+    }
+    logic_evaluate(&app.graph);
+    assert(find_node_by_name(&app, "22")->inputs[0].value == LOGIC_HIGH);
+    assert(find_node_by_name(&app, "23")->inputs[0].value == LOGIC_LOW);
+
+    fd = mkstemp(base);
+    assert(fd >= 0);
+    close(fd);
+    snprintf(path, sizeof(path), "%s.blif", base);
+    write_text_file(
+        path,
+        ".model xor_latch\n"
+        ".inputs a b \\\n"
+        "  en\n"
+        ".outputs y q\n"
+        ".names a b y  # xor as an on-set cover\n"
+        "01 1\n"
+        "10 1\n"
+        ".latch y q ah en 0\n"
+        ".end\n"
+    );
+    assert(circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    y = find_node_by_name(&app, "y");
+    find_node_by_name(&app, "a")->outputs[0].value = LOGIC_HIGH;
+    find_node_by_name(&app, "b")->outputs[0].value = LOGIC_LOW;
+    logic_evaluate(&app.graph);
+    assert(y->inputs[0].value == LOGIC_HIGH);
+    find_node_by_name(&app, "b")->outputs[0].value = LOGIC_HIGH;
+    logic_evaluate(&app.graph);
+    assert(y->inputs[0].value == LOGIC_LOW);
+    assert(find_incoming_net_for_sink(&app, &find_node_by_name(&app, "q")->inputs[0])->source->node->type == NODE_GATE_LATCH);
+
+    write_text_file(path, ".inputs a b\n.outputs y\n.names a b y\n11 1\n00 0\n");
+    assert(!circuit_file_load(&app, path, error_message, sizeof(error_message)));
+    assert(strstr(error_message, "Line 5:") != NULL);
+
+    unlink(path);
+    unlink(base);
+    app_clear_graph(&app);
+    printf("test_circuit_bench_and_blif_import passed!\n");
+}
+
+static void test_sim_cli_runs_stimulus(void) {
+    char circuit_path[] = "/tmp/mlvd-cli-circ-XXXXXX";
+    char stimulus_path[] = "/tmp/mlvd-cli-stim-XXXXXX";
+    char error_message[128];
+    char text[1024];
+    SimCliOptions options;
+    FILE *stream;
+    size_t length;
+    int fd;
+
+    fd = mkstemp(circuit_path);
+    assert(fd >= 0);
+    close(fd);
+    fd = mkstemp(stimulus_path);
+    assert(fd >= 0);
+    close(fd);
+    write_text_file(
+        circuit_path,
+        "input D\nclock CLK\ndff R\nand G\noutput Q\noutput Y\n"
+        "wire D -> R.in0\nwire CLK -> R.in1\nwire R -> Q\nwire D -> G.in0\nwire D -> G.in1\nwire G -> Y\n"
+    );
+    write_text_file(stimulus_path, "# set D, then clock it in\nD=1\ntick 1\nD=0 tick 2\n");
+
+    memset(&options, 0, sizeof(options));
+    options.circuit_path = circuit_path;
+    options.stimulus_path = stimulus_path;
+    stream = tmpfile();
+    assert(stream != NULL);
+    assert(sim_cli_run(&options, stream, error_message, sizeof(error_message)));
+    rewind(stream);
+    length = fread(text, 1U, sizeof(text) - 1U, stream);
+    text[length] = '\0';
+    fclose(stream);
+    assert(strncmp(text, "step D CLK | Q Y\n", 17U) == 0);
+    assert(strstr(text, "   1 1   X | 0 1\n") != NULL);
+    assert(strstr(text, "   2 1   1 | 1 1\n") != NULL);
+    assert(strstr(text, "   3 0   0 | 1 0\n") != NULL);
+    assert(strstr(text, "   4 0   1 | 0 0\n") != NULL);
+
+    options.stimulus_path = NULL;
+    options.format = SIM_CLI_FORMAT_VCD;
+    options.ticks = 2U;
+    stream = tmpfile();
+    assert(stream != NULL);
+    assert(sim_cli_run(&options, stream, error_message, sizeof(error_message)));
+    rewind(stream);
+    length = fread(text, 1U, sizeof(text) - 1U, stream);
+    text[length] = '\0';
+    fclose(stream);
+    assert(strstr(text, "$var wire 1 \" CLK $end\n") != NULL);
+    assert(strstr(text, "#2\n0\"\n") != NULL);
+
+    write_text_file(stimulus_path, "D=1\nE=1\n");
+    options.stimulus_path = stimulus_path;
+    stream = tmpfile();
+    assert(stream != NULL);
+    assert(!sim_cli_run(&options, stream, error_message, sizeof(error_message)));
+    fclose(stream);
+    assert(strstr(error_message, "Line 2:") != NULL);
+
+    unlink(circuit_path);
+    unlink(stimulus_path);
+    printf("test_sim_cli_runs_stimulus passed!\n");
+}
+
+static LogicValue stimulus_probe_value(const LogicGraph *graph, uint16_t node_index) {
+    const LogicNode *node;
+
+    node = &graph->nodes[node_index];
+    return node->type == NODE_OUTPUT ? node->inputs[0].value : node->outputs[0].value;
+}
+
+static void test_app_stimulus_replays_after_reset(void) {
+    static AppContext app;
+    char path[] = "/tmp/mlvd-app-stim-XXXXXX";
+    char error_message[128];
+    LogicNode *input;
+    LogicNode *inverter;
+    LogicNode *output;
+    int fd;
+
+    fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    write_text_file(path, "A=1 tick\nA=0 tick\n");
+
+    app_init(&app);
+    input = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 0.0f, 0.0f });
+    inverter = app_add_named_node(&app, NODE_GATE_NOT, "N", (Vector2){ 100.0f, 0.0f });
+    output = app_add_named_node(&app, NODE_OUTPUT, "Y", (Vector2){ 200.0f, 0.0f });
+    assert(logic_connect(&app.graph, &input->outputs[0], &inverter->inputs[0]));
+    assert(logic_connect(&app.graph, &inverter->outputs[0], &output->inputs[0]));
+    app_update_logic(&app);
+    assert(app_load_stimulus(&app, path, error_message, sizeof(error_message)));
+
+    app.simulation.active = true;
+    app_step_simulation(&app);
+    assert(output->inputs[0].value == LOGIC_LOW);
+    app_step_simulation(&app);
+    assert(output->inputs[0].value == LOGIC_HIGH);
+    assert(!app.simulation.active && app.simulation.playback != NULL);
+
+    app_reset_simulation(&app);
+    app.simulation.active = true;
+    app_step_simulation(&app);
+    assert(output->inputs[0].value == LOGIC_LOW);
+    assert(app.simulation.active && app.perf.ticks == 3U);
+
+    unlink(path);
+    app_clear_graph(&app);
+    printf("test_app_stimulus_replays_after_reset passed!\n");
+}
+
+static void test_stimulus_batch_matches_tick(void) {
+    static LogicGraph graph;
+    static LogicGraph reference;
+    static LogicStimulusRun run;
+    static const char text[] =
+        "clock EN 2        # toggles before every second tick\n"
+        "repeat 3 {\n"
+        "  D=1 tick 2\n"
+        "  D=0 tick\n"
+        "}\n"
+        "D=1\n";
+    char circuit_path[] = "/tmp/mlvd-stim-circ-XXXXXX";
+    char error_message[128];
+    LogicStimulus stimulus;
+    uint8_t results[10U * 5U];
+    uint32_t produced;
+    uint32_t sample;
+    uint32_t ticks;
+    uint32_t pass;
+    uint32_t probe;
+    int fd;
+
+    fd = mkstemp(circuit_path);
+    assert(fd >= 0);
+    close(fd);
+    write_text_file(
+        circuit_path,
+        "input D\ninput EN\nclock CLK\ndff R\nlatch L\nxor X\nnot N\noutput Q\noutput Y\n"
+        "wire D -> R.in0\nwire CLK -> R.in1\nwire D -> L.in0\nwire EN -> L.in1\n"
+        "wire R -> X.in0\nwire L -> X.in1\nwire X -> N\nwire R -> Q\nwire N -> Y\n"
+    );
+    logic_init_graph(&graph);
+    logic_init_graph(&reference);
+    assert(circuit_file_load_graph(&graph, circuit_path, error_message, sizeof(error_message)));
+    assert(circuit_file_load_graph(&reference, circuit_path, error_message, sizeof(error_message)));
+    unlink(circuit_path);
+
+    assert(logic_stimulus_parse(&stimulus, &graph, text, strlen(text), error_message, sizeof(error_message)));
+    assert(stimulus.sample_count == 10U);
+    logic_stimulus_run_init(&run, &graph, &stimulus);
+    assert(run.probe_count == 5U && run.driver_count == 3U);
+
+    // Small batches so playback resumes mid-TICK and mid-repeat.
+    produced = 0U;
+    while (!logic_stimulus_run_done(&run)) {
+        produced += logic_apply_stimulus_batch(&run, results + (produced * run.probe_count), 4U);
+    }
+    assert(produced == 10U);
+
+    // The same program by hand with logic_evaluate and logic_tick.
+    sample = 0U;
+    ticks = 0U;
+    for (pass = 0U; pass < 3U; pass++) {
+        uint32_t step;
+        uint32_t tick_count;
+
+        for (step = 0U; step < 2U; step++) {
+            reference.nodes[0].outputs[0].value = step == 0U ? LOGIC_HIGH : LOGIC_LOW;
+            for (tick_count = 0U; tick_count < (step == 0U ? 2U : 1U); tick_count++) {
+                uint32_t column;
+
+                if (++ticks % 2U == 0U) {
+                    reference.nodes[1].outputs[0].value = reference.nodes[1].outputs[0].value == LOGIC_HIGH ? LOGIC_LOW : LOGIC_HIGH;
+                }
+                logic_evaluate(&reference);
+                logic_tick(&reference);
+                for (column = 0U; column < run.probe_count; column++) {
+                    assert(results[(sample * run.probe_count) + column] == stimulus_probe_value(&reference, run.probes[column]));
+                }
+                sample++;
+            }
+        }
+    }
+    reference.nodes[0].outputs[0].value = LOGIC_HIGH;
+    logic_evaluate(&reference);
+    for (probe = 0U; probe < run.probe_count; probe++) {
+        assert(results[(9U * run.probe_count) + probe] == stimulus_probe_value(&reference, run.probes[probe]));
+        assert(stimulus_probe_value(&graph, run.probes[probe]) == stimulus_probe_value(&reference, run.probes[probe]));
+    }
+    for (probe = 0U; probe < graph.node_count; probe++) {
+        assert(graph.nodes[probe].state == reference.nodes[probe].state);
+    }
+    logic_stimulus_release(&stimulus);
+
+    assert(!logic_stimulus_parse(&stimulus, &graph, "repeat 2 {\nD=1\n", 15U, error_message, sizeof(error_message)));
+    assert(strstr(error_message, "Line 2:") != NULL);
+    assert(!logic_stimulus_parse(&stimulus, &graph, "clock Q\n", 8U, error_message, sizeof(error_message)));
+    assert(strstr(error_message, "unknown input") != NULL);
+
+    logic_clear_graph(&graph);
+    logic_clear_graph(&reference);
+    printf("test_stimulus_batch_matches_tick passed!\n");
+}
+
+// Drives the inputs in graph order from the bits of `inputs`, first input in
+// bit 0.
+static void drive_packed(LogicGraph *graph, uint64_t inputs) {
+    uint32_t input_bit;
+    uint32_t index;
+
+    input_bit = 0U;
+    for (index = 0U; index < graph->node_count; index++) {
+        if (graph->nodes[index].type == NODE_INPUT) {
+            graph->nodes[index].outputs[0].value = ((inputs >> input_bit++) & 1U) != 0U ? LOGIC_HIGH : LOGIC_LOW;
+        }
+    }
+}
+
+// Packs the outputs the same way, which must all be known.
+static uint64_t read_packed(const LogicGraph *graph) {
+    uint64_t outputs;
+    uint32_t output_bit;
+    uint32_t index;
+
+    outputs = 0U;
+    output_bit = 0U;
+    for (index = 0U; index < graph->node_count; index++) {
+        if (graph->nodes[index].type == NODE_OUTPUT) {
+            assert(graph->nodes[index].inputs[0].value == LOGIC_LOW || graph->nodes[index].inputs[0].value == LOGIC_HIGH);
+            outputs |= (uint64_t)(graph->nodes[index].inputs[0].value == LOGIC_HIGH) << output_bit++;
+        }
+    }
+    return outputs;
+}
+
+static uint64_t evaluate_packed(LogicGraph *graph, uint64_t inputs) {
+    drive_packed(graph, inputs);
+    logic_evaluate(graph);
+    return read_packed(graph);
+}
+
+// One full clock period, rising edge first, on nothing but logic_tick's own
+// evaluation, so a register whose logic settles late shows up as X.
+static uint64_t tick_packed(LogicGraph *graph, uint64_t inputs) {
+    drive_packed(graph, inputs);
+    logic_tick(graph);
+    logic_tick(graph);
+    return read_packed(graph);
+}
+
+static const LogicNet *graph_net_for_sink(const LogicGraph *graph, const LogicPin *sink_pin) {
+    uint32_t net_index;
+    uint8_t sink_index;
+
+    for (net_index = 0U; net_index < graph->net_count; net_index++) {
+        for (sink_index = 0U; sink_index < graph->nets[net_index].sink_count; sink_index++) {
+            if (graph->nets[net_index].sinks[sink_index] == sink_pin) {
+                return &graph->nets[net_index];
+            }
+        }
+    }
+    return NULL;
+}
+
+static void build_generated(LogicGraph *graph, CircuitGenKind kind, uint32_t bits) {
+    CircuitGenParams params;
+    char error_message[128];
+
+    circuit_gen_params_init(&params, kind);
+    params.bits = bits;
+    assert(circuit_gen_build(graph, &params, error_message, sizeof(error_message)));
+}
+
+static void test_circuit_gen_builds_working_circuits(void) {
+    static LogicGraph graph;
+    static LogicGraph loaded;
+    char path[] = "/tmp/mlvd-gen-XXXXXX.circb";
+    char error_message[128];
+    CircuitGenParams params;
+    uint32_t level[MAX_NODES];
+    uint32_t depth;
+    uint32_t a;
+    uint32_t b;
+    uint32_t index;
+    struct stat info;
+    int fd;
+
+    logic_init_graph(&graph);
+    logic_init_graph(&loaded);
+
+    // Inputs go A0, B0, A1, B1, ..., CIN.
+    build_generated(&graph, CIRCUIT_GEN_LOOKAHEAD_ADDER, 4U);
+    for (a = 0U; a < 16U; a++) {
+        for (b = 0U; b < 32U; b++) {
+            uint64_t packed;
+
+            packed = (uint64_t)(b >> 4) << 8;
+            for (index = 0U; index < 4U; index++) {
+                packed |= (uint64_t)(((a >> index) & 1U) | (((b >> index) & 1U) << 1)) << (index * 2U);
+            }
+            assert(evaluate_packed(&graph, packed) == a + (b & 15U) + (b >> 4));
+        }
+    }
+
+    build_generated(&graph, CIRCUIT_GEN_BARREL_SHIFTER, 8U);
+    for (a = 0U; a < 256U; a += 7U) {
+        for (b = 0U; b < 8U; b++) {
+            assert(evaluate_packed(&graph, a | (b << 8)) == ((a << b) & 0xFFU));
+        }
+    }
+
+    // Nine bits puts every operand bit behind a buffer tree.
+    build_generated(&graph, CIRCUIT_GEN_MULTIPLIER, 9U);
+    for (a = 0U; a < 512U; a += 97U) {
+        for (b = 1U; b < 512U; b += 131U) {
+            assert(evaluate_packed(&graph, a | (b << 9)) == a * b);
+        }
+    }
+
+    // The decoder also round-trips through .circb, which carries no layout.
+    // The save replaces the file rather than rewriting it, so the copy still
+    // open here keeps its old (empty) contents.
+    build_generated(&graph, CIRCUIT_GEN_DECODER, 3U);
+    fd = mkstemps(path, 6);
+    assert(fd >= 0);
+    assert(circuit_gen_save(&graph, path, error_message, sizeof(error_message)));
+    assert(fstat(fd, &info) == 0 && info.st_size == 0);
+    close(fd);
+    assert(stat(path, &info) == 0 && info.st_size > 0 && (info.st_mode & 0777) == 0600);
+    assert(circuit_file_load_graph(&loaded, path, error_message, sizeof(error_message)));
+    unlink(path);
+    assert(loaded.node_count == graph.node_count);
+    for (a = 0U; a < 8U; a++) {
+        assert(evaluate_packed(&graph, a) == 1U << a);
+        assert(evaluate_packed(&loaded, a) == 1U << a);
+    }
+
+    // Gates come after their sources, so one pass finds the longest path.
+    circuit_gen_params_init(&params, CIRCUIT_GEN_RANDOM_DAG);
+    params.inputs = 16U;
+    params.gates = 300U;
+    params.depth = 12U;
+    params.max_fanout = 4U;
+    params.fanout_skew = 50U;
+    params.seed = 99U;
+    assert(circuit_gen_build(&graph, &params, error_message, sizeof(error_message)));
+    assert(graph.node_count == 324U);
+    depth = 0U;
+    memset(level, 0, sizeof(level));
+    for (index = 0U; index < graph.net_count; index++) {
+        assert(graph.nets[index].sink_count <= 4U);
+    }
+    for (index = 0U; index < graph.node_count; index++) {
+        const LogicNode *node;
+        uint32_t pin;
+
+        node = &graph.nodes[index];
+        if (node->type == NODE_INPUT || node->type == NODE_OUTPUT) {
+            continue;
+        }
+        for (pin = 0U; pin < node->input_count; pin++) {
+            const LogicNet *net;
+            uint32_t source;
+
+            net = graph_net_for_sink(&graph, &node->inputs[pin]);
+            assert(net);
+            source = (uint32_t)(net->source->node - graph.nodes);
+            assert(source < index);
+            level[index] = level[source] + 1U > level[index] ? level[source] + 1U : level[index];
+        }
+        depth = level[index] > depth ? level[index] : depth;
+    }
+    assert(depth == 12U);
+
+    params.max_fanout = 1U;
+    assert(!circuit_gen_build(&graph, &params, error_message, sizeof(error_message)));
+    assert(graph.node_count == 0U);
+    params.kind = CIRCUIT_GEN_LOOKAHEAD_ADDER;
+    params.bits = 64U;
+    assert(!circuit_gen_build(&graph, &params, error_message, sizeof(error_message)));
+
+    logic_clear_graph(&graph);
+    logic_clear_graph(&loaded);
+    printf("test_circuit_gen_builds_working_circuits passed!\n");
+}
+
+// engine_bench times the 4x4 and 8x8 multipliers. Every operand pair is
+// checked here: 15 * 15 needs the carry that ripples into an empty top
+// slot, which an earlier version of the builder dropped.
+static void test_circuit_gen_multiplier_keeps_top_carry(void) {
+    static LogicGraph graph;
+    uint32_t a;
+    uint32_t b;
+
+    logic_init_graph(&graph);
+    build_generated(&graph, CIRCUIT_GEN_MULTIPLIER, 4U);
+    for (a = 0U; a < 16U; a++) {
+        for (b = 0U; b < 16U; b++) {
+            assert(evaluate_packed(&graph, a | (b << 4)) == a * b);
+        }
+    }
+    build_generated(&graph, CIRCUIT_GEN_MULTIPLIER, 8U);
+    assert(evaluate_packed(&graph, 255U | (255U << 8)) == 255U * 255U);
+    assert(evaluate_packed(&graph, 128U | (255U << 8)) == 128U * 255U);
+
+    printf("test_circuit_gen_multiplier_keeps_top_carry passed!\n");
+}
+
+// Nine and ten bits need two CLOCK nodes, so the registers also span clocks.
+static void test_circuit_gen_clocks_sequential_circuits(void) {
+    static LogicGraph graph;
+    static bool seen[1U << 9];
+    uint64_t expected;
+    uint64_t state;
+    uint32_t edge;
+
+    logic_init_graph(&graph);
+
+    // XNOR feedback from the 9-bit taps (bits 4 and 8) walks all 511 states
+    // but all-ones, starting from the flip-flops' power-up zero.
+    build_generated(&graph, CIRCUIT_GEN_LFSR, 9U);
+    memset(seen, 0, sizeof(seen));
+    state = evaluate_packed(&graph, 0U);
+    assert(state == 0U);
+    for (edge = 0U; edge < 511U; edge++) {
+        assert(!seen[state]);
+        seen[state] = true;
+        expected = ((state << 1) | (((state >> 4) ^ (state >> 8) ^ 1U) & 1U)) & 0x1FFU;
+        state = tick_packed(&graph, 0U);
+        assert(state == expected);
+    }
+    assert(state == 0U && !seen[0x1FFU]);
+
+    // Holds while EN is low, then counts and wraps.
+    build_generated(&graph, CIRCUIT_GEN_COUNTER, 10U);
+    assert(evaluate_packed(&graph, 0U) == 0U);
+    for (edge = 0U; edge < 3U; edge++) {
+        assert(tick_packed(&graph, 0U) == 0U);
+    }
+    assert(evaluate_packed(&graph, 1U) == 0U);
+    for (edge = 1U; edge <= 1030U; edge++) {
+        assert(tick_packed(&graph, 1U) == (edge & 0x3FFU));
+    }
+    assert(evaluate_packed(&graph, 0U) == (1030U & 0x3FFU));
+    assert(tick_packed(&graph, 0U) == (1030U & 0x3FFU));
+
+    // SIN enters R0 on the edge that samples it and reaches SOUT, the
+    // twelfth stage, eleven edges later.
+    build_generated(&graph, CIRCUIT_GEN_SHIFT_REGISTER, 12U);
+    assert(evaluate_packed(&graph, 0U) == 0U);
+    for (edge = 0U; edge < 40U; edge++) {
+        state = tick_packed(&graph, (0xB2C5U >> (edge % 16U)) & 1U);
+        assert(state == (edge < 11U ? 0U : (0xB2C5U >> ((edge - 11U) % 16U)) & 1U));
+    }
+
+    logic_clear_graph(&graph);
+    printf("test_circuit_gen_clocks_sequential_circuits passed!\n");
+}
+
+// Records one zone named after the thread, then exits and frees its ring.
+static void *trace_test_thread(void *name) {
+    trace_set_thread_name((const char *)name);
+    trace_begin((const char *)name);
+    trace_end();
+    return NULL;
+}
+
+// Closes more zones than a ring holds.
+static void *trace_test_wrap_thread(void *name) {
+    uint32_t count;
+
+    for (count = 0U; count < TRACE_RING_EVENTS + 100U; count++) {
+        trace_begin((const char *)name);
+        trace_end();
+    }
+    return NULL;
+}
+
+// Reads the whole dump into a malloc'd string.
+static char *trace_test_dump(long *length) {
+    FILE *stream;
+    char *text;
+
+    stream = tmpfile();
+    assert(stream != NULL);
+    assert(trace_write_chrome_json(stream));
+    *length = ftell(stream);
+    assert(*length > 0);
+    text = (char *)malloc((size_t)*length + 1U);
+    assert(text != NULL);
+    rewind(stream);
+    assert(fread(text, 1U, (size_t)*length, stream) == (size_t)*length);
+    text[*length] = '\0';
+    fclose(stream);
+    return text;
+}
+
+// A zone in the dump must sit on the track named after the thread that
+// recorded it, even when that thread's ring has since changed hands.
+static bool trace_test_zone_on_own_track(const char *text, const char *name) {
+    char pattern[96];
+    const char *zone;
+    unsigned int tid;
+
+    snprintf(pattern, sizeof(pattern), "{\"name\": \"%s\", \"cat\"", name);
+    zone = strstr(text, pattern);
+    if (!zone) {
+        return false;
+    }
+    zone = strstr(zone, "\"tid\": ");
+    assert(zone != NULL && sscanf(zone, "\"tid\": %u", &tid) == 1);
+    snprintf(pattern, sizeof(pattern), "\"tid\": %u, \"args\": {\"name\": \"%s\"}", tid, name);
+    assert(strstr(text, pattern) != NULL);
+    return true;
+}
+
+static void test_trace_writes_nested_zones_as_chrome_json(void) {
+    static const char first_name[] = "trace test first";
+    static const char second_name[] = "trace test second";
+    static const char wrap_name[] = "trace test wrap";
+    static const char wrap_zone[] = "{\"name\": \"trace test wrap\", \"cat\"";
+    pthread_t thread;
+    char error_message[128];
+    char *text;
+    const char *inner;
+    const char *outer;
+    const char *zone;
+    uint32_t count;
+    long length;
+    LogicGraph graph;
+
+    trace_set_thread_name("test main");
+    trace_begin("test_trace_outer");
+    trace_begin("test_trace_inner");
+    trace_end();
+    trace_end();
+    trace_end(); // unbalanced ends are ignored
+    logic_init_graph(&graph);
+    logic_add_node(&graph, NODE_INPUT, "A");
+    logic_evaluate(&graph);
+    assert(!circuit_file_load_graph(&graph, "/nonexistent/trace-test.circ", error_message, sizeof(error_message)));
+    logic_clear_graph(&graph);
+
+    text = trace_test_dump(&length);
+    assert(strncmp(text, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", 43U) == 0);
+    assert(strstr(text, "\"args\": {\"name\": \"test main\"}") != NULL);
+    inner = strstr(text, "{\"name\": \"test_trace_inner\", \"cat\": \"logicsim\", \"ph\": \"X\"");
+    outer = strstr(text, "{\"name\": \"test_trace_outer\", \"cat\": \"logicsim\", \"ph\": \"X\"");
+    assert(inner != NULL && outer != NULL && inner < outer);
+#if LOGICSIM_TRACE
+    assert(strstr(outer, "\"name\": \"circuit_file_open_spec\"") != NULL);
+#endif
+    // Evaluation is the inner loop of every table and grade, so it stays untimed.
+    assert(strstr(text, "\"name\": \"logic_evaluate\"") == NULL);
+    assert(strcmp(text + length - 4, "\n]}\n") == 0);
+    free(text);
+
+    // The second thread reuses the first one's ring.
+    assert(pthread_create(&thread, NULL, trace_test_thread, (void *)(uintptr_t)first_name) == 0);
+    assert(pthread_join(thread, NULL) == 0);
+    assert(pthread_create(&thread, NULL, trace_test_thread, (void *)(uintptr_t)second_name) == 0);
+    assert(pthread_join(thread, NULL) == 0);
+    text = trace_test_dump(&length);
+#if LOGICSIM_TRACE
+    assert(trace_test_zone_on_own_track(text, second_name));
+#endif
+    trace_test_zone_on_own_track(text, first_name);
+    free(text);
+
+    // A wrapped ring is dumped from its newest half only.
+    assert(pthread_create(&thread, NULL, trace_test_wrap_thread, (void *)(uintptr_t)wrap_name) == 0);
+    assert(pthread_join(thread, NULL) == 0);
+    text = trace_test_dump(&length);
+    count = 0U;
+    zone = strstr(text, wrap_zone);
+    while (zone) {
+        count++;
+        zone = strstr(zone + 1, wrap_zone);
+    }
+    assert(count == TRACE_RING_EVENTS / 2U);
+    free(text);
+    printf("test_trace_writes_nested_zones_as_chrome_json passed!\n");
+}
+
+static void test_perf_hud_summarizes_frames_and_ticks(void) {
+    static AppContext app;
+    static PerfHud hud;
+    LogicNode *input;
+    LogicNode *inverter;
+    LogicNode *output;
+    uint32_t frame;
+
+    app_init(&app);
+    input = app_add_node(&app, NODE_INPUT, (Vector2){ 0.0f, 0.0f });
+    inverter = app_add_node(&app, NODE_GATE_NOT, (Vector2){ 100.0f, 0.0f });
+    output = app_add_node(&app, NODE_OUTPUT, (Vector2){ 200.0f, 0.0f });
+    assert(logic_connect(&app.graph, &input->outputs[0], &inverter->inputs[0]));
+    assert(logic_connect(&app.graph, &inverter->outputs[0], &output->inputs[0]));
+    app_update_logic(&app);
+    app_step_simulation(&app);
+    assert(app.perf.ticks == 1U);
+    assert(app.perf.tick_evaluations == 2U);
+
+    perf_hud_init(&hud);
+    app.simulation.active = true;
+    app.simulation.speed = 10.0f;
+    app.perf.update_logic_seconds = 0.002;
+    perf_hud_end_frame(&hud, &app, 0.010f, 0U, 0U, 1.0);
+    for (frame = 1U; frame <= 100U; frame++) {
+        app.perf.ticks++;
+        app.perf.tick_evaluations += 12U;
+        perf_hud_end_frame(&hud, &app, (frame == 50U || frame == 60U) ? 0.050f : 0.010f, 20U, 400U, frame < 100U ? 1.1 : 1.5);
+        assert(frame == 100U || hud.shown.histogram_total == 0U);
+    }
+
+    assert(hud.shown.histogram_total == 101U);
+    assert(fabs(hud.shown.frame_avg_ms - (1090.0 / 101.0)) < 0.01);
+    assert(fabs(hud.shown.frame_p99_ms - 50.0) < 0.01);
+    assert(hud.shown.histogram[2] == 99U);
+    assert(hud.shown.histogram[PERF_HUD_HISTOGRAM_BUCKETS - 1U] == 2U);
+    assert(fabs(hud.shown.ticks_per_second - 200.0) < 0.01);
+    assert(fabs(hud.shown.requested_hz - 10.0) < 0.01);
+    assert(fabs(hud.shown.evaluations_per_tick - 12.0) < 0.01);
+    assert(fabs(hud.shown.update_logic_ms - 2.0) < 0.01);
+    assert(hud.shown.draw_calls == 20U && hud.shown.vertices == 400U);
+#if defined(__linux__)
+    assert(hud.shown.memory_bytes > 0U);
+#endif
+    app_clear_graph(&app);
+    printf("test_perf_hud_summarizes_frames_and_ticks passed!\n");
+}
+
+static void test_logic_activity_counts_evaluations_and_toggles(void) {
+    static LogicGraph graph;
+    static LogicActivity activity;
+    LogicActivitySummary summary;
+    LogicNode *clock;
+    LogicNode *clocked_not;
+    LogicNode *clocked_out;
+    LogicNode *input;
+    LogicNode *idle_not;
+    LogicNode *idle_out;
+    uint32_t tick;
+
+    logic_init_graph(&graph);
+    clock = logic_add_node(&graph, NODE_GATE_CLOCK, "clk");
+    clocked_not = logic_add_node(&graph, NODE_GATE_NOT, "n1");
+    clocked_out = logic_add_node(&graph, NODE_OUTPUT, "q1");
+    input = logic_add_node(&graph, NODE_INPUT, "a");
+    idle_not = logic_add_node(&graph, NODE_GATE_NOT, "n2");
+    idle_out = logic_add_node(&graph, NODE_OUTPUT, "q2");
+    assert(logic_connect(&graph, &clock->outputs[0], &clocked_not->inputs[0]));
+    assert(logic_connect(&graph, &clocked_not->outputs[0], &clocked_out->inputs[0]));
+    assert(logic_connect(&graph, &input->outputs[0], &idle_not->inputs[0]));
+    assert(logic_connect(&graph, &idle_not->outputs[0], &idle_out->inputs[0]));
+    logic_evaluate(&graph);
+
+    logic_activity_reset(&activity, 1U);
+    logic_activity_attach(&graph, &activity);
+    for (tick = 0U; tick < 6U; tick++) {
+        logic_tick(&graph);
+    }
+
+    assert(activity.passes == 6U);
+    assert(activity.nodes[0].evaluations == 6U && activity.nodes[0].toggles == 6U);
+    assert(activity.nodes[1].evaluations == 6U && activity.nodes[1].toggles == 6U);
+    assert(activity.nodes[2].evaluations == 6U && activity.nodes[2].toggles == 6U);
+    assert(activity.nodes[3].evaluations == 0U);
+    assert(activity.nodes[4].evaluations == 6U && activity.nodes[4].toggles == 0U);
+    assert(activity.nodes[5].evaluations == 6U && activity.nodes[5].toggles == 0U);
+    assert(activity.nodes[1].samples == 6U && activity.nodes[0].samples == 0U);
+    assert(logic_activity_node_seconds(&activity, 1U) >= 0.0);
+
+    logic_activity_summarize(&graph, &activity, &summary);
+    assert(summary.active_nodes == 5U);
+    assert(summary.idle_nodes == 2U);
+    assert(summary.evaluations == 30U && summary.toggles == 18U);
+    assert(summary.peak_toggles == 6U && summary.hottest_node == 0U);
+    assert(fabs(summary.activity_factor - 0.6) < 1e-9);
+
+    logic_clear_graph(&graph);
+    assert(graph.activity == NULL);
+    printf("test_logic_activity_counts_evaluations_and_toggles passed!\n");
+}
+
+// Eight evaluations per pass divide the default interval, which a fixed
+// sampling stride would turn into timing the same gate every time.
+static void test_logic_activity_samples_spread_across_nodes(void) {
+    static LogicGraph graph;
+    static LogicActivity activity;
+    LogicActivitySummary summary;
+    LogicNode *previous;
+    uint32_t sampled;
+    uint32_t index;
+
+    logic_init_graph(&graph);
+    previous = logic_add_node(&graph, NODE_INPUT, "a");
+    for (index = 0U; index < 8U; index++) {
+        LogicNode *gate;
+
+        gate = logic_add_node(&graph, NODE_GATE_NOT, NULL);
+        assert(logic_connect(&graph, &previous->outputs[0], &gate->inputs[0]));
+        previous = gate;
+    }
+    logic_activity_reset(&activity, LOGIC_ACTIVITY_SAMPLE_INTERVAL);
+    logic_activity_attach(&graph, &activity);
+    for (index = 0U; index < 1024U; index++) {
+        logic_evaluate(&graph);
+    }
+
+    sampled = 0U;
+    for (index = 1U; index <= 8U; index++) {
+        assert(activity.nodes[index].evaluations == 1024U);
+        if (activity.nodes[index].samples > 0U) {
+            sampled++;
+        }
+    }
+    assert(sampled == 8U);
+    logic_activity_summarize(&graph, &activity, &summary);
+    assert(summary.estimated_seconds > 0.0);
+
+    logic_clear_graph(&graph);
+    printf("test_logic_activity_samples_spread_across_nodes passed!\n");
+}
+
+static void test_mem_accounts_tagged_allocations(void) {
+    static AppContext app;
+    static LogicGraph graph;
+    MemHooks hooks;
+    MemReport before;
+    MemReport report;
+    char *block;
+    char *name;
+
+    hooks.allocate = test_mem_allocate;
+    hooks.reallocate = test_mem_reallocate;
+    hooks.release = test_mem_release;
+    hooks.user = NULL;
+    memset(test_mem_hook_calls, 0, sizeof(test_mem_hook_calls));
+    // Blocks from before the switch keep going back to malloc's hooks.
+    assert(mem_set_hooks(&hooks));
+    mem_report(&before);
+
+    block = (char *)mem_alloc(MEM_TAG_OTHER, 100U);
+    assert(block);
+    block = (char *)mem_realloc(MEM_TAG_OTHER, block, 300U);
+    assert(block);
+    name = mem_strdup(MEM_TAG_NAMES, "abc");
+    assert(name && strcmp(name, "abc") == 0);
+    assert(mem_calloc(MEM_TAG_OTHER, SIZE_MAX, 2U) == NULL);
+    mem_report(&report);
+    assert(report.tags[MEM_TAG_OTHER].current_bytes == before.tags[MEM_TAG_OTHER].current_bytes + 300U);
+    assert(report.tags[MEM_TAG_OTHER].live_blocks == before.tags[MEM_TAG_OTHER].live_blocks + 1U);
+    assert(report.tags[MEM_TAG_OTHER].allocations == before.tags[MEM_TAG_OTHER].allocations + 2U);
+    assert(report.tags[MEM_TAG_NAMES].current_bytes == before.tags[MEM_TAG_NAMES].current_bytes + 4U);
+    assert(report.current_bytes == before.current_bytes + 304U);
+    assert(report.peak_bytes >= report.current_bytes);
+
+    mem_free(block);
+    mem_free(name);
+    mem_free(NULL);
+    mem_report(&report);
+    assert(report.current_bytes == before.current_bytes);
+    assert(report.tags[MEM_TAG_OTHER].peak_bytes >= before.tags[MEM_TAG_OTHER].current_bytes + 300U);
+    assert(test_mem_hook_calls[0] == 2U && test_mem_hook_calls[1] == 1U && test_mem_hook_calls[2] == 2U);
+
+    // ... and blocks from these hooks go back to them after switching away.
+    block = (char *)mem_alloc(MEM_TAG_OTHER, 10U);
+    assert(block);
+    assert(mem_set_hooks(NULL));
+    block = (char *)mem_realloc(MEM_TAG_OTHER, block, 20U);
+    assert(block);
+    mem_free(block);
+    assert(test_mem_hook_calls[0] == 3U && test_mem_hook_calls[1] == 2U && test_mem_hook_calls[2] == 3U);
+    assert(mem_set_hooks(&hooks) && mem_set_hooks(NULL));
+
+    // Clearing a graph hands every name back.
+    logic_init_graph(&graph);
+    assert(logic_add_node(&graph, NODE_INPUT, "a"));
+    assert(logic_add_node(&graph, NODE_OUTPUT, "q"));
+    mem_report(&report);
+    assert(report.tags[MEM_TAG_NAMES].current_bytes == before.tags[MEM_TAG_NAMES].current_bytes + 4U);
+    logic_clear_graph(&graph);
+    mem_report(&report);
+    assert(report.tags[MEM_TAG_NAMES].current_bytes == before.tags[MEM_TAG_NAMES].current_bytes);
+
+    app_init(&app);
+    mem_report(&report);
+    assert(report.tags[MEM_TAG_WAVEFORMS].fixed_bytes == sizeof(app.simulation.waveforms));
+    assert(report.fixed_bytes == sizeof(app.simulation.waveforms) + sizeof(app.graph));
+    app_init(&app);
+    mem_report(&before);
+    assert(before.fixed_bytes == report.fixed_bytes);
+    printf("test_mem_accounts_tagged_allocations passed!\n");
+}
+
+static void test_arena_reset_rewinds_and_rezeroes(void) {
+    Arena arena;
+    uint8_t *first;
+    uint8_t *again;
+    uint8_t *large;
+    size_t index;
+
+    arena_init(&arena, 256U, MEM_TAG_ANALYSIS);
+    first = (uint8_t *)arena_alloc(&arena, 100U);
+    assert(first);
+    memset(first, 0xFF, 100U);
+
+    // One block: the reset rewinds it and reused bytes come back zeroed.
+    arena_reset(&arena);
+    again = (uint8_t *)arena_alloc(&arena, 200U);
+    assert(again == first);
+    for (index = 0U; index < 200U; index++) {
+        assert(again[index] == 0U);
+    }
+
+    // Spilling into a second block makes the next block big enough for both,
+    // so the pass after that stays in one block.
+    large = (uint8_t *)arena_alloc(&arena, 300U);
+    assert(large);
+    memset(large, 0xFF, 300U);
+    arena_reset(&arena);
+    assert(arena.block_size >= 512U);
+    first = (uint8_t *)arena_alloc(&arena, 200U);
+    memset(first, 0xFF, 200U);
+    large = (uint8_t *)arena_alloc(&arena, 300U);
+    assert(large == first + 208);
+    arena_reset(&arena);
+    again = (uint8_t *)arena_alloc(&arena, 500U);
+    assert(again == first);
+    for (index = 0U; index < 500U; index++) {
+        assert(again[index] == 0U);
+    }
+
+    arena_release(&arena);
+    printf("test_arena_reset_rewinds_and_rezeroes passed!\n");
+}
+
+static void test_analysis_passes_reuse_double_buffered_arenas(void) {
+    static AppContext app;
+    LogicNode *a;
+    LogicNode *b;
+    LogicNode *and_gate;
+    LogicNode *out;
+    MemReport before;
+    MemReport after;
+    const char *previous_expression;
+    const TruthTable *previous_table;
+    char explanation[256];
+    uint32_t pass;
+    uint32_t frame;
+
+    app_init(&app);
+    a = app_add_node(&app, NODE_INPUT, (Vector2){ 0.0f, 0.0f });
+    b = app_add_node(&app, NODE_INPUT, (Vector2){ 0.0f, 100.0f });
+    and_gate = app_add_node(&app, NODE_GATE_AND, (Vector2){ 100.0f, 50.0f });
+    out = app_add_node(&app, NODE_OUTPUT, (Vector2){ 200.0f, 50.0f });
+    assert(app_connect_pins(&app, &a->outputs[0], &and_gate->inputs[0]));
+    assert(app_connect_pins(&app, &b->outputs[0], &and_gate->inputs[1]));
+    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+    app_update_logic(&app);
+
+    // The last pass's results survive the next one untouched.
+    previous_expression = app.analysis.expression;
+    previous_table = app.analysis.truth_table;
+    app_update_logic(&app);
+    assert(app.analysis.expression != previous_expression);
+    assert(strcmp(previous_expression, "(A AND B)") == 0);
+    assert(previous_table->row_count == 4U && app.analysis.truth_table->row_count == 4U);
+    assert(strcmp(app.analysis.expression, "(A AND B)") == 0);
+    assert(strcmp(app.analysis.simplified_expression, "AB") == 0);
+
+    // Once both arenas exist, passes stop touching the heap for their results.
+    mem_report(&before);
+    for (pass = 0U; pass < 8U; pass++) {
+        app_update_logic(&app);
+        // A hovered node is explained every frame between passes.
+        for (frame = 0U; frame < 1000U; frame++) {
+            assert(app_get_node_explanation(and_gate, explanation, sizeof(explanation)));
+        }
+    }
+    mem_report(&after);
+    assert(after.tags[MEM_TAG_TRUTH_TABLE].allocations == before.tags[MEM_TAG_TRUTH_TABLE].allocations);
+    assert(after.tags[MEM_TAG_EXPRESSIONS].allocations == before.tags[MEM_TAG_EXPRESSIONS].allocations);
+    assert(after.tags[MEM_TAG_ANALYSIS].current_bytes == before.tags[MEM_TAG_ANALYSIS].current_bytes);
+    assert(after.tags[MEM_TAG_ANALYSIS].live_blocks == before.tags[MEM_TAG_ANALYSIS].live_blocks);
+    assert(strcmp(app.analysis.expression, "(A AND B)") == 0);
+
+    app_clear_graph(&app);
+    assert(app.analysis.truth_table == NULL && app.analysis.expression == NULL);
+    mem_report(&after);
+    assert(after.tags[MEM_TAG_ANALYSIS].live_blocks == before.tags[MEM_TAG_ANALYSIS].live_blocks - 2U);
+    printf("test_analysis_passes_reuse_double_buffered_arenas passed!\n");
+}
+
+static void test_connected_nodes_can_snap_to_straight_wire_alignment(void) {
+    AppContext app;
+    LogicNode *gate;
+    LogicNode *output;
+    Vector2 snapped;
+    Vector2 gate_pin;
+    Vector2 output_pin;
+
+    app_init(&app);
+    gate = app_add_named_node(&app, NODE_GATE_AND, "G1", (Vector2){ 340.0f, 220.0f });
+    output = app_add_named_node(&app, NODE_OUTPUT, "Z", (Vector2){ 560.0f, 240.0f });
+
+    assert(gate != NULL);
+    assert(output != NULL);
+    assert(app_connect_pins(&app, &gate->outputs[0], &output->inputs[0]));
+
+    snapped = app_snap_live_node_position(&app, output, (Vector2){ 560.0f, 236.0f });
+    assert(snapped.x == 560.0f);
+    assert(snapped.y == 240.0f);
+
+    app_set_node_position(&app, output, snapped);
+    gate_pin = ui_output_pin_position(&app, &gate->outputs[0]);
+    output_pin = ui_input_pin_position(&app, &output->inputs[0]);
+    assert(fabsf(gate_pin.y - output_pin.y) < 0.001f);
+
+    app_clear_graph(&app);
+    printf("test_connected_nodes_can_snap_to_straight_wire_alignment passed!\n");
+}
+
+static void test_multi_input_gate_can_snap_to_connected_inputs_centerline(void) {
+    AppContext app;
+    LogicNode *a;
+    LogicNode *b;
+    LogicNode *gate;
+    Vector2 snapped;
+    Vector2 a_pin;
+    Vector2 b_pin;
+    Vector2 gate_in_0;
+    Vector2 gate_in_1;
+    float source_midpoint;
+    float gate_midpoint;
+
+    app_init(&app);
+    a = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 180.0f, 200.0f });
+    b = app_add_named_node(&app, NODE_INPUT, "B", (Vector2){ 180.0f, 300.0f });
+    gate = app_add_named_node(&app, NODE_GATE_AND, "G1", (Vector2){ 440.0f, 220.0f });
+
+    assert(a != NULL);
+    assert(b != NULL);
+    assert(gate != NULL);
+    assert(app_connect_pins(&app, &a->outputs[0], &gate->inputs[0]));
+    assert(app_connect_pins(&app, &b->outputs[0], &gate->inputs[1]));
+
+    snapped = app_snap_live_node_position(&app, gate, (Vector2){ 440.0f, 232.0f });
+    assert(snapped.x == 440.0f);
+    assert(snapped.y == 230.0f);
+
+    app_set_node_position(&app, gate, snapped);
+
+    a_pin = ui_output_pin_position(&app, &a->outputs[0]);
+    b_pin = ui_output_pin_position(&app, &b->outputs[0]);
+    gate_in_0 = ui_input_pin_position(&app, &gate->inputs[0]);
+    gate_in_1 = ui_input_pin_position(&app, &gate->inputs[1]);
+
+    source_midpoint = (a_pin.y + b_pin.y) * 0.5f;
+    gate_midpoint = (gate_in_0.y + gate_in_1.y) * 0.5f;
+    assert(fabsf(gate_midpoint - source_midpoint) < 0.001f);
+
+    app_clear_graph(&app);
+    printf("test_multi_input_gate_can_snap_to_connected_inputs_centerline passed!\n");
+}
+
+static void test_view_context_matches_live_state(void) {
+    AppContext app;
+    LogicNode *a;
+    LogicNode *b;
+    LogicNode *out;
+    LogicNode *and_gate;
+
+    app_init(&app);
+    a = app_add_node(&app, NODE_INPUT, (Vector2){ 140.0f, 160.0f });
+    b = app_add_node(&app, NODE_INPUT, (Vector2){ 140.0f, 260.0f });
+    and_gate = app_add_node(&app, NODE_GATE_AND, (Vector2){ 320.0f, 220.0f });
+    out = app_add_node(&app, NODE_OUTPUT, (Vector2){ 520.0f, 220.0f });
+    assert(app_connect_pins(&app, &a->outputs[0], &and_gate->inputs[0]));
+    assert(app_connect_pins(&app, &b->outputs[0], &and_gate->inputs[1]));
+    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+
+    a->outputs[0].value = LOGIC_HIGH;
+    b->outputs[0].value = LOGIC_HIGH;
+    logic_evaluate(&app.graph);
+    app_compute_view_context(&app);
+
+    assert(app.selection.view.row_valid);
+    assert(app.selection.view.live_row_index == 3U);
+
+    app.selection.selected_row = 0U;
+    app_compute_view_context(&app);
+    assert(app.selection.view.live_row_index == 3U);
+    assert(a->outputs[0].value == LOGIC_HIGH);
+    assert(b->outputs[0].value == LOGIC_HIGH);
+
+    app.selection.selected_node = and_gate;
+    app_compute_view_context(&app);
+    assert(app.selection.view.output_valid);
+    assert(app.selection.view.live_output == LOGIC_HIGH);
+
+    app_clear_graph(&app);
+    printf("test_view_context_matches_live_state passed!\n");
+}
+
+static void test_equation_resolved(void) {
+    AppContext app;
+    LogicNode *a;
+    LogicNode *b;
+    LogicNode *and_gate;
+    LogicNode *out;
+    char buf[256];
+
+    app_init(&app);
+    a = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 140.0f, 160.0f });
+    b = app_add_named_node(&app, NODE_INPUT, "B", (Vector2){ 140.0f, 260.0f });
+    and_gate = app_add_named_node(&app, NODE_GATE_AND, "AND1", (Vector2){ 320.0f, 220.0f });
+    out = app_add_named_node(&app, NODE_OUTPUT, "Z", (Vector2){ 520.0f, 220.0f });
+    assert(app_connect_pins(&app, &a->outputs[0], &and_gate->inputs[0]));
+    assert(app_connect_pins(&app, &b->outputs[0], &and_gate->inputs[1]));
+    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+
+    a->outputs[0].value = LOGIC_HIGH;
+    b->outputs[0].value = LOGIC_HIGH;
+    logic_evaluate(&app.graph);
+
+    assert(logic_format_equation_resolved(&app.graph, out, buf, sizeof(buf)));
+    assert(strcmp(buf, "Z = (A AND B) = (1 AND 1) = 1") == 0);
+
+    assert(logic_format_equation_resolved(&app.graph, and_gate, buf, sizeof(buf)));
+    assert(strcmp(buf, "AND1 = (A AND B) = (1 AND 1) = 1") == 0);
+
+    a->outputs[0].value = LOGIC_LOW;
+    logic_evaluate(&app.graph);
+    assert(logic_format_equation_resolved(&app.graph, out, buf, sizeof(buf)));
+    assert(strcmp(buf, "Z = (A AND B) = (0 AND 1) = 0") == 0);
+
+    app_clear_graph(&app);
+    printf("test_equation_resolved passed!\n");
+}
+
+static void test_equation_symbolic_and_values(void) {
+    AppContext app;
+    LogicNode *a;
+    LogicNode *b;
+    LogicNode *and_gate;
+    LogicNode *out;
+    char buf[256];
+
+    app_init(&app);
+    a = app_add_named_node(&app, NODE_INPUT, "A", (Vector2){ 140.0f, 160.0f });
+    b = app_add_named_node(&app, NODE_INPUT, "B", (Vector2){ 140.0f, 260.0f });
+    and_gate = app_add_named_node(&app, NODE_GATE_AND, "AND1", (Vector2){ 320.0f, 220.0f });
+    out = app_add_named_node(&app, NODE_OUTPUT, "Z", (Vector2){ 520.0f, 220.0f });
+    assert(app_connect_pins(&app, &a->outputs[0], &and_gate->inputs[0]));
+    assert(app_connect_pins(&app, &b->outputs[0], &and_gate->inputs[1]));
+    assert(app_connect_pins(&app, &and_gate->outputs[0], &out->inputs[0]));
+
+    a->outputs[0].value = LOGIC_HIGH;
+    b->outputs[0].value = LOGIC_HIGH;
+    logic_evaluate(&app.graph);
+
+    assert(logic_format_equation_symbolic(&app.graph, out, buf, sizeof(buf)));
+    assert(strcmp(buf, "Z = (A AND B)") == 0);
+
+    assert(logic_format_equation_values(&app.graph, out, buf, sizeof(buf)));
+    assert(strcmp(buf, "(1 AND 1) -> 1") == 0);
+
+    assert(logic_format_equation_symbolic(&app.graph, and_gate, buf, sizeof(buf)));
+    assert(strcmp(buf, "AND1 = (A AND B)") == 0);
+
+    assert(logic_format_equation_values(&app.graph, and_gate, buf, sizeof(buf)));
+    assert(strcmp(buf, "(1 AND 1) -> 1") == 0);
+
+    app_clear_graph(&app);
+    printf("test_equation_symbolic_and_values passed!\n");
+}
+
+static void test_equation_values_with_unknown_inputs(void) {
+    AppContext app;
     LogicNode *a;
     LogicNode *and_gate;
     LogicNode *out;
@@ -1276,26 +3172,22 @@ static void test_snap_node_position_centers_tall_gates(void) {
     assert(((int)gate_snapped.y % 20) == 0);
 
     {
-        LogicNode gate;
+        AppContext app;
+        LogicNode *gate;
         Vector2 in0;
         Vector2 in1;
 
-        memset(&gate, 0, sizeof(gate));
-        gate.pos = gate_snapped;
-        gate.rect = (Rectangle){ gate_snapped.x, gate_snapped.y, 80.0f, 80.0f };
-        gate.input_count = 2;
-        gate.output_count = 1;
-        gate.inputs[0].node = &gate;
-        gate.inputs[0].index = 0;
-        gate.inputs[1].node = &gate;
-        gate.inputs[1].index = 1;
-
-        in0 = ui_input_pin_position(&gate.inputs[0]);
-        in1 = ui_input_pin_position(&gate.inputs[1]);
+        app_init(&app);
+        gate = app_add_named_node(&app, NODE_GATE_AND, "G1", gate_snapped);
+        assert(gate != NULL);
+
+        in0 = ui_input_pin_position(&app, &gate->inputs[0]);
+        in1 = ui_input_pin_position(&app, &gate->inputs[1]);
         assert(in0.y == 220.0f);
         assert(in1.y == 260.0f);
         assert(((int)in0.y % 20) == 0);
         assert(((int)in1.y % 20) == 0);
+        app_clear_graph(&app);
     }
 
     printf("test_snap_node_position_centers_tall_gates passed!\n");
@@ -1432,32 +3324,34 @@ static void test_frame_graph_in_canvas_centers_loaded_circuit(void) {
 
     for (node_index = 0U; node_index < app.graph.node_count; node_index++) {
         LogicNode *node;
+        Rectangle rect;
 
         node = &app.graph.nodes[node_index];
         if (node->type == (NodeType)-1) {
             continue;
         }
 
+        rect = app_node_rect(&app, node);
         if (!found_node) {
-            min_x = node->rect.x;
-            min_y = node->rect.y;
-            max_x = node->rect.x + node->rect.width;
-            max_y = node->rect.y + node->rect.height;
+            min_x = rect.x;
+            min_y = rect.y;
+            max_x = rect.x + rect.width;
+            max_y = rect.y + rect.height;
             found_node = true;
             continue;
         }
 
-        if (node->rect.x < min_x) {
-            min_x = node->rect.x;
+        if (rect.x < min_x) {
+            min_x = rect.x;
         }
-        if (node->rect.y < min_y) {
-            min_y = node->rect.y;
+        if (rect.y < min_y) {
+            min_y = rect.y;
         }
-        if (node->rect.x + node->rect.width > max_x) {
-            max_x = node->rect.x + node->rect.width;
+        if (rect.x + rect.width > max_x) {
+            max_x = rect.x + rect.width;
         }
-        if (node->rect.y + node->rect.height > max_y) {
-            max_y = node->rect.y + node->rect.height;
+        if (rect.y + rect.height > max_y) {
+            max_y = rect.y + rect.height;
         }
     }
 
@@ -1837,13 +3731,43 @@ int main(void) {
     test_app_default_names();
     test_interactive_construction_flow();
     test_compare_mode_without_target();
+    test_compare_mode_caches_target_table();
+    test_compare_mode_matches_columns_by_name();
     test_circuit_file_load();
     test_circuit_file_load_ignores_explicit_positions();
     test_circuit_file_load_failure_keeps_existing_graph();
     test_example_circuits_load();
     test_circuit_file_load_uses_declaration_order_for_symmetric_layers();
     test_circuit_file_load_packs_disconnected_components();
+    test_circuit_file_reads_small_files_and_maps_large_ones();
     test_circuit_file_load_handles_feedback_cycles();
+    test_batch_grade_reports_each_candidate();
+    test_logic_minimize_column();
+    test_kmap_groups_for_three_inputs();
+    test_fault_coverage_reports_undetected_faults();
+    test_compare_mode_blames_single_stuck_node();
+    test_name_index_lookup_and_duplicate_names();
+    test_circuit_file_tokenizer_handles_edge_cases();
+    test_circuit_binary_round_trip();
+    test_circuit_file_build_graph_swaps_into_app();
+    test_graph_revisions_never_repeat_across_clear_and_move();
+    test_circuit_file_reload_edits_graph_in_place();
+    test_circuit_file_save_round_trips_atomically();
+    test_circuit_verilog_import();
+    test_circuit_bench_and_blif_import();
+    test_sim_cli_runs_stimulus();
+    test_stimulus_batch_matches_tick();
+    test_app_stimulus_replays_after_reset();
+    test_circuit_gen_builds_working_circuits();
+    test_circuit_gen_multiplier_keeps_top_carry();
+    test_circuit_gen_clocks_sequential_circuits();
+    test_trace_writes_nested_zones_as_chrome_json();
+    test_perf_hud_summarizes_frames_and_ticks();
+    test_logic_activity_counts_evaluations_and_toggles();
+    test_logic_activity_samples_spread_across_nodes();
+    test_mem_accounts_tagged_allocations();
+    test_arena_reset_rewinds_and_rezeroes();
+    test_analysis_passes_reuse_double_buffered_arenas();
     test_connected_nodes_can_snap_to_straight_wire_alignment();
     test_multi_input_gate_can_snap_to_connected_inputs_centerline();
     test_view_context_matches_live_state();
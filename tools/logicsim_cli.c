@@ -0,0 +1,5 @@
+#include "sim_cli.h"
+
+int main(int argc, char **argv) {
+    return sim_cli_main(argc, argv);
+}
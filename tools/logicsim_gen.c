@@ -0,0 +1,5 @@
+#include "gen_cli.h"
+
+int main(int argc, char **argv) {
+    return gen_cli_main(argc, argv);
+}